@@ -118,6 +118,13 @@ typedef struct cl_mem_ext_ptr_t {
 /* Additional cl_device_partition_property */
 #define CL_DEVICE_PARTITION_BY_CONNECTIVITY         (1 << 31)
 
+/* Additional cl_context_properties, placement of buffers that are not
+ * assigned a memory bank across the banks connected to the kernels */
+#define CL_CONTEXT_MEM_PLACEMENT_XILINX             (1 << 31)
+#define CL_MEM_PLACEMENT_FIRST_XILINX               1
+#define CL_MEM_PLACEMENT_BALANCE_XILINX             2
+#define CL_MEM_PLACEMENT_STRIPE_XILINX              3
+
 #ifdef CL_VERSION_1_0
 extern cl_int
 clSetCommandQueueProperty(cl_command_queue command_queue,
@@ -186,6 +193,68 @@ xclEnqueuePeerToPeerCopyBuffer(cl_command_queue    command_queue,
                      const cl_event *    event_wait_list,
                      cl_event *          event_parameter);
 
+/*----
+ *
+ * DOC: Command graph APIs
+ * ~~~~~~~~~~~~~~~~~~~~~~~
+ * A command graph records the commands enqueued on a command queue
+ * along with their dependencies, and replays them without repeating
+ * the validation and buffer allocation of the original enqueue calls.
+ * Kernel arguments set with clSetKernelArg after recording are
+ * rebound on the next replay, for all recorded launches of the kernel.
+ * Buffers and host pointers of transfer commands are fixed when
+ * recorded and must remain valid for the lifetime of the graph.
+ */
+typedef struct _cl_command_graph_xilinx * cl_command_graph_xilinx;
+
+/**
+ * clBeginCommandGraphRecordingXilinx - start recording commands
+ * @command_queue : The queue to record, commands enqueued on this
+ *                 queue are recorded instead of executed.
+ * Return a cl_int, CL_SUCCESS or CL_INVALID_OPERATION if the queue
+ * is already recording.
+ */
+extern CL_API_ENTRY cl_int CL_API_CALL
+clBeginCommandGraphRecordingXilinx(cl_command_queue /* command_queue */) CL_API_SUFFIX__VERSION_1_0;
+
+/**
+ * clEndCommandGraphRecordingXilinx - end recording of commands
+ * @command_queue : The recording queue
+ * errcode_ret    : The return value, CL_INVALID_OPERATION if the queue
+ *                  is not recording or if a command could not be recorded
+ *                  (printf kernels, dependencies on incomplete events not
+ *                  in the graph, recorded events waited on by other events)
+ * Returns the recorded cl_command_graph_xilinx
+ */
+extern CL_API_ENTRY cl_command_graph_xilinx CL_API_CALL
+clEndCommandGraphRecordingXilinx(cl_command_queue /* command_queue */,
+                                 cl_int *         /* errcode_ret */) CL_API_SUFFIX__VERSION_1_0;
+
+/**
+ * clEnqueueCommandGraphXilinx - replay a recorded command graph
+ * @command_queue : The queue the graph was recorded on
+ * @graph         : The graph to replay
+ * @num_events_in_wait_list, @event_wait_list : Events to wait for
+ * @event         : Returned event that completes when all recorded
+ *                  commands have completed
+ * A replay waits for the previous replay of the same graph to complete.
+ * Return a cl_int, eg CL_SUCCESS
+ */
+extern CL_API_ENTRY cl_int CL_API_CALL
+clEnqueueCommandGraphXilinx(cl_command_queue        /* command_queue */,
+                            cl_command_graph_xilinx /* graph */,
+                            cl_uint                 /* num_events_in_wait_list */,
+                            const cl_event *        /* event_wait_list */,
+                            cl_event *              /* event */) CL_API_SUFFIX__VERSION_1_0;
+
+/**
+ * clReleaseCommandGraphXilinx - release a command graph
+ * @graph : The graph to release
+ * Return a cl_int
+ */
+extern CL_API_ENTRY cl_int CL_API_CALL
+clReleaseCommandGraphXilinx(cl_command_graph_xilinx /* graph */) CL_API_SUFFIX__VERSION_1_0;
+
 /*----
  *
  * DOC: OpenCL Stream APIs
@@ -224,6 +293,29 @@ typedef cl_uint             cl_stream_xfer_req;
 typedef struct _cl_stream *      cl_stream;
 typedef struct _cl_stream_mem *  cl_stream_mem;
 
+/**
+ * cl_stream_xfer_buf. One buffer of a scatter-gather request.
+ * Used in clReadStreamv() and clWriteStreamv()
+ */
+typedef struct _cl_stream_xfer_buf {
+  void*                     ptr;
+  size_t                    size;
+} cl_stream_xfer_buf;
+
+/**
+ * cl_streams_poll_req_completions. Completion of a CL_STREAM_NONBLOCKING
+ * request, returned by clPollStreams()
+ * @priv_data : The priv_data of the request, or the ptr + offset of a
+ *              request submitted with clReadStream() or clWriteStream()
+ * @nbytes    : The number of bytes transferred
+ * @err_code  : 0 or a negative errno value from the driver
+ */
+typedef struct _cl_streams_poll_req_completions {
+  void*                     priv_data;
+  size_t                    nbytes;
+  cl_int                    err_code;
+} cl_streams_poll_req_completions;
+
 /**
  * clCreateStream - create the stream for reading or writing.
  * @device_id   : The device handle on which stream is to be created.
@@ -289,6 +381,67 @@ clReadStream(cl_device_id     /* device_id*/,
 	     cl_int*               /* errcode_ret*/) CL_API_SUFFIX__VERSION_1_0;
 
 
+/**
+ * clWriteStreamv - write a scatter-gather list to stream as one request
+ * @device_id : The device
+ * @stream    : The stream
+ * @bufs      : The buffers to write from, in order.
+ * @num_bufs  : The number of buffers.
+ * @req_type  : The write request type.
+ * @priv_data : Returned by clPollStreams() for CL_STREAM_NONBLOCKING.
+ * errcode_ret: The return value eg CL_SUCCESS
+ * Return a cl_int, the number of bytes written, 0 for CL_STREAM_NONBLOCKING.
+ */
+extern CL_API_ENTRY cl_int CL_API_CALL
+clWriteStreamv(cl_device_id          /* device_id*/,
+	       cl_stream             /* stream*/,
+	       const cl_stream_xfer_buf* /* bufs */,
+	       cl_uint               /* num_bufs */,
+	       cl_stream_xfer_req    /* req_type*/,
+	       void*                 /* priv_data */,
+	       cl_int*               /* errcode_ret*/) CL_API_SUFFIX__VERSION_1_0;
+
+/**
+ * clReadStreamv - read from stream into a scatter-gather list as one request
+ * @device_id : The device
+ * @stream    : The stream
+ * @bufs      : The buffers to read into, in order.
+ * @num_bufs  : The number of buffers.
+ * @req_type  : The read request type.
+ * @priv_data : Returned by clPollStreams() for CL_STREAM_NONBLOCKING.
+ * errcode_ret: The return value eg CL_SUCCESS
+ * Return a cl_int, the number of bytes read, 0 for CL_STREAM_NONBLOCKING.
+ */
+extern CL_API_ENTRY cl_int CL_API_CALL
+clReadStreamv(cl_device_id           /* device_id*/,
+	      cl_stream              /* stream*/,
+	      const cl_stream_xfer_buf* /* bufs */,
+	      cl_uint                /* num_bufs */,
+	      cl_stream_xfer_req     /* req_type*/,
+	      void*                  /* priv_data */,
+	      cl_int*                /* errcode_ret*/) CL_API_SUFFIX__VERSION_1_0;
+
+/**
+ * clPollStreams - poll completions of CL_STREAM_NONBLOCKING requests
+ * @device_id       : The device
+ * @completions     : The returned completions.
+ * @min_num_completion : The number of completions to wait for.
+ * @max_num_completion : The size of the completions array.
+ * @num_completion  : The number of completions returned.
+ * @timeout         : Timeout in ms, 0 does not wait, negative waits forever.
+ * errcode_ret      : The return value eg CL_SUCCESS
+ * Return a cl_int, CL_SUCCESS or CL_INVALID_OPERATION if fewer than
+ * min_num_completion requests completed before the timeout.
+ */
+extern CL_API_ENTRY cl_int CL_API_CALL
+clPollStreams(cl_device_id           /* device_id*/,
+	      cl_streams_poll_req_completions* /* completions */,
+	      cl_int                 /* min_num_completion */,
+	      cl_int                 /* max_num_completion */,
+	      cl_int*                /* num_completion */,
+	      cl_int                 /* timeout */,
+	      cl_int*                /* errcode_ret*/) CL_API_SUFFIX__VERSION_1_0;
+
 /* clCreateStreamBuffer - Alloc buffer used for read and write.
  * @size       : The size of the buffer
  * errcode_ret : The return value, eg CL_SUCCESS
@@ -48,6 +48,7 @@ namespace xclemulation{
     mVerbosity = 0; 
     mServerPort = 0; 
     mKeepRunDir=false; 
+    mDDRSnapshot = "";
   }
 
   static bool getBoolValue(std::string& value,bool defaultValue)
@@ -126,6 +127,10 @@ namespace xclemulation{
       {
         setSimDir(value);
       }
+      else if(name == "ddr_snapshot")
+      {
+        setDDRSnapshot(value);
+      }
       else if(name == "verbosity")
       {
         unsigned int verbosity = strtoll(value.c_str(),NULL,0);
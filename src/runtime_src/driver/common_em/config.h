@@ -111,6 +111,7 @@ namespace xclemulation{
       inline void setVerbosityLevel(unsigned int verbosity)     { mVerbosity        = verbosity;     }
       inline void setServerPort(unsigned int serverPort)        { mServerPort       = serverPort;    }
       inline void setKeepRunDir(bool _mKeepRundir)              { mKeepRunDir = _mKeepRundir;        }    
+      inline void setDDRSnapshot( std::string& ddrSnapshot)     { mDDRSnapshot      = ddrSnapshot;   }
       
       inline bool isDiagnosticsEnabled()        const { return mDiagnostics;    }
       inline bool isUMRChecksEnabled()          const { return mUMRChecks;      }
@@ -127,6 +128,7 @@ namespace xclemulation{
       inline bool isErrorsSuppressed()          const { return mSuppressErrors;  }
       inline bool getVerbosityLevel()           const { return mVerbosity;       }    
       inline bool isKeepRunDirEnabled()         const { return mKeepRunDir;       }    
+      inline std::string getDDRSnapshot()       const { return mDDRSnapshot;      }
       inline bool isInfosToBePrintedOnConsole() const { return mPrintInfosInConsole;   }  
       inline unsigned int getServerPort()       const { return mServerPort;      }
       inline bool isErrorsToBePrintedOnConsole()   const { return mPrintErrorsInConsole;  }
@@ -155,6 +157,7 @@ namespace xclemulation{
       bool mVerbosity;
       unsigned int mServerPort;
       bool mKeepRunDir;
+      std::string mDDRSnapshot;
       
      
       config();
@@ -17,12 +17,14 @@
 #include "memorymanager.h"
 
 namespace xclemulation {
+  const uint64_t MemoryManager::mNull;
+
   MemoryManager::MemoryManager(uint64_t size, uint64_t start,
       unsigned alignment) : mSize(size), mStart(start), mAlignment(alignment),
-  mCoalesceThreshold(4), mFreeSize(0)
+  mFreeSize(0)
   {
     assert(start % alignment == 0);
-    mFreeBufferList.push_back(std::make_pair(mStart, mSize));
+    insertFree(mStart, mSize);
     mFreeSize = mSize;
   }
 
@@ -36,7 +38,6 @@ namespace xclemulation {
     if (origSize == 0)
       origSize = mAlignment;
 
-    uint64_t result = mNull;
     const size_t mod_size = origSize % mAlignment;
     const size_t pad = (mod_size > 0) ? (mAlignment - mod_size) : 0;
     origSize += pad;
@@ -45,100 +46,77 @@ namespace xclemulation {
 
     std::lock_guard<std::mutex> lock(mMemManagerMutex);
 
-    for (PairList::iterator i = mFreeBufferList.begin(), e = mFreeBufferList.end(); i != e; ++i) 
-    {
-      if (i->second < size)
-        continue;
-      result = i->first;
-      if (i->second > size) 
-      {
-        // Resize the existing entry in freelist
-        i->first += size;
-        i->second -= size;
-      }
-      else 
-      {
-        // remove the exact match found
-        mFreeBufferList.erase(i);
-      }
-      mBusyBufferList.push_back(std::make_pair(result, size));
-      mFreeSize -= size;
-      break;
-    }
+    // Best fit, the smallest free block that is large enough and the
+    // lowest address among blocks of that size
+    SizeIndex::iterator i = mFreeBySize.lower_bound(std::make_pair(static_cast<uint64_t>(size), static_cast<uint64_t>(0)));
+    if (i == mFreeBySize.end())
+      return mNull;
+
+    const uint64_t result = i->second;
+    const uint64_t blockSize = i->first;
+    eraseFree(mFreeBuffers.find(result));
+    if (blockSize > size)
+      insertFree(result + size, blockSize - size);
+    mBusyBuffers.insert(std::make_pair(result, static_cast<uint64_t>(size)));
+    mFreeSize -= size;
     return result;
   }
 
   void MemoryManager::free(uint64_t buf)
   {
     std::lock_guard<std::mutex> lock(mMemManagerMutex);
-    PairList::iterator i = find(buf);
-    if (i == mBusyBufferList.end())
+    BlockMap::iterator i = mBusyBuffers.find(buf);
+    if (i == mBusyBuffers.end())
       return;
-    mFreeSize += i->second;
-    mFreeBufferList.push_back(std::make_pair(i->first, i->second));
-    mBusyBufferList.erase(i);
-    if (mFreeBufferList.size() > mCoalesceThreshold) {
-      coalesce();
+    uint64_t start = i->first;
+    uint64_t size = i->second;
+    mBusyBuffers.erase(i);
+    mFreeSize += size;
+
+    // Merge with the free neighbours
+    BlockMap::iterator next = mFreeBuffers.lower_bound(start);
+    if ((next != mFreeBuffers.end()) && (start + size == next->first)) {
+      size += next->second;
+      next = eraseFree(next);
     }
-  }
-
-
-  void MemoryManager::coalesce()
-  {
-    // First sort the free buffers and then attempt to coalesce the neighbors
-    mFreeBufferList.sort();
-
-    PairList::iterator curr = mFreeBufferList.begin();
-    PairList::iterator next = curr;
-    ++next;
-    PairList::iterator last = mFreeBufferList.end();
-    while (next != last) {
-      if ((curr->first + curr->second) != next->first) {
-        // Non contiguous blocks
-        curr = next;
-        ++next;
-        continue;
+    if (next != mFreeBuffers.begin()) {
+      BlockMap::iterator prev = std::prev(next);
+      if (prev->first + prev->second == start) {
+        start = prev->first;
+        size += prev->second;
+        eraseFree(prev);
       }
-      // Coalesce curr and next
-      curr->second += next->second;
-      mFreeBufferList.erase(next);
-      next = curr;
-      ++next;
     }
+    insertFree(start, size);
   }
 
+  void MemoryManager::insertFree(uint64_t buf, uint64_t size)
+  {
+    mFreeBuffers.insert(std::make_pair(buf, size));
+    mFreeBySize.insert(std::make_pair(size, buf));
+  }
 
-  MemoryManager::PairList::iterator MemoryManager::find(uint64_t buf)
+  MemoryManager::BlockMap::iterator MemoryManager::eraseFree(BlockMap::iterator i)
   {
-#if GCC_VERSION >= 40800
-    PairList::iterator i = std::find_if(mBusyBufferList.begin(), mBusyBufferList.end(), [&] (const PairList::value_type& s)
-        { return s.first == buf; });
-#else
-    PairList::iterator i = mBusyBufferList.begin();
-    PairList::iterator last  = mBusyBufferList.end();
-    while(i != last) {
-      if (i->first == buf)
-        break;
-      ++i;
-    }
-#endif
-    return i;
+    mFreeBySize.erase(std::make_pair(i->second, i->first));
+    return mFreeBuffers.erase(i);
   }
 
   void MemoryManager::reset()
   {
     std::lock_guard<std::mutex> lock(mMemManagerMutex);
-    mFreeBufferList.clear();
-    mBusyBufferList.clear();
-    mFreeBufferList.push_back(std::make_pair(mStart, mSize));
-    mFreeSize = 0;
+    mFreeBuffers.clear();
+    mFreeBySize.clear();
+    mBusyBuffers.clear();
+    insertFree(mStart, mSize);
+    mFreeSize = mSize;
   }
 
   std::pair<uint64_t, uint64_t> MemoryManager::lookup(uint64_t buf)
   {
     std::lock_guard<std::mutex> lock(mMemManagerMutex);
-    PairList::iterator i = find(buf);
-    if (i != mBusyBufferList.end())
+    BlockMap::iterator i = mBusyBuffers.find(buf);
+    if (i != mBusyBuffers.end())
       return *i;
     // Compiler bug -- Some versions of GCC C++11 compiler do not
     // like mNull directly inside std::make_pair, so capture mNull
@@ -146,5 +124,16 @@ namespace xclemulation {
     const uint64_t v = mNull;
     return std::make_pair(v, v);
   }
-}
 
+  MemoryManager::Stats MemoryManager::stats()
+  {
+    std::lock_guard<std::mutex> lock(mMemManagerMutex);
+    Stats result;
+    result.freeSize = mFreeSize;
+    result.largestFreeBlock = mFreeBySize.empty() ? 0 : mFreeBySize.rbegin()->first;
+    result.freeBlocks = mFreeBuffers.size();
+    result.busyBlocks = mBusyBuffers.size();
+    result.fragmentation = mFreeSize ? 1.0 - (double)result.largestFreeBlock / mFreeSize : 0.0;
+    return result;
+  }
+}
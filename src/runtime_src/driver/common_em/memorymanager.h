@@ -18,31 +18,49 @@
 #define _HWEM_MEMORY_MANAGER_H_
 
 #include <mutex>
-#include <list>
+#include <map>
+#include <set>
 #include <cassert>
 #include <algorithm>
+#include <iterator>
 
 #include "em_defines.h"
 #include "xclhal2.h"
 
 namespace xclemulation
 {
+    // Device memory allocator of one DDR bank. Free blocks are indexed
+    // by address, to merge a freed block with its neighbours, and by size
+    // for best fit allocation. Busy blocks are indexed by address. alloc,
+    // free and lookup are O(log n) in the number of blocks.
     class MemoryManager 
     {
+        typedef std::map<uint64_t, uint64_t> BlockMap;                 // address -> size
+        typedef std::set<std::pair<uint64_t, uint64_t> > SizeIndex;    // (size, address)
+
         std::mutex mMemManagerMutex;
-        std::list<std::pair<uint64_t, uint64_t> > mFreeBufferList;
-        std::list<std::pair<uint64_t, uint64_t> > mBusyBufferList;
+        BlockMap mFreeBuffers;
+        SizeIndex mFreeBySize;
+        BlockMap mBusyBuffers;
         uint64_t mSize;
         uint64_t mStart;
         uint64_t mAlignment;
-        const unsigned mCoalesceThreshold;
         uint64_t mFreeSize;
 
-        typedef std::list<std::pair<uint64_t, uint64_t> > PairList;
-
     public:
         static const uint64_t mNull = 0xffffffffffffffffull;
 
+        // Fragmentation of the free space
+        struct Stats
+        {
+            uint64_t freeSize;
+            uint64_t largestFreeBlock;
+            size_t freeBlocks;
+            size_t busyBlocks;
+            // 1 - largestFreeBlock/freeSize, 0 when the free space is one block
+            double fragmentation;
+        };
+
     public:
         MemoryManager(uint64_t size, uint64_t start, unsigned alignment);
         ~MemoryManager();
@@ -56,13 +74,12 @@ namespace xclemulation
         static bool isNullAlloc(const std::pair<uint64_t, uint64_t>& buf) { return ((buf.first == mNull) || (buf.second == mNull)); }
 
         std::pair<uint64_t, uint64_t>lookup(uint64_t buf);
+        Stats stats();
 
     private:
-        void coalesce();
-        PairList::iterator find(uint64_t buf);
+        void insertFree(uint64_t buf, uint64_t size);
+        BlockMap::iterator eraseFree(BlockMap::iterator i);
     };
 }
 
 #endif
-
-
@@ -81,6 +81,14 @@ int xclGetDeviceInfo2(xclDeviceHandle handle, xclDeviceInfo2 *info)
   return drv->xclGetDeviceInfo2(info);
 }
 
+int xclGetUsageInfo(xclDeviceHandle handle, xclDeviceUsage *info)
+{
+  xclcpuemhal2::CpuemShim *drv = xclcpuemhal2::CpuemShim::handleCheck(handle);
+  if (!drv)
+    return -1;
+  return drv->xclGetUsageInfo(info);
+}
+
 int xclLoadXclBin(xclDeviceHandle handle, const xclBin *buffer)
 {
   xclcpuemhal2::CpuemShim *drv = xclcpuemhal2::CpuemShim::handleCheck(handle);
@@ -437,3 +445,68 @@ int xclGetBOProperties(xclDeviceHandle handle, unsigned int boHandle, xclBOPrope
     return -1;
   return drv->xclGetBOProperties(boHandle, properties);
 }
+
+//QDMA Support
+int xclCreateWriteQueue(xclDeviceHandle handle, xclQueueContext *q_ctx, uint64_t *q_hdl)
+{
+  xclcpuemhal2::CpuemShim *drv = xclcpuemhal2::CpuemShim::handleCheck(handle);
+  if (!drv)
+    return -ENODEV;
+  return drv->xclCreateWriteQueue(q_ctx, q_hdl);
+}
+
+int xclCreateReadQueue(xclDeviceHandle handle, xclQueueContext *q_ctx, uint64_t *q_hdl)
+{
+  xclcpuemhal2::CpuemShim *drv = xclcpuemhal2::CpuemShim::handleCheck(handle);
+  if (!drv)
+    return -ENODEV;
+  return drv->xclCreateReadQueue(q_ctx, q_hdl);
+}
+
+int xclDestroyQueue(xclDeviceHandle handle, uint64_t q_hdl)
+{
+  xclcpuemhal2::CpuemShim *drv = xclcpuemhal2::CpuemShim::handleCheck(handle);
+  if (!drv)
+    return -ENODEV;
+  return drv->xclDestroyQueue(q_hdl);
+}
+
+void *xclAllocQDMABuf(xclDeviceHandle handle, size_t size, uint64_t *buf_hdl)
+{
+  xclcpuemhal2::CpuemShim *drv = xclcpuemhal2::CpuemShim::handleCheck(handle);
+  if (!drv)
+    return NULL;
+  return drv->xclAllocQDMABuf(size, buf_hdl);
+}
+
+int xclFreeQDMABuf(xclDeviceHandle handle, uint64_t buf_hdl)
+{
+  xclcpuemhal2::CpuemShim *drv = xclcpuemhal2::CpuemShim::handleCheck(handle);
+  if (!drv)
+    return -ENODEV;
+  return drv->xclFreeQDMABuf(buf_hdl);
+}
+
+ssize_t xclWriteQueue(xclDeviceHandle handle, uint64_t q_hdl, xclQueueRequest *wr)
+{
+  xclcpuemhal2::CpuemShim *drv = xclcpuemhal2::CpuemShim::handleCheck(handle);
+  if (!drv)
+    return -ENODEV;
+  return drv->xclWriteQueue(q_hdl, wr);
+}
+
+ssize_t xclReadQueue(xclDeviceHandle handle, uint64_t q_hdl, xclQueueRequest *wr)
+{
+  xclcpuemhal2::CpuemShim *drv = xclcpuemhal2::CpuemShim::handleCheck(handle);
+  if (!drv)
+    return -ENODEV;
+  return drv->xclReadQueue(q_hdl, wr);
+}
+
+int xclPollCompletion(xclDeviceHandle handle, int min_compl, int max_compl, xclReqCompletion *comps, int* actual_compl, int timeout)
+{
+  xclcpuemhal2::CpuemShim *drv = xclcpuemhal2::CpuemShim::handleCheck(handle);
+  if (!drv)
+    return -ENODEV;
+  return drv->xclPollCompletion(min_compl, max_compl, comps, actual_compl, timeout);
+}
@@ -39,6 +39,7 @@ namespace xclcpuemhal2 {
     ,mDSAMajorVersion(DSA_MAJOR_VERSION)
     ,mDSAMinorVersion(DSA_MINOR_VERSION)
     ,mDeviceIndex(deviceIndex)
+    ,mStreamQueues("/xrt_swemu_" + std::to_string(getpid()) + "_device" + std::to_string(deviceIndex))
   {
     binaryCounter = 0;
     sock = NULL;
@@ -343,6 +344,9 @@ namespace xclcpuemhal2 {
       std::stringstream socket_id;
       socket_id << deviceName << "_" << binaryCounter << "_" << getpid();
       setenv("EMULATION_SOCKETID",socket_id.str().c_str(),true);
+      // Shared memory prefix of the stream queue rings, the device
+      // process does not attach to them yet (loopback only)
+      setenv("EMULATION_STREAM_PREFIX",mStreamQueues.prefix().c_str(),true);
 
       pid_t pid = fork();
       assert(pid >= 0);
@@ -544,6 +548,21 @@ namespace xclcpuemhal2 {
     return 0;
   }
 
+  // Usage of the emulated DDR banks, indexed like mDDRMemoryManager
+  int CpuemShim::xclGetUsageInfo(xclDeviceUsage *info)
+  {
+    std::memset(info, 0, sizeof(xclDeviceUsage));
+    const size_t count = std::min(mDDRMemoryManager.size(), sizeof(info->ddrMemUsed)/sizeof(info->ddrMemUsed[0]));
+    for (size_t i = 0; i < count; i++)
+    {
+      xclemulation::MemoryManager::Stats stats = mDDRMemoryManager[i]->stats();
+      info->memSize[i] = mDDRMemoryManager[i]->size();
+      info->ddrMemUsed[i] = info->memSize[i] - stats.freeSize;
+      info->ddrBOAllocated[i] = stats.busyBlocks;
+    }
+    return 0;
+  }
+
   void CpuemShim::launchTempProcess()
   {
     std::string binaryDirectory("");
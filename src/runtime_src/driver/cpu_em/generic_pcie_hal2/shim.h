@@ -22,6 +22,7 @@
 #include "em_defines.h"
 #include "memorymanager.h"
 #include "rpc_messages.pb.h"
+#include "stream_queue.h"
 
 #include "xclperf.h"
 #include "xcl_api_macros.h"
@@ -70,6 +71,17 @@ namespace xclcpuemhal2 {
       unsigned int xclImportBO(int boGlobalHandle);
 
       xclemulation::drm_xocl_bo* xclGetBoByHandle(unsigned int boHandle);
+
+      // QDMA streaming APIs, emulated by StreamQueues
+      int xclCreateWriteQueue(xclQueueContext *q_ctx, uint64_t *q_hdl) { return mStreamQueues.createQueue(q_ctx, true, q_hdl); }
+      int xclCreateReadQueue(xclQueueContext *q_ctx, uint64_t *q_hdl) { return mStreamQueues.createQueue(q_ctx, false, q_hdl); }
+      int xclDestroyQueue(uint64_t q_hdl) { return mStreamQueues.destroyQueue(q_hdl); }
+      void *xclAllocQDMABuf(size_t size, uint64_t *buf_hdl) { return mStreamQueues.allocBuf(size, buf_hdl); }
+      int xclFreeQDMABuf(uint64_t buf_hdl) { return mStreamQueues.freeBuf(buf_hdl); }
+      ssize_t xclWriteQueue(uint64_t q_hdl, xclQueueRequest *wr) { return mStreamQueues.writeQueue(q_hdl, wr); }
+      ssize_t xclReadQueue(uint64_t q_hdl, xclQueueRequest *rd) { return mStreamQueues.readQueue(q_hdl, rd); }
+      int xclPollCompletion(int min_compl, int max_compl, xclReqCompletion *comps, int *actual_compl, int timeout)
+      { return mStreamQueues.pollCompletion(min_compl, max_compl, comps, actual_compl, timeout); }
       inline unsigned short xocl_ddr_channel_count();
       inline unsigned long long xocl_ddr_channel_size();
       // HAL2 RELATED member functions end 
@@ -114,6 +126,7 @@ namespace xclcpuemhal2 {
 
       // Sanity checks
       int xclGetDeviceInfo2(xclDeviceInfo2 *info);
+      int xclGetUsageInfo(xclDeviceUsage *info);
       static unsigned xclProbe();
       void fillDeviceInfo(xclDeviceInfo2* dest, xclDeviceInfo2* src);
       void saveDeviceProcessOutput();
@@ -197,6 +210,7 @@ namespace xclcpuemhal2 {
       std::map<int, xclemulation::drm_xocl_bo*> mXoclObjMap;
       static unsigned int mBufferCount;
       // HAL2 RELATED member variables end 
+      StreamQueues mStreamQueues;
 
   };
   
@@ -0,0 +1,539 @@
+/**
+ * Copyright (C) 2016-2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "stream_queue.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+  const std::chrono::microseconds POLL_INTERVAL(100);
+
+  inline uint64_t align8(uint64_t value)
+  {
+    return (value + 7) & ~7ULL;
+  }
+
+  inline size_t headerSize()
+  {
+    return (sizeof(xclcpuemhal2::StreamRing::Header) + 63) & ~63ULL;
+  }
+
+}
+
+namespace xclcpuemhal2 {
+
+  //
+  // StreamRing
+  //
+
+  const uint32_t StreamRing::MAGIC;
+  const uint32_t StreamRing::VERSION;
+  const uint32_t StreamRing::RECORD_EOT;
+
+  StreamRing::StreamRing(const std::string& name, size_t size)
+    : mName(name), mMapSize(0), mHeader(nullptr), mData(nullptr), mMask(0), mReadOffset(0)
+  {
+    size_t dataSize = 4096;
+    while (dataSize < size)
+      dataSize <<= 1;
+    mMapSize = headerSize() + dataSize;
+
+    void* addr = MAP_FAILED;
+    if (mName.empty()) {
+      addr = mmap(nullptr, mMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    }
+    else {
+      int fd = shm_open(mName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+      if (fd < 0)
+        return;
+      if (ftruncate(fd, mMapSize) == 0)
+        addr = mmap(nullptr, mMapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      close(fd);
+      if (addr == MAP_FAILED) {
+        shm_unlink(mName.c_str());
+        return;
+      }
+    }
+    if (addr == MAP_FAILED)
+      return;
+
+    mHeader = static_cast<Header*>(addr);
+    mData = static_cast<char*>(addr) + headerSize();
+    mMask = dataSize - 1;
+    mHeader->size = dataSize;
+    mHeader->head.store(0);
+    mHeader->tail.store(0);
+    mHeader->producerPid.store(0);
+    mHeader->consumerPid.store(0);
+    mHeader->version = VERSION;
+    std::atomic_thread_fence(std::memory_order_release);
+    mHeader->magic = MAGIC;
+  }
+
+  StreamRing::~StreamRing()
+  {
+    if (!mHeader)
+      return;
+    munmap(mHeader, mMapSize);
+    if (!mName.empty())
+      shm_unlink(mName.c_str());
+  }
+
+  bool StreamRing::empty() const
+  {
+    return mHeader->head.load(std::memory_order_acquire) == mHeader->tail.load(std::memory_order_relaxed);
+  }
+
+  void StreamRing::copyIn(uint64_t pos, const char* src, size_t len)
+  {
+    size_t idx = pos & mMask;
+    size_t first = std::min<size_t>(len, mHeader->size - idx);
+    std::memcpy(mData + idx, src, first);
+    if (first < len)
+      std::memcpy(mData, src + first, len - first);
+  }
+
+  bool StreamRing::write(const char* data, size_t& len, bool eot)
+  {
+    uint64_t head = mHeader->head.load(std::memory_order_relaxed);
+    uint64_t tail = mHeader->tail.load(std::memory_order_acquire);
+    uint64_t space = mHeader->size - (head - tail);
+    if (space < sizeof(Record))
+      return false;
+
+    size_t count = std::min<uint64_t>(len, (space - sizeof(Record)) & ~7ULL);
+    if (count == 0 && len)
+      return false;
+
+    Record record = { static_cast<uint32_t>(count), (eot && count == len) ? RECORD_EOT : 0 };
+    copyIn(head, reinterpret_cast<const char*>(&record), sizeof(record));
+    copyIn(head + sizeof(record), data, count);
+    mHeader->head.store(head + sizeof(record) + align8(count), std::memory_order_release);
+    len = count;
+    return true;
+  }
+
+  bool StreamRing::peek(const char*& data, size_t& len, bool& last, bool& eot)
+  {
+    uint64_t tail = mHeader->tail.load(std::memory_order_relaxed);
+    if (mHeader->head.load(std::memory_order_acquire) == tail)
+      return false;
+
+    // Records are 8 byte aligned, a record header never wraps
+    Record record;
+    std::memcpy(&record, mData + (tail & mMask), sizeof(record));
+    size_t remaining = record.len - mReadOffset;
+    size_t idx = (tail + sizeof(record) + mReadOffset) & mMask;
+    len = std::min<size_t>(remaining, mHeader->size - idx);
+    data = mData + idx;
+    last = (len == remaining);
+    eot = (record.flags & RECORD_EOT) != 0;
+    return true;
+  }
+
+  void StreamRing::consume(size_t len)
+  {
+    uint64_t tail = mHeader->tail.load(std::memory_order_relaxed);
+    Record record;
+    std::memcpy(&record, mData + (tail & mMask), sizeof(record));
+    mReadOffset += len;
+    if (mReadOffset < record.len)
+      return;
+    mReadOffset = 0;
+    mHeader->tail.store(tail + sizeof(record) + align8(record.len), std::memory_order_release);
+  }
+
+  //
+  // StreamQueues
+  //
+
+  const size_t StreamQueues::DEFAULT_RING_SIZE;
+  const uint32_t StreamQueues::CONTEXT_TYPE_PACKET;
+
+  StreamQueues::StreamQueues(const std::string& prefix, size_t ringSize)
+    : mPrefix(prefix), mRingSize(ringSize), mPid(getpid()), mNextHandle(1), mNonBlocking(false)
+  {
+  }
+
+  StreamQueues::~StreamQueues()
+  {
+    for (auto& buf : mBufs)
+      free(buf.second.first);
+  }
+
+  StreamQueues::Queue* StreamQueues::findQueue(uint64_t q_hdl)
+  {
+    auto itr = mQueues.find(q_hdl);
+    return (itr == mQueues.end()) ? nullptr : itr->second.get();
+  }
+
+  std::string StreamQueues::ringName(uint64_t q_hdl)
+  {
+    std::lock_guard<std::mutex> lk(mMutex);
+    auto q = findQueue(q_hdl);
+    return q ? q->ring->name() : std::string();
+  }
+
+  int StreamQueues::createQueue(const xclQueueContext *q_ctx, bool write, uint64_t *q_hdl)
+  {
+    if (!q_ctx || !q_hdl)
+      return -EINVAL;
+
+    std::lock_guard<std::mutex> lk(mMutex);
+    if (!write && mReadQueueByFlow.count(q_ctx->flow))
+      return -EEXIST;
+
+    std::unique_ptr<Queue> q(new Queue);
+    q->write = write;
+    q->packet = (q_ctx->type & CONTEXT_TYPE_PACKET) != 0;
+    q->route = q_ctx->route;
+    q->flow = q_ctx->flow;
+    q->dropping = false;
+
+    std::string name;
+    if (!mPrefix.empty())
+      name = mPrefix + (write ? "_w_" : "_r_") + std::to_string(q->route) + "_" + std::to_string(q->flow);
+    q->ring.reset(new StreamRing(name, mRingSize));
+    if (!q->ring->isGood())
+      return -EEXIST;
+    if (write)
+      q->ring->header()->producerPid.store(mPid);
+    else
+      q->ring->header()->consumerPid.store(mPid);
+
+    if (!write)
+      mReadQueueByFlow[q->flow] = q.get();
+    *q_hdl = mNextHandle++;
+    mQueues[*q_hdl] = std::move(q);
+    return 0;
+  }
+
+  int StreamQueues::destroyQueue(uint64_t q_hdl)
+  {
+    std::lock_guard<std::mutex> lk(mMutex);
+    auto q = findQueue(q_hdl);
+    if (!q)
+      return -EINVAL;
+
+    // A blocked caller still owns one of the pending requests
+    for (auto r : q->pending)
+      if (!(r->flag & XCL_QUEUE_NONBLOCKING))
+        return -EBUSY;
+
+    while (!q->pending.empty()) {
+      auto r = q->pending.front();
+      q->pending.pop_front();
+      complete(*q, r, -ECANCELED);
+    }
+
+    if (!q->write)
+      mReadQueueByFlow.erase(q->flow);
+    mQueues.erase(q_hdl);
+    return 0;
+  }
+
+  void* StreamQueues::allocBuf(size_t size, uint64_t *buf_hdl)
+  {
+    void* buf = nullptr;
+    if (!buf_hdl || posix_memalign(&buf, 4096, size))
+      return nullptr;
+
+    std::lock_guard<std::mutex> lk(mMutex);
+    *buf_hdl = mNextHandle++;
+    mBufs[*buf_hdl] = std::make_pair(buf, size);
+    return buf;
+  }
+
+  int StreamQueues::freeBuf(uint64_t buf_hdl)
+  {
+    std::lock_guard<std::mutex> lk(mMutex);
+    auto itr = mBufs.find(buf_hdl);
+    if (itr == mBufs.end())
+      return -EINVAL;
+    free(itr->second.first);
+    mBufs.erase(itr);
+    return 0;
+  }
+
+  StreamQueues::Request* StreamQueues::getRequest(Queue& q, const xclQueueRequest *req)
+  {
+    Request* r = nullptr;
+    if (q.freeList.empty()) {
+      q.pool.emplace_back(new Request);
+      r = q.pool.back().get();
+    }
+    else {
+      r = q.freeList.back();
+      q.freeList.pop_back();
+    }
+
+    r->bufs.assign(req->bufs, req->bufs + req->buf_num);
+    r->bufIndex = 0;
+    r->bufOffset = 0;
+    r->nbytes = 0;
+    r->flag = req->flag;
+    // Not part of requests that predate non-blocking requests
+    r->priv_data = (req->flag & XCL_QUEUE_NONBLOCKING) ? req->priv_data : nullptr;
+    r->done = false;
+    r->err_code = 0;
+    return r;
+  }
+
+  // Caller has removed the request from the pending list
+  void StreamQueues::complete(Queue& q, Request* r, int err_code)
+  {
+    r->err_code = err_code;
+    if (r->flag & XCL_QUEUE_NONBLOCKING) {
+      mCompletions.push_back(xclReqCompletion{r->priv_data, r->nbytes, err_code});
+      q.freeList.push_back(r);
+    }
+    else {
+      r->done = true;
+    }
+    mCond.notify_all();
+  }
+
+  // Copy pending write requests into the ring of a write queue
+  bool StreamQueues::fillRing(Queue& q)
+  {
+    bool moved = false;
+    while (!q.pending.empty()) {
+      auto r = q.pending.front();
+      bool eot = (r->flag & XCL_QUEUE_EOT) != 0;
+      while (r->bufIndex < r->bufs.size()) {
+        auto& buf = r->bufs[r->bufIndex];
+        bool last = (r->bufIndex + 1 == r->bufs.size());
+        size_t len = buf.len - r->bufOffset;
+        if (len == 0 && !(eot && last)) {
+          ++r->bufIndex;
+          continue;
+        }
+        if (!q.ring->write(buf.buf + r->bufOffset, len, eot && last))
+          break;
+        moved = true;
+        r->nbytes += len;
+        r->bufOffset += len;
+        if (r->bufOffset == buf.len) {
+          ++r->bufIndex;
+          r->bufOffset = 0;
+        }
+      }
+      if (r->bufIndex < r->bufs.size())
+        break;
+      q.pending.pop_front();
+      complete(q, r, 0);
+      moved = true;
+    }
+    return moved;
+  }
+
+  // Emulated loopback kernel, moves the records of a write queue ring
+  // to the ring of the read queue with the same flow
+  bool StreamQueues::routeRing(Queue& q)
+  {
+    int32_t consumer = q.ring->header()->consumerPid.load(std::memory_order_acquire);
+    if (consumer && consumer != mPid)
+      return false;
+
+    auto itr = mReadQueueByFlow.find(q.flow);
+    if (itr == mReadQueueByFlow.end())
+      return false;
+    auto& dst = *itr->second->ring;
+    int32_t producer = dst.header()->producerPid.load(std::memory_order_acquire);
+    if (producer && producer != mPid)
+      return false;
+    dst.header()->producerPid.store(mPid, std::memory_order_release);
+
+    bool moved = false;
+    const char* data;
+    size_t len;
+    bool last, eot;
+    while (q.ring->peek(data, len, last, eot)) {
+      size_t count = len;
+      if (!dst.write(data, count, last && eot))
+        break;
+      q.ring->consume(count);
+      moved = true;
+    }
+    return moved;
+  }
+
+  // Copy the records of a read queue ring into its pending requests
+  bool StreamQueues::drainRing(Queue& q)
+  {
+    bool moved = false;
+    const char* data;
+    size_t len;
+    bool last, eot;
+    while (q.ring->peek(data, len, last, eot)) {
+      if (q.dropping) {
+        q.ring->consume(len);
+        q.dropping = !(last && eot);
+        moved = true;
+        continue;
+      }
+      if (q.pending.empty())
+        break;
+
+      auto r = q.pending.front();
+      size_t count = 0;
+      while (count < len && r->bufIndex < r->bufs.size()) {
+        auto& buf = r->bufs[r->bufIndex];
+        size_t chunk = std::min<size_t>(len - count, buf.len - r->bufOffset);
+        std::memcpy(buf.buf + r->bufOffset, data + count, chunk);
+        count += chunk;
+        r->nbytes += chunk;
+        r->bufOffset += chunk;
+        if (r->bufOffset == buf.len) {
+          ++r->bufIndex;
+          r->bufOffset = 0;
+        }
+      }
+      q.ring->consume(count);
+      moved = true;
+
+      bool packetEnd = (count == len) && last && eot;
+      bool full = (r->bufIndex == r->bufs.size());
+      if (!packetEnd && !full)
+        continue;
+
+      q.pending.pop_front();
+      if (packetEnd || !q.packet) {
+        complete(q, r, 0);
+      }
+      else {
+        q.dropping = true;
+        complete(q, r, -EMSGSIZE);
+      }
+    }
+
+    if (!q.pending.empty() && q.ring->empty()) {
+      auto r = q.pending.front();
+      if ((r->flag & XCL_QUEUE_PARTIAL) && r->nbytes) {
+        q.pending.pop_front();
+        complete(q, r, 0);
+        moved = true;
+      }
+    }
+    return moved;
+  }
+
+  void StreamQueues::progress()
+  {
+    bool moved = true;
+    while (moved) {
+      moved = false;
+      for (auto& entry : mQueues) {
+        auto& q = *entry.second;
+        if (q.write) {
+          moved |= fillRing(q);
+          moved |= routeRing(q);
+        }
+      }
+      for (auto& entry : mQueues) {
+        auto& q = *entry.second;
+        if (!q.write)
+          moved |= drainRing(q);
+      }
+    }
+  }
+
+  ssize_t StreamQueues::submit(Queue& q, const xclQueueRequest *req, std::unique_lock<std::mutex>& lk)
+  {
+    auto r = getRequest(q, req);
+    q.pending.push_back(r);
+    progress();
+    if (req->flag & XCL_QUEUE_NONBLOCKING) {
+      mNonBlocking = true;
+      return 0;
+    }
+
+    while (!r->done) {
+      mCond.wait_for(lk, POLL_INTERVAL);
+      progress();
+    }
+    ssize_t ret = r->err_code ? r->err_code : static_cast<ssize_t>(r->nbytes);
+    q.freeList.push_back(r);
+    return ret;
+  }
+
+  ssize_t StreamQueues::writeQueue(uint64_t q_hdl, const xclQueueRequest *wr)
+  {
+    if (!wr || (wr->buf_num && !wr->bufs))
+      return -EINVAL;
+
+    std::unique_lock<std::mutex> lk(mMutex);
+    auto q = findQueue(q_hdl);
+    if (!q || !q->write)
+      return -EINVAL;
+    return submit(*q, wr, lk);
+  }
+
+  ssize_t StreamQueues::readQueue(uint64_t q_hdl, const xclQueueRequest *rd)
+  {
+    if (!rd || (rd->buf_num && !rd->bufs))
+      return -EINVAL;
+
+    std::unique_lock<std::mutex> lk(mMutex);
+    auto q = findQueue(q_hdl);
+    if (!q || q->write)
+      return -EINVAL;
+    return submit(*q, rd, lk);
+  }
+
+  int StreamQueues::pollCompletion(int min_compl, int max_compl, xclReqCompletion *comps, int *actual_compl, int timeout)
+  {
+    if (!comps || !actual_compl || min_compl < 0 || max_compl < min_compl)
+      return -EINVAL;
+
+    std::unique_lock<std::mutex> lk(mMutex);
+    // Nothing can complete before a non-blocking request is submitted
+    if (!mNonBlocking && min_compl > 0) {
+      *actual_compl = 0;
+      return -EINVAL;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    progress();
+    while (mCompletions.size() < static_cast<size_t>(min_compl) && timeout) {
+      auto wait = POLL_INTERVAL;
+      if (timeout > 0) {
+        auto left = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now());
+        if (left.count() <= 0)
+          break;
+        wait = std::min(wait, left);
+      }
+      mCond.wait_for(lk, wait);
+      progress();
+    }
+
+    int count = 0;
+    while (count < max_compl && !mCompletions.empty()) {
+      comps[count++] = mCompletions.front();
+      mCompletions.pop_front();
+    }
+    *actual_compl = count;
+    return (count < min_compl) ? -ETIMEDOUT : 0;
+  }
+}
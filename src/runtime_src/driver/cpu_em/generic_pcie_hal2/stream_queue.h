@@ -0,0 +1,189 @@
+/**
+ * Copyright (C) 2016-2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _SW_EMU_STREAM_QUEUE_H_
+#define _SW_EMU_STREAM_QUEUE_H_
+
+#include "xclhal2.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace xclcpuemhal2 {
+
+  // Single producer, single consumer ring of records in shared memory
+  //
+  // The segment starts with a Header followed by the data area.  Each
+  // record is a Record header and its payload, padded to 8 bytes.  The
+  // producer owns head, the consumer owns tail, both are byte positions
+  // that only grow.  A process attaching to a ring sets its pid as
+  // producer or consumer so that the other side knows it is present.
+  class StreamRing {
+    public:
+      static const uint32_t MAGIC = 0x58535452; // "XSTR"
+      static const uint32_t VERSION = 1;
+      static const uint32_t RECORD_EOT = 0x1;
+
+      struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t size;                            // data area, power of 2
+        alignas(64) std::atomic<uint64_t> head;
+        alignas(64) std::atomic<uint64_t> tail;
+        alignas(64) std::atomic<int32_t> producerPid;
+        std::atomic<int32_t> consumerPid;
+      };
+
+      struct Record {
+        uint32_t len;
+        uint32_t flags;
+      };
+
+      // Create the shared memory segment name, size is rounded up to a
+      // power of 2
+      StreamRing(const std::string& name, size_t size);
+      ~StreamRing();
+
+      bool isGood() const { return mHeader != nullptr; }
+      const std::string& name() const { return mName; }
+      Header* header() { return mHeader; }
+      bool empty() const;
+
+      // Producer side.  Writes one record with as much of len bytes as
+      // fits, len is updated to the number of bytes written.  eot is
+      // set on the record only if all bytes were written.  Returns
+      // false if there is no room for a record.
+      bool write(const char* data, size_t& len, bool eot);
+
+      // Consumer side.  Returns the contiguous bytes of the front
+      // record from the current read offset.  last is set if they end
+      // the record, and eot is the EOT flag of the record.
+      bool peek(const char*& data, size_t& len, bool& last, bool& eot);
+      void consume(size_t len);
+
+    private:
+      void copyIn(uint64_t pos, const char* src, size_t len);
+
+    private:
+      std::string mName;
+      size_t mMapSize;
+      Header* mHeader;
+      char* mData;
+      uint64_t mMask;
+      uint32_t mReadOffset;                       // in the front record
+  };
+
+  // Emulated QDMA stream queues
+  //
+  // Each queue owns a ring in shared memory named
+  //   <prefix>_<w|r>_<route>_<flow>
+  // A write queue is the producer of its ring and a read queue the
+  // consumer of its ring.
+  //
+  // Streams are loopback only.  The records of a write queue are routed
+  // by flow id to the ring of the read queue with the same flow, which
+  // emulates a loopback kernel.  Record boundaries and EOT flags are
+  // kept.  The device process does not attach to the rings, so stream
+  // data never reaches the kernels it runs.  The ring layout and the
+  // producer/consumer pids are what a device side needs to attach; the
+  // routing already backs off when another process owns the far end.
+  //
+  // xclQueueContext::type is the cl_stream_attributes of the stream.
+  // A packet queue (CL_PACKET) completes a read at the end of a packet
+  // and fails it with -EMSGSIZE if the packet does not fit.  A stream
+  // queue completes a read when its buffers are full or at EOT.
+  //
+  // Requests are scatter-gather lists.  Blocking requests wait for
+  // their completion, non-blocking requests return immediately and
+  // their completion is returned by pollCompletion.  The engine makes
+  // progress in the calling threads, waiting threads poll the rings.
+  // Pending requests are kept in per-queue pools and reused.
+  class StreamQueues {
+    public:
+      static const size_t DEFAULT_RING_SIZE = 1 << 20;
+      static const uint32_t CONTEXT_TYPE_PACKET = (1 << 1);
+
+      StreamQueues(const std::string& prefix = "", size_t ringSize = DEFAULT_RING_SIZE);
+      ~StreamQueues();
+
+      int createQueue(const xclQueueContext *q_ctx, bool write, uint64_t *q_hdl);
+      int destroyQueue(uint64_t q_hdl);
+      void* allocBuf(size_t size, uint64_t *buf_hdl);
+      int freeBuf(uint64_t buf_hdl);
+      ssize_t writeQueue(uint64_t q_hdl, const xclQueueRequest *wr);
+      ssize_t readQueue(uint64_t q_hdl, const xclQueueRequest *rd);
+      int pollCompletion(int min_compl, int max_compl, xclReqCompletion *comps, int *actual_compl, int timeout);
+
+      // Shared memory name of the ring of a queue
+      std::string ringName(uint64_t q_hdl);
+      const std::string& prefix() const { return mPrefix; }
+
+    private:
+      struct Request {
+        std::vector<xclWRBuffer> bufs;
+        size_t bufIndex;     // buffer being transferred
+        size_t bufOffset;    // offset in that buffer
+        size_t nbytes;
+        uint32_t flag;
+        void* priv_data;
+        bool done;
+        int err_code;
+      };
+
+      struct Queue {
+        bool write;
+        bool packet;
+        uint64_t route;
+        uint64_t flow;
+        std::unique_ptr<StreamRing> ring;
+        bool dropping;                        // rest of an oversized packet
+        std::deque<Request*> pending;
+        std::vector<std::unique_ptr<Request>> pool;
+        std::vector<Request*> freeList;
+      };
+
+      Request* getRequest(Queue& q, const xclQueueRequest *req);
+      void complete(Queue& q, Request* r, int err_code);
+      bool fillRing(Queue& q);
+      bool routeRing(Queue& q);
+      bool drainRing(Queue& q);
+      void progress();
+      ssize_t submit(Queue& q, const xclQueueRequest *req, std::unique_lock<std::mutex>& lk);
+      Queue* findQueue(uint64_t q_hdl);
+
+    private:
+      std::mutex mMutex;
+      std::condition_variable mCond;
+      std::string mPrefix;
+      size_t mRingSize;
+      int32_t mPid;
+      uint64_t mNextHandle;
+      bool mNonBlocking;
+      std::map<uint64_t, std::unique_ptr<Queue>> mQueues;
+      std::map<uint64_t, Queue*> mReadQueueByFlow;
+      std::map<uint64_t, std::pair<void*, size_t>> mBufs;
+      std::deque<xclReqCompletion> mCompletions;
+  };
+}
+
+#endif
@@ -0,0 +1,350 @@
+/**
+ * Copyright (C) 2016-2017 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "stream_queue.h"
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// % swemtest --run_test=test_stream_queue
+
+using xclcpuemhal2::StreamQueues;
+
+namespace {
+
+static xclQueueRequest
+request(xclWRBuffer* bufs, uint32_t num, uint32_t flag, void* priv_data = nullptr)
+{
+  xclQueueRequest req;
+  std::memset(&req, 0, sizeof(req));
+  req.bufs = bufs;
+  req.buf_num = num;
+  req.flag = flag;
+  req.priv_data = priv_data;
+  return req;
+}
+
+static void
+create_loopback(StreamQueues& sq, uint64_t flow, uint64_t& wq, uint64_t& rq, uint32_t type = 0)
+{
+  xclQueueContext ctx;
+  std::memset(&ctx, 0, sizeof(ctx));
+  ctx.type = type;
+  ctx.flow = flow;
+  BOOST_CHECK_EQUAL(sq.createQueue(&ctx, true, &wq), 0);
+  BOOST_CHECK_EQUAL(sq.createQueue(&ctx, false, &rq), 0);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE ( test_stream_queue )
+
+BOOST_AUTO_TEST_CASE( test_stream_queue_scatter_gather )
+{
+  StreamQueues sq;
+  uint64_t wq, rq;
+  create_loopback(sq, 0, wq, rq);
+
+  char src[3][5] = { "abcd", "efgh", "ijkl" };
+  xclWRBuffer wbufs[3];
+  for (int i = 0; i < 3; ++i)
+    wbufs[i] = xclWRBuffer{ {src[i]}, 4, 0 };
+  auto wr = request(wbufs, 3, XCL_QUEUE_BLOCKING);
+  BOOST_CHECK_EQUAL(sq.writeQueue(wq, &wr), 12);
+
+  // Different split on the read side
+  char dst[12] = {0};
+  xclWRBuffer rbufs[2] = { { {dst} , 7, 0 }, { {dst + 7}, 5, 0 } };
+  auto rd = request(rbufs, 2, XCL_QUEUE_BLOCKING);
+  BOOST_CHECK_EQUAL(sq.readQueue(rq, &rd), 12);
+  BOOST_CHECK(std::memcmp(dst, "abcdefghijkl", 12) == 0);
+
+  BOOST_CHECK_EQUAL(sq.destroyQueue(wq), 0);
+  BOOST_CHECK_EQUAL(sq.destroyQueue(rq), 0);
+}
+
+BOOST_AUTO_TEST_CASE( test_stream_queue_nonblocking )
+{
+  StreamQueues sq;
+  uint64_t wq, rq;
+  create_loopback(sq, 1, wq, rq);
+
+  // Reads posted before the data arrives complete in order
+  char dst[4][8];
+  for (int i = 0; i < 4; ++i) {
+    xclWRBuffer buf = { {dst[i]}, 8, 0 };
+    auto rd = request(&buf, 1, XCL_QUEUE_NONBLOCKING, dst[i]);
+    BOOST_CHECK_EQUAL(sq.readQueue(rq, &rd), 0);
+  }
+
+  xclReqCompletion comps[8];
+  int actual = -1;
+  BOOST_CHECK_EQUAL(sq.pollCompletion(1, 8, comps, &actual, 0), -ETIMEDOUT);
+  BOOST_CHECK_EQUAL(actual, 0);
+
+  char src[32];
+  for (int i = 0; i < 32; ++i)
+    src[i] = i;
+  xclWRBuffer buf = { {src}, 32, 0 };
+  auto wr = request(&buf, 1, XCL_QUEUE_NONBLOCKING, src);
+  BOOST_CHECK_EQUAL(sq.writeQueue(wq, &wr), 0);
+
+  // The write completes once its data is in the ring
+  BOOST_CHECK_EQUAL(sq.pollCompletion(5, 8, comps, &actual, 1000), 0);
+  BOOST_CHECK_EQUAL(actual, 5);
+  BOOST_CHECK_EQUAL(comps[0].priv_data, src);
+  BOOST_CHECK_EQUAL(comps[0].nbytes, 32);
+  for (int i = 0; i < 4; ++i) {
+    BOOST_CHECK_EQUAL(comps[i + 1].priv_data, dst[i]);
+    BOOST_CHECK_EQUAL(comps[i + 1].nbytes, 8);
+    BOOST_CHECK_EQUAL(comps[i + 1].err_code, 0);
+    BOOST_CHECK_EQUAL(dst[i][0], i * 8);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( test_stream_queue_poll_without_requests )
+{
+  StreamQueues sq;
+  uint64_t wq, rq;
+  create_loopback(sq, 5, wq, rq);
+
+  // No non-blocking request yet, so waiting for one is an error
+  xclReqCompletion comps[2];
+  int actual = -1;
+  BOOST_CHECK_EQUAL(sq.pollCompletion(1, 2, comps, &actual, -1), -EINVAL);
+  BOOST_CHECK_EQUAL(actual, 0);
+  BOOST_CHECK_EQUAL(sq.pollCompletion(0, 2, comps, &actual, 0), 0);
+  BOOST_CHECK_EQUAL(actual, 0);
+
+  // Blocking requests have no completion to poll
+  char src[4] = { 1, 2, 3, 4 };
+  char dst[4] = {0};
+  xclWRBuffer wbuf = { {src}, 4, 0 };
+  auto wr = request(&wbuf, 1, XCL_QUEUE_BLOCKING);
+  BOOST_CHECK_EQUAL(sq.writeQueue(wq, &wr), 4);
+  xclWRBuffer rbuf = { {dst}, 4, 0 };
+  auto rd = request(&rbuf, 1, XCL_QUEUE_BLOCKING);
+  BOOST_CHECK_EQUAL(sq.readQueue(rq, &rd), 4);
+  BOOST_CHECK_EQUAL(sq.pollCompletion(1, 2, comps, &actual, 0), -EINVAL);
+
+  // Non-blocking loopback without waiting in poll
+  auto nbrd = request(&rbuf, 1, XCL_QUEUE_NONBLOCKING, dst);
+  BOOST_CHECK_EQUAL(sq.readQueue(rq, &nbrd), 0);
+  BOOST_CHECK_EQUAL(sq.pollCompletion(1, 2, comps, &actual, 0), -ETIMEDOUT);
+  BOOST_CHECK_EQUAL(actual, 0);
+  auto nbwr = request(&wbuf, 1, XCL_QUEUE_NONBLOCKING, src);
+  BOOST_CHECK_EQUAL(sq.writeQueue(wq, &nbwr), 0);
+
+  int total = 0;
+  for (int i = 0; i < 1000 && total < 2; ++i) {
+    BOOST_CHECK_EQUAL(sq.pollCompletion(0, 2 - total, comps + total, &actual, 0), 0);
+    total += actual;
+    if (total < 2)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  BOOST_CHECK_EQUAL(total, 2);
+  BOOST_CHECK_EQUAL(comps[0].priv_data, src);
+  BOOST_CHECK_EQUAL(comps[1].priv_data, dst);
+  BOOST_CHECK_EQUAL(comps[1].nbytes, 4);
+  BOOST_CHECK(std::memcmp(dst, src, 4) == 0);
+
+  BOOST_CHECK_EQUAL(sq.destroyQueue(wq), 0);
+  BOOST_CHECK_EQUAL(sq.destroyQueue(rq), 0);
+}
+
+BOOST_AUTO_TEST_CASE( test_stream_queue_partial_and_cancel )
+{
+  StreamQueues sq;
+  uint64_t wq, rq;
+  create_loopback(sq, 2, wq, rq);
+
+  char src[4] = { 1, 2, 3, 4 };
+  xclWRBuffer wbuf = { {src}, 4, 0 };
+  auto wr = request(&wbuf, 1, XCL_QUEUE_BLOCKING);
+  BOOST_CHECK_EQUAL(sq.writeQueue(wq, &wr), 4);
+
+  char dst[16];
+  xclWRBuffer rbuf = { {dst}, 16, 0 };
+  auto rd = request(&rbuf, 1, XCL_QUEUE_BLOCKING | XCL_QUEUE_PARTIAL);
+  BOOST_CHECK_EQUAL(sq.readQueue(rq, &rd), 4);
+
+  // A pending non-blocking read is cancelled by destroying the queue
+  auto nb = request(&rbuf, 1, XCL_QUEUE_NONBLOCKING, dst);
+  BOOST_CHECK_EQUAL(sq.readQueue(rq, &nb), 0);
+  BOOST_CHECK_EQUAL(sq.destroyQueue(rq), 0);
+
+  xclReqCompletion comp;
+  int actual = 0;
+  BOOST_CHECK_EQUAL(sq.pollCompletion(1, 1, &comp, &actual, 0), 0);
+  BOOST_CHECK_EQUAL(comp.err_code, -ECANCELED);
+  BOOST_CHECK_EQUAL(sq.readQueue(rq, &rd), -EINVAL);
+}
+
+BOOST_AUTO_TEST_CASE( test_stream_queue_packets )
+{
+  StreamQueues sq;
+  uint64_t wq, rq;
+  create_loopback(sq, 4, wq, rq, StreamQueues::CONTEXT_TYPE_PACKET);
+
+  // A packet written in two requests, EOT on the second
+  char src[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  xclWRBuffer w1 = { {src}, 6, 0 };
+  xclWRBuffer w2 = { {src + 6}, 4, 0 };
+  auto wr1 = request(&w1, 1, XCL_QUEUE_BLOCKING);
+  auto wr2 = request(&w2, 1, XCL_QUEUE_BLOCKING | XCL_QUEUE_EOT);
+  BOOST_CHECK_EQUAL(sq.writeQueue(wq, &wr1), 6);
+  BOOST_CHECK_EQUAL(sq.writeQueue(wq, &wr2), 4);
+
+  // Read completes at the end of the packet
+  char dst[64];
+  xclWRBuffer rbuf = { {dst}, sizeof(dst), 0 };
+  auto rd = request(&rbuf, 1, XCL_QUEUE_BLOCKING);
+  BOOST_CHECK_EQUAL(sq.readQueue(rq, &rd), 10);
+  BOOST_CHECK(std::memcmp(dst, src, 10) == 0);
+
+  // A packet larger than the read buffers fails and is dropped
+  auto big = request(&w1, 1, XCL_QUEUE_BLOCKING | XCL_QUEUE_EOT);
+  BOOST_CHECK_EQUAL(sq.writeQueue(wq, &big), 6);
+  BOOST_CHECK_EQUAL(sq.writeQueue(wq, &wr2), 4);
+  xclWRBuffer small = { {dst}, 4, 0 };
+  auto rds = request(&small, 1, XCL_QUEUE_BLOCKING);
+  BOOST_CHECK_EQUAL(sq.readQueue(rq, &rds), -EMSGSIZE);
+  BOOST_CHECK_EQUAL(sq.readQueue(rq, &rds), 4);
+  BOOST_CHECK(std::memcmp(dst, src + 6, 4) == 0);
+}
+
+BOOST_AUTO_TEST_CASE( test_stream_queue_shm_rings )
+{
+  std::string prefix = "/xrt_swemu_test_" + std::to_string(getpid());
+  StreamQueues sq(prefix, 4096);
+  xclQueueContext ctx;
+  std::memset(&ctx, 0, sizeof(ctx));
+  ctx.route = 2;
+  ctx.flow = 5;
+  uint64_t wq, rq, wq2;
+  BOOST_CHECK_EQUAL(sq.createQueue(&ctx, true, &wq), 0);
+  BOOST_CHECK_EQUAL(sq.createQueue(&ctx, false, &rq), 0);
+  BOOST_CHECK_EQUAL(sq.ringName(wq), prefix + "_w_2_5");
+  BOOST_CHECK_EQUAL(sq.createQueue(&ctx, true, &wq2), -EEXIST);
+
+  // Attach to the write ring as the device process would
+  int fd = shm_open(sq.ringName(wq).c_str(), O_RDWR, 0);
+  BOOST_REQUIRE(fd >= 0);
+  struct stat st;
+  fstat(fd, &st);
+  void* addr = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  BOOST_REQUIRE(addr != MAP_FAILED);
+  auto header = static_cast<xclcpuemhal2::StreamRing::Header*>(addr);
+  BOOST_CHECK_EQUAL(header->magic, xclcpuemhal2::StreamRing::MAGIC);
+  BOOST_CHECK_EQUAL(header->producerPid.load(), getpid());
+
+  // With a device consumer attached nothing is looped back, and the
+  // ring fills up after 4096 bytes
+  header->consumerPid.store(getpid() + 1);
+  std::vector<char> src(1024, 'a');
+  xclWRBuffer wbuf = { {src.data()}, src.size(), 0 };
+  auto wr = request(&wbuf, 1, XCL_QUEUE_NONBLOCKING);
+  for (int i = 0; i < 4; ++i)
+    BOOST_CHECK_EQUAL(sq.writeQueue(wq, &wr), 0);
+  xclReqCompletion comps[4];
+  int actual = 0;
+  BOOST_CHECK_EQUAL(sq.pollCompletion(4, 4, comps, &actual, 10), -ETIMEDOUT);
+  BOOST_CHECK_EQUAL(actual, 3);
+  BOOST_CHECK(header->head.load() > header->tail.load());
+
+  // Consume as the device would, the last write completes
+  header->tail.store(header->head.load());
+  BOOST_CHECK_EQUAL(sq.pollCompletion(1, 4, comps, &actual, 1000), 0);
+  BOOST_CHECK_EQUAL(actual, 1);
+
+  munmap(addr, st.st_size);
+  BOOST_CHECK_EQUAL(sq.destroyQueue(wq), 0);
+  BOOST_CHECK_EQUAL(sq.destroyQueue(rq), 0);
+  BOOST_CHECK(shm_open((prefix + "_w_2_5").c_str(), O_RDWR, 0) < 0);
+}
+
+// Packets/s through the loopback with a writer thread and a reader
+// keeping a window of non-blocking reads in flight
+static void
+loopback_bw(size_t pkt_size, int packets)
+{
+  const int window = 64;
+
+  StreamQueues sq;
+  uint64_t wq, rq;
+  create_loopback(sq, 3, wq, rq, StreamQueues::CONTEXT_TYPE_PACKET);
+
+  std::vector<char> rdata(window * pkt_size);
+  std::vector<xclWRBuffer> rbufs(window);
+  for (int i = 0; i < window; ++i)
+    rbufs[i] = xclWRBuffer{ {rdata.data() + i * pkt_size}, pkt_size, 0 };
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread writer([&] {
+    std::vector<char> wdata(pkt_size, 'x');
+    xclWRBuffer wbuf = { {wdata.data()}, pkt_size, 0 };
+    auto wr = request(&wbuf, 1, XCL_QUEUE_BLOCKING | XCL_QUEUE_EOT);
+    for (int i = 0; i < packets; ++i)
+      sq.writeQueue(wq, &wr);
+  });
+
+  int posted = 0, completed = 0;
+  for (; posted < window; ++posted) {
+    auto rd = request(&rbufs[posted], 1, XCL_QUEUE_NONBLOCKING, &rbufs[posted]);
+    sq.readQueue(rq, &rd);
+  }
+
+  std::vector<xclReqCompletion> comps(window);
+  while (completed < packets) {
+    int actual = 0;
+    sq.pollCompletion(1, window, comps.data(), &actual, -1);
+    for (int i = 0; i < actual; ++i) {
+      BOOST_CHECK_EQUAL(comps[i].nbytes, pkt_size);
+      BOOST_CHECK_EQUAL(comps[i].err_code, 0);
+      ++completed;
+      if (posted < packets) {
+        auto rd = request(static_cast<xclWRBuffer*>(comps[i].priv_data), 1, XCL_QUEUE_NONBLOCKING, comps[i].priv_data);
+        sq.readQueue(rq, &rd);
+        ++posted;
+      }
+    }
+  }
+  writer.join();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  std::cout << "loopback " << pkt_size << " byte packets: "
+            << packets / elapsed.count() << " packets/s, "
+            << packets * pkt_size / elapsed.count() / 1.0e6 << " MB/s\n";
+}
+
+BOOST_AUTO_TEST_CASE( test_stream_queue_loopback_bw )
+{
+  loopback_bw(64, 200000);
+  loopback_bw(256, 200000);
+  loopback_bw(1500, 100000);
+  loopback_bw(9000, 20000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
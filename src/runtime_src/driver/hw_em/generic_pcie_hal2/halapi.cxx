@@ -134,6 +134,14 @@ int xclExecBuf(xclDeviceHandle handle, unsigned int cmdBO)
   return drv->xclExecBuf(cmdBO);
 }
 
+int xclExecBufWithWaitList(xclDeviceHandle handle, unsigned int cmdBO, size_t num_bo_in_wait_list, unsigned int *bo_wait_list)
+{
+  xclhwemhal2::HwEmShim *drv = xclhwemhal2::HwEmShim::handleCheck(handle);
+  if (!drv)
+    return -1;
+  return drv->xclExecBuf(cmdBO, num_bo_in_wait_list, bo_wait_list);
+}
+
 int xclRegisterEventNotify(xclDeviceHandle handle, unsigned int userInterrupt, int fd)
 {
   xclhwemhal2::HwEmShim *drv = xclhwemhal2::HwEmShim::handleCheck(handle);
@@ -317,6 +325,14 @@ int xclGetDeviceInfo2(xclDeviceHandle handle, xclDeviceInfo2 *info)
   return drv->xclGetDeviceInfo2(info);
 }
 
+int xclGetUsageInfo(xclDeviceHandle handle, xclDeviceUsage *info)
+{
+  xclhwemhal2::HwEmShim *drv = xclhwemhal2::HwEmShim::handleCheck(handle);
+  if (!drv)
+    return -1;
+  return drv->xclGetUsageInfo(info);
+}
+
 unsigned int xclVersion ()
 {
   return 2;
@@ -1,5 +1,8 @@
-#include "shim.h"
+#include "mbscheduler.h"
 #include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <unistd.h>
 //#define EM_DEBUG_KDS
 namespace xclhwemhal2 {
 
@@ -9,7 +12,11 @@ namespace xclhwemhal2 {
     exec = NULL;
     cu_idx = 0;
     slot_idx = 0;
+    wait_count = 0;
+    chain_count = 0;
     packet = NULL;
+    next = NULL;
+    prev = NULL;
     state = ERT_CMD_STATE_NEW;
   }
 
@@ -67,6 +74,9 @@ namespace xclhwemhal2 {
     for (unsigned i=0; i<MAX_U32_SLOT_MASKS; ++i)
       slot_status[i] = 0;
 
+    for (unsigned i=0; i<MAX_U32_SLOT_MASKS; ++i)
+      queried_pass[i] = 0;
+
     for(unsigned i=0; i <MAX_SLOTS; ++i)
       submitted_cmds[i] = NULL;
       
@@ -82,15 +92,25 @@ namespace xclhwemhal2 {
   {
   }
 
+  static void delete_cmds(xocl_cmd_queue& queue)
+  {
+    while (xocl_cmd* xcmd = queue.pop_front())
+      delete xcmd;
+  }
+
   MBScheduler::MBScheduler(HwEmShim* _parent)
   {
     mParent = _parent;
     mScheduler = new xocl_sched(this);
     num_pending = 0;
+    query_pass = 0;
+    chain_started = false;
+    num_completed = 0;
   }
 
   MBScheduler::~MBScheduler()
   {
+    delete_cmds(free_cmds);
     delete mScheduler;
     mScheduler = NULL;
     num_pending = 0;
@@ -113,8 +133,15 @@ namespace xclhwemhal2 {
       bool waitForResp = false;
       if (opcode(xcmd)==ERT_CONFIGURE)
         waitForResp = true;
+
+      /* The status register is clear on read and was already read in
+         this pass, completions it reported have been processed */
+      if (!waitForResp && exec->queried_pass[cmd_mask_idx]==query_pass)
+        return;
+      exec->queried_pass[cmd_mask_idx] = query_pass;
+
       do{
-        mParent->xclRead(XCL_ADDR_KERNEL_CTRL, xcmd->exec->base + csr_addr, (void*)&mask, 4);
+        read_ctrl(xcmd->exec->base + csr_addr, (void*)&mask, 4);
       }while(waitForResp && !mask);
       
       if (mask)
@@ -161,11 +188,11 @@ namespace xclhwemhal2 {
     slot_addr = ERT_CQ_BASE_ADDR + xcmd->slot_idx*slot_size(xcmd->exec);
 
     /* TODO write packet minus header */
-    mParent->xclWrite(XCL_ADDR_KERNEL_CTRL, xcmd->exec->base + slot_addr + 4, xcmd->packet->data,(packet_size(xcmd)-1)*sizeof(uint32_t)); 
+    write_ctrl(xcmd->exec->base + slot_addr + 4, xcmd->packet->data,(packet_size(xcmd)-1)*sizeof(uint32_t)); 
     //memcpy_toio(xcmd->exec->base + slot_addr + 4,xcmd->packet->data,(packet_size(xcmd)-1)*sizeof(uint32_t));
 
     /* TODO write header */
-    mParent->xclWrite(XCL_ADDR_KERNEL_CTRL, xcmd->exec->base + slot_addr, (void*)(&xcmd->packet->header) ,4); 
+    write_ctrl(xcmd->exec->base + slot_addr, (void*)(&xcmd->packet->header) ,4); 
     //iowrite32(xcmd->packet->header,xcmd->exec->base + slot_addr);
 
     /* trigger interrupt to embedded scheduler if feature is enabled */
@@ -173,7 +200,7 @@ namespace xclhwemhal2 {
       uint32_t cq_int_addr = ERT_CQ_STATUS_REGISTER_ADDR + (slot_mask_idx(xcmd->slot_idx)<<2);
       uint32_t mask = 1<<slot_idx_in_mask(xcmd->slot_idx);
       //TODO 
-      mParent->xclWrite(XCL_ADDR_KERNEL_CTRL,xcmd->exec->base + cq_int_addr, (void*)(&mask) ,4);
+      write_ctrl(xcmd->exec->base + cq_int_addr, (void*)(&mask) ,4);
         //iowrite32(mask,xcmd->exec->base + cq_int_addr);
     }
 #ifdef EM_DEBUG_KDS
@@ -190,6 +217,9 @@ namespace xclhwemhal2 {
 
     cfg = (struct ert_configure_cmd *)(xcmd->packet);
 
+    /* CU addresses are passed to the emulated ERT as is, it handles the
+       CU control protocol in bits [1:0] (ERT_CU_CTRL_CHAIN) and restarts
+       chained CUs with AP_CONTINUE.  This scheduler never starts CUs. */
     if (exec->configured==0) 
     {
       exec->base = 0;
@@ -233,6 +263,13 @@ namespace xclhwemhal2 {
       client_ctx* entry = it;
       entry->trigger++;
     }
+
+    /* wake up threads blocked in wait_for_completion */
+    {
+      std::lock_guard<std::mutex> lk(completion_mutex);
+      ++num_completed;
+    }
+    completion_cond.notify_all();
   }
 
   void MBScheduler::mark_cmd_complete(xocl_cmd *xcmd)
@@ -247,6 +284,7 @@ namespace xclhwemhal2 {
     std::cout<<"Releasing slot " << xcmd->slot_idx << std::endl<<std::endl;
 #endif
     notify_host(xcmd);
+    trigger_chain(xcmd);
   }
 
   void MBScheduler::mark_mask_complete(exec_core *exec, uint32_t mask, unsigned int mask_idx)
@@ -254,24 +292,68 @@ namespace xclhwemhal2 {
 #ifdef EM_DEBUG_KDS
     std::cout<<"Marking some commands complete" << std::endl;
 #endif
-    int bit_idx=0,cmd_idx=0;
-    if (!mask)
-      return;
-    for (bit_idx=0, cmd_idx=mask_idx<<5; bit_idx<32; mask>>=1,++bit_idx,++cmd_idx)
+    int bit_idx=0;
+    while ((bit_idx = ffs_or_neg_one(mask)) >= 0)
     {
-      if (mask & 0x1)
+      mask &= mask-1;
+      unsigned int cmd_idx = slot_idx_from_mask_idx(bit_idx,mask_idx);
+      if(exec->submitted_cmds[cmd_idx])
       {
-        if(exec->submitted_cmds[cmd_idx])
-        {
-          mark_cmd_complete(exec->submitted_cmds[cmd_idx]);
-        }
+        mark_cmd_complete(exec->submitted_cmds[cmd_idx]);
       }
     }
   }
 
+  /* Chain argument command to the active commands it depends on so
+     that it is triggered when they complete.  The wait_count is reduced
+     to the number of dependencies that are still active.  Returns 1 if
+     a dependency cannot chain more commands */
+  int MBScheduler::chain_dependencies(xocl_cmd *xcmd)
+  {
+    xocl_cmd* chain_to[MAX_DEPS];
+    unsigned int dcount = xcmd->wait_count;
+    unsigned int count = 0;
+    for (unsigned int didx=0; didx<dcount; ++didx)
+    {
+      xclemulation::drm_xocl_bo *dbo = xcmd->deps[didx];
+      xocl_cmd *dep = mScheduler->command_queue.front();
+      for (; dep; dep = dep->next)
+        if (dep->bo==dbo && dep->state<ERT_CMD_STATE_COMPLETED)
+          break;
+      if (!dep) /* command may have completed already */
+        continue;
+      unsigned int chained = dep->chain_count;
+      for (unsigned int i=0; i<count; ++i)
+        chained += (chain_to[i]==dep);
+      if (chained>=MAX_DEPS)
+        return 1;
+      chain_to[count++] = dep;
+    }
+
+    xcmd->wait_count = count;
+    for (unsigned int i=0; i<count; ++i)
+      chain_to[i]->chain[chain_to[i]->chain_count++] = xcmd;
+    return 0;
+  }
+
+  /* Trigger the commands chained to argument completed command, a
+     chained command is started when its last dependency completes */
+  void MBScheduler::trigger_chain(xocl_cmd *xcmd)
+  {
+    while (xcmd->chain_count)
+    {
+      xocl_cmd *trigger = xcmd->chain[--xcmd->chain_count];
+      if (--trigger->wait_count==0 && queued_to_running(trigger))
+        chain_started = true;
+    }
+  }
+
   int MBScheduler::queued_to_running(xocl_cmd *xcmd)
   {
     int retval = false;
+
+    if (xcmd->wait_count)
+      return false;
     if (opcode(xcmd)==ERT_CONFIGURE)
     {
 #ifdef EM_DEBUG_KDS
@@ -296,21 +378,42 @@ namespace xclhwemhal2 {
     mb_query(xcmd);
   }
 
+  void MBScheduler::complete_to_free(xocl_cmd *xcmd)
+  {
+    xcmd->bo = NULL;
+    xcmd->exec = NULL;
+    xcmd->packet = NULL;
+    std::lock_guard<std::mutex> lk(free_cmds_mutex);
+    free_cmds.push_back(xcmd);
+  }
+
   xocl_cmd* MBScheduler::get_free_xocl_cmd(void)
   {
+    {
+      std::lock_guard<std::mutex> lk(free_cmds_mutex);
+      if (xocl_cmd* cmd = free_cmds.pop_front())
+        return cmd;
+    }
     xocl_cmd* cmd = new xocl_cmd;
     return cmd;
   } 
   
-  int MBScheduler::add_cmd(exec_core *exec, xclemulation::drm_xocl_bo* bo)
+  int MBScheduler::add_cmd(exec_core *exec, xclemulation::drm_xocl_bo* bo, int numdeps, xclemulation::drm_xocl_bo** deps)
   {
-    std::lock_guard<std::mutex> lk(pending_cmds_mutex);
+    if (numdeps<0 || numdeps>MAX_DEPS)
+      return -1;
+
+    std::unique_lock<std::mutex> lk(pending_cmds_mutex);
     xocl_cmd *xcmd = get_free_xocl_cmd();
     xcmd->packet = (struct ert_packet*)bo->buf;
     xcmd->bo=bo;
     xcmd->exec=exec;
     xcmd->cu_idx=-1;
     xcmd->slot_idx=-1;
+    /* dependencies are chained when the command is queued */
+    std::copy(deps,deps+numdeps,xcmd->deps);
+    xcmd->wait_count=numdeps;
+    xcmd->chain_count=0;
 #ifdef EM_DEBUG_KDS
     std::cout<<"adding a command CMD: " <<xcmd<<" PACKET: "<<xcmd->packet<< " BO: "<< xcmd->bo <<" BASE: "<<xcmd->bo->base<< std::endl;
 #endif
@@ -318,6 +421,7 @@ namespace xclhwemhal2 {
     set_cmd_state(xcmd,ERT_CMD_STATE_NEW);
     pending_cmds.push_back(xcmd);
     num_pending++;
+    lk.unlock();
     scheduler_wait_condition();
     return 0;
   }
@@ -326,6 +430,7 @@ namespace xclhwemhal2 {
   
   int MBScheduler::scheduler_wait_condition()
   {
+    pthread_mutex_lock(&mScheduler->state_lock);
     bool bSchComeOutOfCond = false;
     if (mScheduler->stop || mScheduler->error) {
       bSchComeOutOfCond = true;
@@ -346,8 +451,10 @@ namespace xclhwemhal2 {
     if(bSchComeOutOfCond)
     {
       pthread_cond_signal(&mScheduler->state_cond);
+      pthread_mutex_unlock(&mScheduler->state_lock);
       return 0;
     }
+    pthread_mutex_unlock(&mScheduler->state_lock);
     return 1;
   }
 
@@ -359,29 +466,39 @@ namespace xclhwemhal2 {
 #ifdef EM_DEBUG_KDS
     std::cout<<"Iterating on pending commands and adding to Scheduler command_queue  "<< std::endl;
 #endif
-    for(auto it: pending_cmds)
+    /* queue in order of submission, a command can depend only on
+       commands submitted before it */
+    num_pending -= pending_cmds.size();
+    while (xocl_cmd *xcmd = pending_cmds.pop_front())
     {
-      xocl_cmd *xcmd = it;
+      if (xcmd->wait_count && chain_dependencies(xcmd))
+      {
+        std::cout << "MBScheduler: command dependency chain exceeds " << MAX_DEPS << std::endl;
+        set_cmd_state(xcmd,ERT_CMD_STATE_ERROR);
+        notify_host(xcmd);
+      }
+      else
+        xcmd->state = ERT_CMD_STATE_QUEUED;
       mScheduler->command_queue.push_back(xcmd);
-      xcmd->state = ERT_CMD_STATE_QUEUED;
 #ifdef EM_DEBUG_KDS
     std::cout<<xcmd <<" ADDED to Scheduler command_queue  "<< std::endl;
 #endif
-      num_pending--;
     }
-    pending_cmds.clear();
   }
 
   void MBScheduler::scheduler_iterate_cmds()
   {
-     auto end = mScheduler->command_queue.end();
+     ++query_pass;
+     chain_started = false;
 #ifdef EM_DEBUG_KDS
      //if(mScheduler->command_queue.size() > 0)
      //  std::cout<<" command_queue size is "<<mScheduler->command_queue.size()<< std::endl;
 #endif
-     for (auto itr=mScheduler->command_queue.begin(); itr!=end; ) 
+     /* submit queued commands first, so that the status registers
+        read below also cover the commands started in this pass */
+     xocl_cmd *xcmd = mScheduler->command_queue.front();
+     for (; xcmd; xcmd = xcmd->next)
      {
-       xocl_cmd *xcmd = *itr;
        if (xcmd->state == ERT_CMD_STATE_QUEUED)
        {
 #ifdef EM_DEBUG_KDS
@@ -389,22 +506,27 @@ namespace xclhwemhal2 {
 #endif
          queued_to_running(xcmd);
        }
+     }
+
+     xcmd = mScheduler->command_queue.front();
+     while (xcmd) 
+     {
        if (xcmd->state == ERT_CMD_STATE_RUNNING)
        {
          running_to_complete(xcmd);
        }
        
-       if (xcmd->state == ERT_CMD_STATE_COMPLETED)
+       if (xcmd->state >= ERT_CMD_STATE_COMPLETED)
        {
 #ifdef EM_DEBUG_KDS
          std::cout<<xcmd << " is in COMPLETED state  "<< std::endl;
 #endif
+         xocl_cmd *next = mScheduler->command_queue.erase(xcmd);
          complete_to_free(xcmd);
-         itr = mScheduler->command_queue.erase(itr);
-         end = mScheduler->command_queue.end();
+         xcmd = next;
        }
        else {
-         ++itr;
+         xcmd = xcmd->next;
        }
      }
 
@@ -413,24 +535,40 @@ namespace xclhwemhal2 {
   void scheduler_loop(xocl_sched *xs)
   {
     MBScheduler* pSch = xs->pSch;
-    std::lock_guard<std::mutex> lk(pSch->pending_cmds_mutex);
 
     if (xs->error) { return; }
 
     /* queue new pending commands */
-    pSch->scheduler_queue_cmds();
+    {
+      std::lock_guard<std::mutex> lk(pSch->pending_cmds_mutex);
+      pSch->scheduler_queue_cmds();
+    }
 
-    /* iterate all commands */
+    /* iterate all commands, command_queue is owned by the scheduler
+       thread so commands can be added while it is iterated */
     pSch->scheduler_iterate_cmds();
   }
 
   void* scheduler(void* data)
   {
     xocl_sched *xs = (xocl_sched *)data;
+    MBScheduler* pSch = xs->pSch;
     while (!xs->stop && !xs->error)
     {
+      /* Sleep while there is no command to process. Running commands
+         are polled since the emulator reports completion only through
+         the ERT status registers */
+      pthread_mutex_lock(&xs->state_lock);
+      while (!xs->stop && !xs->error && pSch->num_pending==0 && xs->command_queue.empty())
+        pthread_cond_wait(&xs->state_cond,&xs->state_lock);
+      pthread_mutex_unlock(&xs->state_lock);
+
       scheduler_loop(xs);
-      usleep(10);
+
+      /* Commands started by completion of their dependencies are
+         checked in the next pass without delay */
+      if (xs->poll > 0 && !pSch->chain_started)
+        usleep(10);
     }
     return NULL;
   }
@@ -466,21 +604,43 @@ namespace xclhwemhal2 {
     std::cout<<"Scheduler Thread ended "<< std::endl;
 #endif
 
+    pthread_mutex_lock(&mScheduler->state_lock);
     mScheduler->stop= true;
+    pthread_mutex_unlock(&mScheduler->state_lock);
     scheduler_wait_condition();
     mScheduler->bThreadCreated = false;
 
     int retval = pthread_join(mScheduler->scheduler_thread,NULL);
 
-    pending_cmds.clear();
-    mScheduler->command_queue.clear();
-    free_cmds.clear();
+    delete_cmds(pending_cmds);
+    num_pending = 0;
+    delete_cmds(mScheduler->command_queue);
+    std::lock_guard<std::mutex> lk(free_cmds_mutex);
+    delete_cmds(free_cmds);
 
     return retval;
   } 
 
   int MBScheduler::add_exec_buffer(exec_core* exec, xclemulation::drm_xocl_bo *buf)
   {
-    return add_cmd(exec, buf);
+    return add_cmd(exec, buf, 0, NULL);
+  }
+
+  int MBScheduler::add_exec_buffer(exec_core* exec, xclemulation::drm_xocl_bo *buf, int numdeps, xclemulation::drm_xocl_bo **deps)
+  {
+    return add_cmd(exec, buf, numdeps, deps);
+  }
+
+  int MBScheduler::wait_for_completion(int timeoutMilliSec)
+  {
+    std::unique_lock<std::mutex> lk(completion_mutex);
+    uint64_t& seen = completed_seen[std::this_thread::get_id()];
+    if (seen == num_completed)
+      completion_cond.wait_for(lk, std::chrono::milliseconds(timeoutMilliSec),
+                               [this,&seen] { return seen != num_completed; });
+    if (seen == num_completed)
+      return 0;
+    seen = num_completed;
+    return 1;
   }
 }
@@ -2,10 +2,15 @@
 #define _MB_SCHEDULER_H_
 
 #include <list>
+#include <map>
 #include <mutex>
-#include <math.h>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <pthread.h>
 #include <stdint.h>
 #include "ert.h"
+#include "em_defines.h"
 
 #define XOCL_U32_MASK 0xFFFFFFFF
 
@@ -13,6 +18,7 @@
 #define MAX_CUS		128
 #define MAX_U32_SLOT_MASKS (((MAX_SLOTS-1)>>5) + 1)
 #define MAX_U32_CU_MASKS (((MAX_CUS-1)>>5) + 1)
+#define MAX_DEPS	ERT_MAX_WAIT_LIST
 
 namespace xclhwemhal2 {
   class HwEmShim;
@@ -26,13 +32,104 @@ namespace xclhwemhal2 {
     std::mutex mLock;
   };
   
+  class xocl_cmd
+  {
+    public:
+      xclemulation::drm_xocl_bo *bo;
+      exec_core *exec;
+      enum ert_cmd_state state;
+      int cu_idx;
+      int slot_idx;
+      /* Dependency handling, same as kernel driver.  wait_count is the
+         number of commands that must complete before this command can
+         start, chain lists the commands to trigger upon completion.
+         The deps are converted to chain when the command is queued */
+      unsigned int wait_count;
+      unsigned int chain_count;
+      union {
+        xocl_cmd* chain[MAX_DEPS];
+        xclemulation::drm_xocl_bo* deps[MAX_DEPS];
+      };
+      /* The actual cmd object representation */
+      struct ert_packet *packet;
+      /* Links in the xocl_cmd_queue holding the command */
+      xocl_cmd* next;
+      xocl_cmd* prev;
+      xocl_cmd();
+      ~xocl_cmd();
+  };
+
+  /* Intrusive doubly linked list of commands. Commands are linked
+     through their own next/prev members, so queueing never allocates */
+  class xocl_cmd_queue
+  {
+    public:
+      xocl_cmd_queue() : head(NULL), tail(NULL), count(0) {}
+      bool empty() const { return head == NULL; }
+      unsigned int size() const { return count; }
+      xocl_cmd* front() const { return head; }
+      void push_back(xocl_cmd* xcmd)
+      {
+        xcmd->next = NULL;
+        xcmd->prev = tail;
+        if (tail)
+          tail->next = xcmd;
+        else
+          head = xcmd;
+        tail = xcmd;
+        ++count;
+      }
+      /* Unlink xcmd, returns the command that followed it */
+      xocl_cmd* erase(xocl_cmd* xcmd)
+      {
+        xocl_cmd* next = xcmd->next;
+        if (xcmd->prev)
+          xcmd->prev->next = next;
+        else
+          head = next;
+        if (next)
+          next->prev = xcmd->prev;
+        else
+          tail = xcmd->prev;
+        xcmd->next = xcmd->prev = NULL;
+        --count;
+        return next;
+      }
+      xocl_cmd* pop_front()
+      {
+        xocl_cmd* xcmd = head;
+        if (xcmd)
+          erase(xcmd);
+        return xcmd;
+      }
+      /* Move all commands of other to the end of this queue */
+      void splice(xocl_cmd_queue& other)
+      {
+        if (other.empty())
+          return;
+        other.head->prev = tail;
+        if (tail)
+          tail->next = other.head;
+        else
+          head = other.head;
+        tail = other.tail;
+        count += other.count;
+        other.head = other.tail = NULL;
+        other.count = 0;
+      }
+    private:
+      xocl_cmd* head;
+      xocl_cmd* tail;
+      unsigned int count;
+  };
+
   class xocl_sched
   {
     public:
       pthread_t                   scheduler_thread;
       pthread_mutex_t             state_lock;
       pthread_cond_t              state_cond;
-      std::list<xocl_cmd*>        command_queue;
+      xocl_cmd_queue              command_queue;
       bool                        bThreadCreated;
       unsigned int                error;
       int                         intc;
@@ -43,20 +140,6 @@ namespace xclhwemhal2 {
       ~xocl_sched();
   };
   
-  class xocl_cmd
-  {
-    public:
-      xclemulation::drm_xocl_bo *bo;
-      exec_core *exec;
-      enum ert_cmd_state state;
-      int cu_idx;
-      int slot_idx;
-      /* The actual cmd object representation */
-      struct ert_packet *packet;
-      xocl_cmd();
-      ~xocl_cmd();
-  };
-
   class exec_core 
   {
     public:
@@ -87,6 +170,10 @@ namespace xclhwemhal2 {
     uint32_t                        cu_status[MAX_U32_CU_MASKS];
     unsigned int               num_cu_masks; /* ((num_cus-1)>>5+1 */
 
+    /* Scheduler pass in which each status register was last read,
+       the registers are clear on read so one read per pass is enough */
+    unsigned int               queried_pass[MAX_U32_SLOT_MASKS];
+
     /* Status register pending complete.  Written by ISR, cleared
        by scheduler */
     int                   sr0;
@@ -102,11 +189,15 @@ namespace xclhwemhal2 {
     void set_cmd_int_state(xocl_cmd* xcmd, enum ert_cmd_state state) { xcmd->state = state; }
     void set_cmd_state(xocl_cmd* xcmd, enum ert_cmd_state state) { xcmd->state = state; xcmd->packet->state = state; }
     bool is_ert(exec_core *exec) { return true; }
-    int ffz(uint32_t mask) { return( log2( ~mask & (mask+1) )); }
+    int ffz(uint32_t mask) { return __builtin_ctz(~mask); }
     int ffz_or_neg_one(uint32_t mask){
       if (mask==XOCL_U32_MASK) return -1;
       return ffz(mask);
     }
+    int ffs_or_neg_one(uint32_t mask){
+      if (!mask) return -1;
+      return __builtin_ctz(mask);
+    }
     
     unsigned int slot_size(exec_core *exec)   { return ERT_CQ_SIZE / exec->num_slots; }
     unsigned int cu_mask_idx(unsigned int cu_idx)    { return cu_idx >> 5; /* 32 cus per mask */ }
@@ -126,11 +217,13 @@ namespace xclhwemhal2 {
     void notify_host(xocl_cmd *xcmd);
     void mark_cmd_complete(xocl_cmd *xcmd);
     void mark_mask_complete(exec_core *exec, uint32_t mask, unsigned int mask_idx);
+    int chain_dependencies(xocl_cmd *xcmd) ;
+    void trigger_chain(xocl_cmd *xcmd) ;
     int queued_to_running(xocl_cmd *xcmd) ;
     void running_to_complete(xocl_cmd *xcmd) ;
-    void complete_to_free(xocl_cmd *xcmd) { }
+    void complete_to_free(xocl_cmd *xcmd) ;
     xocl_cmd* get_free_xocl_cmd(void) ; 
-    int add_cmd(exec_core *exec, xclemulation::drm_xocl_bo* bo) ;
+    int add_cmd(exec_core *exec, xclemulation::drm_xocl_bo* bo, int numdeps, xclemulation::drm_xocl_bo** deps) ;
     int scheduler_wait_condition() ;
     void scheduler_queue_cmds();
     void scheduler_iterate_cmds();
@@ -141,20 +234,41 @@ namespace xclhwemhal2 {
     int init_scheduler_thread(void) ;
     int fini_scheduler_thread(void) ;
     int add_exec_buffer(exec_core *eCore , xclemulation::drm_xocl_bo *buf) ;
+    /* The commands of the BOs in deps must complete before buf is
+       started, the BOs must have been added prior to buf */
+    int add_exec_buffer(exec_core *eCore , xclemulation::drm_xocl_bo *buf, int numdeps, xclemulation::drm_xocl_bo **deps) ;
+    /* Block until a command completes or timeout, returns 1 if any
+       command completed since the calling thread last waited */
+    int wait_for_completion(int timeoutMilliSec) ;
+
+    /* ERT register access, implemented by HwEmShim */
+    void read_ctrl(uint64_t offset, void* buf, size_t size) ;
+    void write_ctrl(uint64_t offset, const void* buf, size_t size) ;
 
     xocl_sched* mScheduler;
     MBScheduler(HwEmShim* _parent);
     ~MBScheduler();
     HwEmShim* mParent;
     private:
-    std::list<xocl_cmd*> free_cmds;
+    xocl_cmd_queue free_cmds;
     std::mutex free_cmds_mutex;
     
-    std::list<xocl_cmd*> pending_cmds;
+    xocl_cmd_queue pending_cmds;
     std::mutex pending_cmds_mutex;
     
     std::mutex m_add_cmd_mutex;
-    int num_pending;
+    std::atomic<int> num_pending;
+
+    unsigned int query_pass;
+
+    /* A chained command was started in the current pass */
+    bool chain_started;
+
+    /* Completion notification for wait_for_completion */
+    std::mutex completion_mutex;
+    std::condition_variable completion_cond;
+    uint64_t num_completed;
+    std::map<std::thread::id, uint64_t> completed_seen;
   };
 }
 
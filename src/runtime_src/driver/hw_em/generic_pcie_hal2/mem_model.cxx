@@ -15,16 +15,67 @@
  */
 
 #include "mem_model.h"
+#include "config.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+
+static bool writeAll(int fd, const unsigned char* buf, uint64_t size, uint64_t offset)
+{
+  while(size > 0)
+  {
+    ssize_t written = pwrite(fd, buf, size, offset);
+    if(written <= 0)
+      return false;
+    buf += written;
+    offset += written;
+    size -= written;
+  }
+  return true;
+}
 
 mem_model::~ mem_model()
 {
   serialize();
+  if(!mSnapshot.empty() && !mSnapshotRestored)
+    saveSnapshot(mSnapshot);
+  if(mBase)
+    munmap(mBase, MEM_MODEL_RESERVE);
+  for (pageCacheItr=pageCache.begin(); pageCacheItr != pageCache.end(); ++pageCacheItr)
+    delete [] pageCacheItr->second;
 }
 
 mem_model::mem_model(std::string deviceName):
   mDeviceName(deviceName),
-  module_name("dr_wrapper_dr_i_sdaccel_generic_pcie_0.sdaccel_generic_pcie_model.ddrx_top_tlm_model_0.axi_app_tlm_model_0")
+  module_name("dr_wrapper_dr_i_sdaccel_generic_pcie_0.sdaccel_generic_pcie_model.ddrx_top_tlm_model_0.axi_app_tlm_model_0"),
+  mBase(NULL),
+  mNumPagesLoaded(0),
+  mSnapshotRestored(false)
 {
+  // Reserve the DDR range up front, memory is committed only for the
+  // pages that are touched. If the reservation fails, fall back to
+  // individually allocated pages.
+  void* base = mmap(NULL, MEM_MODEL_RESERVE, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if(base != MAP_FAILED)
+  {
+    mBase = (unsigned char*)base;
+    mPageLoaded.resize(MEM_MODEL_RESERVE >> ADDRBITS, false);
+  }
+
+  mSnapshot = xclemulation::config::getInstance()->getDDRSnapshot();
+  if(!mSnapshot.empty())
+  {
+    if(!mDeviceName.empty())
+      mSnapshot += "." + mDeviceName;
+    struct stat statBuf;
+    if(stat(mSnapshot.c_str(), &statBuf) == 0)
+    {
+      mSnapshotRestored = loadSnapshot(mSnapshot);
+      if(!mSnapshotRestored)
+        std::cerr << "WARNING: unable to restore DDR snapshot " << mSnapshot << std::endl;
+    }
+  }
 }
 
   unsigned int mem_model::writeDevMem(uint64_t offset, const void* src, unsigned int size)
@@ -32,6 +83,13 @@ mem_model::mem_model(std::string deviceName):
 #ifdef DEBUGMSG
       cout<<endl<<module_name<<" write offset:"<<std::hex<<offset<<endl;
 #endif 
+      unsigned char* range_ptr = get_range(offset, size);
+      if(range_ptr)
+      {
+          memcpy(range_ptr,src,size);
+          return 0;
+      }
+
       uint64_t written_bytes = 0;
       uint64_t addr = offset;
       while(written_bytes < size){
@@ -78,6 +136,12 @@ mem_model::mem_model(std::string deviceName):
 #ifdef DEBUGMSG
 	  cout<<endl<<module_name<<" read offset:"<<std::hex<< (uint64_t)offset<<endl;
 #endif 
+	  unsigned char* range_ptr = get_range(offset, size);
+	  if(range_ptr)
+	  {
+		  memcpy(dest,range_ptr,size);
+		  return 0;
+	  }
 	 
 	  uint64_t read_bytes = 0;
 	  uint64_t addr = offset;
@@ -118,43 +182,79 @@ mem_model::mem_model(std::string deviceName):
 
 	  return 0;
   }
+
+  // Pointer to [offset, offset+size) in the reserved range, loading the
+  // pages on first access. NULL if the range is not direct mapped.
+  unsigned char* mem_model::get_range(uint64_t offset, uint64_t size) {
+	  if(!mBase || offset >= MEM_MODEL_RESERVE || size > MEM_MODEL_RESERVE - offset)
+		  return NULL;
+	  if(size == 0)
+		  return mBase + offset;
+
+	  uint64_t first_page = offset >> ADDRBITS;
+	  uint64_t last_page = (offset + size - 1) >> ADDRBITS;
+	  for(uint64_t page_idx = first_page; page_idx <= last_page; ++page_idx)
+	  {
+		  if(mPageLoaded[page_idx])
+			  continue;
+		  if(mNumPagesLoaded + pageCache.size() > N_1MBARRAYS)
+		  {
+			  std::cerr << "Out of Memory. DDR model does not support this much of memory\n";
+			  exit(1);
+		  }
+		  load_page(page_idx, mBase + (page_idx << ADDRBITS));
+		  mPageLoaded[page_idx] = true;
+		  ++mNumPagesLoaded;
+	  }
+	  return mBase + offset;
+  }
+
+  // Fill a page from its serialized mem file, if any
+  bool mem_model::load_page(uint64_t pageIdx, unsigned char* page_ptr) {
+	  std::string file_name = get_mem_file_name(pageIdx);
+	  FILE* pFile = fopen(file_name.c_str(),"r");
+	  if(pFile == NULL)
+		  return false;
+
+	  int fhandle = fileno(pFile);
+	  if (deserialize_msg.ParseFromFileDescriptor(fhandle) == false)
+	  {
+		  fclose(pFile);
+		  exit(1);
+	  }
+	  memcpy(page_ptr,deserialize_msg.data().c_str(),PAGESIZE);
+	  fclose(pFile);
+	  return true;
+  }
+
   unsigned char* mem_model::get_page(uint64_t offset) {
 	  uint64_t page_idx = offset >> ADDRBITS;
-	  std::string file_name = get_mem_file_name(page_idx);
-	  if(pageCache.size() > N_1MBARRAYS)
+	  pageCacheItr = pageCache.find(page_idx);
+	  if(pageCacheItr != pageCache.end())
+		  return pageCacheItr->second;
+
+	  if(mNumPagesLoaded + pageCache.size() > N_1MBARRAYS)
 	  {
 		  std::cerr << "Out of Memory. DDR model does not support this much of memory\n";
 		  exit(1);
-	  } else {
-      FILE* pFile = NULL;
-		  if(pageCache.find(page_idx) != pageCache.end())
-		  {
-			  return pageCache[page_idx];
-		  } else if(((pFile = fopen(file_name.c_str(),"r")) != NULL)) {
-			  int fhandle = fileno(pFile);
-
-			  if (deserialize_msg.ParseFromFileDescriptor(fhandle) == false)
-        {
-          fclose(pFile);
-          exit(1);
-        }
-			  pageCache[page_idx] = new unsigned char[PAGESIZE];
-
-			  memcpy(pageCache[page_idx],deserialize_msg.data().c_str(),PAGESIZE);
-			  fclose(pFile);
-			  return pageCache[page_idx];
-		  } else {
-			  pageCache[page_idx] = new unsigned char[PAGESIZE];
-			  return pageCache[page_idx];
-		  }
 	  }
+	  unsigned char* page_ptr = new unsigned char[PAGESIZE];
+	  load_page(page_idx, page_ptr);
+	  pageCache[page_idx] = page_ptr;
+	  return page_ptr;
   }
 
 
   void mem_model::serialize() {
      FILE *pFile;
      int fhandle;
-     for (pageCacheItr=pageCache.begin(); pageCacheItr != pageCache.end(); ++pageCacheItr)
+     std::map<uint64_t,unsigned char*> pages(pageCache);
+     for (uint64_t page_idx = 0; page_idx < mPageLoaded.size(); ++page_idx)
+     {
+        if(mPageLoaded[page_idx])
+          pages[page_idx] = mBase + (page_idx << ADDRBITS);
+     }
+     for (pageCacheItr=pages.begin(); pageCacheItr != pages.end(); ++pageCacheItr)
      {
         std::string file_name = get_mem_file_name(pageCacheItr->first);
         pFile = fopen(file_name.c_str(),"w+");
@@ -177,6 +277,83 @@ mem_model::mem_model(std::string deviceName):
      }
   }
 
+  // The snapshot is a sparse image of the reserved range, pages that
+  // were never touched are left as holes
+  bool mem_model::saveSnapshot(const std::string& path) {
+	  if(!mBase)
+		  return false;
+	  int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+	  if(fd == -1)
+		  return false;
+
+	  bool status = true;
+	  uint64_t image_size = 0;
+	  for(uint64_t page_idx = 0; status && page_idx < mPageLoaded.size(); ++page_idx)
+	  {
+		  if(!mPageLoaded[page_idx])
+			  continue;
+		  uint64_t page_offset = page_idx << ADDRBITS;
+		  status = writeAll(fd, mBase + page_offset, PAGESIZE, page_offset);
+		  image_size = page_offset + PAGESIZE;
+	  }
+	  if(status && ftruncate(fd, image_size) != 0)
+		  status = false;
+	  close(fd);
+	  return status;
+  }
+
+  bool mem_model::loadSnapshot(const std::string& path) {
+	  if(!mBase)
+		  return false;
+	  int fd = open(path.c_str(), O_RDONLY);
+	  if(fd == -1)
+		  return false;
+
+	  // The image must cover whole pages, accessing a mapping past the end
+	  // of the file would fault
+	  struct stat statBuf;
+	  if(fstat(fd, &statBuf) == -1 || (statBuf.st_size % PAGESIZE) != 0
+	      || (uint64_t)statBuf.st_size > MEM_MODEL_RESERVE)
+	  {
+		  close(fd);
+		  return false;
+	  }
+	  uint64_t image_size = statBuf.st_size;
+	  if(image_size == 0)
+	  {
+		  close(fd);
+		  return true;
+	  }
+
+	  // Map the image copy-on-write, so the snapshot file is paged in on
+	  // demand and never modified
+	  if(mmap(mBase, image_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED | MAP_NORESERVE, fd, 0) == MAP_FAILED)
+	  {
+		  close(fd);
+		  return false;
+	  }
+
+	  // Pages with data in the image are restored, holes behave as pages
+	  // that were never touched
+	  off_t data = lseek(fd, 0, SEEK_DATA);
+	  while(data >= 0 && (uint64_t)data < image_size)
+	  {
+		  off_t hole = lseek(fd, data, SEEK_HOLE);
+		  if(hole < 0 || (uint64_t)hole > image_size)
+			  hole = image_size;
+		  for(uint64_t page_idx = data >> ADDRBITS; page_idx <= (uint64_t)(hole - 1) >> ADDRBITS; ++page_idx)
+		  {
+			  if(mPageLoaded[page_idx])
+				  continue;
+			  mPageLoaded[page_idx] = true;
+			  ++mNumPagesLoaded;
+		  }
+		  data = lseek(fd, hole, SEEK_DATA);
+	  }
+	  close(fd);
+	  return true;
+  }
+
  std::string mem_model::get_mem_file_name(uint64_t pageIdx)
  {
    std::string file_name("");
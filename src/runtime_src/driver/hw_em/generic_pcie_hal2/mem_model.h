@@ -23,6 +23,7 @@
 #include <sstream> // memcpy
 #include <stdlib.h> //realloc
 #include <map> //realloc
+#include <vector>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -34,14 +35,25 @@
 #define PAGESIZE (ONE_MB)
 #define ADDRBITS (20)
 #define N_1MBARRAYS 4096
+// Virtual address range reserved for the direct mapped DDR model. Only
+// the pages that are touched are backed by memory.
+#define MEM_MODEL_RESERVE (1ULL << 38)
 
 class mem_model{
 public:
 unsigned int writeDevMem(uint64_t offset, const void* src, unsigned int size);
 unsigned int readDevMem(uint64_t offset, void* dest, unsigned int size);
 
+// Save the touched DDR pages to a sparse image file, restore it by
+// mapping the file copy-on-write over the DDR range. Restore replaces
+// the current content of the pages in the image.
+bool saveSnapshot(const std::string& path);
+bool loadSnapshot(const std::string& path);
+
 protected:
 private:
+  unsigned char* get_range(uint64_t offset, uint64_t size);
+  bool load_page(uint64_t pageIdx, unsigned char* page_ptr);
   unsigned char* get_page(uint64_t offset);
   std::string get_mem_file_name(uint64_t pageIdx);
   std::map<uint64_t,unsigned char*> pageCache;
@@ -52,6 +64,13 @@ private:
   void serialize();
   std::string mDeviceName;
   std::string module_name;
+
+  // Direct mapped model, pages loaded into the reserved range
+  unsigned char* mBase;
+  std::vector<bool> mPageLoaded;
+  uint64_t mNumPagesLoaded;
+  std::string mSnapshot;
+  bool mSnapshotRestored;
 public:
   mem_model(std::string deviceName);
   ~ mem_model();
@@ -1551,6 +1551,20 @@ uint32_t HwEmShim::getAddressSpace (uint32_t topology)
     return 0;
   }
 
+  // Usage of the emulated DDR banks, indexed like mDDRMemoryManager
+  int HwEmShim::xclGetUsageInfo(xclDeviceUsage *info)
+  {
+    std::memset(info, 0, sizeof(xclDeviceUsage));
+    const size_t count = std::min(mDDRMemoryManager.size(), sizeof(info->ddrMemUsed)/sizeof(info->ddrMemUsed[0]));
+    for (size_t i = 0; i < count; i++) {
+      xclemulation::MemoryManager::Stats stats = mDDRMemoryManager[i]->stats();
+      info->memSize[i] = mDDRMemoryManager[i]->size();
+      info->ddrMemUsed[i] = info->memSize[i] - stats.freeSize;
+      info->ddrBOAllocated[i] = stats.busyBlocks;
+    }
+    return 0;
+  }
+
   //TODO::SPECIFIC TO LINUX
   //Need to modify for windows
   void HwEmShim::xclOpen(const char* logfileName)
@@ -1878,6 +1892,34 @@ int HwEmShim::xclExecBuf(unsigned int cmdBO)
   return 0;
 }
 
+int HwEmShim::xclExecBuf(unsigned int cmdBO, size_t num_bo_in_wait_list, unsigned int *bo_wait_list)
+{
+
+  if (mLogStream.is_open())
+  {
+    mLogStream << __func__ << ", " << std::this_thread::get_id() << ", " << cmdBO << ", " << num_bo_in_wait_list << std::endl;
+  }
+  xclemulation::drm_xocl_bo* bo = xclGetBoByHandle(cmdBO);
+  if(!mMBSch || !bo || num_bo_in_wait_list > MAX_DEPS)
+  {
+    PRINTENDFUNC;
+    return -1;
+  }
+  xclemulation::drm_xocl_bo* deps[MAX_DEPS];
+  for (size_t i = 0; i < num_bo_in_wait_list; ++i)
+  {
+    deps[i] = xclGetBoByHandle(bo_wait_list[i]);
+    if (!deps[i])
+    {
+      PRINTENDFUNC;
+      return -1;
+    }
+  }
+  mMBSch->add_exec_buffer(mCore, bo, num_bo_in_wait_list, deps);
+  PRINTENDFUNC;
+  return 0;
+}
+
 int HwEmShim::xclRegisterEventNotify(unsigned int userInterrupt, int fd)
 {
   if (mLogStream.is_open())
@@ -1895,17 +1937,20 @@ int HwEmShim::xclExecWait(int timeoutMilliSec)
  //   mLogStream << __func__ << ", " << std::this_thread::get_id() << ", " << timeoutMilliSec << std::endl;
   }
 
-  unsigned int tSec = 0;
-  static bool bConfig = true;
-  tSec = timeoutMilliSec/1000;
-  if(bConfig)
-  {
-    tSec = timeoutMilliSec/100;
-    bConfig = false;
-  }
-  sleep(tSec);
+  if(!mMBSch)
+    return 0;
   //PRINTENDFUNC;
-  return 1;
+  return mMBSch->wait_for_completion(timeoutMilliSec);
+}
+
+void MBScheduler::read_ctrl(uint64_t offset, void* buf, size_t size)
+{
+  mParent->xclRead(XCL_ADDR_KERNEL_CTRL, offset, buf, size);
+}
+
+void MBScheduler::write_ctrl(uint64_t offset, const void* buf, size_t size)
+{
+  mParent->xclWrite(XCL_ADDR_KERNEL_CTRL, offset, buf, size);
 }
 
 /**********************************************HAL2 API's END HERE **********************************************/
@@ -90,6 +90,7 @@ using addr_type = uint64_t;
 
       //MB scheduler related API's
       int xclExecBuf( unsigned int cmdBO);
+      int xclExecBuf( unsigned int cmdBO, size_t num_bo_in_wait_list, unsigned int *bo_wait_list);
       int xclRegisterEventNotify( unsigned int userInterrupt, int fd);
       int xclExecWait( int timeoutMilliSec);
       struct exec_core* getExecCore() { return mCore; }
@@ -110,6 +111,7 @@ using addr_type = uint64_t;
       int xclBootFPGA();
       int resetProgram(bool saveWdb=true);
       int xclGetDeviceInfo2(xclDeviceInfo2 *info);
+      int xclGetUsageInfo(xclDeviceUsage *info);
 
       // Raw read/write
       size_t xclWrite(xclAddressSpace space, uint64_t offset, const void *hostBuf, size_t size);
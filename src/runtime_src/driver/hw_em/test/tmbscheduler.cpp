@@ -0,0 +1,265 @@
+/**
+ * Copyright (C) 2016-2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "mbscheduler.h"
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+// % hwemtest --run_test=test_mbscheduler
+
+namespace xclhwemhal2 {
+
+// Mock device standing in for the emulator.  A command written to a
+// command queue slot completes immediately and is reported by the next
+// read of the ERT status register of that slot.
+class HwEmShim
+{
+public:
+  HwEmShim() : reads(0)
+  {
+    for (auto& sr : status)
+      sr = 0;
+  }
+
+  void
+  write(uint64_t offset, const void* buf, size_t size)
+  {
+    if (offset < ERT_CQ_BASE_ADDR || size != 4)
+      return;
+    // header write of a slot starts the command
+    uint64_t slot_offset = offset - ERT_CQ_BASE_ADDR;
+    if (slot_offset % slot_size)
+      return;
+    unsigned int slot_idx = slot_offset / slot_size;
+    std::lock_guard<std::mutex> lk(mutex);
+    status[slot_idx >> 5] |= 1 << (slot_idx & 0x1f);
+  }
+
+  void
+  read(uint64_t offset, void* buf, size_t size)
+  {
+    std::lock_guard<std::mutex> lk(mutex);
+    ++reads;
+    uint32_t mask = 0;
+    if (offset >= ERT_STATUS_REGISTER_ADDR && offset < ERT_STATUS_REGISTER_ADDR + 0x10) {
+      auto idx = (offset - ERT_STATUS_REGISTER_ADDR) >> 2;
+      mask = status[idx];
+      status[idx] = 0; // clear on read
+    }
+    *static_cast<uint32_t*>(buf) = mask;
+  }
+
+  unsigned int slot_size = 0x800;
+  uint64_t reads;
+
+private:
+  std::mutex mutex;
+  uint32_t status[MAX_U32_SLOT_MASKS];
+};
+
+void
+MBScheduler::read_ctrl(uint64_t offset, void* buf, size_t size)
+{
+  mParent->read(offset, buf, size);
+}
+
+void
+MBScheduler::write_ctrl(uint64_t offset, const void* buf, size_t size)
+{
+  mParent->write(offset, buf, size);
+}
+
+}
+
+namespace {
+
+using namespace xclhwemhal2;
+
+static double
+elapsed(const std::chrono::high_resolution_clock::time_point& start)
+{
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+}
+
+struct command
+{
+  std::vector<uint32_t> words;
+  xclemulation::drm_xocl_bo bo;
+
+  command(size_t size)
+    : words(size, 0)
+  {
+    bo.buf = words.data();
+  }
+
+  command(const command& rhs)
+    : words(rhs.words)
+  {
+    bo.buf = words.data();
+  }
+
+  ert_packet*
+  packet()
+  {
+    return reinterpret_cast<ert_packet*>(words.data());
+  }
+
+  bool
+  completed()
+  {
+    return packet()->state == ERT_CMD_STATE_COMPLETED;
+  }
+};
+
+static void
+configure(MBScheduler& sch, exec_core& core, HwEmShim& shim)
+{
+  const unsigned int num_cus = 4;
+  command cmd(6 + num_cus);
+  auto cfg = reinterpret_cast<ert_configure_cmd*>(cmd.words.data());
+  cfg->state = ERT_CMD_STATE_NEW;
+  cfg->opcode = ERT_CONFIGURE;
+  cfg->count = 5 + num_cus;
+  cfg->slot_size = shim.slot_size;
+  cfg->num_cus = num_cus;
+  cfg->cu_shift = 16;
+  cfg->cu_base_addr = 0;
+  cfg->ert = 1;
+
+  sch.add_exec_buffer(&core, &cmd.bo);
+  while (!cmd.completed())
+    sch.wait_for_completion(1000);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE ( test_mbscheduler )
+
+BOOST_AUTO_TEST_CASE( test_mbscheduler_throughput )
+{
+  HwEmShim shim;
+  exec_core core;
+  MBScheduler sch(&shim);
+  sch.init_scheduler_thread();
+
+  configure(sch, core, shim);
+
+  // Keep a window of commands in flight, resubmitting each one as
+  // soon as it completes
+  const unsigned int window = 24;
+  const unsigned int total = 100000;
+  std::vector<command> cmds(window, command(4));
+  std::vector<bool> busy(window, false);
+  unsigned int submitted = 0, completed = 0;
+
+  auto start = std::chrono::high_resolution_clock::now();
+  while (completed < total) {
+    for (unsigned int i = 0; i < window; ++i) {
+      auto& cmd = cmds[i];
+      if (busy[i] && cmd.completed()) {
+        busy[i] = false;
+        ++completed;
+      }
+      if (!busy[i] && submitted < total) {
+        auto pkt = cmd.packet();
+        pkt->state = ERT_CMD_STATE_NEW;
+        pkt->opcode = ERT_START_CU;
+        pkt->count = 3;
+        busy[i] = true;
+        ++submitted;
+        sch.add_exec_buffer(&core, &cmd.bo);
+      }
+    }
+    if (completed < total)
+      sch.wait_for_completion(1000);
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  double time = std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+
+  sch.fini_scheduler_thread();
+
+  BOOST_CHECK_EQUAL(completed, total);
+  std::cout << "MBScheduler throughput = " << total / time << " commands/s, "
+            << shim.reads / double(total) << " status reads per command\n";
+}
+
+BOOST_AUTO_TEST_CASE( test_mbscheduler_chain_latency )
+{
+  HwEmShim shim;
+  exec_core core;
+  MBScheduler sch(&shim);
+  sch.init_scheduler_thread();
+
+  configure(sch, core, shim);
+
+  // Chain of commands where each command depends on the previous one
+  const unsigned int total = 20000;
+
+  auto start_cu = [](command& cmd) {
+    auto pkt = cmd.packet();
+    pkt->state = ERT_CMD_STATE_NEW;
+    pkt->opcode = ERT_START_CU;
+    pkt->count = 3;
+  };
+
+  // Host resolves the dependency, the next command is submitted when
+  // the previous one has completed
+  command hcmd(4);
+  auto start = std::chrono::high_resolution_clock::now();
+  for (unsigned int i = 0; i < total; ++i) {
+    start_cu(hcmd);
+    sch.add_exec_buffer(&core, &hcmd.bo);
+    while (!hcmd.completed())
+      sch.wait_for_completion(1000);
+  }
+  double host_time = elapsed(start);
+
+  // Scheduler resolves the dependency, commands are submitted ahead
+  // with the previous command in their wait list
+  const unsigned int window = 8;
+  std::vector<command> cmds(window, command(4));
+  unsigned int submitted = 0, completed = 0, out_of_order = 0;
+  start = std::chrono::high_resolution_clock::now();
+  while (completed < total) {
+    while (submitted < total && submitted - completed < window) {
+      auto& cmd = cmds[submitted % window];
+      start_cu(cmd);
+      auto dep = &cmds[(submitted + window - 1) % window].bo;
+      sch.add_exec_buffer(&core, &cmd.bo, submitted ? 1 : 0, &dep);
+      ++submitted;
+    }
+    sch.wait_for_completion(1000);
+    while (completed < submitted && cmds[completed % window].completed())
+      ++completed;
+    if (completed < submitted - 1 && cmds[(completed + 1) % window].completed())
+      ++out_of_order;
+  }
+  double device_time = elapsed(start);
+
+  sch.fini_scheduler_thread();
+
+  BOOST_CHECK_EQUAL(completed, total);
+  BOOST_CHECK_EQUAL(out_of_order, 0);
+  std::cout << "MBScheduler chain latency = " << host_time / total * 1e6 << " us/command host resolved, "
+            << device_time / total * 1e6 << " us/command with wait list\n";
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,166 @@
+/**
+ * Copyright (C) 2016-2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "mem_model.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <unistd.h>
+
+// % hwemtest --run_test=test_mem_model
+
+namespace {
+
+static double
+elapsed(const std::chrono::high_resolution_clock::time_point& start)
+{
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+}
+
+static void
+fillPattern(std::vector<unsigned char>& buf, unsigned int seed)
+{
+  for (size_t i = 0; i < buf.size(); ++i)
+    buf[i] = static_cast<unsigned char>((i * 31 + seed) & 0xff);
+}
+
+// A named model serializes its pages to mem files under a directory
+// of this process (see mem_model::get_mem_file_name), so tests never
+// see pages of other runs.  The files are removed when the device goes
+// out of scope, it must outlive the models using its name.
+class test_device
+{
+  std::string mName;
+  std::string mDir;
+
+public:
+  explicit
+  test_device(const std::string& name)
+    : mName("tmem_model_" + name)
+  {
+    const char* user = getenv("USER");
+    mDir = "/tmp/" + std::string(user ? user : "") + "/" + std::to_string(getpid()) + "/hw_em";
+  }
+
+  ~test_device()
+  {
+    std::string command = "rm -rf " + mDir + "/" + mName;
+    if (system(command.c_str()) == 0) {
+      rmdir(mDir.c_str());
+      rmdir(mDir.substr(0, mDir.rfind('/')).c_str());
+    }
+  }
+
+  const std::string&
+  name() const
+  {
+    return mName;
+  }
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE ( test_mem_model )
+
+// Unaligned transfers crossing page boundaries, both in the direct
+// mapped range and above it
+BOOST_AUTO_TEST_CASE( test_mem_model_rw )
+{
+  test_device device("rw");
+  mem_model model(device.name());
+  std::vector<unsigned char> wbuf(3 * PAGESIZE + 123);
+  std::vector<unsigned char> rbuf(wbuf.size());
+
+  for (uint64_t offset : {0x0ULL, 0x40000ULL - 7, 0x100000000ULL + 3, MEM_MODEL_RESERVE - PAGESIZE - 11}) {
+    fillPattern(wbuf, static_cast<unsigned int>(offset));
+    std::fill(rbuf.begin(), rbuf.end(), 0);
+    model.writeDevMem(offset, wbuf.data(), wbuf.size());
+    model.readDevMem(offset, rbuf.data(), rbuf.size());
+    BOOST_CHECK(wbuf == rbuf);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( test_mem_model_snapshot )
+{
+  std::string path = "/tmp/tmem_model_snapshot." + std::to_string(getpid());
+  std::vector<unsigned char> wbuf(PAGESIZE + 17);
+  std::vector<unsigned char> rbuf(wbuf.size());
+  fillPattern(wbuf, 5);
+  test_device saved("snapshot_saved");
+  test_device restored("snapshot_restored");
+
+  {
+    mem_model model(saved.name());
+    model.writeDevMem(0x200000000ULL - 9, wbuf.data(), wbuf.size());
+    BOOST_CHECK(model.saveSnapshot(path));
+  }
+  {
+    mem_model model(restored.name());
+    BOOST_CHECK(model.loadSnapshot(path));
+    model.readDevMem(0x200000000ULL - 9, rbuf.data(), rbuf.size());
+    BOOST_CHECK(wbuf == rbuf);
+
+    // Writes after restore are private to the model
+    model.writeDevMem(0x200000000ULL, rbuf.data(), 16);
+  }
+  {
+    test_device again("snapshot_again");
+    mem_model model(again.name());
+    BOOST_CHECK(model.loadSnapshot(path));
+    model.readDevMem(0x200000000ULL - 9, rbuf.data(), rbuf.size());
+    BOOST_CHECK(wbuf == rbuf);
+  }
+  unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE( test_mem_model_bw )
+{
+  test_device device("bw");
+  mem_model model(device.name());
+  const unsigned int blockSize = 64 * ONE_MB;
+  const unsigned int count = 16;
+  std::vector<unsigned char> wbuf(blockSize);
+  std::vector<unsigned char> rbuf(blockSize);
+  fillPattern(wbuf, 1);
+
+  // First pass loads the pages, the timed passes only copy
+  for (unsigned int i = 0; i < 4; ++i)
+    model.writeDevMem(i * blockSize, wbuf.data(), blockSize);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  for (unsigned int i = 0; i < count; ++i)
+    model.writeDevMem((i % 4) * blockSize, wbuf.data(), blockSize);
+  double wtime = elapsed(start);
+
+  start = std::chrono::high_resolution_clock::now();
+  for (unsigned int i = 0; i < count; ++i)
+    model.readDevMem((i % 4) * blockSize, rbuf.data(), blockSize);
+  double rtime = elapsed(start);
+
+  BOOST_CHECK(wbuf == rbuf);
+
+  double totalMB = static_cast<double>(blockSize) * count / ONE_MB;
+  std::cout << "mem_model writeDevMem bandwidth = " << totalMB / wtime << " MB/s\n";
+  std::cout << "mem_model readDevMem bandwidth = " << totalMB / rtime << " MB/s\n";
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,164 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "memorymanager.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// % hwemtest --run_test=test_memorymanager
+
+using xclemulation::MemoryManager;
+
+namespace {
+
+const uint64_t PAGE = 4096;
+
+static double
+elapsed(const std::chrono::high_resolution_clock::time_point& start)
+{
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+}
+
+static uint64_t
+allocPages(MemoryManager& mm, size_t pages)
+{
+  size_t size = pages * PAGE;
+  return mm.alloc(size);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE ( test_memorymanager )
+
+BOOST_AUTO_TEST_CASE( test_memorymanager_alloc_free )
+{
+  MemoryManager mm(64 * PAGE, 0x1000000, PAGE);
+
+  // Sizes are rounded up to the alignment
+  size_t size = 10;
+  uint64_t a = mm.alloc(size);
+  BOOST_CHECK_EQUAL(size, PAGE);
+  BOOST_CHECK_EQUAL(a, 0x1000000);
+  BOOST_CHECK(mm.lookup(a) == std::make_pair(a, PAGE));
+  BOOST_CHECK(MemoryManager::isNullAlloc(mm.lookup(a + PAGE)));
+
+  uint64_t b = allocPages(mm, 63);
+  BOOST_CHECK_EQUAL(b, a + PAGE);
+  BOOST_CHECK_EQUAL(mm.freeSize(), 0);
+  BOOST_CHECK_EQUAL(allocPages(mm, 1), MemoryManager::mNull);
+
+  mm.free(a);
+  mm.free(b);
+  BOOST_CHECK(MemoryManager::isNullAlloc(mm.lookup(a)));
+  auto stats = mm.stats();
+  BOOST_CHECK_EQUAL(stats.freeSize, 64 * PAGE);
+  BOOST_CHECK_EQUAL(stats.freeBlocks, 1);
+  BOOST_CHECK_EQUAL(stats.busyBlocks, 0);
+  BOOST_CHECK_EQUAL(stats.fragmentation, 0.0);
+
+  // Freeing an unknown buffer is ignored
+  mm.free(a);
+  BOOST_CHECK_EQUAL(mm.freeSize(), 64 * PAGE);
+}
+
+BOOST_AUTO_TEST_CASE( test_memorymanager_best_fit )
+{
+  MemoryManager mm(64 * PAGE, 0, PAGE);
+  uint64_t a = allocPages(mm, 4);
+  uint64_t b = allocPages(mm, 1);
+  uint64_t c = allocPages(mm, 2);
+  uint64_t d = allocPages(mm, 1);
+  mm.free(a);
+  mm.free(c);
+
+  auto stats = mm.stats();
+  BOOST_CHECK_EQUAL(stats.freeBlocks, 3);
+  BOOST_CHECK_EQUAL(stats.largestFreeBlock, 56 * PAGE);
+  BOOST_CHECK_CLOSE(stats.fragmentation, 1.0 - 56.0 / 62.0, 1e-9);
+
+  // The hole left by c fits exactly
+  BOOST_CHECK_EQUAL(allocPages(mm, 2), c);
+  // Then the hole left by a
+  BOOST_CHECK_EQUAL(allocPages(mm, 3), a);
+  BOOST_CHECK_EQUAL(allocPages(mm, 1), a + 3 * PAGE);
+
+  // Freeing b merges it with both neighbours
+  mm.free(c);
+  mm.free(a + 3 * PAGE);
+  mm.free(b);
+  BOOST_CHECK(mm.lookup(d).first == d);
+  BOOST_CHECK_EQUAL(mm.stats().freeBlocks, 2);
+  BOOST_CHECK_EQUAL(allocPages(mm, 4), a + 3 * PAGE);
+
+  mm.reset();
+  stats = mm.stats();
+  BOOST_CHECK_EQUAL(stats.freeSize, 64 * PAGE);
+  BOOST_CHECK_EQUAL(stats.freeBlocks, 1);
+  BOOST_CHECK_EQUAL(stats.busyBlocks, 0);
+}
+
+// Alloc/free churn with 10k to 1M live blocks of random sizes. Every
+// iteration frees a random live block and allocates a new one.
+BOOST_AUTO_TEST_CASE( test_memorymanager_churn )
+{
+  const uint64_t alignment = 64;
+  std::mt19937 rng(1);
+  for (size_t live : {10000, 100000, 1000000}) {
+    MemoryManager mm(1ULL << 40, 0, alignment);
+    std::vector<uint64_t> bufs;
+    bufs.reserve(live);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < live; ++i) {
+      size_t size = rng() % 4096 + 1;
+      bufs.push_back(mm.alloc(size));
+    }
+    double fill = elapsed(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < live; ++i) {
+      auto& buf = bufs[rng() % live];
+      mm.free(buf);
+      size_t size = rng() % 4096 + 1;
+      buf = mm.alloc(size);
+      BOOST_REQUIRE(buf != MemoryManager::mNull);
+    }
+    double churn = elapsed(start);
+    auto stats = mm.stats();
+
+    start = std::chrono::high_resolution_clock::now();
+    for (auto buf : bufs)
+      mm.free(buf);
+    double release = elapsed(start);
+
+    std::cout << "MemoryManager " << live << " live blocks: alloc " << fill
+              << "s, churn " << churn << "s, free " << release << "s"
+              << ", free blocks " << stats.freeBlocks
+              << ", fragmentation " << stats.fragmentation << "\n";
+
+    BOOST_CHECK_EQUAL(stats.busyBlocks, live);
+    stats = mm.stats();
+    BOOST_CHECK_EQUAL(stats.freeBlocks, 1);
+    BOOST_CHECK_EQUAL(stats.freeSize, 1ULL << 40);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
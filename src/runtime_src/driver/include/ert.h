@@ -133,7 +133,8 @@ struct ert_start_kernel_cmd {
  * @unused:25
  * @dsa52:1          reserved for internal use
  *
- * @data:            addresses of @num_cus CUs
+ * @data:            addresses of @num_cus CUs, bits [1:0] of an address
+ *                   encode the CU control protocol (ERT_CU_CTRL_*)
  */
 struct ert_configure_cmd {
   union {
@@ -167,6 +168,26 @@ struct ert_configure_cmd {
   uint32_t data[1];
 };
 
+/**
+ * CU control protocol in bits [1:0] of CU address in ert_configure_cmd
+ *
+ * @ERT_CU_CTRL_HS:    ap_ctrl_hs, CU can be started when AP_DONE/AP_IDLE
+ * @ERT_CU_CTRL_CHAIN: ap_ctrl_chain, CU can be started again on AP_READY
+ *                     before previous invocation is done, AP_DONE is
+ *                     acknowledged with AP_CONTINUE
+ */
+#define ERT_CU_CTRL_HS                    0x0
+#define ERT_CU_CTRL_CHAIN                 0x1
+#define ERT_CU_CTRL_MASK                  0x3
+
+/**
+ * Max number of commands a command can wait on
+ *
+ * Bounded by the deps array of struct drm_xocl_execbuf, limits the
+ * wait list of xclExecBufWithWaitList in all drivers.
+ */
+#define ERT_MAX_WAIT_LIST                 8
+
 /**
  * struct ert_abort_cmd: ERT abort command format.
  *
@@ -175,6 +175,16 @@ extern "C" {
         IP_DNASC
     };
 
+    /* Control protocol of IP_KERNEL in bits [15:8] of ip_data.properties */
+    enum IP_CONTROL {
+        AP_CTRL_HS = 0,
+        AP_CTRL_CHAIN = 1,
+        AP_CTRL_NONE = 2
+    };
+
+#define IP_CONTROL_MASK  0xFF00
+#define IP_CONTROL_SHIFT 0x8
+
     struct axlf_section_header {
         uint32_t m_sectionKind;             /* Section type */
         char m_sectionName[16];             /* Examples: "stage2", "clear1", "clear2", "ocl1", "ocl2, "ublaze", "sched" */
@@ -268,7 +278,7 @@ extern "C" {
     /* IPs on AXI lite - their types, names, and base addresses.*/
     struct ip_data {
         uint32_t m_type; //map to IP_TYPE enum
-        uint32_t properties; //32 bits to indicate ip specific property. eg if m_type == IP_KERNEL then bit 0 is for interrupt.
+        uint32_t properties; //32 bits to indicate ip specific property. eg if m_type == IP_KERNEL then bit 0 is for interrupt, bits [15:8] are IP_CONTROL.
         uint64_t m_base_address;
         uint8_t m_name[64]; //eg Kernel name corresponding to KERNEL instance, can embed CU name in future.
     };
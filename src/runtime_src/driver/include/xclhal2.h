@@ -1077,13 +1077,25 @@ enum xclQueueRequestKind {
  * enum xclQueueRequestFlag - flags associated with the request.
  */
 enum xclQueueRequestFlag {
-    XCL_QUEUE_DEFAULT,
-    XCL_QUEUE_BLOCKING,
-    XCL_QUEUE_PARTIAL
+    XCL_QUEUE_DEFAULT     = 0,
+    XCL_QUEUE_BLOCKING    = (1 << 0),
+    XCL_QUEUE_PARTIAL     = (1 << 1),
+    XCL_QUEUE_NONBLOCKING = (1 << 2),
+    XCL_QUEUE_EOT         = (1 << 3),
 };
 
 /**
  * struct xclQueueRequest - read and write request
+ * @bufs:      scatter-gather list, the buffers are transferred in order
+ *             as one request
+ * @flag:      bitwise or of xclQueueRequestFlag
+ * @priv_data: returned in the xclReqCompletion of a non-blocking request
+ *
+ * The layout is compatible with requests built against earlier HAL2
+ * headers.  @flag has the size and offset of the enum it replaces and
+ * the earlier flags keep their values.  @priv_data is appended and is
+ * read only when XCL_QUEUE_NONBLOCKING is set, which earlier callers
+ * cannot set.
  */
 struct xclQueueRequest {
     xclQueueRequestKind op_code;
@@ -1091,7 +1103,20 @@ struct xclQueueRequest {
     uint32_t	        buf_num;
     char*               cdh;
     uint32_t	        cdh_len;
-    xclQueueRequestFlag flag;
+    uint32_t            flag;
+    void*               priv_data;
+};
+
+/**
+ * struct xclReqCompletion - completion of a non-blocking request
+ * @priv_data: priv_data of the completed request
+ * @nbytes:    number of bytes transferred
+ * @err_code:  0 or negative errno
+ */
+struct xclReqCompletion {
+    void*    priv_data;
+    size_t   nbytes;
+    int      err_code;
 };
 
 /**
@@ -1111,12 +1136,14 @@ struct xclQueueRequest {
  * This function supports blocking and non-blocking write
  *     blocking:
  *         return only when the entire buf has been written, or error.
- *     non-blocking:
- *         return 0 immediatly. wr_complete is called when DMA is completed.
- *     complete callback:
- *         used only with non-blocking.
- *         (there should be a way to poll wr complete to avoid too many notifications)
- * This feature will be enabled in a future release.
+ *     non-blocking (XCL_QUEUE_NONBLOCKING):
+ *         return 0 immediatly. The completion of the request, tagged with
+ *         wr_req->priv_data, is returned by xclPollCompletion.
+ *     end of transfer (XCL_QUEUE_EOT):
+ *         the last buffer of the request ends a packet.
+ * The request and its xclWRBuffer array can be reused as soon as this
+ * function returns, the buffers themselves must stay valid until the
+ * request is completed.
  */
 XCL_DRIVER_DLLESPEC ssize_t xclWriteQueue(xclDeviceHandle handle, uint64_t q_hdl, xclQueueRequest *wr_req);
 
@@ -1134,22 +1161,34 @@ XCL_DRIVER_DLLESPEC ssize_t xclWriteQueue(xclDeviceHandle handle, uint64_t q_hdl
  *         read until packet boundary arrives.
  *         any incoming packet beyond requested buffer size will be dropped and rd_complete will be
  *         called with error code. (will HW be able to do this??)
- * This function supports blocking, non-blocking and polling
+ * This function supports blocking and non-blocking read
  *     blocking:
  *         return only when the requested bytes are read (stream) or the entire packet is read (packet)
- *     non-blocking:
- *         return 0 immediatly. rd_complete is called when DMA is completed.
- *     polling: do not need buffer
- *         return number of bytes or packets which is ready. it could call blocking read to get the data
- *         if there is any.
- *     complete:
- *         used only with non-blocking.
- *         good place to do polling which will decrease the completion notifciaton.
- * This feature will be enabled in a future release.
+ *     non-blocking (XCL_QUEUE_NONBLOCKING):
+ *         return 0 immediatly. The completion of the request, tagged with
+ *         rd_req->priv_data, is returned by xclPollCompletion.
+ *     partial (XCL_QUEUE_PARTIAL):
+ *         the request completes as soon as some data has been read.
  *
  */
 XCL_DRIVER_DLLESPEC ssize_t xclReadQueue(xclDeviceHandle handle, uint64_t q_hdl, xclQueueRequest *wr_req);
 
+/**
+ * xclPollCompletion - poll completions of non-blocking read and write requests
+ * @handle:             Device handle
+ * @min_compl:          Number of completions to wait for
+ * @max_compl:          Size of the comps array
+ * @comps:              Returned completions
+ * @actual_compl:       Number of completions returned in comps
+ * @timeout:            Timeout in ms, 0 does not wait and a negative value waits forever
+ *
+ * Completions of all queues of the device are returned in the order they happen.
+ * Return: 0, or -ETIMEDOUT if fewer than min_compl requests completed in time,
+ *         or -EINVAL if min_compl > 0 and no non-blocking request was submitted.
+ */
+XCL_DRIVER_DLLESPEC int xclPollCompletion(xclDeviceHandle handle, int min_compl, int max_compl,
+                                          xclReqCompletion *comps, int *actual_compl, int timeout);
+
 /* Hack for xbflash only */
 XCL_DRIVER_DLLESPEC char *xclMapMgmt(xclDeviceHandle handle);
 XCL_DRIVER_DLLESPEC xclDeviceHandle xclOpenMgmt(unsigned deviceIndex);
@@ -112,6 +112,10 @@ struct exec_core {
 
 	u32                        cu_addr_map[MAX_CUS];
 
+	/* Bitmap of chained (ap_ctrl_chain) CUs, AP_DONE is acknowledged
+	   with AP_CONTINUE */
+	u32                        cu_chain[MAX_U32_CU_MASKS];
+
         /* Bitmap tracks busy(1)/free(0) slots in cmd_slots*/
         u32                        slot_status[MAX_U32_SLOT_MASKS];
         unsigned int               num_slot_masks; /* ((num_slots-1)>>5)+1 */
@@ -210,8 +214,8 @@ struct xocl_cmd
 	unsigned int chain_count;
 	unsigned int wait_count;
 	union {
-		struct xocl_cmd *chain[8];
-		struct drm_xocl_bo *deps[8];
+		struct xocl_cmd *chain[MAX_DEPS];
+		struct drm_xocl_bo *deps[MAX_DEPS];
 	};
 
 	/* The actual cmd object representation */
@@ -565,8 +569,10 @@ reset_exec(struct exec_core* exec)
 		exec->slot_status[i] = 0;
 	exec->num_slot_masks = 1;
 
-	for (i=0; i<MAX_U32_CU_MASKS; ++i)
+	for (i=0; i<MAX_U32_CU_MASKS; ++i) {
 		exec->cu_status[i] = 0;
+		exec->cu_chain[i] = 0;
+	}
 	exec->num_cu_masks = 0;
 
 	atomic_set(&exec->sr0,0);
@@ -812,7 +818,12 @@ configure(struct xocl_cmd *xcmd)
 	exec->num_slot_masks = ((exec->num_slots-1)>>5) + 1;
 
 	for (i=0; i<exec->num_cus; ++i) {
-		exec->cu_addr_map[i] = cfg->data[i];
+		/* penguin mode starts chained CUs as regular CUs */
+		exec->cu_addr_map[i] = cfg->data[i] & ~ERT_CU_CTRL_MASK;
+		if ((cfg->data[i] & ERT_CU_CTRL_MASK) == ERT_CU_CTRL_CHAIN)
+			exec->cu_chain[cu_mask_idx(i)] |= 1<<cu_idx_in_mask(i);
+		else
+			exec->cu_chain[cu_mask_idx(i)] &= ~(1<<cu_idx_in_mask(i));
 		SCHED_DEBUGF("++ configure cu(%d) at 0x%x\n",i,exec->cu_addr_map[i]);
 	}
 
@@ -956,6 +967,8 @@ cu_done(struct exec_core *exec, unsigned int cu_idx)
 		unsigned int mask_idx = cu_mask_idx(cu_idx);
 		unsigned int pos = cu_idx_in_mask(cu_idx);
 		exec->cu_status[mask_idx] ^= 1<<pos;
+		if (exec->cu_chain[mask_idx] & (1<<pos))
+			iowrite32(0x10,exec->base + cu_addr); /* AP_CONTINUE */
 		SCHED_DEBUG("<- cu_done returns 1\n");
 		return true;
 	}
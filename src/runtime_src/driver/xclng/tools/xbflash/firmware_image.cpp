@@ -18,10 +18,13 @@
 #include <algorithm>
 #include <climits>
 #include <iomanip>
+#include <map>
 #include <memory>
+#include <cstdio>
 #include <fcntl.h>
 #include <unistd.h>
 #include <dirent.h>
+#include <sys/stat.h>
 #include "firmware_image.h"
 #include "xclbin.h"
 
@@ -160,6 +163,87 @@ DSAInfo::~DSAInfo()
 {
 }
 
+#define DSA_INDEX_VERSION "xbflash DSA index 1"
+
+/*
+ * DSA index
+ *
+ * Reading DSA info opens every .dsabin file and parses its headers, so
+ * the result is kept in DSA_INDEX_FILE for the next run. Each .dsabin
+ * file is stamped with its size and modification time, the file is only
+ * parsed again when its stamp changed. One line per file with tab
+ * separated fields: file, stamp, valid, name, timestamp, BMC version.
+ */
+typedef std::map<std::string, std::pair<std::string, DSAInfo>> DSAIndex;
+
+static std::string fileStamp(const struct stat& st)
+{
+    std::stringstream ss;
+    ss << st.st_size << ":" << st.st_mtim.tv_sec << "." << st.st_mtim.tv_nsec;
+    return ss.str();
+}
+
+static void loadDSAIndex(DSAIndex& index)
+{
+    std::ifstream in(DSA_INDEX_FILE);
+    std::string line;
+
+    if (!std::getline(in, line) || line != DSA_INDEX_VERSION)
+        return;
+
+    while (std::getline(in, line))
+    {
+        std::vector<std::string> fields;
+        std::stringstream ss(line);
+        std::string field;
+        while (std::getline(ss, field, '\t'))
+            fields.push_back(field);
+        // An empty BMC version is dropped by getline
+        if (fields.size() == 5)
+            fields.push_back("");
+        if (fields.size() != 6)
+            continue;
+
+        DSAInfo dsa("");
+        dsa.file = fields[0];
+        dsa.DSAValid = (fields[2] == "1");
+        dsa.name = fields[3];
+        getVendorBoardFromDSAName(dsa.name, dsa.vendor, dsa.board);
+        dsa.timestamp = strtoull(fields[4].c_str(), nullptr, 0);
+        dsa.bmcVer = fields[5];
+        index.insert(std::make_pair(fields[0], std::make_pair(fields[1], dsa)));
+    }
+}
+
+static void saveDSAIndex(const DSAIndex& index)
+{
+    // Failing to save the index only costs parsing the files next time
+    mkdir(DSA_INDEX_DIR, 0755);
+
+    std::stringstream tmp;
+    tmp << DSA_INDEX_FILE << "." << getpid();
+    std::ofstream out(tmp.str());
+    if (!out.is_open())
+        return;
+
+    out << DSA_INDEX_VERSION << std::endl;
+    for (auto& e : index)
+    {
+        const DSAInfo& dsa = e.second.second;
+        std::string fields = dsa.file + dsa.name + dsa.bmcVer;
+        if (fields.find_first_of("\t\n") != std::string::npos)
+            continue;
+        out << dsa.file << "\t" << e.second.first << "\t"
+            << (dsa.DSAValid ? "1" : "0") << "\t" << dsa.name << "\t"
+            << dsa.timestamp << "\t" << dsa.bmcVer << std::endl;
+    }
+    out.close();
+
+    // Readers see either the old or the new index
+    if (!out || rename(tmp.str().c_str(), DSA_INDEX_FILE) != 0)
+        unlink(tmp.str().c_str());
+}
+
 std::vector<DSAInfo> firmwareImage::installedDSA;
 
 std::vector<DSAInfo>& firmwareImage::getIntalledDSAs()
@@ -169,7 +253,11 @@ std::vector<DSAInfo>& firmwareImage::getIntalledDSAs()
 
     struct dirent *entry;
     DIR *dp;
-    std::string nm;
+    DSAIndex cached;
+    DSAIndex index;
+    bool changed = false;
+
+    loadDSAIndex(cached);
 
     // Obtain installed DSA info.
     dp = opendir(FIRMWARE_DIR);
@@ -185,14 +273,34 @@ std::vector<DSAInfo>& firmwareImage::getIntalledDSAs()
             if (e.find(DSABIN_FILE_SUFFIX) == std::string::npos)
                 continue;
 
-            DSAInfo dsa(d + e);
-            if (!dsa.DSAValid)
+            std::string path = d + e;
+            struct stat st;
+            if (stat(path.c_str(), &st) != 0)
                 continue;
-            installedDSA.push_back(dsa);
+            std::string stamp = fileStamp(st);
+
+            auto it = cached.find(path);
+            if (it != cached.end() && it->second.first == stamp)
+            {
+                index.insert(*it);
+                continue;
+            }
+            index.insert(std::make_pair(path, std::make_pair(stamp, DSAInfo(path))));
+            changed = true;
         }
         closedir(dp);
     }
 
+    // Also drops files which were removed
+    if (changed || index.size() != cached.size())
+        saveDSAIndex(index);
+
+    for (auto& e : index)
+    {
+        if (e.second.second.DSAValid)
+            installedDSA.push_back(e.second.second);
+    }
+
     return installedDSA;
 }
 
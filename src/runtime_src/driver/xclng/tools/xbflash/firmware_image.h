@@ -33,6 +33,9 @@
 #define DSA_FILE_SUFFIX     "mcs"
 #define DSABIN_FILE_SUFFIX  "dsabin"
 #define NULL_TIMESTAMP      0
+// cached info of the DSA installed in FIRMWARE_DIR
+#define DSA_INDEX_DIR       "/var/cache/xilinx/"
+#define DSA_INDEX_FILE      DSA_INDEX_DIR "xbflash_dsa.idx"
 
 class DSAInfo
 {
@@ -0,0 +1,91 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _FLASH_PROGRESS_H_
+#define _FLASH_PROGRESS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+
+/*
+ * Progress of the firmware update of one card
+ *
+ * The flashers write their messages to log() and report the current
+ * phase and how many of its steps are done. A card flashed on its own
+ * logs to std::cout. When several cards are updated at once each card
+ * gets its own log buffer, and the counters are polled from the main
+ * thread to print a status line per card.
+ */
+class FlashProgress
+{
+public:
+    enum Phase
+    {
+        PENDING,
+        COMPARING,
+        ERASING,
+        PROGRAMMING,
+        DONE,
+        FAILED,
+    };
+
+    explicit FlashProgress(std::ostream& log) :
+        mLog(log), mPhase(PENDING), mDone(0), mTotal(0), mResult(0) {}
+
+    // Progress of an update without an owner, logging to std::cout
+    static FlashProgress& console()
+    {
+        static FlashProgress progress(std::cout);
+        return progress;
+    }
+
+    std::ostream& log() { return mLog; }
+
+    void start(Phase phase, size_t total)
+    {
+        mDone = 0;
+        mTotal = total;
+        mPhase = phase;
+    }
+    void step(size_t count = 1) { mDone += count; }
+    void finish(int result)
+    {
+        mResult = result;
+        mPhase = result ? FAILED : DONE;
+    }
+
+    Phase phase() const { return mPhase; }
+    size_t done() const { return mDone; }
+    size_t total() const { return mTotal; }
+    int result() const { return mResult; }
+
+    static const char *phaseName(Phase phase)
+    {
+        static const char *names[] = {
+            "pending", "comparing", "erasing", "programming", "done", "failed"
+        };
+        return names[phase];
+    }
+
+private:
+    std::ostream& mLog;
+    std::atomic<Phase> mPhase;
+    std::atomic<size_t> mDone;
+    std::atomic<size_t> mTotal;
+    std::atomic<int> mResult;
+};
+
+#endif
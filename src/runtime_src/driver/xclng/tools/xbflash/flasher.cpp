@@ -78,35 +78,58 @@ Flasher::E_FlasherType Flasher::getFlashType(std::string typeStr)
  * upgradeFirmware
  */
 int Flasher::upgradeFirmware(const std::string& flasherType,
-    firmwareImage *primary, firmwareImage *secondary)
+    firmwareImage *primary, firmwareImage *secondary, bool delta)
+{
+    // Decode the MCS files before touching the flash
+    McsImage primaryImage;
+    McsImage secondaryImage;
+    if (primaryImage.parse(*primary) ||
+        (secondary != nullptr && secondaryImage.parse(*secondary)))
+    {
+        std::cout << "ERROR: Invalid MCS file" << std::endl;
+        return -EINVAL;
+    }
+
+    return upgradeFirmware(flasherType, &primaryImage,
+        secondary ? &secondaryImage : nullptr, delta);
+}
+
+int Flasher::upgradeFirmware(const std::string& flasherType,
+    const McsImage *primary, const McsImage *secondary, bool delta,
+    FlashProgress *progress)
 {
     int retVal = -EINVAL;
     E_FlasherType type = getFlashType(flasherType);
+    std::ostream& log = progress ? progress->log() : std::cout;
 
     switch(type)
     {
     case SPI:
     {
-        XSPI_Flasher xspi(mIdx, mMgmtMap);
+        XSPI_Flasher xspi(mIdx, mMgmtMap, progress);
         if(secondary == nullptr)
         {
-            retVal = xspi.xclUpgradeFirmwareXSpi(*primary);
+            retVal = xspi.xclUpgradeFirmwareXSpi(*primary, 0, delta);
         }
         else
         {
-            retVal = xspi.xclUpgradeFirmware2(*primary, *secondary);
+            retVal = xspi.xclUpgradeFirmware2(*primary, *secondary, delta);
         }
         break;
     }
     case BPI:
     {
-        BPI_Flasher bpi(mIdx, mMgmtMap);
+        BPI_Flasher bpi(mIdx, mMgmtMap, progress);
         if(secondary != nullptr)
         {
-            std::cout << "ERROR: BPI mode does not support two mcs files." << std::endl;
+            log << "ERROR: BPI mode does not support two mcs files." << std::endl;
         }
         else
         {
+            if(delta)
+            {
+                log << "INFO: BPI mode can not read back the flash, programming the whole image." << std::endl;
+            }
             retVal = bpi.xclUpgradeFirmware(*primary);
         }
         break;
@@ -117,14 +140,14 @@ int Flasher::upgradeFirmware(const std::string& flasherType,
     return retVal;
 }
 
-int Flasher::upgradeBMCFirmware(firmwareImage* bmc)
+int Flasher::upgradeBMCFirmware(firmwareImage* bmc, FlashProgress* progress)
 {
-    XMC_Flasher flasher(mIdx, mMgmtMap);
+    XMC_Flasher flasher(mIdx, mMgmtMap, progress);
     const std::string e = flasher.probingErrMsg();
 
     if (!e.empty())
     {
-        std::cout << "ERROR: " << e << std::endl;
+        (progress ? progress->log() : std::cout) << "ERROR: " << e << std::endl;
         return -EOPNOTSUPP;
     }
 
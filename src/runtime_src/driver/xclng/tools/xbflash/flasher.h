@@ -69,8 +69,12 @@ class Flasher
 public:
     Flasher(unsigned int index);
     ~Flasher();
-    int upgradeFirmware(const std::string& typeStr, firmwareImage* primary, firmwareImage* secondary);
-    int upgradeBMCFirmware(firmwareImage* bmc);
+    int upgradeFirmware(const std::string& typeStr, firmwareImage* primary, firmwareImage* secondary, bool delta = false);
+    // Images are only read, so one decoded image can be used to update
+    // several cards at once. Messages and progress go to progress if set.
+    int upgradeFirmware(const std::string& typeStr, const McsImage* primary, const McsImage* secondary,
+        bool delta = false, FlashProgress* progress = nullptr);
+    int upgradeBMCFirmware(firmwareImage* bmc, FlashProgress* progress = nullptr);
     bool isValid(void) { return mMgmtMap != nullptr; }
 
     static void* wordcopy(void *dst, const void* src, size_t bytes);
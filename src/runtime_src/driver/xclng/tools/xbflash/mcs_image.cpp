@@ -0,0 +1,183 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <errno.h>
+#include "mcs_image.h"
+
+static int hexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+static int hexByte(const char *p)
+{
+    int hi = hexDigit(p[0]);
+    int lo = hexDigit(p[1]);
+    if (hi < 0 || lo < 0)
+        return -1;
+    return (hi << 4) | lo;
+}
+
+/*
+ * parse
+ *
+ * The stream is read in one go and decoded in place, each record is
+ * checked against its checksum.
+ */
+int McsImage::parse(std::istream& mcsStream)
+{
+    mSegments.clear();
+
+    std::ostringstream text;
+    text << mcsStream.rdbuf();
+    const std::string& buf = text.str();
+
+    const char *p = buf.data();
+    const char *end = p + buf.size();
+    uint32_t extAddress = 0;
+    unsigned char record[255 + 5];
+    bool endRecordFound = false;
+
+    while (p < end && !endRecordFound) {
+        const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        if (eol == nullptr)
+            eol = end;
+        const char *line = p;
+        const char *lineEnd = eol;
+        p = eol + 1;
+
+        while (lineEnd > line && std::isspace(static_cast<unsigned char>(lineEnd[-1])))
+            lineEnd--;
+        if (lineEnd == line)
+            continue;
+        if (line[0] != ':')
+            return -EINVAL;
+
+        // Byte count, address, type, data and checksum
+        size_t digits = lineEnd - line - 1;
+        if (digits < 10 || (digits % 2) != 0)
+            return -EINVAL;
+        size_t count = digits / 2;
+        unsigned char sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            int value = hexByte(line + 1 + 2 * i);
+            if (value < 0)
+                return -EINVAL;
+            record[i] = static_cast<unsigned char>(value);
+            sum += record[i];
+        }
+        const unsigned dataLen = record[0];
+        const unsigned address = (record[1] << 8) | record[2];
+        const unsigned recordType = record[3];
+        if (count != dataLen + 5 || sum != 0)
+            return -EINVAL;
+        const unsigned char *data = record + 4;
+
+        switch (recordType) {
+        case 0x00:
+        {
+            if (dataLen > 16) {
+                // For xilinx mcs files data length should be 16 for all records
+                // except for the last one which can be smaller
+                return -EINVAL;
+            }
+            const uint32_t start = extAddress + address;
+            if (mSegments.empty() || mSegments.back().endAddress() != start) {
+                mSegments.push_back(Segment());
+                mSegments.back().mAddress = start;
+            }
+            std::vector<unsigned char>& segData = mSegments.back().mData;
+            segData.insert(segData.end(), data, data + dataLen);
+            break;
+        }
+        case 0x01:
+            endRecordFound = true;
+            break;
+        case 0x03:
+        case 0x05:
+            // Start address records, nothing to program
+            break;
+        case 0x04:
+        {
+            if (address != 0x0 || dataLen != 2) {
+                return -EINVAL;
+            }
+            extAddress = ((data[0] << 8) | data[1]) << 16;
+            break;
+        }
+        default:
+            return -EINVAL;
+        }
+    }
+
+    return mSegments.empty() ? -EINVAL : 0;
+}
+
+size_t McsImage::size() const
+{
+    size_t total = 0;
+    for (const Segment& s : mSegments)
+        total += s.mData.size();
+    return total;
+}
+
+void McsImage::shift(uint32_t offset)
+{
+    for (Segment& s : mSegments)
+        s.mAddress += offset;
+}
+
+std::vector<uint32_t> McsImage::getSectors(uint32_t sectorSize) const
+{
+    std::vector<uint32_t> sectors;
+    const uint32_t mask = ~(sectorSize - 1);
+    for (const Segment& s : mSegments) {
+        if (s.mData.empty())
+            continue;
+        uint64_t last = (s.endAddress() - 1) & mask;
+        for (uint64_t addr = s.mAddress & mask; addr <= last; addr += sectorSize)
+            sectors.push_back(static_cast<uint32_t>(addr));
+    }
+    std::sort(sectors.begin(), sectors.end());
+    sectors.erase(std::unique(sectors.begin(), sectors.end()), sectors.end());
+    return sectors;
+}
+
+bool McsImage::read(uint32_t address, unsigned char *buf, size_t length) const
+{
+    bool found = false;
+    const uint64_t end = static_cast<uint64_t>(address) + length;
+    std::memset(buf, 0xff, length);
+    for (const Segment& s : mSegments) {
+        uint64_t from = std::max<uint64_t>(address, s.mAddress);
+        uint64_t to = std::min<uint64_t>(end, s.endAddress());
+        if (from >= to)
+            continue;
+        std::memcpy(buf + (from - address), s.mData.data() + (from - s.mAddress), to - from);
+        found = true;
+    }
+    return found;
+}
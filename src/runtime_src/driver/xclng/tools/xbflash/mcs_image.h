@@ -0,0 +1,66 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _MCS_IMAGE_H_
+#define _MCS_IMAGE_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+/*
+ * Binary image decoded from an MCS (Intel hex) file
+ *
+ * The whole file is decoded once before programming, so the flashers
+ * work on plain bytes instead of parsing text while talking to the
+ * flash. Data records following each other are merged into segments,
+ * a new segment starts when the address is not contiguous. Segments
+ * are kept in file order.
+ */
+class McsImage
+{
+public:
+    struct Segment
+    {
+        uint32_t mAddress;
+        std::vector<unsigned char> mData;
+        uint32_t endAddress() const { return mAddress + mData.size(); }
+    };
+
+    // Returns 0 on success, -EINVAL on malformed input
+    int parse(std::istream& mcsStream);
+
+    const std::vector<Segment>& segments() const { return mSegments; }
+    bool empty() const { return mSegments.empty(); }
+    size_t size() const;
+
+    // Move all segments up by offset bytes
+    void shift(uint32_t offset);
+
+    // Base addresses of all sectors of sectorSize (power of 2) holding
+    // image data, in ascending order
+    std::vector<uint32_t> getSectors(uint32_t sectorSize) const;
+
+    // Copy image bytes in [address, address + length) to buf, bytes not
+    // in the image read as 0xFF (erased flash). Returns false if none of
+    // the bytes are in the image.
+    bool read(uint32_t address, unsigned char *buf, size_t length) const;
+
+private:
+    std::vector<Segment> mSegments;
+};
+
+#endif
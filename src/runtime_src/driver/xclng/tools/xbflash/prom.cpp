@@ -23,6 +23,7 @@
 #include <fstream>
 #include <cassert>
 #include <thread>
+#include <algorithm>
 #include <cstring>
 #include <sys/ioctl.h>
 #include <fcntl.h>
@@ -93,7 +94,8 @@ int BPI_Flasher::freeAXIGate() {
     return Flasher::flashWrite(/*SHIM_MGMT_BAR*/0, AXI_GATE_OFFSET, &buf, 1);
 }
 
-BPI_Flasher::BPI_Flasher(unsigned int device_index, char *inMap)
+BPI_Flasher::BPI_Flasher(unsigned int device_index, char *inMap, FlashProgress *progress) :
+    mProgress(progress ? *progress : FlashProgress::console()), mLog(mProgress.log())
 {
     mMgmtMap = inMap;
 }
@@ -106,7 +108,25 @@ BPI_Flasher::~BPI_Flasher()
  * xclUpgradeFirmware
  */
 int BPI_Flasher::xclUpgradeFirmware(std::istream& mcsStream) {
-    std::cout << "INFO: Reseting hardware\n";
+    //Decode the whole file up front, programming only deals with bytes
+    McsImage image;
+    if (image.parse(mcsStream)) {
+        return -EINVAL;
+    }
+    return xclUpgradeFirmware(image);
+}
+
+/*
+ * xclUpgradeFirmware
+ *
+ * The image is only read, it may be shared with other flashers.
+ */
+int BPI_Flasher::xclUpgradeFirmware(const McsImage& image) {
+    if (image.empty()) {
+        return -EINVAL;
+    }
+
+    mLog << "INFO: Reseting hardware\n";
     if (freezeAXIGate() != 0) {
         return -ENXIO;
     }
@@ -126,81 +146,16 @@ int BPI_Flasher::xclUpgradeFirmware(std::istream& mcsStream) {
     nanosleep(&req, 0);
 #endif
 
-    std::string line;
-    std::string startAddress;
-    ELARecord record;
-    bool endRecordFound = false;
-
-    while (!mcsStream.eof() && !endRecordFound) {
-        std::string line;
-        std::getline(mcsStream, line);
-        if (line.size() == 0) {
-            continue;
-        }
-        if (line[0] != ':') {
+    //Data of each ELA record starts at offset 0
+    for (const McsImage::Segment& segment : image.segments()) {
+        if (segment.mAddress & 0xFFFF) {
             return -EINVAL;
         }
-        const unsigned dataLen = std::stoi(line.substr(1, 2), 0 , 16);
-        const unsigned address = std::stoi(line.substr(3, 4), 0, 16);
-        const unsigned recordType = std::stoi(line.substr(7, 2), 0 , 16);
-        switch (recordType) {
-        case 0x00:
-        {
-            if (dataLen > 16) {
-                // For xilinx mcs files data length should be 16 for all records
-                // except for the last one which can be smaller
-                return -EINVAL;
-            }
-            if (address != record.mDataCount) {
-                return -EINVAL;
-            }
-            if (record.mEndAddress != address) {
-                return -EINVAL;
-            }
-            record.mDataCount += dataLen;
-            record.mEndAddress += dataLen;
-            break;
-        }
-        case 0x01:
-        {
-            if (startAddress.size() == 0) {
-                break;
-            }
-            mRecordList.push_back(record);
-            endRecordFound = true;
-            break;
-        }
-        case 0x02:
-        {
-            break;
-        }
-        case 0x04:
-        {
-            if (address != 0x0) {
-                return -EINVAL;
-            }
-            if (dataLen != 2) {
-                return -EINVAL;
-            }
-            std::string newAddress = line.substr(9, dataLen * 2);
-            if (startAddress.size()) {
-                // Finish the old record
-                mRecordList.push_back(record);
-            }
-            // Start a new record
-            record.mStartAddress = std::stoi(newAddress, 0 , 16);
-            record.mDataPos = mcsStream.tellg();
-            record.mEndAddress = 0;
-            record.mDataCount = 0;
-            startAddress = newAddress;
-        }
-        }
     }
 
-    mcsStream.seekg(0);
-    std::cout << "INFO: Found " << mRecordList.size() << " ELA Records\n";
+    mLog << "INFO: Found " << image.segments().size() << " data segments\n";
 
-    return program(mcsStream);
+    return program(image);
 }
 
 /*
@@ -209,7 +164,7 @@ int BPI_Flasher::xclUpgradeFirmware(std::istream& mcsStream) {
 int BPI_Flasher::prepare_microblaze(unsigned startAddress, unsigned endAddress) {
     int status = 0;
     //Send the "hi" msb address command
-    std::cout << "sending hi cmd" << std::endl;
+    mLog << "sending hi cmd" << std::endl;
     unsigned addrHi = startAddress;
     addrHi >>= 24;
     addrHi &= 0xF;
@@ -225,7 +180,7 @@ int BPI_Flasher::prepare_microblaze(unsigned startAddress, unsigned endAddress)
         }
         Flasher::flashRead(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET+0x10, &status, 4);
     }
-    std::cout << "INFO: Finished draining mailbox\n";
+    mLog << "INFO: Finished draining mailbox\n";
     // Check for Ready
     if (Flasher::flashWrite(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET, &cmdHi, 4)) {
         return -ENXIO;
@@ -233,12 +188,12 @@ int BPI_Flasher::prepare_microblaze(unsigned startAddress, unsigned endAddress)
     if (waitAndFinish_microblaze(READY_STAT, 0xff)) {
         return -ETIMEDOUT;
     }
-    std::cout << "INFO: Finished waiting for READY_STAT\n";
+    mLog << "INFO: Finished waiting for READY_STAT\n";
 
     if (Flasher::flashWrite(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET, &cmdHi, 4)) {
         return -ENXIO;
     }
-    std::cout << "done sending hi cmd " << std::hex << cmdHi << std::dec<< std::endl;
+    mLog << "done sending hi cmd " << std::hex << cmdHi << std::dec<< std::endl;
     //End sending "hi" msb address command
     startAddress &= 0x00ffffff; // truncate to 24 bits
     startAddress >>= 8; // Pick the middle 16 bits
@@ -248,7 +203,7 @@ int BPI_Flasher::prepare_microblaze(unsigned startAddress, unsigned endAddress)
         return -ETIMEDOUT;
     }
 
-    std::cout << "INFO: Sending the address range\n";
+    mLog << "INFO: Sending the address range\n";
     // Send start and end address
     unsigned command = START_ADDR_CMD;
     command |= startAddress;
@@ -268,7 +223,7 @@ int BPI_Flasher::prepare_microblaze(unsigned startAddress, unsigned endAddress)
         return -ENXIO;
     }
 
-    std::cout << "INFO: Sending unlock command\n";
+    mLog << "INFO: Sending unlock command\n";
     // Send unlock command
     command = UNLOCK_CMD;
     if (Flasher::flashWrite(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET, &command, 4)) {
@@ -279,7 +234,7 @@ int BPI_Flasher::prepare_microblaze(unsigned startAddress, unsigned endAddress)
     }
 
     // Send erase command
-    std::cout << "INFO: Sending erase command\n";
+    mLog << "INFO: Sending erase command\n";
     command = ERASE_CMD;
     if (Flasher::flashWrite(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET, &command, 4)) {
         return -ENXIO;
@@ -294,7 +249,7 @@ int BPI_Flasher::prepare_microblaze(unsigned startAddress, unsigned endAddress)
     }
 
     // Send program command
-    std::cout << "INFO: Erasing the address range\n";
+    mLog << "INFO: Erasing the address range\n";
     command = PROGRAM_CMD;
     if (Flasher::flashWrite(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET, &command, 4)) {
         return -ENXIO;
@@ -312,7 +267,7 @@ int BPI_Flasher::prepare_microblaze(unsigned startAddress, unsigned endAddress)
  */
 int BPI_Flasher::prepare(unsigned startAddress, unsigned endAddress) {
     //Send the "hi" msb address command
-    std::cout << "sending hi cmd" << std::endl;
+    mLog << "sending hi cmd" << std::endl;
     unsigned addrHi = (startAddress >> 24) & 0xF;
     unsigned endAddressHi = (endAddress >>24)& 0x3;
     unsigned cmdHi = START_ADDR_HI_CMD;
@@ -320,7 +275,7 @@ int BPI_Flasher::prepare(unsigned startAddress, unsigned endAddress) {
     if (Flasher::flashWrite(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET, &cmdHi, 4)) {
         return -ENXIO;
     }
-    std::cout << "done sending hi cmd " << std::hex << cmdHi << std::dec<< std::endl;
+    mLog << "done sending hi cmd " << std::hex << cmdHi << std::dec<< std::endl;
     //End sending "hi" msb address command
     startAddress &= 0x00ffffff; // truncate to 24 bits
     startAddress >>= 8; // Pick the middle 16 bits
@@ -330,7 +285,7 @@ int BPI_Flasher::prepare(unsigned startAddress, unsigned endAddress) {
         return -ETIMEDOUT;
     }
 
-    std::cout << "INFO: Sending the address range\n";
+    mLog << "INFO: Sending the address range\n";
     // Send start and end address
     unsigned command = START_ADDR_CMD;
     command |= startAddress;
@@ -350,7 +305,7 @@ int BPI_Flasher::prepare(unsigned startAddress, unsigned endAddress) {
         return -ENXIO;
     }
 
-    std::cout << "INFO: Sending unlock command\n";
+    mLog << "INFO: Sending unlock command\n";
     // Send unlock command
     command = UNLOCK_CMD;
     if (Flasher::flashWrite(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET, &command, 4)) {
@@ -361,7 +316,7 @@ int BPI_Flasher::prepare(unsigned startAddress, unsigned endAddress) {
     }
 
     // Send erase command
-    std::cout << "INFO: Sending erase command\n";
+    mLog << "INFO: Sending erase command\n";
     command = ERASE_CMD;
     if (Flasher::flashWrite(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET, &command, 4)) {
         return -ENXIO;
@@ -376,7 +331,7 @@ int BPI_Flasher::prepare(unsigned startAddress, unsigned endAddress) {
     }
 
     // Send program command
-    std::cout << "INFO: Erasing the address range\n";
+    mLog << "INFO: Erasing the address range\n";
     command = PROGRAM_CMD;
     if (Flasher::flashWrite(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET, &command, 4)) {
         return -ENXIO;
@@ -392,81 +347,26 @@ int BPI_Flasher::prepare(unsigned startAddress, unsigned endAddress) {
 /*
  * program_microblaze
  */
-int BPI_Flasher::program_microblaze(std::istream& mcsStream, const ELARecord& record) {
+int BPI_Flasher::program_microblaze(const McsImage::Segment& segment) {
     int status = 0;
 //    if (mLogStream.is_open()) {
 //        mLogStream << __func__ << ", " << std::this_thread::get_id() << std::endl;
 //    }
-#ifndef _WINDOWS
-    // TODO: Windows build support
-    //  timespec
-    const timespec req = {0, 2000};
-#endif
 
-    std::cout << "Programming block (" << std::hex << record.mStartAddress << ", " << record.mEndAddress << std::dec << ")" << std::endl;
-    assert(mcsStream.tellg() < record.mDataPos);
-    mcsStream.seekg(record.mDataPos, std::ios_base::beg);
+    mLog << "Programming block (" << std::hex << segment.mAddress / 2 << ", " << segment.endAddress() / 2 << std::dec << ")" << std::endl;
+    const std::vector<unsigned char>& data = segment.mData;
     unsigned char buffer[64];
-    int bufferIndex = 0;
-    for (unsigned index = record.mDataCount; index > 0;) {
-        std::string line;
-        std::getline(mcsStream, line);
-        //std::cout << "current line:" <<line << std::endl;
-        const unsigned dataLen = std::stoi(line.substr(1, 2), 0 , 16);
-        index -= dataLen;
-        const unsigned recordType = std::stoi(line.substr(7, 2), 0 , 16);
-        if (recordType != 0x00) {
-            continue;
-        }
-        const std::string data = line.substr(9, dataLen * 2);
-        // Write in byte swapped order
-        for (unsigned i = 0; i < data.length(); i += 2) {
-            //                if ((bufferIndex % 4) == 0) {
-            //                    bufferIndex += 4;
-            //                }
-            assert(bufferIndex <= 64);
-            unsigned value = std::stoi(data.substr(i, 2), 0, 16);
-            buffer[bufferIndex++] = (unsigned char)value;
-            //                if ((bufferIndex % 4) == 0) {
-            //                    bufferIndex += 4;
-            //                }
-            if (bufferIndex == 64) {
-                break;
-            }
-        }
+    for (size_t offset = 0; offset < data.size(); offset += sizeof(buffer)) {
+        const size_t length = std::min(sizeof(buffer), data.size() - offset);
+        // A partial last word is padded with 0xff
+        const size_t words = (length + 3) / 4;
+        std::memset(buffer, 0xff, sizeof(buffer));
+        std::memcpy(buffer, &data[offset], length);
 
-        assert((bufferIndex % 4) == 0);
-        assert(bufferIndex <= 64);
-        if (bufferIndex == 64) {
-            if (waitForReady_microblaze(PROGRAM_STAT, false)) {
-                return -ETIMEDOUT;
-            }
-            for (int i=0; i< 16; i++)
-            {
-                Flasher::flashRead(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET+0x10, &status, 4);
-                while((status&2)==2){ //2: fifo is full
-                    Flasher::flashRead(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET+0x10, &status, 4);
-                }
-                if (Flasher::flashWrite(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET, buffer+4*i, 4)) {
-                    return -ENXIO;
-                }
-            }
-            if (waitForReady_microblaze(PROGRAM_STAT, false)) {
-                return -ETIMEDOUT;
-            }
-#ifndef _WINDOWS
-            // TODO: Windows build support
-            //   nanosleep is defined in unistd.h
-            nanosleep(&req, 0);
-#endif
-            bufferIndex = 0;
-        }
-    }
-    if (bufferIndex) {
         if (waitForReady_microblaze(PROGRAM_STAT, false)) {
             return -ETIMEDOUT;
         }
-        for (int i=0; i<bufferIndex/4 ; i++)
+        for (size_t i = 0; i < words; i++)
         {
             Flasher::flashRead(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET+0x10, &status, 4);
             while((status&2)==2){ //2: fifo is full
@@ -476,12 +376,9 @@ int BPI_Flasher::program_microblaze(std::istream& mcsStream, const ELARecord& re
                 return -ENXIO;
             }
         }
-
-#ifndef _WINDOWS
-        // TODO: Windows build support
-        //   nanosleep is defined in unistd.h
-        nanosleep(&req, 0);
-#endif
+        if (length == sizeof(buffer) && waitForReady_microblaze(PROGRAM_STAT, false)) {
+            return -ETIMEDOUT;
+        }
     }
     return 0;
 }
@@ -489,68 +386,22 @@ int BPI_Flasher::program_microblaze(std::istream& mcsStream, const ELARecord& re
 /*
  * program
  */
-int BPI_Flasher::program(std::istream& mcsStream, const ELARecord& record) {
+int BPI_Flasher::program(const McsImage::Segment& segment) {
 //    if (mLogStream.is_open()) {
 //        mLogStream << __func__ << ", " << std::this_thread::get_id() << std::endl;
 //    }
-#ifndef _WINDOWS
-    // TODO: Windows build support
-    //  timespec
-    const timespec req = {0, 2000};
-#endif
 
-    std::cout << "Programming block (" << std::hex << record.mStartAddress << ", " << record.mEndAddress << std::dec << ")" << std::endl;
-    assert(mcsStream.tellg() < record.mDataPos);
-    mcsStream.seekg(record.mDataPos, std::ios_base::beg);
+    mLog << "Programming block (" << std::hex << segment.mAddress / 2 << ", " << segment.endAddress() / 2 << std::dec << ")" << std::endl;
+    const std::vector<unsigned char>& data = segment.mData;
     unsigned char buffer[64];
-    int bufferIndex = 0;
-    for (unsigned index = record.mDataCount; index > 0;) {
-        std::string line;
-        std::getline(mcsStream, line);
-        const unsigned dataLen = std::stoi(line.substr(1, 2), 0 , 16);
-        index -= dataLen;
-        const unsigned recordType = std::stoi(line.substr(7, 2), 0 , 16);
-        if (recordType != 0x00) {
-            continue;
-        }
-        const std::string data = line.substr(9, dataLen * 2);
-        // Write in byte swapped order
-        for (unsigned i = 0; i < data.length(); i += 2) {
-            if ((bufferIndex % 4) == 0) {
-                bufferIndex += 4;
-            }
-            assert(bufferIndex <= 64);
-            unsigned value = std::stoi(data.substr(i, 2), 0, 16);
-            buffer[--bufferIndex] = (unsigned char)value;
-            if ((bufferIndex % 4) == 0) {
-                bufferIndex += 4;
-            }
-            if (bufferIndex == 64) {
-                break;
-            }
+    for (size_t offset = 0; offset < data.size(); offset += sizeof(buffer)) {
+        const size_t length = std::min(sizeof(buffer), data.size() - offset);
+        // Write in byte swapped order, a partial last word is padded with 0xff
+        const size_t bufferIndex = (length + 3) & ~3;
+        for (size_t i = 0; i < bufferIndex; i++) {
+            buffer[(i & ~3) + 3 - (i & 3)] = (i < length) ? data[offset + i] : 0xff;
         }
 
-        assert((bufferIndex % 4) == 0);
-        assert(bufferIndex <= 64);
-        if (bufferIndex == 64) {
-            if (waitForReady(PROGRAM_STAT, false)) {
-                return -ETIMEDOUT;
-            }
-            if (Flasher::flashWrite(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET, buffer, 64)) {
-                return -ENXIO;
-            }
-            if (waitForReady(PROGRAM_STAT, false)) {
-                return -ETIMEDOUT;
-            }
-#ifndef _WINDOWS
-            // TODO: Windows build support
-            //   nanosleep is defined in unistd.h
-            nanosleep(&req, 0);
-#endif
-            bufferIndex = 0;
-        }
-    }
-    if (bufferIndex) {
         if (waitForReady(PROGRAM_STAT, false)) {
             return -ETIMEDOUT;
         }
@@ -560,11 +411,6 @@ int BPI_Flasher::program(std::istream& mcsStream, const ELARecord& record) {
         if (waitForReady(PROGRAM_STAT, false)) {
             return -ETIMEDOUT;
         }
-#ifndef _WINDOWS
-        // TODO: Windows build support
-        //   nanosleep is defined in unistd.h
-        nanosleep(&req, 0);
-#endif
     }
     return 0;
 }
@@ -574,19 +420,15 @@ int BPI_Flasher::program(std::istream& mcsStream, const ELARecord& record) {
  *
  * return 0 on success, < 0 on error
  */
-int BPI_Flasher::program(std::istream& mcsStream) {
+int BPI_Flasher::program(const McsImage& image) {
     int status = 0;
     int rxthresh = 256;
     bool use_mailbox = 0;
-    for (ELARecordList::iterator i = mRecordList.begin(), e = mRecordList.end(); i != e; ++i) {
-        i->mStartAddress <<= 16;
-        i->mEndAddress += i->mStartAddress;
-        // Convert from 2 bytes address to 4 bytes address
-        i->mStartAddress /= 2;
-        i->mEndAddress /= 2;
-    }
-    std::cout << "INFO: Start address 0x" << std::hex << mRecordList.front().mStartAddress << std::dec << "\n";
-    std::cout << "INFO: End address 0x" << std::hex << mRecordList.back().mEndAddress << std::dec << "\n";
+    // Convert from 2 bytes address to 4 bytes address
+    const unsigned startAddress = image.segments().front().mAddress / 2;
+    const unsigned endAddress = image.segments().back().endAddress() / 2;
+    mLog << "INFO: Start address 0x" << std::hex << startAddress << std::dec << "\n";
+    mLog << "INFO: End address 0x" << std::hex << endAddress << std::dec << "\n";
 
     // Check for existance of Mailbox IP
     if (Flasher::flashWrite(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET+0x1C, &rxthresh, 4)) {
@@ -597,19 +439,19 @@ int BPI_Flasher::program(std::istream& mcsStream) {
     }
     if(status==rxthresh) {
         use_mailbox = 1;
-        std::cout << "INFO: Using Mailbox and Microblaze for flash programming\n";
+        mLog << "INFO: Using Mailbox and Microblaze for flash programming\n";
     } else {
-        std::cout << "INFO: Using custom flash programmer for flash programming\n";
+        mLog << "INFO: Using custom flash programmer for flash programming\n";
     }
 
     if(use_mailbox) {
-        if (prepare_microblaze(mRecordList.front().mStartAddress, mRecordList.back().mEndAddress)) {
-            std::cout << "ERROR: Could not unlock or erase the blocks\n";
+        if (prepare_microblaze(startAddress, endAddress)) {
+            mLog << "ERROR: Could not unlock or erase the blocks\n";
             return -EACCES;
         }
     } else {
-        if (prepare(mRecordList.front().mStartAddress, mRecordList.back().mEndAddress)) {
-            std::cout << "ERROR: Could not unlock or erase the blocks\n";
+        if (prepare(startAddress, endAddress)) {
+            mLog << "ERROR: Could not unlock or erase the blocks\n";
             return -EACCES;
         }
     }
@@ -619,21 +461,23 @@ int BPI_Flasher::program(std::istream& mcsStream) {
     const timespec req = {0, 1000};
 #endif
     int beatCount = 0;
-    for (ELARecordList::iterator i = mRecordList.begin(), e = mRecordList.end(); i != e; ++i)
+    mProgress.start(FlashProgress::PROGRAMMING, image.segments().size());
+    for (const McsImage::Segment& segment : image.segments())
     {
+        mProgress.step();
         beatCount++;
         if(beatCount%10==0) {
-            std::cout << "." << std::flush;
+            mLog << "." << std::flush;
         }
 
         if(use_mailbox) {
-            if (program_microblaze(mcsStream, *i)) {
-                std::cout << "ERROR: Could not program the block\n";
+            if (program_microblaze(segment)) {
+                mLog << "ERROR: Could not program the block\n";
                 return -ENXIO;
             }
         } else {
-            if (program(mcsStream, *i)) {
-                std::cout << "ERROR: Could not program the block\n";
+            if (program(segment)) {
+                mLog << "ERROR: Could not program the block\n";
                 return -ENXIO;
             }
         }
@@ -643,7 +487,7 @@ int BPI_Flasher::program(std::istream& mcsStream) {
         nanosleep(&req, 0);
 #endif
     }
-    std::cout << std::endl;
+    mLog << std::endl;
     // Now keep writing 0xff till the hardware says ready
     if(use_mailbox) {
         if (waitAndFinish_microblaze(READY_STAT, 0xff)) {
@@ -666,18 +510,13 @@ int BPI_Flasher::waitForReady_microblaze(unsigned code, bool verbose) {
     const timespec req = {0, 5000};
 #endif
     if (verbose) {
-        std::cout << "INFO: Waiting for hardware\n";
+        mLog << "INFO: Waiting for hardware\n";
     }
     if(code==ERASE_STAT) {
-        std::cout << "INFO: Waiting for erase...  Will take a couple minutes...\n";
+        mLog << "INFO: Waiting for erase...  Will take a couple minutes...\n";
     }
     while ((status != code) && (delay < 300000000000)) {
-#ifndef _WINDOWS
-        // TODO: Windows build support
-        //    nanosleep is defined in unistd.h
-        nanosleep(&req, 0);
-#endif
-
+        // Check before sleeping, the hardware is often ready already
         Flasher::flashRead(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET+0x10, &status, 4);
         if(!(status&0x1)){ //0: fifo is not empty
 
@@ -685,10 +524,18 @@ int BPI_Flasher::waitForReady_microblaze(unsigned code, bool verbose) {
                 return -ENXIO;
             }
         }
+        if (status == code) {
+            break;
+        }
+#ifndef _WINDOWS
+        // TODO: Windows build support
+        //    nanosleep is defined in unistd.h
+        nanosleep(&req, 0);
+#endif
         delay += 5000;
         if(code==ERASE_STAT) {
             if((delay % 5000000) == 0) {
-                std::cout << ".";
+                mLog << ".";
             }
         }
     }
@@ -707,17 +554,21 @@ int BPI_Flasher::waitForReady(unsigned code, bool verbose) {
     const timespec req = {0, 5000};
 #endif
     if (verbose) {
-        std::cout << "INFO: Waiting for hardware\n";
+        mLog << "INFO: Waiting for hardware\n";
     }
     while ((status != code) && (delay < 30000000000)) {
+        // Check before sleeping, the hardware is often ready already
+        if (Flasher::flashRead(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET, &status, 4)) {
+            return -ENXIO;
+        }
+        if (status == code) {
+            break;
+        }
 #ifndef _WINDOWS
         // TODO: Windows build support
         //    nanosleep is defined in unistd.h
         nanosleep(&req, 0);
 #endif
-        if (Flasher::flashRead(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET, &status, 4)) {
-            return -ENXIO;
-        }
         delay += 5000;
     }
     return (status == code) ? 0 : -ETIMEDOUT;
@@ -735,13 +586,13 @@ int BPI_Flasher::waitAndFinish_microblaze(unsigned code, unsigned data, bool ver
     const timespec req = {0, 5000};
 #endif
     if (verbose) {
-        std::cout << "INFO: Finishing up\n";
+        mLog << "INFO: Finishing up\n";
     }
     Flasher::flashRead(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET+0x10, &status, 4);
     if(!(status&0x1)){ //0: fifo is not empty
 
         if(Flasher::flashRead(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET+0x8, &status, 4)) {
-            std::cout << "INFO: Failed to read from Mailbox\n";
+            mLog << "INFO: Failed to read from Mailbox\n";
             return -ENXIO;
         }
     }
@@ -757,14 +608,14 @@ int BPI_Flasher::waitAndFinish_microblaze(unsigned code, unsigned data, bool ver
             return 0;
         }
         if (Flasher::flashWrite(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET, &data, 4)) {
-            std::cout << "INFO: Failed to write to Mailbox\n";
+            mLog << "INFO: Failed to write to Mailbox\n";
             return -ENXIO;
         }
 
         if(!(status&0x1)){ //0: fifo is not empty
 
             if(Flasher::flashRead(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET+0x8, &status, 4)) {
-                std::cout << "INFO: Failed to read from Mailbox\n";
+                mLog << "INFO: Failed to read from Mailbox\n";
                 return -ENXIO;
             }
         }
@@ -786,7 +637,7 @@ int BPI_Flasher::waitAndFinish(unsigned code, unsigned data, bool verbose) {
     const timespec req = {0, 5000};
 #endif
     if (verbose) {
-        std::cout << "INFO: Finishing up\n";
+        mLog << "INFO: Finishing up\n";
     }
     if (Flasher::flashRead(/*SHIM_MGMT_BAR*/0, BPI_FLASH_OFFSET, &status, 4)) {
         return -ENXIO;
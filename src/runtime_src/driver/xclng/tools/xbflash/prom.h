@@ -20,39 +20,31 @@
 #ifndef _PROM_H_
 #define _PROM_H_
 
-#include <list>
 #include <sys/stat.h>
 #include <iostream>
+#include "mcs_image.h"
+#include "flash_progress.h"
 
 class BPI_Flasher
 {
-    struct ELARecord
-    {
-        unsigned mStartAddress;
-        unsigned mEndAddress;
-        unsigned mDataCount;
-        std::streampos mDataPos;
-        ELARecord() : mStartAddress(0), mEndAddress(0), mDataCount(0), mDataPos(0) {}
-    };
-
-    typedef std::list<ELARecord> ELARecordList;
-    ELARecordList mRecordList;
-
 public:
-    BPI_Flasher( unsigned int device_index, char *inMap );
+    BPI_Flasher( unsigned int device_index, char *inMap, FlashProgress *progress = nullptr );
     ~BPI_Flasher();
     int xclUpgradeFirmware(std::istream& mcsStream);
+    int xclUpgradeFirmware(const McsImage& image);
 
 private:
     char *mMgmtMap;
+    FlashProgress& mProgress;
+    std::ostream& mLog;
 
     int freezeAXIGate();
     int freeAXIGate();
     int prepare_microblaze(unsigned startAddress, unsigned endAddress);
     int prepare(unsigned startAddress, unsigned endAddress);
-    int program_microblaze(std::istream& mcsStream, const ELARecord& record);
-    int program(std::istream& mcsStream, const ELARecord& record);
-    int program(std::istream& mcsStream);
+    int program_microblaze(const McsImage::Segment& segment);
+    int program(const McsImage::Segment& segment);
+    int program(const McsImage& image);
     int waitForReady_microblaze(unsigned code, bool verbose = true);
     int waitForReady(unsigned code, bool verbose = true);
     int waitAndFinish_microblaze(unsigned code, unsigned data, bool verbose = true);
@@ -0,0 +1,391 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _XBFLASH_TEST_MOCK_FLASH_H_
+#define _XBFLASH_TEST_MOCK_FLASH_H_
+
+#include "xspi.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Mock of the AXI Quad SPI controller and of the SPI flash on each of
+// its two slave selects.
+//
+// The controller registers behave as used by XSPI_Flasher: bytes
+// written to DTR are shifted out to the selected flash once the
+// transfer is no longer inhibited, the bytes shifted in are queued for
+// DRR, and deselecting the slave ends the flash command.  The flash
+// decodes the command set of the Micron parts driven by xbflash.
+// Program only clears bits, and commands other than status reads sent
+// while the flash is busy are ignored and counted as violations.
+class MockFlash
+{
+public:
+  struct Stats
+  {
+    uint64_t regReads = 0;
+    uint64_t regWrites = 0;
+    uint64_t erases = 0;
+    uint64_t pagePrograms = 0;
+    uint64_t bytesProgrammed = 0;
+    uint64_t reads = 0;
+    uint64_t busyViolations = 0;
+
+    // Estimated time on a board: ~1us per register access over PCIe,
+    // 50ms per 4KB subsector erase and 0.2ms per page program
+    double estimatedSeconds() const
+    {
+      return (regReads + regWrites) * 1e-6 + erases * 50e-3 + pagePrograms * 0.2e-3;
+    }
+  };
+
+  // Capacity code 0x19 is a 256Mb part, 2 sectors of 16MB.  busyPolls
+  // is the number of status reads the flash stays busy after an erase
+  // or a program.
+  MockFlash(uint8_t capacityCode = 0x19, unsigned busyPolls = 1)
+    : mCapacityCode(capacityCode), mBusyPolls(busyPolls)
+  {
+    size_t size = size_t(16) << 20 << (capacityCode > 0x18 ? capacityCode - 0x18 : 0);
+    for (auto& dev : mDevices)
+      dev.mem.assign(size, 0xff);
+  }
+
+  std::vector<uint8_t>& memory(int slave) { return mDevices[slave].mem; }
+  Stats stats;
+
+  unsigned
+  readReg(unsigned offset)
+  {
+    ++stats.regReads;
+    switch (offset) {
+    case CR:
+      return mCR;
+    case SR: {
+      unsigned sr = 0;
+      if (mRx.empty())
+        sr |= SR_RX_EMPTY;
+      if (mRx.size() >= FIFO_DEPTH)
+        sr |= SR_RX_FULL;
+      if (mTx.empty())
+        sr |= SR_TX_EMPTY;
+      if (mTx.size() >= FIFO_DEPTH)
+        sr |= SR_TX_FULL;
+      return sr;
+    }
+    case DRR: {
+      if (mRx.empty())
+        return 0;
+      unsigned value = mRx.front();
+      mRx.pop_front();
+      return value;
+    }
+    case SSR:
+      return mSSR;
+    case TFO:
+      return mTx.empty() ? 0 : mTx.size() - 1;
+    case RFO:
+      return mRx.empty() ? 0 : mRx.size() - 1;
+    default:
+      return 0;
+    }
+  }
+
+  void
+  writeReg(unsigned offset, unsigned value)
+  {
+    ++stats.regWrites;
+    switch (offset) {
+    case CR:
+      if (value & CR_TXFIFO_RESET)
+        mTx.clear();
+      if (value & CR_RXFIFO_RESET)
+        mRx.clear();
+      mCR = value & ~(CR_TXFIFO_RESET | CR_RXFIFO_RESET);
+      break;
+    case DTR:
+      if (mTx.size() < FIFO_DEPTH)
+        mTx.push_back(value & 0xff);
+      break;
+    case SSR: {
+      int before = selected();
+      mSSR = value;
+      if (before >= 0 && before != selected())
+        endCommand(mDevices[before]);
+      break;
+    }
+    default:
+      break;
+    }
+    shift();
+  }
+
+private:
+  static const unsigned CR = 0x60, SR = 0x64, DTR = 0x68, DRR = 0x6C;
+  static const unsigned SSR = 0x70, TFO = 0x74, RFO = 0x78;
+  static const unsigned CR_ENABLE = 0x2, CR_MASTER = 0x4;
+  static const unsigned CR_TXFIFO_RESET = 0x20, CR_RXFIFO_RESET = 0x40;
+  static const unsigned CR_INHIBIT = 0x100;
+  static const unsigned SR_RX_EMPTY = 0x1, SR_RX_FULL = 0x2;
+  static const unsigned SR_TX_EMPTY = 0x4, SR_TX_FULL = 0x8;
+  static const size_t FIFO_DEPTH = 256;
+
+  struct Device
+  {
+    std::vector<uint8_t> mem;
+    std::vector<uint8_t> cmd;       // bytes of the current command
+    bool wel = false;
+    bool fourByte = false;
+    uint8_t extAddr = 0;
+    unsigned busy = 0;
+  };
+
+  int
+  selected() const
+  {
+    if ((mSSR & 0x1) == 0)
+      return 0;
+    if ((mSSR & 0x2) == 0)
+      return 1;
+    return -1;
+  }
+
+  void
+  shift()
+  {
+    int slave = selected();
+    if (slave < 0 || (mCR & CR_INHIBIT) || !(mCR & CR_ENABLE) || !(mCR & CR_MASTER))
+      return;
+    while (!mTx.empty()) {
+      uint8_t out = transfer(mDevices[slave], mTx.front());
+      mTx.pop_front();
+      if (mRx.size() < FIFO_DEPTH)
+        mRx.push_back(out);
+    }
+  }
+
+  static bool
+  isStatusRead(uint8_t op)
+  {
+    return op == 0x05 || op == 0x70;
+  }
+
+  // Number of address bytes and dummy bytes before read data
+  static bool
+  readLayout(const Device& dev, uint8_t op, unsigned& addrBytes, unsigned& dummy)
+  {
+    switch (op) {
+    case 0x03: addrBytes = dev.fourByte ? 4 : 3; dummy = 0; return true;
+    case 0x0B: addrBytes = dev.fourByte ? 4 : 3; dummy = 1; return true;
+    case 0x6B: addrBytes = dev.fourByte ? 4 : 3; dummy = 4; return true;
+    case 0x13: addrBytes = 4; dummy = 0; return true;
+    case 0x0C: addrBytes = 4; dummy = 1; return true;
+    case 0x6C: addrBytes = 4; dummy = 4; return true;
+    default: return false;
+    }
+  }
+
+  size_t
+  address(const Device& dev, unsigned addrBytes) const
+  {
+    size_t addr = 0;
+    for (unsigned i = 1; i <= addrBytes; ++i)
+      addr = (addr << 8) | dev.cmd[i];
+    if (addrBytes == 3)
+      addr |= size_t(dev.extAddr) << 24;
+    return addr % dev.mem.size();
+  }
+
+  uint8_t
+  transfer(Device& dev, uint8_t in)
+  {
+    dev.cmd.push_back(in);
+    size_t pos = dev.cmd.size() - 1;
+    if (pos == 0)
+      return 0;
+
+    uint8_t op = dev.cmd[0];
+    if (op == 0x05) {
+      uint8_t status = (dev.busy ? 0x1 : 0) | (dev.wel ? 0x2 : 0);
+      if (dev.busy)
+        --dev.busy;
+      return status;
+    }
+    if (op == 0x70)
+      return dev.busy ? 0x00 : 0x80;
+    if (dev.busy)
+      return 0;
+    if (op == 0x9F) {
+      const uint8_t id[] = { 0x20, 0xBA, mCapacityCode, 0x10, 0x00 };
+      return pos <= sizeof(id) ? id[pos - 1] : 0;
+    }
+    if (op == 0xC8)
+      return dev.extAddr;
+
+    unsigned addrBytes, dummy;
+    if (readLayout(dev, op, addrBytes, dummy) && pos > addrBytes + dummy) {
+      size_t addr = address(dev, addrBytes) + (pos - addrBytes - dummy - 1);
+      return dev.mem[addr % dev.mem.size()];
+    }
+    return 0;
+  }
+
+  void
+  endCommand(Device& dev)
+  {
+    std::vector<uint8_t> cmd;
+    cmd.swap(dev.cmd);
+    if (cmd.empty())
+      return;
+
+    uint8_t op = cmd[0];
+    if (dev.busy && !isStatusRead(op)) {
+      ++stats.busyViolations;
+      return;
+    }
+
+    dev.cmd = cmd;
+    unsigned addrBytes = dev.fourByte ? 4 : 3;
+    switch (op) {
+    case 0x06:
+      dev.wel = true;
+      break;
+    case 0x04:
+      dev.wel = false;
+      break;
+    case 0xB7:
+      dev.fourByte = true;
+      break;
+    case 0xE9:
+      dev.fourByte = false;
+      break;
+    case 0xC5:
+      if (dev.wel && cmd.size() >= 2)
+        dev.extAddr = cmd[1];
+      dev.wel = false;
+      break;
+    case 0x20: case 0x52: case 0xD8: case 0xDC: case 0xC7: {
+      if (!dev.wel)
+        break;
+      size_t size = dev.mem.size(), base = 0;
+      if (op != 0xC7) {
+        if (op == 0xDC)
+          addrBytes = 4;
+        if (cmd.size() < addrBytes + 1)
+          break;
+        size = (op == 0x20) ? 0x1000 : (op == 0x52) ? 0x8000 : 0x10000;
+        base = address(dev, addrBytes) & ~(size - 1);
+      }
+      std::fill(dev.mem.begin() + base, dev.mem.begin() + base + size, 0xff);
+      ++stats.erases;
+      dev.wel = false;
+      dev.busy = mBusyPolls;
+      break;
+    }
+    case 0x02: case 0x32: case 0x38: case 0x12: case 0x34: case 0x3E: {
+      if (!dev.wel)
+        break;
+      if (op == 0x12 || op == 0x34 || op == 0x3E)
+        addrBytes = 4;
+      if (cmd.size() <= addrBytes + 1)
+        break;
+      size_t addr = address(dev, addrBytes);
+      size_t page = addr & ~size_t(0xff);
+      size_t count = cmd.size() - addrBytes - 1;
+      for (size_t i = 0; i < count; ++i)
+        dev.mem[page | ((addr + i) & 0xff)] &= cmd[addrBytes + 1 + i];
+      ++stats.pagePrograms;
+      stats.bytesProgrammed += count;
+      dev.wel = false;
+      dev.busy = mBusyPolls;
+      break;
+    }
+    case 0x01: case 0xB1: case 0x81: case 0x61:
+      dev.wel = false;
+      break;
+    default: {
+      unsigned dummy;
+      if (readLayout(dev, op, addrBytes, dummy))
+        ++stats.reads;
+      break;
+    }
+    }
+    dev.cmd.clear();
+  }
+
+private:
+  uint8_t mCapacityCode;
+  unsigned mBusyPolls;
+  unsigned mCR = 0;
+  unsigned mSSR = 0xffffffff;
+  std::deque<uint8_t> mTx;
+  std::deque<uint8_t> mRx;
+  Device mDevices[2];
+};
+
+// XSPI_Flasher with its register accesses going to a MockFlash
+class MockXSPI_Flasher : public XSPI_Flasher
+{
+public:
+  explicit MockXSPI_Flasher(MockFlash& flash, FlashProgress* progress = nullptr)
+    : XSPI_Flasher(0, reinterpret_cast<char*>(&flash), progress), mFlash(flash)
+  {}
+
+protected:
+  unsigned readReg(unsigned offset) override { return mFlash.readReg(offset); }
+  int writeReg(unsigned offset, unsigned value) override { mFlash.writeReg(offset, value); return 0; }
+
+private:
+  MockFlash& mFlash;
+};
+
+// MCS text for data at address, 16 bytes per record
+inline std::string
+makeMcs(uint32_t address, const std::vector<uint8_t>& data)
+{
+  std::string mcs;
+  char line[64];
+  auto record = [&](unsigned type, unsigned addr, const uint8_t* bytes, unsigned len) {
+    unsigned sum = len + (addr >> 8) + (addr & 0xff) + type;
+    int n = std::sprintf(line, ":%02X%04X%02X", len, addr & 0xffff, type);
+    for (unsigned i = 0; i < len; ++i) {
+      n += std::sprintf(line + n, "%02X", bytes[i]);
+      sum += bytes[i];
+    }
+    std::sprintf(line + n, "%02X\r\n", (0x100 - (sum & 0xff)) & 0xff);
+    mcs += line;
+  };
+
+  uint32_t ela = ~0u;
+  for (size_t offset = 0; offset < data.size(); offset += 16) {
+    uint32_t addr = address + offset;
+    if ((addr >> 16) != ela) {
+      ela = addr >> 16;
+      uint8_t hi[] = { uint8_t(ela >> 8), uint8_t(ela) };
+      record(0x04, 0, hi, 2);
+    }
+    unsigned len = std::min<size_t>(16, data.size() - offset);
+    record(0x00, addr, &data[offset], len);
+  }
+  record(0x01, 0, nullptr, 0);
+  return mcs;
+}
+
+#endif
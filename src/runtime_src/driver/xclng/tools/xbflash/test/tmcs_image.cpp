@@ -0,0 +1,134 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "mcs_image.h"
+#include "mock_flash.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+// % xbflashtest --run_test=test_mcs_image
+
+namespace {
+
+static std::vector<uint8_t>
+pattern(size_t size, unsigned seed)
+{
+  std::vector<uint8_t> data(size);
+  for (size_t i = 0; i < size; ++i)
+    data[i] = static_cast<uint8_t>((i * 31 + seed) ^ (i >> 8));
+  return data;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE ( test_mcs_image )
+
+BOOST_AUTO_TEST_CASE( segments )
+{
+  // Contiguous across an ELA boundary, then a gap
+  auto first = pattern(0x10000 + 40, 1);
+  auto second = pattern(100, 2);
+  std::string mcs = makeMcs(0x0100ffe0, first);
+  mcs.erase(mcs.rfind(':'));                     // drop end record
+  mcs += makeMcs(0x02000000, second);
+
+  std::istringstream stream(mcs);
+  McsImage image;
+  BOOST_CHECK_EQUAL(image.parse(stream), 0);
+  BOOST_REQUIRE_EQUAL(image.segments().size(), 2);
+  BOOST_CHECK_EQUAL(image.segments()[0].mAddress, 0x0100ffe0);
+  BOOST_CHECK(image.segments()[0].mData == first);
+  BOOST_CHECK_EQUAL(image.segments()[1].mAddress, 0x02000000);
+  BOOST_CHECK(image.segments()[1].mData == second);
+  BOOST_CHECK_EQUAL(image.size(), first.size() + second.size());
+
+  auto sectors = image.getSectors(0x1000);
+  BOOST_REQUIRE_EQUAL(sectors.size(), 19);
+  BOOST_CHECK_EQUAL(sectors.front(), 0x0100f000);
+  BOOST_CHECK_EQUAL(sectors[17], 0x01020000);
+  BOOST_CHECK_EQUAL(sectors.back(), 0x02000000);
+
+  // Bytes outside the image read as erased
+  std::vector<uint8_t> buf(0x20);
+  BOOST_CHECK(image.read(0x0100ffd0, buf.data(), buf.size()));
+  for (size_t i = 0; i < 0x10; ++i)
+    BOOST_CHECK_EQUAL(buf[i], 0xff);
+  BOOST_CHECK(std::equal(buf.begin() + 0x10, buf.end(), first.begin()));
+  BOOST_CHECK(!image.read(0x03000000, buf.data(), buf.size()));
+
+  image.shift(0x1000);
+  BOOST_CHECK_EQUAL(image.segments()[0].mAddress, 0x01010fe0);
+}
+
+BOOST_AUTO_TEST_CASE( malformed )
+{
+  std::string good = makeMcs(0, pattern(64, 3));
+  {
+    std::istringstream stream(good);
+    McsImage image;
+    BOOST_CHECK_EQUAL(image.parse(stream), 0);
+  }
+  {
+    // Bad checksum
+    std::string bad = good;
+    size_t pos = bad.find(":10");
+    bad[pos + 9] = (bad[pos + 9] == '0') ? '1' : '0';
+    std::istringstream stream(bad);
+    McsImage image;
+    BOOST_CHECK_EQUAL(image.parse(stream), -EINVAL);
+  }
+  {
+    // Not a record
+    std::istringstream stream("garbage\n" + good);
+    McsImage image;
+    BOOST_CHECK_EQUAL(image.parse(stream), -EINVAL);
+  }
+  {
+    // Extended segment address
+    std::istringstream stream(":020000021000EC\n" + good);
+    McsImage image;
+    BOOST_CHECK_EQUAL(image.parse(stream), -EINVAL);
+  }
+  {
+    std::istringstream stream(":00000001FF\n");
+    McsImage image;
+    BOOST_CHECK_EQUAL(image.parse(stream), -EINVAL);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( parse_bw )
+{
+  const size_t size = 32 << 20;
+  auto data = pattern(size, 4);
+  std::string mcs = makeMcs(0, data);
+
+  std::istringstream stream(mcs);
+  McsImage image;
+  auto start = std::chrono::high_resolution_clock::now();
+  BOOST_CHECK_EQUAL(image.parse(stream), 0);
+  auto end = std::chrono::high_resolution_clock::now();
+  BOOST_CHECK_EQUAL(image.size(), size);
+
+  double sec = std::chrono::duration<double>(end - start).count();
+  std::cout << "MCS decode: " << (mcs.size() >> 20) << " MB text in " << sec
+            << " s, " << (mcs.size() / sec / (1 << 20)) << " MB/s" << std::endl;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,258 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "flasher.h"
+#include "mock_flash.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+// % xbflashtest --run_test=test_xspi
+
+// xspi.cpp reaches the card through these, they are never called since
+// MockXSPI_Flasher overrides the register accessors
+int Flasher::flashRead(unsigned int, unsigned long long, void*, unsigned long long) { return -ENODEV; }
+int Flasher::flashWrite(unsigned int, unsigned long long, const void*, unsigned long long) { return -ENODEV; }
+
+namespace {
+
+static std::vector<uint8_t>
+pattern(size_t size, unsigned seed)
+{
+  std::vector<uint8_t> data(size);
+  for (size_t i = 0; i < size; ++i)
+    data[i] = static_cast<uint8_t>((i * 13 + seed) ^ (i >> 9));
+  return data;
+}
+
+static int
+program(MockFlash& flash, uint32_t address, const std::vector<uint8_t>& data, bool delta, int slave = 0)
+{
+  std::istringstream stream(makeMcs(address, data));
+  MockXSPI_Flasher xspi(flash);
+  return xspi.xclUpgradeFirmwareXSpi(stream, slave, delta);
+}
+
+static bool
+holds(MockFlash& flash, uint32_t address, const std::vector<uint8_t>& data, int slave = 0)
+{
+  auto& mem = flash.memory(slave);
+  return std::equal(data.begin(), data.end(), mem.begin() + address);
+}
+
+static bool
+erased(MockFlash& flash, uint32_t address, size_t size, int slave = 0)
+{
+  auto& mem = flash.memory(slave);
+  return std::all_of(mem.begin() + address, mem.begin() + address + size,
+                     [](uint8_t b) { return b == 0xff; });
+}
+
+static void
+report(const char* what, size_t bytes, const MockFlash::Stats& stats, double wall)
+{
+  std::cout << what << ": " << (bytes >> 10) << " KB, "
+            << stats.erases << " erases, " << stats.pagePrograms << " page programs, "
+            << (stats.regReads + stats.regWrites) << " register accesses, "
+            << wall << " s host, ~" << stats.estimatedSeconds() << " s on a board"
+            << std::endl;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE ( test_xspi )
+
+BOOST_AUTO_TEST_CASE( program_full )
+{
+  MockFlash flash;
+  auto data = pattern(0x10000 + 100, 1);
+  BOOST_CHECK_EQUAL(program(flash, 0, data, false), 0);
+  BOOST_CHECK(holds(flash, 0, data));
+  BOOST_CHECK(erased(flash, data.size(), 0x1000));
+  BOOST_CHECK_EQUAL(flash.stats.erases, 17);
+  BOOST_CHECK_EQUAL(flash.stats.pagePrograms, (data.size() + 127) / 128);
+  BOOST_CHECK_EQUAL(flash.stats.busyViolations, 0);
+}
+
+BOOST_AUTO_TEST_CASE( bitstream_guard )
+{
+  // Data is written below the guard, which is cleared when done
+  MockFlash flash;
+  auto data = pattern(20000, 2);
+  flash.memory(0)[0x01000010] = 0;
+  BOOST_CHECK_EQUAL(program(flash, 0x01000000, data, false), 0);
+  BOOST_CHECK(holds(flash, 0x01001000, data));
+  BOOST_CHECK(erased(flash, 0x01000000, 0x1000));
+  BOOST_CHECK(erased(flash, 0, 0x1000));
+  BOOST_CHECK_EQUAL(flash.stats.busyViolations, 0);
+}
+
+BOOST_AUTO_TEST_CASE( program_delta )
+{
+  MockFlash flash;
+  auto a = pattern(0x10000, 3);
+  BOOST_CHECK_EQUAL(program(flash, 0, a, false), 0);
+
+  // Sectors 2 and 7 set bits and need an erase, sector 5 only clears bits
+  auto b = a;
+  size_t pos2 = 0x2010, pos5 = 0x5100, pos7 = 0x7f00;
+  while (a[pos2] == 0xff)
+    ++pos2;
+  while (a[pos7] == 0xff)
+    ++pos7;
+  while ((a[pos5] & 0xf0) == 0)
+    ++pos5;
+  b[pos2] = 0xff;
+  b[pos7] = 0xff;
+  b[pos5] = a[pos5] & 0x0f;
+
+  flash.stats = MockFlash::Stats();
+  BOOST_CHECK_EQUAL(program(flash, 0, b, true), 0);
+  BOOST_CHECK(holds(flash, 0, b));
+  BOOST_CHECK_EQUAL(flash.stats.erases, 2);
+  BOOST_CHECK_EQUAL(flash.stats.pagePrograms, 2 * 32 + 1);
+  BOOST_CHECK_EQUAL(flash.stats.busyViolations, 0);
+
+  // Nothing left to do
+  flash.stats = MockFlash::Stats();
+  BOOST_CHECK_EQUAL(program(flash, 0, b, true), 0);
+  BOOST_CHECK(holds(flash, 0, b));
+  BOOST_CHECK_EQUAL(flash.stats.erases, 0);
+  BOOST_CHECK_EQUAL(flash.stats.pagePrograms, 0);
+}
+
+BOOST_AUTO_TEST_CASE( delta_guard )
+{
+  MockFlash flash;
+  auto data = pattern(0x8000, 4);
+  BOOST_CHECK_EQUAL(program(flash, 0x00100000, data, false), 0);
+
+  // Up to date, the guard is not touched
+  flash.stats = MockFlash::Stats();
+  BOOST_CHECK_EQUAL(program(flash, 0x00100000, data, true), 0);
+  BOOST_CHECK_EQUAL(flash.stats.erases, 0);
+
+  // A guard left by an interrupted update is cleared
+  flash.memory(0)[0x00100080] = 0;
+  flash.stats = MockFlash::Stats();
+  BOOST_CHECK_EQUAL(program(flash, 0x00100000, data, true), 0);
+  BOOST_CHECK(erased(flash, 0x00100000, 0x1000));
+  BOOST_CHECK(holds(flash, 0x00101000, data));
+  BOOST_CHECK_EQUAL(flash.stats.erases, 2);
+}
+
+BOOST_AUTO_TEST_CASE( two_slaves )
+{
+  // Each flash has its own extended address register
+  MockFlash flash;
+  auto primary = pattern(0x3000, 5);
+  auto secondary = pattern(0x3000, 6);
+  std::istringstream stream1(makeMcs(0x01000000, primary));
+  std::istringstream stream2(makeMcs(0x01000000, secondary));
+  MockXSPI_Flasher xspi(flash);
+  BOOST_CHECK_EQUAL(xspi.xclUpgradeFirmware2(stream1, stream2), 0);
+  BOOST_CHECK(holds(flash, 0x01001000, primary, 0));
+  BOOST_CHECK(holds(flash, 0x01001000, secondary, 1));
+  BOOST_CHECK(erased(flash, 0x00001000, 0x3000, 1));
+}
+
+BOOST_AUTO_TEST_CASE( parallel_cards )
+{
+  // One image decoded once and programmed to several cards at once, each
+  // card from its own thread with its own log and progress
+  const unsigned cards = 4;
+  auto data = pattern(0x20000, 8);
+  McsImage image;
+  std::istringstream stream(makeMcs(0x01000000, data));
+  BOOST_REQUIRE_EQUAL(image.parse(stream), 0);
+
+  std::vector<std::unique_ptr<MockFlash>> flashes;
+  std::vector<std::unique_ptr<std::ostringstream>> logs;
+  std::vector<std::unique_ptr<FlashProgress>> progress;
+  for (unsigned i = 0; i < cards; ++i) {
+    flashes.emplace_back(new MockFlash);
+    logs.emplace_back(new std::ostringstream);
+    progress.emplace_back(new FlashProgress(*logs.back()));
+  }
+  // Card 1 is up to date, card 2 holds an older image
+  BOOST_CHECK_EQUAL(program(*flashes[1], 0x01000000, data, false), 0);
+  BOOST_CHECK_EQUAL(program(*flashes[2], 0x01000000, pattern(0x20000, 9), false), 0);
+  for (auto& flash : flashes)
+    flash->stats = MockFlash::Stats();
+
+  std::vector<int> results(cards, -1);
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < cards; ++i) {
+    workers.emplace_back([&, i] {
+      MockXSPI_Flasher xspi(*flashes[i], progress[i].get());
+      results[i] = xspi.xclUpgradeFirmwareXSpi(image, 0, true);
+      progress[i]->finish(results[i]);
+    });
+  }
+  for (auto& w : workers)
+    w.join();
+
+  for (unsigned i = 0; i < cards; ++i) {
+    BOOST_CHECK_EQUAL(results[i], 0);
+    BOOST_CHECK_EQUAL(progress[i]->phase(), FlashProgress::DONE);
+    BOOST_CHECK(holds(*flashes[i], 0x01001000, data));
+    BOOST_CHECK(erased(*flashes[i], 0x01000000, 0x1000));
+    BOOST_CHECK_EQUAL(flashes[i]->stats.busyViolations, 0);
+  }
+  BOOST_CHECK_EQUAL(flashes[1]->stats.erases, 0);
+  BOOST_CHECK(logs[1]->str().find("Flash is up-to-date") != std::string::npos);
+  // Erased flash only needs programming, the older image an erase
+  BOOST_CHECK_EQUAL(flashes[0]->stats.pagePrograms, 0x20000 / 128 + 1);
+  BOOST_CHECK(flashes[2]->stats.erases > 0);
+  BOOST_CHECK_EQUAL(progress[0]->total(), 0x20000 / 0x1000);
+  BOOST_CHECK_EQUAL(progress[0]->done(), progress[0]->total());
+
+  // The shared image is left as decoded
+  BOOST_CHECK_EQUAL(image.segments().front().mAddress, 0x01000000);
+}
+
+BOOST_AUTO_TEST_CASE( program_bw )
+{
+  const size_t size = 4 << 20;
+  auto a = pattern(size, 7);
+  MockFlash flash;
+
+  auto start = std::chrono::high_resolution_clock::now();
+  BOOST_CHECK_EQUAL(program(flash, 0, a, false), 0);
+  auto end = std::chrono::high_resolution_clock::now();
+  BOOST_CHECK(holds(flash, 0, a));
+  report("Full program", size, flash.stats, std::chrono::duration<double>(end - start).count());
+
+  // Change one byte in 1% of the subsectors
+  auto b = a;
+  for (size_t addr = 0x800; addr < size; addr += 100 * 0x1000)
+    b[addr] ^= 0x5a;
+
+  flash.stats = MockFlash::Stats();
+  start = std::chrono::high_resolution_clock::now();
+  BOOST_CHECK_EQUAL(program(flash, 0, b, true), 0);
+  end = std::chrono::high_resolution_clock::now();
+  BOOST_CHECK(holds(flash, 0, b));
+  BOOST_CHECK_EQUAL(flash.stats.erases, (size / 0x1000 + 99) / 100);
+  report("Delta program", size, flash.stats, std::chrono::duration<double>(end - start).count());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
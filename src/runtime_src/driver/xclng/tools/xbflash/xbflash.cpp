@@ -22,13 +22,17 @@
 #include <getopt.h>
 #include <memory>
 #include <iomanip>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <chrono>
 #include "flasher.h"
 #include "scan.h"
 #include "firmware_image.h"
 
 const char* UsageMessages[] = {
-    "[-d card] -m primary_mcs [-n secondary_mcs] [-o spi|bpi]'",
-    "[-d card] -a <all | dsa> [-t timestamp]",
+    "[-d card] -m primary_mcs [-n secondary_mcs] [-o spi|bpi] [-i]'",
+    "[-d card] -a <all | dsa> [-t timestamp] [-i]",
     "[-d card] -p msp432_firmware",
     "scan [-v]",
 };
@@ -67,10 +71,19 @@ struct T_Arguments
     std::string dsa;
     uint64_t timestamp = 0;
     bool force = false;
+    bool delta = false;
 };
 
-// Flashing DSA on the board.
-int flashDSA(Flasher& f, DSAInfo& dsa)
+// MCS images of a DSA, decoded once and shared by all cards updated to it
+struct DSAImages
+{
+    McsImage primary;
+    McsImage secondary;
+    bool hasSecondary = false;
+};
+
+// Decoding DSA images.
+int loadDSA(DSAInfo& dsa, DSAImages& images)
 {
     std::shared_ptr<firmwareImage> primary;
     std::shared_ptr<firmwareImage> secondary;
@@ -107,11 +120,26 @@ int flashDSA(Flasher& f, DSAInfo& dsa)
     if (primary == nullptr)
         return -EINVAL;
 
-    return f.upgradeFirmware("", primary.get(), secondary.get());
+    if (images.primary.parse(*primary) ||
+        (secondary != nullptr && images.secondary.parse(*secondary)))
+    {
+        std::cout << "ERROR: Invalid MCS file in " << dsa.file << std::endl;
+        return -EINVAL;
+    }
+    images.hasSecondary = (secondary != nullptr);
+    return 0;
+}
+
+// Flashing DSA on the board.
+int flashDSA(Flasher& f, const DSAImages& images, bool delta,
+    FlashProgress& progress)
+{
+    return f.upgradeFirmware("", &images.primary,
+        images.hasSecondary ? &images.secondary : nullptr, delta, &progress);
 }
 
 // Flashing BMC on the board.
-int flashBMC(Flasher& f, DSAInfo& dsa)
+int flashBMC(Flasher& f, DSAInfo& dsa, FlashProgress& progress)
 {
     std::shared_ptr<firmwareImage> bmc;
 
@@ -125,7 +153,7 @@ int flashBMC(Flasher& f, DSAInfo& dsa)
     if (bmc == nullptr)
         return -EINVAL;
 
-    return f.upgradeBMCFirmware(bmc.get());
+    return f.upgradeBMCFirmware(bmc.get(), &progress);
 }
 
 unsigned selectDSA(unsigned idx, std::string& dsa, uint64_t ts)
@@ -205,11 +233,36 @@ unsigned selectDSA(unsigned idx, std::string& dsa, uint64_t ts)
     return candidateDSAIndex;
 }
 
-int updateDSA(unsigned boardIdx, unsigned dsaIdx, bool& reboot)
+/*
+ * Update of one card
+ *
+ * What to update is decided and the images are decoded before any card is
+ * flashed. Several cards are then flashed at once, one thread per card,
+ * each logging to its own buffer which is printed when all are done.
+ */
+struct CardUpdate
 {
-    reboot = false;
+    unsigned boardIdx;
+    std::unique_ptr<Flasher> flasher;
+    DSAInfo candidate;
+    std::shared_ptr<const DSAImages> images;
+    bool updateBMC = false;
+    bool updateDSA = false;
+    std::stringstream log;
+    FlashProgress progress;
+
+    CardUpdate(unsigned idx, bool buffered) : boardIdx(idx), candidate(""),
+        progress(buffered ? static_cast<std::ostream&>(log) : std::cout) {}
+};
+
+typedef std::map<std::string, std::shared_ptr<const DSAImages>> DSAImageCache;
 
-    Flasher flasher(boardIdx);
+int prepareUpdate(CardUpdate& update, unsigned dsaIdx, DSAImageCache& cache)
+{
+    unsigned boardIdx = update.boardIdx;
+
+    update.flasher = std::unique_ptr<Flasher>(new Flasher(boardIdx));
+    Flasher& flasher = *update.flasher;
     if(!flasher.isValid())
     {
         std::cout << "card not available" << std::endl;
@@ -231,37 +284,99 @@ int updateDSA(unsigned boardIdx, unsigned dsaIdx, bool& reboot)
     }
     if (same_dsa && same_bmc)
     {
-        std::cout << "update not needed" << std::endl;
+        std::cout << "update not needed on card[" << boardIdx << "]"
+            << std::endl;
         return -EINVAL;
     }
 
-    if (!same_bmc)
+    update.candidate = candidate;
+    update.updateBMC = !same_bmc;
+    update.updateDSA = !same_dsa;
+    if (!update.updateDSA)
+        return 0;
+
+    auto it = cache.find(candidate.file);
+    if (it == cache.end())
+    {
+        std::shared_ptr<DSAImages> images = std::make_shared<DSAImages>();
+        int ret = loadDSA(candidate, *images);
+        if (ret != 0)
+        {
+            std::cout << "Failed to load DSA for card[" << boardIdx << "]"
+                << std::endl;
+            return ret;
+        }
+        it = cache.insert(std::make_pair(candidate.file, images)).first;
+    }
+    update.images = it->second;
+    return 0;
+}
+
+void runUpdate(CardUpdate& update, bool delta)
+{
+    std::ostream& log = update.progress.log();
+    unsigned boardIdx = update.boardIdx;
+    int ret = 0;
+
+    if (update.updateBMC)
     {
-        std::cout << "Updating BMC firmware on card[" << boardIdx << "]"
+        log << "Updating BMC firmware on card[" << boardIdx << "]"
             << std::endl;
-        int ret = flashBMC(flasher, candidate);
+        ret = flashBMC(*update.flasher, update.candidate, update.progress);
         if (ret != 0)
         {
-            std::cout << "Failed to update BMC firmware on card["
+            log << "Failed to update BMC firmware on card["
                 << boardIdx << "]" << std::endl;
-            return ret;
         }
     }
 
-    if (!same_dsa)
+    if (ret == 0 && update.updateDSA)
     {
-        std::cout << "Updating DSA on card[" << boardIdx << "]" << std::endl;
-        int ret = flashDSA(flasher, candidate);
+        log << "Updating DSA on card[" << boardIdx << "]" << std::endl;
+        ret = flashDSA(*update.flasher, *update.images, delta,
+            update.progress);
         if (ret != 0)
         {
-            std::cout << "Failed to update DSA on card[" << boardIdx << "]"
+            log << "Failed to update DSA on card[" << boardIdx << "]"
                 << std::endl;
-            return ret;
         }
-        reboot = true;
     }
 
-    return 0;
+    update.progress.finish(ret);
+}
+
+// Print the state of all cards whenever it changes, until all are finished.
+void reportProgress(std::vector<std::unique_ptr<CardUpdate>>& updates)
+{
+    std::string last;
+    bool finished = false;
+
+    while (!finished)
+    {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+
+        std::stringstream line;
+        finished = true;
+        for (auto& u : updates)
+        {
+            FlashProgress& p = u->progress;
+            FlashProgress::Phase phase = p.phase();
+            line << "Card [" << u->boardIdx << "] "
+                << FlashProgress::phaseName(phase);
+            if (phase != FlashProgress::DONE && phase != FlashProgress::FAILED)
+            {
+                finished = false;
+                if (p.total())
+                    line << " " << p.done() * 100 / p.total() << "%";
+            }
+            line << "  ";
+        }
+        if (line.str() != last)
+        {
+            std::cout << line.str() << std::endl;
+            last = line.str();
+        }
+    }
 }
 
 bool canProceed()
@@ -331,6 +446,7 @@ int main( int argc, char *argv[] )
     bool seen_a = false;
     bool seen_d = false;
     bool seen_f = false;
+    bool seen_i = false;
     bool seen_m = false;
     bool seen_n = false;
     bool seen_o = false;
@@ -339,7 +455,7 @@ int main( int argc, char *argv[] )
     T_Arguments args;
 
     int opt;
-    while( ( opt = getopt( argc, argv, "a:d:fm:n:o:p:t:" ) ) != -1 )
+    while( ( opt = getopt( argc, argv, "a:d:fim:n:o:p:t:" ) ) != -1 )
     {
         switch( opt )
         {
@@ -355,6 +471,11 @@ int main( int argc, char *argv[] )
             notSeenOrDie(seen_f);
             args.force = true;
             break;
+        case 'i':
+            // only update flash sectors which changed
+            notSeenOrDie(seen_i);
+            args.delta = true;
+            break;
         case 'm':
             notSeenOrDie(seen_m);
             args.primary = std::make_shared<firmwareImage>(optarg,
@@ -395,7 +516,7 @@ int main( int argc, char *argv[] )
 
     if(argc > optind || // More options than expected.
         // Combination of options not expected.
-        (seen_p && (seen_m || seen_n || seen_o))    ||
+        (seen_p && (seen_m || seen_n || seen_o || seen_i))    ||
         (seen_a && (seen_m || seen_n || seen_o))    ||
         (seen_t && (!seen_a || args.dsa.compare("all") == 0)))
     {
@@ -426,7 +547,7 @@ int main( int argc, char *argv[] )
         else
         {
             ret = flasher.upgradeFirmware(args.flasherType,
-                args.primary.get(), args.secondary.get());
+                args.primary.get(), args.secondary.get(), args.delta);
             if (ret == 0)
             {
                 std::cout << "DSA image flashed succesfully" << std::endl;
@@ -520,14 +641,46 @@ int main( int argc, char *argv[] )
             exit(-ECANCELED);
         }
 
-        // Perform DSA and BMC updating
+        // Decide what to update and decode the DSA images, the same
+        // images are used for all cards updated to the same DSA
+        bool parallel = (boardsToUpdate.size() > 1);
+        DSAImageCache cache;
+        std::vector<std::unique_ptr<CardUpdate>> updates;
         for (auto p : boardsToUpdate)
         {
-            bool reboot;
-            ret = updateDSA(p.first, p.second, reboot);
-            needreboot |= reboot;
-            if (ret == 0)
+            std::unique_ptr<CardUpdate> u(new CardUpdate(p.first, parallel));
+            if (prepareUpdate(*u, p.second, cache) == 0)
+                updates.push_back(std::move(u));
+        }
+
+        // Perform DSA and BMC updating, all cards at once
+        if (parallel)
+        {
+            std::vector<std::thread> workers;
+            for (auto& u : updates)
+                workers.emplace_back(runUpdate, std::ref(*u), args.delta);
+            reportProgress(updates);
+            for (auto& w : workers)
+                w.join();
+        }
+        else
+        {
+            for (auto& u : updates)
+                runUpdate(*u, args.delta);
+        }
+
+        for (auto& u : updates)
+        {
+            if (parallel)
+            {
+                std::cout << "----- Card [" << u->boardIdx << "] -----"
+                    << std::endl << u->log.str();
+            }
+            if (u->progress.result() == 0)
+            {
+                needreboot |= u->updateDSA;
                 success++;
+            }
         }
     }
 
@@ -31,7 +31,8 @@
 //#define XMC_DEBUG
 #define BMC_JUMP_ADDR   0x201  /* Hard-coded for now */
 
-XMC_Flasher::XMC_Flasher(unsigned int device_index, char *inMap)
+XMC_Flasher::XMC_Flasher(unsigned int device_index, char *inMap, FlashProgress *progress) :
+    mProgress(progress ? *progress : FlashProgress::console()), mLog(mProgress.log())
 {
     unsigned val = 0;
     mMgmtMap = inMap;
@@ -173,24 +174,26 @@ int XMC_Flasher::xclUpgradeFirmware(std::istream& tiTxtStream) {
     tiTxtStream.seekg(0);
 
     if (errorFound) {
-        std::cout << "ERROR: Bad firmware file format." << std::endl;
+        mLog << "ERROR: Bad firmware file format." << std::endl;
         return -EINVAL;
     }
 
     // Start of flashing BMC firmware
-    std::cout << "INFO: found " << mRecordList.size() << " sections" << std::endl;
+    mLog << "INFO: found " << mRecordList.size() << " sections" << std::endl;
     while(retries != 0) {
         retries--;
 
         ret = erase();
+        mProgress.start(FlashProgress::PROGRAMMING, mRecordList.size());
         for (auto i = mRecordList.begin(); ret == 0 && i != mRecordList.end(); ++i) {
             ret = program(tiTxtStream, *i);
+            mProgress.step();
         }
         if(ret == 0)
             break;
-        std::cout << "WARN: Failed to flash firmware, retrying..." << std::endl;
+        mLog << "WARN: Failed to flash firmware, retrying..." << std::endl;
     }
-    std::cout << std::endl;
+    mLog << std::endl;
     // End of flashing BMC firmware
 
     if (ret != 0)
@@ -198,17 +201,17 @@ int XMC_Flasher::xclUpgradeFirmware(std::istream& tiTxtStream) {
 
     // Waiting for BMC to come back online.
     // It should not take more than 10 sec, but wait for 1 min to be safe.
-    std::cout << "INFO: Loading new firmware on BMC" << std::endl;
+    mLog << "INFO: Loading new firmware on BMC" << std::endl;
     for (int i = 0; i < 60; i++) {
         if (BMC_MODE() == 0x1)
             break;
         std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-        std::cout << "." << std::flush;
+        mLog << "." << std::flush;
     }
-    std::cout << std::endl;
+    mLog << std::endl;
     if (BMC_MODE() != 0x1)
     {
-        std::cout << "ERROR: Time'd out waiting for BMC to come back online"
+        mLog << "ERROR: Time'd out waiting for BMC to come back online"
             << std::endl;
         return -ETIMEDOUT;
     }
@@ -240,7 +243,7 @@ int XMC_Flasher::xclGetBoardInfo(std::map<char, std::vector<char>>& info)
     if ((ret = sendPkt(false)) != 0){
         if(ret == XMC_HOST_MSG_BRD_INFO_MISSING_ERR)
         {
-            std::cout << "Unable to get board info, need to upgrade firmware"
+            mLog << "Unable to get board info, need to upgrade firmware"
                 << std::endl;
         }
         return ret;
@@ -276,10 +279,10 @@ int XMC_Flasher::program(std::istream& tiTxtStream, const ELARecord& record)
     const int charPerByte = 2;
 
 #ifdef  XMC_DEBUG
-    std::cout << std::hex;
-    std::cout << "Address=0x" << record.mStartAddress
+    mLog << std::hex;
+    mLog << "Address=0x" << record.mStartAddress
         << std::dec << ", Length=" << record.mDataCount;
-    std::cout<< std::endl;
+    mLog<< std::endl;
 #endif
     tiTxtStream.seekg(record.mDataPos, std::ios_base::beg);
 
@@ -297,7 +300,7 @@ int XMC_Flasher::program(std::istream& tiTxtStream, const ELARecord& record)
 
     while (ndigit < record.mDataCount * charPerByte) {
         if (!tiTxtStream.get(c)) {
-            std::cout << "Cannot read data from firmware file" << std::endl;
+            mLog << "Cannot read data from firmware file" << std::endl;
             return -EIO;
         }
         if (!std::isxdigit(c))
@@ -384,7 +387,7 @@ int XMC_Flasher::recvPkt()
         (mPkt.hdr.payloadSize + sizeof (uint32_t) - 1) / sizeof (uint32_t);
 
     if (lenInUint32 <= 0 || lenInUint32 > xmcMaxPayload) {
-        std::cout << "ERROR: Received bad XMC packet" << std::endl;
+        mLog << "ERROR: Received bad XMC packet" << std::endl;
         return -EINVAL;
     }
 
@@ -406,7 +409,7 @@ int XMC_Flasher::sendPkt(bool print_dot)
     describePkt(mPkt, true);
 #else
     if (print_dot)
-        std::cout << "." << std::flush;
+        mLog << "." << std::flush;
 #endif
 
     uint32_t *pkt = reinterpret_cast<uint32_t *>(&mPkt);
@@ -431,14 +434,14 @@ int XMC_Flasher::waitTillIdle()
     unsigned err = 0;
 
 #ifdef  XMC_DEBUG
-    std::cout << "INFO: Waiting until idle" << std::endl;
+    mLog << "INFO: Waiting until idle" << std::endl;
 #endif
     while ((retry-- > 0) && (readReg(XMC_REG_OFF_CTL) & XMC_PKT_OWNER_MASK)){
         (void) nanosleep(&req, nullptr);
     }
 
     if (retry == 0) {
-        std::cout << "ERROR: Time'd out while waiting for XMC packet to be idle"
+        mLog << "ERROR: Time'd out while waiting for XMC packet to be idle"
             << std::endl;
         return -ETIMEDOUT;
     }
@@ -447,7 +450,7 @@ int XMC_Flasher::waitTillIdle()
         err = readReg(XMC_REG_OFF_PKT_STATUS);
 
     if (err) {
-        std::cout << "ERROR: XMC packet error: " << err << std::endl;
+        mLog << "ERROR: XMC packet error: " << err << std::endl;
         return -EINVAL;
     }
 
@@ -459,7 +462,7 @@ unsigned XMC_Flasher::readReg(unsigned RegOffset) {
     if( Flasher::pcieBarRead(0, (unsigned long long)mMgmtMap +
         XMC_REG_BASE + RegOffset, &value, 4 ) != 0 ) {
         assert(0);
-        std::cout << "read reg ERROR" << std::endl;
+        mLog << "read reg ERROR" << std::endl;
     }
     return value;
 }
@@ -469,7 +472,7 @@ int XMC_Flasher::writeReg(unsigned RegOffset, unsigned value) {
         XMC_REG_BASE + RegOffset, &value, 4);
     if(status != 0) {
         assert(0);
-        std::cout << "write reg ERROR " << std::endl;
+        mLog << "write reg ERROR " << std::endl;
         return -EINVAL;
     }
     return 0;
@@ -23,6 +23,7 @@
 #include <sstream>
 #include <map>
 #include <vector>
+#include "flash_progress.h"
 
 // Register offset in mgmt pf BAR 0
 #define XMC_REG_BASE                0x120000
@@ -91,7 +92,7 @@ class XMC_Flasher
     ELARecordList mRecordList;
 
 public:
-    XMC_Flasher( unsigned int device_index, char *inMap );
+    XMC_Flasher( unsigned int device_index, char *inMap, FlashProgress *progress = nullptr );
     ~XMC_Flasher();
     int xclUpgradeFirmware(std::istream& tiTxtStream);
     int xclGetBoardInfo(std::map<char, std::vector<char>>& info);
@@ -99,6 +100,8 @@ public:
 
 private:
     char *mMgmtMap;
+    FlashProgress& mProgress;
+    std::ostream& mLog;
     unsigned mPktBufOffset;
     struct xmcPkt mPkt;
     std::stringstream mProbingErrMsg;
@@ -16,6 +16,7 @@
  * License for the specific language governing permissions and limitations
  * under the License.
  */
+#include <array>
 #include <iostream>
 #include <string>
 #include <fstream>
@@ -44,8 +45,10 @@
 #define PAGE_SIZE 256
 static const bool FOUR_BYTE_ADDRESSING = false;
 
-uint32_t MAX_NUM_SECTORS = 0;
-uint32_t selected_sector = -1;
+//State of the flash being programmed. xbflash updates several cards at
+//once from one thread per card, so this is kept per thread.
+static thread_local uint32_t MAX_NUM_SECTORS = 0;
+static thread_local uint32_t selected_sector = -1;
 
 //testing sizes.
 #define WRITE_DATA_SIZE 128
@@ -202,7 +205,8 @@ static const unsigned  SECTOR_ERASE_BYTES = FOUR_BYTE_ADDRESSING ? 5 :4;
 #define WDT_ENABLE  0x02000040//0x40000002
 
 #define BITSTREAM_GUARD_SIZE 0x1000
-uint32_t BITSTREAM_START_LOC = -1; //Set to 0xFFFFFFFF
+#define SUBSECTOR_SIZE 0x1000
+static thread_local uint32_t BITSTREAM_START_LOC = -1; //Set to 0xFFFFFFFF
 uint32_t BITSTREAM_GUARD[] = { 
             DUMMY,
             BUSWIDTH1,
@@ -232,18 +236,18 @@ uint32_t BITSTREAM_GUARD[] = {
 
 //---
 
-static uint8_t WriteBuffer[PAGE_SIZE + READ_WRITE_EXTRA_BYTES];
-static uint8_t ReadBuffer[PAGE_SIZE + READ_WRITE_EXTRA_BYTES + 4];
+static thread_local uint8_t WriteBuffer[PAGE_SIZE + READ_WRITE_EXTRA_BYTES];
+static thread_local uint8_t ReadBuffer[PAGE_SIZE + READ_WRITE_EXTRA_BYTES + 4];
 
-static int slave_index = 0;
+static thread_local int slave_index = 0;
 
 static std::array<int,2> flashVendors = {
     MICRON_VENDOR_ID,
     MACRONIX_VENDOR_ID
 };
-static int flashVendor = -1;
+static thread_local int flashVendor = -1;
 
-static bool TEST_MODE = false;
+static thread_local bool TEST_MODE = false;
 static bool TEST_MODE_MCS_ONLY = false;
 
 static const uint32_t CONTROL_REG_START_STATE =  XSP_CR_TRANS_INHIBIT_MASK | XSP_CR_MANUAL_SS_MASK |XSP_CR_RXFIFO_RESET_MASK
@@ -266,7 +270,25 @@ static void clearBuffers() {
     clearWriteBuffer(PAGE_SIZE + READ_WRITE_EXTRA_BYTES);
 }
 
-XSPI_Flasher::XSPI_Flasher( unsigned int device_index, char *inMap )
+static bool isErased(const unsigned char *data, unsigned length) {
+    for(unsigned i = 0; i < length; ++i) {
+        if(data[i] != 0xff)
+            return false;
+    }
+    return true;
+}
+
+//Programming can only clear bits, anything else needs an erase first.
+static bool onlyClearsBits(const unsigned char *current, const unsigned char *data, unsigned length) {
+    for(unsigned i = 0; i < length; ++i) {
+        if((current[i] & data[i]) != data[i])
+            return false;
+    }
+    return true;
+}
+
+XSPI_Flasher::XSPI_Flasher( unsigned int device_index, char *inMap, FlashProgress *progress ) :
+    mProgress(progress ? *progress : FlashProgress::console()), mLog(mProgress.log())
 {
     mMgmtMap = inMap; // brought in from Flasher object
 }
@@ -289,8 +311,8 @@ bool XSPI_Flasher::setSector(unsigned address) {
     uint32_t sector = getSector(address);
     //Select sector before 
     if(sector >= MAX_NUM_SECTORS) {
-        std::cout << "ERROR: Invalid sector encountered" << std::endl;
-        std::cout << "ERROR: Bad address 0x" << std::hex << address << std::dec << std::endl;
+        mLog << "ERROR: Invalid sector encountered" << std::endl;
+        mLog << "ERROR: Bad address 0x" << std::hex << address << std::dec << std::endl;
         return false;
     } else if(sector == selected_sector) //Don't do anything if its already selected
         return true;
@@ -318,7 +340,7 @@ int XSPI_Flasher::xclTestXSpi(int index)
     //print the IP (not of flash) control/status register.
     uint32_t ControlReg = XSpi_GetControlReg();
     uint32_t StatusReg = XSpi_GetStatusReg();
-    std::cout << "Boot IP Control/Status " << std::hex << ControlReg << "/" << StatusReg << std::dec << std::endl;
+    mLog << "Boot IP Control/Status " << std::hex << ControlReg << "/" << StatusReg << std::dec << std::endl;
 
     //Make sure it is ready to receive commands.
     ControlReg = XSpi_GetControlReg();
@@ -327,47 +349,47 @@ int XSPI_Flasher::xclTestXSpi(int index)
     XSpi_SetControlReg(ControlReg);
     ControlReg = XSpi_GetControlReg();
     StatusReg = XSpi_GetStatusReg();
-    std::cout << "Reset IP Control/Status " << std::hex << ControlReg << "/" << StatusReg << std::dec << std::endl;
+    mLog << "Reset IP Control/Status " << std::hex << ControlReg << "/" << StatusReg << std::dec << std::endl;
 
     //1. Testing idCode reads.
     //--
-    std::cout << "Testing id code " << std::endl;
+    mLog << "Testing id code " << std::endl;
     if(!getFlashId()) {
-        std::cout << "Exiting now, as could not get correct idcode" << std::endl;
+        mLog << "Exiting now, as could not get correct idcode" << std::endl;
         exit(-EOPNOTSUPP);
     }
 
-    std::cout << "id code successful (please verify the idcode output too" << std::endl;
-    std::cout << "Now reading various flash registers" << std::endl;
+    mLog << "id code successful (please verify the idcode output too" << std::endl;
+    mLog << "Now reading various flash registers" << std::endl;
 
     //2. Testing register reads.
     //Using STATUS_READ_BYTES 2 for all, TODO ?
     uint8_t Cmd = COMMAND_STATUSREG_READ;
-    std::cout << "Testing COMMAND_STATUSREG_READ" << std::endl;
+    mLog << "Testing COMMAND_STATUSREG_READ" << std::endl;
     readRegister(Cmd, STATUS_READ_BYTES);
 
-    std::cout << "Testing COMMAND_FLAG_STATUSREG_READ" << std::endl;
+    mLog << "Testing COMMAND_FLAG_STATUSREG_READ" << std::endl;
     Cmd = COMMAND_FLAG_STATUSREG_READ;
     readRegister(Cmd, STATUS_READ_BYTES);
 
-    std::cout << "Testing COMMAND_NON_VOLATILE_CFGREG_READ" << std::endl;
+    mLog << "Testing COMMAND_NON_VOLATILE_CFGREG_READ" << std::endl;
     Cmd = COMMAND_NON_VOLATILE_CFGREG_READ;
     readRegister(Cmd, 4);
 
-    std::cout << "Testing COMMAND_VOLATILE_CFGREG_READ" << std::endl;
+    mLog << "Testing COMMAND_VOLATILE_CFGREG_READ" << std::endl;
     Cmd = COMMAND_VOLATILE_CFGREG_READ;
     readRegister(Cmd, STATUS_READ_BYTES);
 
-    std::cout << "Testing COMMAND_ENH_VOLATILE_CFGREG_READ" << std::endl;
+    mLog << "Testing COMMAND_ENH_VOLATILE_CFGREG_READ" << std::endl;
     Cmd = COMMAND_ENH_VOLATILE_CFGREG_READ;
     readRegister(Cmd, STATUS_READ_BYTES);
 
-    std::cout << "Testing COMMAND_EXTENDED_ADDRESS_REG_READ" << std::endl;
+    mLog << "Testing COMMAND_EXTENDED_ADDRESS_REG_READ" << std::endl;
     Cmd = COMMAND_EXTENDED_ADDRESS_REG_READ;
     readRegister(Cmd, STATUS_READ_BYTES);
 
     //3. Testing simple read and write
-    std::cout << "Testing read and write of 16 bytes" << std::endl;
+    mLog << "Testing read and write of 16 bytes" << std::endl;
 
     //unsigned baseAddr = 0x007A0000;
     unsigned baseAddr = 0;
@@ -380,7 +402,7 @@ int XSPI_Flasher::xclTestXSpi(int index)
         writeRegister(EXIT_FOUR_BYTE_ADDR_MODE, 0, 0);
 
     //Verify 3 or 4 byte addressing, 0th bit == 1 => 4 byte.
-    std::cout << "Testing COMMAND_FLAG_STATUSREG_READ" << std::endl;
+    mLog << "Testing COMMAND_FLAG_STATUSREG_READ" << std::endl;
     Cmd = COMMAND_FLAG_STATUSREG_READ;
     readRegister(Cmd, STATUS_READ_BYTES);
 
@@ -398,7 +420,7 @@ int XSPI_Flasher::xclTestXSpi(int index)
         if(!writeRegister(COMMAND_EXTENDED_ADDRESS_REG_WRITE, sector, 1))
             return false;
 
-        std::cout << "Testing COMMAND_EXTENDED_ADDRESS_REG_READ" << std::endl;
+        mLog << "Testing COMMAND_EXTENDED_ADDRESS_REG_READ" << std::endl;
         Cmd = COMMAND_EXTENDED_ADDRESS_REG_READ;
         readRegister(Cmd, STATUS_READ_BYTES);
 
@@ -408,7 +430,7 @@ int XSPI_Flasher::xclTestXSpi(int index)
 
         bool ready = isFlashReady();
         if(!ready){
-            std::cout << "Unable to get flash ready" << std::endl;
+            mLog << "Unable to get flash ready" << std::endl;
             return false;
         }
 
@@ -436,7 +458,7 @@ int XSPI_Flasher::xclTestXSpi(int index)
         if(!writeRegister(COMMAND_EXTENDED_ADDRESS_REG_WRITE, sector, 1))
             return false;
 
-        std::cout << "Testing COMMAND_EXTENDED_ADDRESS_REG_READ" << std::endl;
+        mLog << "Testing COMMAND_EXTENDED_ADDRESS_REG_READ" << std::endl;
         Cmd = COMMAND_EXTENDED_ADDRESS_REG_READ;
         readRegister(Cmd, STATUS_READ_BYTES);
 
@@ -450,7 +472,7 @@ int XSPI_Flasher::xclTestXSpi(int index)
             Addr = baseAddr + WRITE_DATA_SIZE*j;
 
             if(!writePage(Addr)) {
-                std::cout << "Write page unsuccessful, returning" << std::endl;
+                mLog << "Write page unsuccessful, returning" << std::endl;
                 return -ENXIO;
             }
         }
@@ -466,7 +488,7 @@ int XSPI_Flasher::xclTestXSpi(int index)
         if(!writeRegister(COMMAND_EXTENDED_ADDRESS_REG_WRITE, sector, 1))
             return false;
 
-        std::cout << "Testing COMMAND_EXTENDED_ADDRESS_REG_READ" << std::endl;
+        mLog << "Testing COMMAND_EXTENDED_ADDRESS_REG_READ" << std::endl;
         Cmd = COMMAND_EXTENDED_ADDRESS_REG_READ;
         readRegister(Cmd, STATUS_READ_BYTES);
 
@@ -476,132 +498,70 @@ int XSPI_Flasher::xclTestXSpi(int index)
             clearBuffers();
             Addr = baseAddr + WRITE_DATA_SIZE*j;
             if(!readPage(Addr)) {
-                std::cout << "Read page unsuccessful, returning" << std::endl;
+                mLog << "Read page unsuccessful, returning" << std::endl;
                 return -ENXIO;
             }
         }
-        std::cout << "Done reading sector: " << sector << std::endl;
+        mLog << "Done reading sector: " << sector << std::endl;
     }
 
     return 0;
 }
 
-int XSPI_Flasher::xclUpgradeFirmware2(std::istream& mcsStream1, std::istream& mcsStream2) {
+int XSPI_Flasher::xclUpgradeFirmware2(std::istream& mcsStream1, std::istream& mcsStream2, bool delta) {
     int status = 0;
-    status = xclUpgradeFirmwareXSpi(mcsStream1, 0);
+    status = xclUpgradeFirmwareXSpi(mcsStream1, 0, delta);
     if(status)
         return status;
     clearBuffers();
-    recordList.clear();
-    return xclUpgradeFirmwareXSpi(mcsStream2, 1);
+    return xclUpgradeFirmwareXSpi(mcsStream2, 1, delta);
 }
 
-int XSPI_Flasher::xclUpgradeFirmwareXSpi(std::istream& mcsStream, int index) {
+int XSPI_Flasher::xclUpgradeFirmwareXSpi(std::istream& mcsStream, int index, bool delta) {
+    //Decode the whole file up front, programming only deals with bytes
+    McsImage image;
+    if (image.parse(mcsStream)) {
+        mLog << "ERROR: Invalid MCS file" << std::endl;
+        return -EINVAL;
+    }
+
+    return xclUpgradeFirmwareXSpi(image, index, delta);
+}
+
+int XSPI_Flasher::xclUpgradeFirmware2(const McsImage& image1, const McsImage& image2, bool delta) {
+    int status = 0;
+    status = xclUpgradeFirmwareXSpi(image1, 0, delta);
+    if(status)
+        return status;
+    clearBuffers();
+    return xclUpgradeFirmwareXSpi(image2, 1, delta);
+}
+
+int XSPI_Flasher::xclUpgradeFirmwareXSpi(const McsImage& image, int index, bool delta) {
     clearBuffers();
-    recordList.clear();
 
     if (!mMgmtMap)
         return -EACCES;
 
+    if (image.empty())
+        return -EINVAL;
+
     slave_index = index;
-    std::string line;
-    std::string startAddress;
-    ELARecord record;
-    bool endRecordFound = false;
-
-    int lineno = 0;
-    while (!mcsStream.eof() && !endRecordFound) {
-    lineno++;
-        std::string line;
-        std::getline(mcsStream, line);
-        if (line.size() == 0) {
-            continue;
-        }
-        if (line[0] != ':') {
-            return -EINVAL;
-        }
-        const unsigned dataLen = std::stoi(line.substr(1, 2), 0 , 16);
-        const unsigned address = std::stoi(line.substr(3, 4), 0, 16);
-        const unsigned recordType = std::stoi(line.substr(7, 2), 0 , 16);
-        switch (recordType) {
-        case 0x00:
-        {
-            if (dataLen > 16) {
-                // For xilinx mcs files data length should be 16 for all records
-                // except for the last one which can be smaller
-                return -EINVAL;
-            }
-            if (address != (record.mDataCount+(record.mStartAddress & 0xFFFF))) {
-                if(record.mDataCount == 0) {
-                    //First entry only.
-                    assert(record.mStartAddress != 0);
-                    assert(record.mEndAddress != 0);
-                    record.mStartAddress += address;
-                    record.mEndAddress += address;
-                }else {
-                    std::cout << "Address is not contiguous ! " << std::endl;
-                    return -EINVAL;
-                }
-            }
-            //if ( ((record.mEndAddress-record.mStartAddress)& 0xFFFF) != address) {
-              //  return -EINVAL;
-            //}
-            record.mDataCount += dataLen;
-            record.mEndAddress += dataLen;
-            break;
-        }
-        case 0x01:
-        {
-            if (startAddress.size() == 0) {
-                break;
-            }
-            recordList.push_back(record);
-            endRecordFound = true;
-            break;
-        }
-        case 0x02:
-        {
-            assert(0);
-            break;
-        }
-        case 0x04:
-        {
-            if (address != 0x0) {
-                return -EINVAL;
-            }
-            if (dataLen != 2) {
-                return -EINVAL;
-            }
-            std::string newAddress = line.substr(9, dataLen * 2);
-            if (startAddress.size()) {
-                // Finish the old record
-                recordList.push_back(record);
-            }
-            // Start a new record
-            record.mStartAddress = std::stoi(newAddress, 0 , 16);
-            record.mStartAddress <<= 16;
-            record.mDataPos = mcsStream.tellg();
-            record.mEndAddress = record.mStartAddress;
-            record.mDataCount = 0;
-            startAddress = newAddress;
-        }
-        }
-    }
 
-    mcsStream.seekg(0);
-    std::cout << "INFO: ***Found " << recordList.size() << " ELA Records" << std::endl;
+    mLog << "INFO: ***Found " << std::dec << image.segments().size() << " data segments, "
+              << image.size() << " bytes" << std::endl;
 
     //Ensure we set bitstream guard to the first location
-    BITSTREAM_START_LOC = recordList.front().mStartAddress;
-    
-    return programXSpi(mcsStream);
+    BITSTREAM_START_LOC = image.segments().front().mAddress;
+
+    return programXSpi(image, delta);
 }
 
 unsigned XSPI_Flasher::readReg(unsigned RegOffset) {
     unsigned value;
     if( Flasher::flashRead( 0, (unsigned long long)mMgmtMap + RegOffset, &value, 4 ) != 0 ) {
         assert(0);
-        std::cout << "read reg ERROR" << std::endl;
+        mLog << "read reg ERROR" << std::endl;
     }
     return value;
 }
@@ -610,7 +570,7 @@ int XSPI_Flasher::writeReg(unsigned RegOffset, unsigned value) {
     int status = Flasher::flashWrite(0, (unsigned long long)mMgmtMap + RegOffset, &value, 4);
     if(status != 0) {
         assert(0);
-        std::cout << "write reg ERROR " << std::endl;
+        mLog << "write reg ERROR " << std::endl;
     }
     return 0;
 }
@@ -625,11 +585,11 @@ bool XSPI_Flasher::waitTxEmpty() {
             return true;
         //If not empty, check how many bytes remain.
         uint32_t Data = XSpi_ReadReg(XSP_TFO_OFFSET);
-        std::cout << std::hex << Data << std::dec << std::endl;
+        mLog << std::hex << Data << std::dec << std::endl;
         nanosleep(&req, 0);
         delay += 5000;
     }
-    std::cout << "Unable to get Tx Empty\n";
+    mLog << "Unable to get Tx Empty\n";
     return false;
 }
 
@@ -654,7 +614,7 @@ bool XSPI_Flasher::isFlashReady() {
         nanosleep(&req, 0);
         delay += 5000;
     }
-    std::cout << "Unable to get Flash Ready\n";
+    mLog << "Unable to get Flash Ready\n";
     return false;
 }
 
@@ -665,7 +625,7 @@ bool XSPI_Flasher::sectorErase(unsigned Addr, unsigned erase_cmd) {
     if(!FOUR_BYTE_ADDRESSING) {
         //Select sector when only using 24bit address  
         if(!setSector(Addr)) {
-            std::cout << "ERROR: Unable to set sector for sectorErase cmd" << std::endl;
+            mLog << "ERROR: Unable to set sector for sectorErase cmd" << std::endl;
             return false;
         } 
     }        
@@ -674,7 +634,7 @@ bool XSPI_Flasher::sectorErase(unsigned Addr, unsigned erase_cmd) {
         return false;
 
     if(TEST_MODE) {
-        std::cout << "Testing COMMAND_FLAG_STATUSREG_READ" << std::endl;
+        mLog << "Testing COMMAND_FLAG_STATUSREG_READ" << std::endl;
         unsigned Cmd = COMMAND_FLAG_STATUSREG_READ;
         readRegister(Cmd, STATUS_READ_BYTES);
     }
@@ -763,7 +723,7 @@ bool XSPI_Flasher::clearBitstreamGuard(unsigned Addr) {
 bool XSPI_Flasher::writeEnable() {
     uint32_t StatusReg = XSpi_GetStatusReg();
     if(StatusReg & XSP_SR_TX_FULL_MASK) {
-        std::cout << "Tx fifo fill during WriteEnable" << std::endl;
+        mLog << "Tx fifo fill during WriteEnable" << std::endl;
         return false;
     }
 
@@ -784,7 +744,7 @@ bool XSPI_Flasher::writeEnable() {
 bool XSPI_Flasher::getFlashId()
 {
     if(!isFlashReady()) {
-        std::cout << "Unable to get flash ready " << std::endl;
+        mLog << "Unable to get flash ready " << std::endl;
         return false;
     }
 
@@ -824,13 +784,13 @@ bool XSPI_Flasher::getFlashId()
             MAX_NUM_SECTORS = 16;
             break;
         default:
-            std::cout << "ERROR: Unrecognized sector field! Exiting..." << std::endl;
+            mLog << "ERROR: Unrecognized sector field! Exiting..." << std::endl;
             return false;                     
         }
     }
         
     for (int i = 0; i < IDCODE_READ_BYTES; i++) {
-        std::cout << "Idcode byte[" << i << "] " << std::hex << (int)ReadBuffer[i] << std::endl;
+        mLog << "Idcode byte[" << i << "] " << std::hex << (int)ReadBuffer[i] << std::endl;
         ReadBuffer[i] = 0;
     }
 
@@ -870,7 +830,7 @@ bool XSPI_Flasher::finalTransfer(uint8_t *SendBufPtr, uint8_t *RecvBufPtr, int B
     StatusReg = XSpi_GetStatusReg();
 
     if(TEST_MODE)
-        std::cout << "Control/Status " << std::hex << ControlReg << "/" << StatusReg << std::dec << std::endl;
+        mLog << "Control/Status " << std::hex << ControlReg << "/" << StatusReg << std::dec << std::endl;
 
 
     /*
@@ -882,7 +842,7 @@ bool XSPI_Flasher::finalTransfer(uint8_t *SendBufPtr, uint8_t *RecvBufPtr, int B
     if (ControlReg & XSP_CR_MASTER_MODE_MASK) {
         if ((ControlReg & XSP_CR_LOOPBACK_MASK) == 0) {
             if (SlaveSelectReg == SlaveSelectMask) {
-                std::cout << "No slave selected" << std::endl;
+                mLog << "No slave selected" << std::endl;
                 return false;
             }
         }
@@ -906,7 +866,7 @@ bool XSPI_Flasher::finalTransfer(uint8_t *SendBufPtr, uint8_t *RecvBufPtr, int B
     */
     StatusReg = XSpi_GetStatusReg();
     if((StatusReg & (1<<10)) != 0) {
-        std::cout << "status reg in error situation " << std::endl;
+        mLog << "status reg in error situation " << std::endl;
         return false;
     }
 
@@ -919,14 +879,14 @@ bool XSPI_Flasher::finalTransfer(uint8_t *SendBufPtr, uint8_t *RecvBufPtr, int B
             Data = *(uint32_t *)SendBufferPtr;
         }
 
-        if(Flasher::flashWrite(0, (unsigned long long)mMgmtMap + XSP_DTR_OFFSET, &Data, 4) != 0) {
+        if(XSpi_WriteReg(XSP_DTR_OFFSET, Data) != 0) {
             return false;
         }
         SendBufferPtr += (DataWidth >> 3);
         RemainingBytes -= (DataWidth >> 3);
         StatusReg = XSpi_GetStatusReg();
         if((StatusReg & (1<<10)) != 0) {
-            std::cout << "Write command caused created error" << std::endl;
+            mLog << "Write command caused created error" << std::endl;
             return false;
         }
     }
@@ -942,10 +902,10 @@ bool XSPI_Flasher::finalTransfer(uint8_t *SendBufPtr, uint8_t *RecvBufPtr, int B
     StatusReg = XSpi_GetStatusReg();
 
     if(TEST_MODE)
-        std::cout << "Control/Status " << std::hex << ControlReg << "/" << StatusReg << std::dec << std::endl;
+        mLog << "Control/Status " << std::hex << ControlReg << "/" << StatusReg << std::dec << std::endl;
 
     if((StatusReg & (1<<10)) != 0) {
-        std::cout << "status reg in error situation: 2 " << std::endl;
+        mLog << "status reg in error situation: 2 " << std::endl;
         return false;
     }
 
@@ -960,7 +920,7 @@ bool XSPI_Flasher::finalTransfer(uint8_t *SendBufPtr, uint8_t *RecvBufPtr, int B
     XSpi_SetControlReg(ControlReg);
 
     if(TEST_MODE)
-        std::cout << "Control/Status " << std::hex << ControlReg << "/" << StatusReg << std::dec << std::endl;
+        mLog << "Control/Status " << std::hex << ControlReg << "/" << StatusReg << std::dec << std::endl;
 
 
     //Data transfer to actual flash has already started happening here.
@@ -992,7 +952,7 @@ bool XSPI_Flasher::finalTransfer(uint8_t *SendBufPtr, uint8_t *RecvBufPtr, int B
             ControlReg = XSpi_GetControlReg();
 
             if(TEST_MODE)
-                std::cout << "Control/Status " << std::hex << ControlReg << "/" << StatusReg << std::dec << std::endl;
+                mLog << "Control/Status " << std::hex << ControlReg << "/" << StatusReg << std::dec << std::endl;
 
             /*
              * First get the data received as a result of the
@@ -1008,10 +968,7 @@ bool XSPI_Flasher::finalTransfer(uint8_t *SendBufPtr, uint8_t *RecvBufPtr, int B
             while ((StatusReg & XSP_SR_RX_EMPTY_MASK) == 0)
             {
                 //read the data.
-                if(Flasher::flashRead(0, (unsigned long long)mMgmtMap + XSP_DRR_OFFSET, &Data, 4) != 0)
-                {
-                    return false;
-                }
+                Data = XSpi_ReadReg(XSP_DRR_OFFSET);
 
 
                 if (DataWidth == 8) {
@@ -1034,7 +991,7 @@ bool XSPI_Flasher::finalTransfer(uint8_t *SendBufPtr, uint8_t *RecvBufPtr, int B
                 ByteCount -= (DataWidth >> 3);
                 StatusReg = XSpi_GetStatusReg();
                 if((StatusReg & (1<<10)) != 0) {
-                    std::cout << "status reg in error situation " << std::endl;
+                    mLog << "status reg in error situation " << std::endl;
                     return false;
                 }
             }
@@ -1065,7 +1022,7 @@ bool XSPI_Flasher::finalTransfer(uint8_t *SendBufPtr, uint8_t *RecvBufPtr, int B
                         Data = *(uint32_t *)SendBufferPtr;
                     }
 
-                    if(Flasher::flashWrite(0, (unsigned long long)mMgmtMap + XSP_DTR_OFFSET, &Data, 4) != 0) {
+                    if(XSpi_WriteReg(XSP_DTR_OFFSET, Data) != 0) {
                         return false;
                     }
 
@@ -1073,7 +1030,7 @@ bool XSPI_Flasher::finalTransfer(uint8_t *SendBufPtr, uint8_t *RecvBufPtr, int B
                     RemainingBytes -= (DataWidth >> 3);
                     StatusReg = XSpi_GetStatusReg();
                     if((StatusReg & (1<<10)) != 0) {
-                        std::cout << "status reg in error situation " << std::endl;
+                        mLog << "status reg in error situation " << std::endl;
                         return false;
                     }
                 }
@@ -1107,7 +1064,7 @@ bool XSPI_Flasher::writePage(unsigned Addr, uint8_t writeCmd)
     if(!FOUR_BYTE_ADDRESSING) {
         //Select sector when only using 24bit address  
         if(!setSector(Addr)) {
-            std::cout << "ERROR: Unable to set sector for writePage cmd" << std::endl;
+            mLog << "ERROR: Unable to set sector for writePage cmd" << std::endl;
             return false;
         } 
     }      
@@ -1168,7 +1125,7 @@ bool XSPI_Flasher::readPage(unsigned Addr, uint8_t readCmd)
     if(!FOUR_BYTE_ADDRESSING) {
         //Select sector when only using 24bit address  
         if(!setSector(Addr)) {
-            std::cout << "ERROR: Unable to set sector for writePage cmd" << std::endl;
+            mLog << "ERROR: Unable to set sector for writePage cmd" << std::endl;
             return false;
         } 
     }      
@@ -1241,22 +1198,25 @@ bool XSPI_Flasher::prepareXSpi()
     XSPI_UNUSED uint32_t tStatusReg = XSpi_GetStatusReg();
 
 #if defined(_debug)
-    std::cout << "Boot Control/Status " << std::hex << tControlReg << "/" << tStatusReg << std::dec << std::endl;
+    mLog << "Boot Control/Status " << std::hex << tControlReg << "/" << tStatusReg << std::dec << std::endl;
 #endif
 
     uint32_t ControlReg = CONTROL_REG_START_STATE;
     XSpi_SetControlReg(ControlReg);
 
+    //The extended address register of this flash is unknown
+    selected_sector = -1;
+
     tControlReg = XSpi_GetControlReg();
     tStatusReg = XSpi_GetStatusReg();
 
 #if defined(_debug)
-    std::cout << "After setting start state, Control/Status " << std::hex << tControlReg << "/" << tStatusReg << std::dec << std::endl;
+    mLog << "After setting start state, Control/Status " << std::hex << tControlReg << "/" << tStatusReg << std::dec << std::endl;
 #endif
     //--
 
     if(!getFlashId()) {
-        std::cout << "Exiting now, as could not get correct idcode" << std::endl;
+        mLog << "Exiting now, as could not get correct idcode" << std::endl;
         exit(-EOPNOTSUPP);
     }
 
@@ -1271,252 +1231,175 @@ bool XSPI_Flasher::prepareXSpi()
     return true;
 }
 
-int XSPI_Flasher::programXSpi(std::istream& mcsStream, const ELARecord& record) {
-    //TODO: decrease the sleep time.
-    const timespec req = {0, 20000};
-
-#if defined(_debug)
-    std::cout << "Programming block (" << std::hex << record.mStartAddress << ", " << record.mEndAddress << std::dec << ")" << std::endl;
-#endif
+//Read back length bytes, a multiple of READ_DATA_SIZE. The plain read
+//command is used so that data directly follows the address bytes.
+bool XSPI_Flasher::readFlash(unsigned addr, unsigned char *buf, unsigned length) {
+    const uint8_t readCmd = FOUR_BYTE_ADDRESSING ? FOUR_BYTE_READ : COMMAND_RANDOM_READ;
+    for(unsigned offset = 0; offset < length; offset += READ_DATA_SIZE) {
+        if(!readPage(addr + offset, readCmd))
+            return false;
+        memcpy(buf + offset, &ReadBuffer[READ_WRITE_EXTRA_BYTES], READ_DATA_SIZE);
+    }
+    return true;
+}
 
-    assert(mcsStream.tellg() < record.mDataPos);
-    mcsStream.seekg(record.mDataPos, std::ios_base::beg);
+//Program a subsector from data. Pages that stay erased are skipped. If
+//current is set the subsector was not erased, and pages already holding
+//the data are skipped instead.
+bool XSPI_Flasher::programSector(unsigned addr, const unsigned char *data, const unsigned char *current) {
     unsigned char* buffer = &WriteBuffer[READ_WRITE_EXTRA_BYTES];
-    int bufferIndex = 0;
-    int pageIndex = 0;
-    std::string prevLine("");
-    for (unsigned index = record.mDataCount; index > 0;) {
-        std::string line;
-        std::getline(mcsStream, line);
-        if(TEST_MODE)
-            std::cout << line << std::endl;
-        const unsigned dataLen = std::stoi(line.substr(1, 2), 0 , 16);
-        index -= dataLen;
-        const unsigned recordType = std::stoi(line.substr(7, 2), 0 , 16);
-        if (recordType != 0x00) {
+    for(unsigned offset = 0; offset < SUBSECTOR_SIZE; offset += WRITE_DATA_SIZE) {
+        const unsigned char *page = data + offset;
+        if(current ? (memcmp(page, current + offset, WRITE_DATA_SIZE) == 0)
+                   : isErased(page, WRITE_DATA_SIZE))
             continue;
-        }
-        const std::string data = line.substr(9, dataLen * 2);
-        // Write in byte swapped order
-        for (unsigned i = 0; i < data.length(); i += 2) {
-            unsigned value = std::stoi(data.substr(i, 2), 0, 16);
-            buffer[bufferIndex++] = (unsigned char)value;
-            assert(bufferIndex <= WRITE_DATA_SIZE);
-
-#if 0
-            //To enable byte swapping uncomment this.
-            //      if ((bufferIndex % 4) == 0) {
-            //        bufferIndex += 4;
-            //      }
-            //      assert(bufferIndex <= WRITE_DATA_SIZE);
-            //      unsigned value = std::stoi(data.substr(i, 2), 0, 16);
-            //      if(TEST_MODE)
-            //        std::cout << data.substr(i, 2);
-            //      buffer[--bufferIndex] = (unsigned char)value;
-            //      if ((bufferIndex % 4) == 0) {
-            //        bufferIndex += 4;
-            //      }
-#endif
-            if (bufferIndex == WRITE_DATA_SIZE) {
-                break;
-            }
-        }
 
-        if(TEST_MODE)
-            std::cout << std::endl;
+        //The next page is staged while the flash is still busy with the
+        //previous one, writePage waits for the flash to be ready.
+        memcpy(buffer, page, WRITE_DATA_SIZE);
+        if(!writePage(addr + offset))
+            return false;
+    }
+    return true;
+}
 
-#if 0
-        //Uncomment if byte swapping enabled.
+/*
+ * programXSpi
+ *
+ * Programs the image by 4KB subsectors. In delta mode the flash is read
+ * back first and only subsectors whose content changed are updated, a
+ * subsector is not erased when the update only clears bits.
+ */
+int XSPI_Flasher::programXSpi(const McsImage& image, bool delta)
+{
+    if (!prepareXSpi()) {
+        mLog << "ERROR: Unable to prepare the XSpi\n";
+        return -EINVAL;
+    }
 
-        //account for the last line
-        //which can have say 14 bytes instead of 16
-        if((bufferIndex %4)!= 0) {
-            while ((bufferIndex %4)!= 0) {
-                unsigned char fillValue = 0xFF;
-                buffer[--bufferIndex] = fillValue;
+    struct SectorUpdate
+    {
+        uint32_t mAddress;
+        bool mErase;
+        std::vector<unsigned char> mCurrent; // flash content if not erased
+    };
+
+    //Shift all write addresses below bitstream guard. The image may be
+    //shared with other flashers, the shift is applied when reading it.
+    const bool guard = (BITSTREAM_START_LOC != 0);
+    const uint32_t guardSector = BITSTREAM_START_LOC & ~(SUBSECTOR_SIZE - 1);
+    const uint32_t shift = guard ? BITSTREAM_GUARD_SIZE : 0;
+
+    std::vector<uint32_t> sectors = image.getSectors(SUBSECTOR_SIZE);
+    for(uint32_t& addr : sectors)
+        addr += shift;
+    std::vector<SectorUpdate> updates;
+    std::vector<unsigned char> data(SUBSECTOR_SIZE);
+    std::vector<unsigned char> current(SUBSECTOR_SIZE);
+
+    if(delta) {
+        mLog << "Comparing flash" << std::flush;
+        mProgress.start(FlashProgress::COMPARING, sectors.size());
+        for(size_t i = 0; i < sectors.size(); i++, mProgress.step()) {
+            if(i % 256 == 255) {
+                mLog << "." << std::flush;
             }
-            bufferIndex += 4;
+            image.read(sectors[i] - shift, data.data(), SUBSECTOR_SIZE);
+            if(!readFlash(sectors[i], current.data(), SUBSECTOR_SIZE)) {
+                mLog << "\nERROR: Failed to read subsector!" << std::endl;
+                return -EINVAL;
+            }
+            if(current == data)
+                continue;
+
+            SectorUpdate update;
+            update.mAddress = sectors[i];
+            update.mErase = !onlyClearsBits(current.data(), data.data(), SUBSECTOR_SIZE);
+            if(!update.mErase)
+                update.mCurrent = current;
+            updates.push_back(std::move(update));
         }
+        mLog << std::endl;
 
-        assert((bufferIndex % 4) == 0);
-#endif
-
-        assert(bufferIndex <= WRITE_DATA_SIZE);
-        if (bufferIndex == WRITE_DATA_SIZE) {
-#if defined(_debug)
-            std::cout << "writing page " << pageIndex << std::endl;
-#endif
-            const unsigned address = std::stoi(line.substr(3, 4), 0, 16);
-            //assert ( (address + dataLen) == static_cast<unsigned int>((pageIndex +1)*WRITE_DATA_SIZE));
-            assert ( (address + dataLen - (record.mStartAddress & 0xFFFF)) 
-                == static_cast<unsigned int>((pageIndex +1)*WRITE_DATA_SIZE));      
-            if(TEST_MODE) {
-                std::cout << (address + dataLen) << " " << (pageIndex +1)*WRITE_DATA_SIZE << std::endl;
-                std::cout << record.mStartAddress << " " << record.mStartAddress + pageIndex*PAGE_SIZE;
-                std::cout << " " << address << std::endl;
-            } else {
-                if(!writePage(record.mStartAddress + pageIndex*WRITE_DATA_SIZE))
-                    return -ENXIO;
-                clearBuffers();
-                {
-                    //debug stuff
-#if defined(_debug)
-                    if(pageIndex == 0) {
-                        if(!readPage(record.mStartAddress + pageIndex*WRITE_DATA_SIZE))
-                            return -ENXIO;
-                        clearBuffers();
-                    }
-#endif
-                }
+        //A guard left over by an interrupted update must be cleared too
+        bool guardSet = false;
+        if(guard) {
+            if(!readFlash(guardSector, current.data(), SUBSECTOR_SIZE)) {
+                mLog << "ERROR: Failed to read bitstream guard!" << std::endl;
+                return -EINVAL;
             }
-            pageIndex++;
-            nanosleep(&req, 0);
-            bufferIndex = 0;
+            guardSet = !isErased(current.data(), SUBSECTOR_SIZE);
         }
-        prevLine = line;
 
-    }
-    if (bufferIndex) {
-        //Write the last page
-        if(TEST_MODE) {
-            std::cout << "writing final page " << pageIndex << std::endl;
-            std::cout << bufferIndex << std::endl;
-            std::cout << prevLine << std::endl;
+        mLog << "INFO: " << std::dec << updates.size() << " of " << sectors.size()
+                  << " subsectors changed" << std::endl;
+        if(updates.empty() && !guardSet) {
+            mLog << "INFO: Flash is up-to-date" << std::endl;
+            return 0;
         }
-
-        const unsigned address = std::stoi(prevLine.substr(3, 4), 0, 16);
-        const unsigned dataLen = std::stoi(prevLine.substr(1, 2), 0 , 16);
-
-        if(TEST_MODE)
-            std::cout << address % WRITE_DATA_SIZE << " " << dataLen << std::endl;
-
-        //assert( (address % WRITE_DATA_SIZE + dataLen) == bufferIndex);
-
-        if(!TEST_MODE) {
-
-            //Fill unused half page to FF
-            for(unsigned i = bufferIndex; i < WRITE_DATA_SIZE; ++i) {
-                buffer[i] = 0xff;
-            }
-
-            if(!writePage(record.mStartAddress + pageIndex*WRITE_DATA_SIZE))
-                return -ENXIO;
-            nanosleep(&req, 0);
-            clearBuffers();
-            {
-                //debug stuff
-#if defined(_debug)
-                if(!readPage(record.mStartAddress + pageIndex*WRITE_DATA_SIZE))
-                    return -ENXIO;
-                clearBuffers();
-#endif
-            }
+    } else {
+        for(uint32_t addr : sectors) {
+            SectorUpdate update;
+            update.mAddress = addr;
+            update.mErase = true;
+            updates.push_back(std::move(update));
         }
     }
-    return 0;
-}
-
-int XSPI_Flasher::programXSpi(std::istream& mcsStream)
-{
-    //  for (ELARecordList::iterator i = mRecordList.begin(), e = mRecordList.end(); i != e; ++i) {
-    //    i->mStartAddress <<= 16;
-    //    i->mEndAddress += i->mStartAddress;
-    //    // Convert from 2 bytes address to 4 bytes address
-    //    i->mStartAddress /= 2;
-    //    i->mEndAddress /= 2;
-    //  }
-
-    if (!prepareXSpi()) {
-        std::cout << "ERROR: Unable to prepare the XSpi\n";
-        return -EINVAL;
-    }
-
-    //if(!bulkErase())
-    //return false;
-
-    const timespec req = {0, 20000};
-    nanosleep(&req, 0);
 
-    uint32_t bitstream_shift_addr = 0;
-    
     //First we enable bitstream guard if not writing to address 0
     //This will protect partially erased/programmed bitstreams
-    if(BITSTREAM_START_LOC != 0) {
+    if(guard) {
         if(!writeBitstreamGuard(BITSTREAM_START_LOC)) {
-            std::cout << "ERROR: Unable to set bitstream guard!" << std::endl;
+            mLog << "ERROR: Unable to set bitstream guard!" << std::endl;
             return -EINVAL;
         }
-        bitstream_shift_addr += BITSTREAM_GUARD_SIZE;
-        std::cout << "Enabled bitstream guard. Bitstream will not be loaded until flashing is finished." << std::endl;
+        mLog << "Enabled bitstream guard. Bitstream will not be loaded until flashing is finished." << std::endl;
     }
 
-    //Now we can safely erase all subsectors  
-    int beatCount = 0;
-    std::cout << "Erasing flash" << std::flush;
-    for (ELARecordList::iterator i = recordList.begin(), e = recordList.end(); i != e; ++i) {
-        beatCount++;
-        if(beatCount%20==0) {
-            std::cout << "." << std::flush;
+    //Now we can safely erase all subsectors
+    mLog << "Erasing flash" << std::flush;
+    mProgress.start(FlashProgress::ERASING, updates.size());
+    for(size_t i = 0; i < updates.size(); i++, mProgress.step()) {
+        if(i % 256 == 255) {
+            mLog << "." << std::flush;
         }
-
-        //Shift all write addresses below bitstream guard
-        i->mStartAddress += bitstream_shift_addr;
-        i->mEndAddress += bitstream_shift_addr;
-        
-        //Erase any subsectors in address range.
-        for(uint32_t j = i->mStartAddress; j < i->mEndAddress; j+=0x1000) {
-            //std::cout << "DEBUG: Erasing subsector @ 0x" << std::hex << j << std::dec << std::endl;
-            if(!sectorErase(j, COMMAND_4KB_SUBSECTOR_ERASE)) {
-                std::cout << "\nERROR: Failed to erase subsector!" << std::endl;
-                return -EINVAL;
-            }
-            nanosleep(&req, 0); //Pause before next sector erase
+        if(!updates[i].mErase)
+            continue;
+        if(!sectorErase(updates[i].mAddress, COMMAND_4KB_SUBSECTOR_ERASE)) {
+            mLog << "\nERROR: Failed to erase subsector!" << std::endl;
+            return -EINVAL;
         }
     }
     //New line after ...
-    std::cout << std::endl;
+    mLog << std::endl;
 
     //Next we program flash. Note that bitstream guard is still active
-    beatCount = 0;
-    std::cout << "Programming flash" << std::flush;
-    for (ELARecordList::iterator i = recordList.begin(), e = recordList.end(); i != e; ++i)
-    {
-        beatCount++;
-        if(beatCount%20==0) {
-            std::cout << "." << std::flush;
+    mLog << "Programming flash" << std::flush;
+    mProgress.start(FlashProgress::PROGRAMMING, updates.size());
+    for(size_t i = 0; i < updates.size(); i++, mProgress.step()) {
+        if(i % 256 == 255) {
+            mLog << "." << std::flush;
         }
-
-        if(TEST_MODE) {
-            std::cout << "INFO: Start address 0x" << std::hex << recordList.front().mStartAddress << std::dec << "\n";
-            std::cout << "INFO: End address 0x" << std::hex << recordList.back().mEndAddress << std::dec << "\n";
-        }
-
-        bool ready = isFlashReady();
-        if(!ready){
-            std::cout << "\nERROR: Unable to get flash ready" << std::endl;
+        const SectorUpdate& update = updates[i];
+        image.read(update.mAddress - shift, data.data(), SUBSECTOR_SIZE);
+        if(!programSector(update.mAddress, data.data(),
+                          update.mErase ? nullptr : update.mCurrent.data())) {
+            mLog << "\nERROR: Could not program the subsector" << std::endl;
             return -EINVAL;
         }
-
-        clearBuffers();
-
-        if (programXSpi(mcsStream, *i)) {
-            std::cout << "\nERROR: Could not programXSpi the block" << std::endl;
-            return -EINVAL;
-        }
-        nanosleep(&req, 0);
     }
-    std::cout << std::endl;
-    
+    mLog << std::endl;
+
     //Finally we clear bitstream guard if not writing to address 0
     //This will allow the bitstream to be loaded
-    if(BITSTREAM_START_LOC != 0) {
+    if(guard) {
         if(!clearBitstreamGuard(BITSTREAM_START_LOC)) {
-            std::cout << "ERROR: Unable to clear bitstream guard!" << std::endl;
+            mLog << "ERROR: Unable to clear bitstream guard!" << std::endl;
             return -EINVAL;
         }
-        std::cout << "Cleared bitstream guard. Bitstream now active." << std::endl;
+        mLog << "Cleared bitstream guard. Bitstream now active." << std::endl;
     }
-    
+
     return 0;
 }
 
@@ -1536,13 +1419,13 @@ bool XSPI_Flasher::readRegister(unsigned commandCode, unsigned bytes) {
     }
 
 #if defined(_debug)
-    std::cout << "Printing output (with some extra bytes of readRegister cmd)" << std::endl;
+    mLog << "Printing output (with some extra bytes of readRegister cmd)" << std::endl;
 #endif
 
     for(unsigned i = 0; i < 5; ++ i) //Some extra bytes, no harm
     {
 #if defined(_debug)
-        std::cout << i << " " << std::hex << (int)ReadBuffer[i] << std::dec << std::endl;
+        mLog << i << " " << std::hex << (int)ReadBuffer[i] << std::dec << std::endl;
 #endif
         ReadBuffer[i] = 0; //clear
     }
@@ -1581,7 +1464,7 @@ bool XSPI_Flasher::writeRegister(unsigned commandCode, unsigned value, unsigned
         WriteBuffer[BYTE2] = (uint8_t) (value >> 8);
         WriteBuffer[BYTE3] = (uint8_t) value;
     }else {
-        std::cout << "ERROR: Setting more than 2 bytes" << std::endl;
+        mLog << "ERROR: Setting more than 2 bytes" << std::endl;
         assert(0);
     }
 
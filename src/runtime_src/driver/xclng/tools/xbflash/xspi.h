@@ -20,37 +20,35 @@
 #define _XSPI_H_
 
 #include <sys/stat.h>
-#include <list>
 #include <iostream>
+#include "mcs_image.h"
+#include "flash_progress.h"
 
 
 class XSPI_Flasher
 {
-    struct ELARecord
-    {
-        unsigned mStartAddress;
-        unsigned mEndAddress;
-        unsigned mDataCount;
-        std::streampos mDataPos;
-        ELARecord() : mStartAddress(0), mEndAddress(0), mDataCount(0), mDataPos(0) {}
-    };
-
-    typedef std::list<ELARecord> ELARecordList;
-    ELARecordList recordList;
-
 public:
-    XSPI_Flasher( unsigned int device_index, char *inMap );
-    ~XSPI_Flasher();
-    int xclUpgradeFirmware2(std::istream& mcsStream1, std::istream& mcsStream2);
-    int xclUpgradeFirmwareXSpi(std::istream& mcsStream, int device_index=0);
+    XSPI_Flasher( unsigned int device_index, char *inMap, FlashProgress *progress = nullptr );
+    virtual ~XSPI_Flasher();
+    int xclUpgradeFirmware2(std::istream& mcsStream1, std::istream& mcsStream2, bool delta=false);
+    int xclUpgradeFirmwareXSpi(std::istream& mcsStream, int device_index=0, bool delta=false);
+    // Program already decoded images, which may be shared by several flashers
+    int xclUpgradeFirmware2(const McsImage& image1, const McsImage& image2, bool delta=false);
+    int xclUpgradeFirmwareXSpi(const McsImage& image, int device_index=0, bool delta=false);
 //    std::ofstream mLogStream;
 
+protected:
+    // Register access to the AXI Quad SPI controller, overridden to run
+    // against a mock flash
+    virtual unsigned readReg(unsigned offset);
+    virtual int writeReg(unsigned regOffset, unsigned value);
+
 private:
     char *mMgmtMap;
+    FlashProgress& mProgress;
+    std::ostream& mLog;
 
     int xclTestXSpi(int device_index);
-    unsigned readReg(unsigned offset);
-    int writeReg(unsigned regOffset, unsigned value);
     bool waitTxEmpty();
     bool isFlashReady();
     bool sectorErase(unsigned Addr, unsigned erase_cmd);
@@ -63,8 +61,9 @@ private:
     bool writePage(unsigned addr, uint8_t writeCmd = 0xff);
     bool readPage(unsigned addr, uint8_t readCmd = 0xff);
     bool prepareXSpi();
-    int programXSpi(std::istream& mcsStream, const ELARecord& record);
-    int programXSpi(std::istream& mcsStream);
+    bool readFlash(unsigned addr, unsigned char *buf, unsigned length);
+    bool programSector(unsigned addr, const unsigned char *data, const unsigned char *current);
+    int programXSpi(const McsImage& image, bool delta);
     bool readRegister(unsigned commandCode, unsigned bytes);
     bool writeRegister(unsigned commandCode, unsigned value, unsigned bytes);
     bool setSector(unsigned address);
@@ -27,6 +27,8 @@
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
 #include <cstring>
 #include <thread>
 #include <chrono>
@@ -122,7 +124,8 @@ xocl::XOCLShim::XOCLShim(unsigned index,
                                                         mOffsets{0x0, 0x0, OCL_CTLR_BASE, 0x0, 0x0},
                                                         mMemoryProfilingNumberSlots(0),
                                                         mAccelProfilingNumberSlots(0),
-                                                        mStallProfilingNumberSlots(0)
+                                                        mStallProfilingNumberSlots(0),
+                                                        mAioContext(0)
 {
     mLogfileName = nullptr;
     init(index, logfileName, verbosity);
@@ -223,6 +226,9 @@ xocl::XOCLShim::~XOCLShim()
     if (mMgtHandle > 0)
         close(mMgtHandle);
 
+    if (mAioContext)
+        syscall(__NR_io_destroy, mAioContext);
+
     if (mStreamHandle > 0)
         close(mStreamHandle);
 }
@@ -1510,17 +1516,108 @@ unsigned long long xocl::XOCLShim::xclSysfsGetInt(bool mgmt,
 }
 
 /*
- * xclWriteQueue()
+ * xclQueueRW()
  */
-ssize_t xocl::XOCLShim::xclWriteQueue(uint64_t q_hdl, xclQueueRequest *wr)
+ssize_t xocl::XOCLShim::xclQueueRW(uint64_t q_hdl, xclQueueRequest *req, bool write)
 {
-    ssize_t rc = 0;
+    if (req->flag & XCL_QUEUE_NONBLOCKING)
+        return submitAio(q_hdl, req, write);
 
-    for (unsigned i = 0; i < wr->buf_num; i++) {
-        auto buf = reinterpret_cast<const void *>(wr->bufs[i].va);
-        rc = write((int)q_hdl, buf, wr->bufs[i].len);
+    // The queue driver transfers all the buffers of a vectored
+    // read or write in order
+    static const unsigned inlineBufs = 16;
+    struct iovec inlineIov[inlineBufs];
+    std::vector<struct iovec> heapIov;
+    struct iovec *iov = inlineIov;
+    if (req->buf_num > inlineBufs) {
+        heapIov.resize(req->buf_num);
+        iov = heapIov.data();
     }
-    return rc;
+    for (unsigned i = 0; i < req->buf_num; i++) {
+        iov[i].iov_base = reinterpret_cast<void *>(req->bufs[i].va);
+        iov[i].iov_len = req->bufs[i].len;
+    }
+
+    ssize_t rc = write ? writev((int)q_hdl, iov, req->buf_num) : readv((int)q_hdl, iov, req->buf_num);
+    return rc < 0 ? -errno : rc;
+}
+
+/*
+ * submitAio()
+ */
+int xocl::XOCLShim::submitAio(uint64_t q_hdl, xclQueueRequest *req, bool write)
+{
+    if (!req->buf_num)
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lk(mAioMutex);
+    if (!mAioContext && syscall(__NR_io_setup, 1024, &mAioContext) < 0) {
+        mAioContext = 0;
+        return -errno;
+    }
+
+    AioRequest *r;
+    if (mAioFree.empty()) {
+        mAioPool.emplace_back(new AioRequest);
+        r = mAioPool.back().get();
+    } else {
+        r = mAioFree.back();
+        mAioFree.pop_back();
+    }
+    r->priv_data = req->priv_data;
+    r->nbytes = 0;
+    r->err_code = 0;
+    r->pending = req->buf_num;
+
+    std::vector<struct iocb> cbs(req->buf_num);
+    std::vector<struct iocb *> cbp(req->buf_num);
+    for (unsigned i = 0; i < req->buf_num; i++) {
+        memset(&cbs[i], 0, sizeof (cbs[i]));
+        cbs[i].aio_data = reinterpret_cast<uint64_t>(r);
+        cbs[i].aio_lio_opcode = write ? IOCB_CMD_PWRITE : IOCB_CMD_PREAD;
+        cbs[i].aio_fildes = (int)q_hdl;
+        cbs[i].aio_buf = req->bufs[i].va;
+        cbs[i].aio_nbytes = req->bufs[i].len;
+        cbp[i] = &cbs[i];
+    }
+
+    long submitted = syscall(__NR_io_submit, mAioContext, (long)req->buf_num, cbp.data());
+    if (submitted == (long)req->buf_num)
+        return 0;
+
+    // Buffers that were not submitted fail the request
+    int err = (submitted < 0) ? -errno : -EIO;
+    if (submitted <= 0) {
+        mAioFree.push_back(r);
+        return err;
+    }
+    r->err_code = err;
+    r->pending = submitted;
+    return 0;
+}
+
+/*
+ * completeAio()
+ */
+void xocl::XOCLShim::completeAio(AioRequest *r, int64_t res)
+{
+    if (res < 0)
+        r->err_code = (int)res;
+    else
+        r->nbytes += res;
+
+    if (--r->pending)
+        return;
+    mAioCompletions.push_back(xclReqCompletion{r->priv_data, r->nbytes, r->err_code});
+    mAioFree.push_back(r);
+}
+
+/*
+ * xclWriteQueue()
+ */
+ssize_t xocl::XOCLShim::xclWriteQueue(uint64_t q_hdl, xclQueueRequest *wr)
+{
+    return xclQueueRW(q_hdl, wr, true);
 }
 
 /*
@@ -1528,14 +1625,62 @@ ssize_t xocl::XOCLShim::xclWriteQueue(uint64_t q_hdl, xclQueueRequest *wr)
  */
 ssize_t xocl::XOCLShim::xclReadQueue(uint64_t q_hdl, xclQueueRequest *wr)
 {
-    ssize_t rc = 0;
+    return xclQueueRW(q_hdl, wr, false);
+}
+
+/*
+ * xclPollCompletion()
+ */
+int xocl::XOCLShim::xclPollCompletion(int min_compl, int max_compl, xclReqCompletion *comps, int* actual_compl, int timeout)
+{
+    if (!comps || !actual_compl || min_compl < 0 || max_compl < min_compl)
+        return -EINVAL;
 
-    for (unsigned i = 0; i < wr->buf_num; i++) {
-        void *buf = (void *)wr->bufs[i].va;
-        rc = read((int)q_hdl, buf, wr->bufs[i].len);
+    std::unique_lock<std::mutex> lk(mAioMutex);
+    // Nothing can complete before a non-blocking request is submitted
+    if (!mAioContext && min_compl > 0) {
+        *actual_compl = 0;
+        return -EINVAL;
     }
-    return rc;
 
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    struct io_event events[64];
+
+    // Submission must not wait for a blocked poller, the lock is
+    // dropped while waiting for events
+    while (mAioContext && mAioCompletions.size() < (size_t)min_compl) {
+        aio_context_t ctx = mAioContext;
+        struct timespec ts = {0, 0};
+        struct timespec *tsp = nullptr;
+        if (timeout >= 0) {
+            auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (left < 0)
+                left = 0;
+            ts.tv_sec = left / 1000000000;
+            ts.tv_nsec = left % 1000000000;
+            tsp = &ts;
+        }
+
+        lk.unlock();
+        long n = syscall(__NR_io_getevents, ctx, 1L, 64L, events, tsp);
+        int err = errno;
+        lk.lock();
+        if (n < 0 && err != EINTR)
+            return -err;
+        for (long i = 0; i < n; i++)
+            completeAio(reinterpret_cast<AioRequest *>(events[i].data), events[i].res);
+        if (n == 0)
+            break;
+    }
+
+    int count = 0;
+    while (count < max_compl && !mAioCompletions.empty()) {
+        comps[count++] = mAioCompletions.front();
+        mAioCompletions.pop_front();
+    }
+    *actual_compl = count;
+    return (count < min_compl) ? -ETIMEDOUT : 0;
 }
 
 /*******************************/
@@ -1980,6 +2125,12 @@ ssize_t xclReadQueue(xclDeviceHandle handle, uint64_t q_hdl, xclQueueRequest *wr
 	return drv ? drv->xclReadQueue(q_hdl, wr) : -ENODEV;
 }
 
+int xclPollCompletion(xclDeviceHandle handle, int min_compl, int max_compl, xclReqCompletion *comps, int* actual_compl, int timeout)
+{
+	xocl::XOCLShim *drv = xocl::XOCLShim::handleCheck(handle);
+	return drv ? drv->xclPollCompletion(min_compl, max_compl, comps, actual_compl, timeout) : -ENODEV;
+}
+
 xclDeviceHandle xclOpenMgmt(unsigned deviceIndex)
 {
     if(xcldev::pci_device_scanner::device_list.size() <= deviceIndex) {
@@ -28,11 +28,14 @@
 #include "driver/xclng/include/mgmt-reg.h"
 #include "driver/xclng/include/qdma_ioctl.h"
 #include <libdrm/drm.h>
+#include <linux/aio_abi.h>
 #include <mutex>
 #include <cstdint>
 #include <fstream>
+#include <deque>
 #include <list>
 #include <map>
+#include <memory>
 #include <utility>
 #include <cassert>
 #include <vector>
@@ -254,6 +257,7 @@ public:
     int xclFreeQDMABuf(uint64_t buf_hdl);
     ssize_t xclWriteQueue(uint64_t q_hdl, xclQueueRequest *wr);
     ssize_t xclReadQueue(uint64_t q_hdl, xclQueueRequest *wr);
+    int xclPollCompletion(int min_compl, int max_compl, xclReqCompletion *comps, int* actual_compl, int timeout);
 
     // Temporary hack for xbflash use only
     char *xclMapMgmt(void) { return mMgtMap; }
@@ -279,6 +283,25 @@ private:
     uint32_t mStallProfilingNumberSlots;
     std::string mDevUserName;
 
+    // Non-blocking queue requests are submitted as one Linux aio per
+    // buffer, the request completes when all its buffers are done.
+    // Request trackers are pooled.
+    struct AioRequest {
+        void *priv_data;
+        size_t nbytes;
+        int err_code;
+        unsigned pending;
+    };
+    std::mutex mAioMutex;
+    aio_context_t mAioContext;
+    std::vector<std::unique_ptr<AioRequest>> mAioPool;
+    std::vector<AioRequest *> mAioFree;
+    std::deque<xclReqCompletion> mAioCompletions;
+
+    ssize_t xclQueueRW(uint64_t q_hdl, xclQueueRequest *req, bool write);
+    int submitAio(uint64_t q_hdl, xclQueueRequest *req, bool write);
+    void completeAio(AioRequest *r, int64_t res);
+
     bool zeroOutDDR();
     bool isXPR() const {
         return ((mDeviceInfo.mSubsystemId >> 12) == 4);
@@ -24,7 +24,9 @@
 #include "ert.h"
 #endif
 // includes from bsp
-#ifndef ERT_HW_EMU
+#if defined(ERT_SIM)
+#include "ert/sim/ert_sim.h"
+#elif !defined(ERT_HW_EMU)
 #include <xil_printf.h>
 #include <mb_interface.h>
 #include <xparameters.h>
@@ -33,6 +35,7 @@
 #define print printf
 #endif
 #include <stdlib.h>
+#include <stdint.h>
 #include <limits>
 
 #define ERT_UNUSED __attribute__((unused))
@@ -46,7 +49,7 @@ ERT_UNUSED
 static void
 ert_assert(const char* file, long line, const char* function, const char* expr, const char* msg)
 {
-  xil_printf("Assert failed: %s:%d:%s:%s %s\n",file,line,function,expr,msg);
+  xil_printf("Assert failed: %s:%d:%s:%s %s\n",file,static_cast<int>(line),function,expr,msg);
   exit(1);
 }
 
@@ -175,6 +178,13 @@ struct bitset_type
     return bitmasks[mask_idx];
   }
 
+  void
+  clear(size_type pos)
+  {
+    auto mask = pos >> 5;
+    bitmasks[mask] &= ~(1<<(pos - (mask << 5)));
+  }
+
   void
   toggle(size_type pos)
   {
@@ -215,7 +225,7 @@ struct bitset_type
 
 // If this assert fails, then ert_parameters is out of sync with
 // the board support package header files.
-#ifndef ERT_HW_EMU
+#if !defined(ERT_HW_EMU) && !defined(ERT_SIM)
 static_assert(ERT_INTC_ADDR==XPAR_INTC_SINGLE_BASEADDR,"update driver/include/ert.h");
 #endif
 
@@ -300,7 +310,43 @@ static bitset_type cu_status;
 
 // Bitmask for interrupt enabled CUs.  (0) no interrupt (1) enabled
 static bitset_type cu_interrupt_mask;
-#ifndef ERT_HW_EMU
+
+// Bitmasks of slots per state.  The scheduler loop visits only the
+// slots with a possible transition.
+static bitset_type slot_free;     // free, polled for new commands (!cq_status_enabled)
+static bitset_type slot_new;      // new, not yet queued
+static bitset_type slot_running;  // running on CU without interrupt
+
+// Slots transitioned by the interrupt handler.  The handler toggles
+// the slot bit in isr_slot_*, the scheduler loop collects the slots
+// where isr_slot_* differs from ack_slot_* and toggles ack_slot_*.
+// Each bitmask has one writer so interrupts need not be disabled.
+static bitset_type isr_slot_new;  // new per CQ status register
+static bitset_type ack_slot_new;
+static bitset_type isr_slot_free; // completed per CU interrupt (!cq_status_enabled)
+static bitset_type ack_slot_free;
+
+// Queued commands waiting for a CU in order of arrival, commands are
+// started in this order so that no command starves
+static size_type queued_slots[max_slots];
+static size_type num_queued = 0;
+
+// Slot after the most recently picked up command, where the
+// scheduler loop starts visiting free and new slots
+static size_type slot_cursor = 0;
+
+// Chained CUs (ap_ctrl_chain) are polled and can be started again
+// when AP_READY is seen after previous start, before the previous
+// invocation is done.  Outstanding invocations complete in order
+// of start and are tracked per CU in a ring of slot indices.
+const  size_type max_cu_chain               = 4;    // power of 2
+static bitset_type cu_chain;                        // chained CUs
+static bitset_type cu_chain_active;                 // with outstanding invocations
+static bitset_type cu_ready;                        // AP_READY seen since start
+static uint8_t cu_chain_slots[max_cus][max_cu_chain];
+static uint8_t cu_chain_head[max_cus];
+static uint8_t cu_chain_count[max_cus];
+#if !defined(ERT_HW_EMU) && !defined(ERT_SIM)
 /**
  * Utility to read a 32 bit value from any axi-lite peripheral
  */
@@ -412,6 +458,19 @@ idx_to_mask(size_type idx, size_type mask_idx)
     : 0;
 }
 
+/**
+ * lowest_bit() - Position of lowest set bit in mask
+ *
+ * @mask: Bitmask with at least one bit set
+ * Return: Position of lowest set bit, iterate a mask by clearing the
+ *  lowest bit with mask &= mask-1
+ */
+inline size_type
+lowest_bit(bitmask_type mask)
+{
+  return __builtin_ctz(mask);
+}
+
 // scope guard for disabling interrupts
 struct disable_interrupt_guard
 {
@@ -466,12 +525,29 @@ setup()
     write_reg(slot.slot_addr,0x0);
   }
 
+  slot_free.reset(num_slots-1);
+  slot_new.reset(num_slots-1);
+  slot_running.reset(num_slots-1);
+  isr_slot_new.reset(num_slots-1);
+  ack_slot_new.reset(num_slots-1);
+  isr_slot_free.reset(num_slots-1);
+  ack_slot_free.reset(num_slots-1);
+  for (size_type i=0; i<num_slots; ++i)
+    slot_free.set(i);
+  num_queued = 0;
+  slot_cursor = 0;
+
   cu_status.reset(num_cus);
 
   // Initialize cu_slot_usage
   for (size_type i=0; i<num_cus; ++i)
     cu_slot_usage[i] = no_index;
 
+  cu_chain_active.reset(num_cus);
+  cu_ready.reset(num_cus);
+  for (size_type i=0; i<num_cus; ++i)
+    cu_chain_head[i] = cu_chain_count[i] = 0;
+
   // Set slot size (4K)
   write_reg(ERT_CQ_SLOT_SIZE_ADDR,slot_size/4);
 
@@ -509,9 +585,12 @@ setup()
   bitmask_type intc_ier_mask = 0;
   if (cu_interrupt_enabled) {
     for (size_type cu=0; cu<num_cus; ++cu) {
-      write_reg(cu_idx_to_addr(cu) + 0x04,1);
-      write_reg(cu_idx_to_addr(cu) + 0x08,1);
-      cu_interrupt_mask.set(cu);
+      // chained cus are polled for AP_READY
+      auto enable = cu_chain.test(cu) ? 0 : 1;
+      write_reg(cu_idx_to_addr(cu) + 0x04,enable);
+      write_reg(cu_idx_to_addr(cu) + 0x08,enable);
+      if (enable)
+        cu_interrupt_mask.set(cu);
     }
     write_reg(ERT_CU_ISR_HANDLER_ENABLE_ADDR,1); // enable CU ISR handler
     intc_ier_mask |= 0x2;                        // acccept cu interrupts on bit 1 of the ier of intc
@@ -672,7 +751,8 @@ start_cu(size_type slot_idx)
   for (size_type cu_idx=0; cu_idx<num_cus; ++cu_idx) {
     if (cus.test(cu_idx) && !cu_status.test(cu_idx)) {
       ERT_DEBUGF("start_cu cu(%d) for slot_idx(%d)\n",cu_idx,slot_idx);
-      ERT_ASSERT(read_reg(cu_idx_to_addr(cu_idx))==4,"cu not ready");
+      // reading control of chained cu would clear AP_READY and AP_DONE
+      ERT_ASSERT(cu_chain.test(cu_idx) || read_reg(cu_idx_to_addr(cu_idx))==4,"cu not ready");
       if (cu_dma_enabled) { // hardware transfer and start
         configure_cu_dma(cu_idx,slot_idx,slot.slot_addr);
       }
@@ -680,7 +760,14 @@ start_cu(size_type slot_idx)
         configure_cu(cu_idx_to_addr(cu_idx),slot.regmap_addr,slot.regmap_size);
       }
       cu_status.toggle(cu_idx);     // toggle cu status bit, it is now busy
-      set_cu_info(cu_idx,slot_idx); // record which slot cu associated with
+      if (cu_chain.test(cu_idx)) {  // busy until AP_READY
+        auto& count = cu_chain_count[cu_idx];
+        cu_chain_slots[cu_idx][(cu_chain_head[cu_idx] + count++) & (max_cu_chain-1)] = slot_idx;
+        cu_chain_active.set(cu_idx);
+        cu_ready.clear(cu_idx);
+      }
+      else
+        set_cu_info(cu_idx,slot_idx); // record which slot cu associated with
       return cu_idx;
     }
   }
@@ -709,6 +796,8 @@ check_command(size_type slot_idx, size_type cu_idx)
   if (slot.cus.none()) {
     notify_host(slot_idx);
     slot.header_value = (slot.header_value & ~0xF) | 0x4; // free
+    if (!cq_status_enabled)
+      isr_slot_free.toggle(slot_idx);
     ERT_DEBUGF("slot(%d) [running -> free]\n",slot_idx);
 
 #ifdef DEBUG_SLOT_STATE
@@ -759,6 +848,59 @@ check_cu(size_type cu_idx, bool wait=false)
   return false;
 }
 
+/**
+ * Check status of chained CU
+ *
+ * AP_READY means the CU accepted its most recent start and can be
+ * started again.  AP_DONE means the oldest outstanding invocation is
+ * done, it is acknowledged with AP_CONTINUE and its command is
+ * transitioned from running to free.  The CU remains busy in
+ * cu_status until AP_READY is seen or while max_cu_chain invocations
+ * are outstanding.
+ *
+ * @param cu_idx
+ *   Index of chained CU with outstanding invocations
+ */
+static void
+check_chain_cu(size_type cu_idx)
+{
+  auto cu_addr = cu_idx_to_addr(cu_idx);
+  auto ctrlreg = read_reg(cu_addr);
+  auto& count = cu_chain_count[cu_idx];
+
+  if (ctrlreg & 0x8) // AP_READY
+    cu_ready.set(cu_idx);
+
+  if (ctrlreg & 0x2) { // AP_DONE
+    write_reg(cu_addr,0x10); // AP_CONTINUE
+    auto& head = cu_chain_head[cu_idx];
+    auto slot_idx = cu_chain_slots[cu_idx][head];
+    head = (head + 1) & (max_cu_chain-1);
+    --count;
+
+    auto& slot = command_slots[slot_idx];
+    ERT_ASSERT((slot.header_value & 0xF)==0x3,"slot is not running\n");
+    notify_host(slot_idx);
+    slot.header_value = (slot.header_value & ~0xF) | 0x4; // free
+    slot_free.set(slot_idx);
+    ERT_DEBUGF("slot(%d) [running -> free]\n",slot_idx);
+
+#ifdef DEBUG_SLOT_STATE
+    write_reg(slot.slot_addr,slot.header_value);
+#endif
+  }
+
+  if (!count)
+    cu_chain_active.clear(cu_idx);
+
+  bool busy = count==max_cu_chain || (count && !cu_ready.test(cu_idx));
+  if (busy!=cu_status.test(cu_idx)) {
+    // cu_status is shared with interrupt handler
+    disable_interrupt_guard guard;
+    cu_status.toggle(cu_idx);
+  }
+}
+
 /**
  * Configure MB and peripherals
  *
@@ -802,10 +944,14 @@ configure_mb(size_type slot_idx)
   cdma_enabled = (features & 0x20)!=0;
   cu_dma_52 = (features & 0x80000000)!=0;
 
-  // CU base address
+  // CU base address, control protocol is in low bits
+  cu_chain.reset(num_cus);
   for (size_type i=0; i<num_cus; ++i) {
-    cu_addr_map[i] = read_reg(slot.slot_addr + 0x18 + (i<<2));
-    INIT_DEBUGF("cu(%d) at 0x%x\n",i,cu_addr_map[i]);
+    auto addr = read_reg(slot.slot_addr + 0x18 + (i<<2));
+    cu_addr_map[i] = addr & ~ERT_CU_CTRL_MASK;
+    if ((addr & ERT_CU_CTRL_MASK)==ERT_CU_CTRL_CHAIN)
+      cu_chain.set(i);
+    INIT_DEBUGF("cu(%d) at 0x%x%s\n",i,cu_addr_map[i],cu_chain.test(i) ? " chained" : "");
   }
 
   // (Re)initilize MB
@@ -845,6 +991,10 @@ abort_mb(size_type slot_idx)
     return true; // bail if not a start_kernel command
   if ((s.header_value & 0xF)!=0x3)
     return true; // bail if not running
+  for (size_type w=0; w<num_cu_masks; ++w)
+    if (s.cus.get_mask(w) & cu_chain.get_mask(w))
+      return true; // bail if on chained cu, its invocations complete in order
+  slot_running.clear(sidx);
   for (size_type cu_idx=0; cu_idx<num_cus; ++cu_idx) {
     if (s.cus.test(cu_idx)) {
       check_command(sidx,cu_idx);
@@ -915,8 +1065,13 @@ new_to_queued(size_type slot_idx)
 
   auto opc = opcode(slot.header_value);
   ERT_DEBUGF("slot_idx(%d) opcode = %d\n",slot_idx,opc);
+  slot_new.clear(slot_idx);
   if (opc!=ERT_START_KERNEL) { // Non performance critical command
-    process_special_command(opc,slot_idx);
+    // configure resets all slots, other commands free their slot
+    if (process_special_command(opc,slot_idx) && opc!=ERT_CONFIGURE) {
+      slot.header_value = (slot.header_value & ~0xF) | 0x4; // free
+      slot_free.set(slot_idx);
+    }
     return false;
   }
 
@@ -928,6 +1083,7 @@ new_to_queued(size_type slot_idx)
   slot.regmap_addr = regmap_section_addr(slot.header_value,slot.slot_addr);
   slot.regmap_size = regmap_size(slot.header_value);
   slot.header_value = (slot.header_value & ~0xF) | 0x2; // queued
+  queued_slots[num_queued++] = slot_idx;
 
   ERT_DEBUGF("slot(%d) [new -> queued]\n",slot_idx);
 
@@ -950,6 +1106,14 @@ queued_to_running(size_type slot_idx)
   auto& slot = command_slots[slot_idx];
   ERT_ASSERT((slot.header_value & 0xF)==0x2,"slot is not queued\n");
 
+  // bail before disabling interrupts if none of the cus are idle,
+  // the interrupt handler can only make busy cus idle
+  bitmask_type idle = 0;
+  for (size_type w=0; w<num_cu_masks && !idle; ++w)
+    idle = slot.cus.get_mask(w) & ~cu_status.get_mask(w);
+  if (!idle)
+    return false;
+
   // disable CU interrupts while starting command
   disable_interrupt_guard guard;
   // queued command, start if any of cus is ready
@@ -957,6 +1121,8 @@ queued_to_running(size_type slot_idx)
   if (cu_idx != no_index) {
     slot.cus.clear_and_set(cu_idx); // bitmask now reflects running cu
     slot.header_value |= 0x1;       // running (0x2->0x3)
+    if (!cu_interrupt_mask.test(cu_idx) && !cu_chain.test(cu_idx))
+      slot_running.set(slot_idx);
     ERT_DEBUGF("slot(%d) [queued -> running]\n",slot_idx);
 
 #ifdef DEBUG_SLOT_STATE
@@ -981,11 +1147,12 @@ running_to_free(size_type slot_idx)
   ERT_ASSERT((slot.header_value & 0xF)==0x3,"slot is not running\n");
   // running command, check its cu status
   for (size_type w=0,offset=0; w<num_cu_masks; ++w,offset+=32) {
-    auto cu_mask = slot.cus.get_mask(w);
-    for (size_type cu_idx=offset; cu_mask; cu_mask >>=1, ++cu_idx) {
-      if ((cu_mask & 0x1) && check_cu(cu_idx,false)) {
+    for (auto cu_mask = slot.cus.get_mask(w); cu_mask; cu_mask &= cu_mask-1) {
+      if (check_cu(offset + lowest_bit(cu_mask),false)) {
         notify_host(slot_idx);
         slot.header_value = (slot.header_value & ~0xF) | 0x4; // free
+        slot_running.clear(slot_idx);
+        slot_free.set(slot_idx);
         ERT_DEBUGF("slot(%d) [running -> free]\n",slot_idx);
 
 #ifdef DEBUG_SLOT_STATE
@@ -998,19 +1165,147 @@ running_to_free(size_type slot_idx)
   return false;
 }
 
+/**
+ * Collect slots transitioned by the interrupt handler
+ *
+ * Slots that became new (CQ status) or free (CU interrupt) in the
+ * interrupt handler are added to the slot bitmaps of the scheduler
+ * loop.
+ */
+inline void
+collect_isr_slots()
+{
+  for (size_type w=0; w<num_slot_masks; ++w) {
+    if (auto pending = isr_slot_new.get_mask(w) ^ ack_slot_new.get_mask(w)) {
+      slot_new.set_mask(w,slot_new.get_mask(w) | pending);
+      ack_slot_new.set_mask(w,ack_slot_new.get_mask(w) ^ pending);
+    }
+    if (auto pending = isr_slot_free.get_mask(w) ^ ack_slot_free.get_mask(w)) {
+      slot_free.set_mask(w,slot_free.get_mask(w) | pending);
+      ack_slot_free.set_mask(w,ack_slot_free.get_mask(w) ^ pending);
+    }
+  }
+}
+
+/**
+ * Wait per visited slot in emulation and simulation
+ */
+inline void
+slot_wait()
+{
+#ifdef ERT_HW_EMU
+  if(sim_embedded_scheduler_sw_imp::getSchedularPtr()!=nullptr) {
+    sim_embedded_scheduler_sw_imp* sch=sim_embedded_scheduler_sw_imp::getSchedularPtr();
+    wait(sch->maxi_lite_mb_aclk.posedge_event());
+  } else {
+    sc_time t(1,SC_NS);
+    wait(t);
+  }
+#endif
+#ifdef ERT_SIM
+  sim::tick();
+#endif
+}
+
+/**
+ * Check if any CU is idle
+ */
+inline bool
+any_idle_cu()
+{
+  for (size_type w=0,offset=0; w<num_cu_masks; ++w,offset+=32) {
+    auto cus = num_cus-offset;
+    if (~cu_status.get_mask(w) & (cus<32 ? (1u<<cus)-1 : ~0u))
+      return true;
+  }
+  return false;
+}
+
+/**
+ * Start queued commands in order of arrival
+ *
+ * Commands that cannot start because none of their CUs are idle
+ * remain queued in order.  Scanning stops when all CUs are busy.
+ */
+inline void
+start_queued_slots()
+{
+  size_type queued = 0;
+  size_type i = 0;
+  for (; i<num_queued && any_idle_cu(); ++i) {
+    auto slot_idx = queued_slots[i];
+    slot_wait();
+    if (!queued_to_running(slot_idx))
+      queued_slots[queued++] = slot_idx;
+  }
+  for (; i<num_queued; ++i)
+    queued_slots[queued++] = queued_slots[i];
+  num_queued = queued;
+}
+
+/**
+ * Visit slots in bitset in round robin order starting at slot_cursor
+ *
+ * Starting after the most recently picked up command avoids that
+ * commands in low slots starve commands in high slots when the
+ * scheduler is saturated.  The first word is visited twice, first for
+ * slots at and after the cursor then for slots before the cursor.
+ * Slots removed from the bitset while visiting are skipped, which
+ * is also the case for all slots if a configure command is processed.
+ */
+template <typename Visit>
+inline void
+visit_slots(const bitset_type& slots, Visit visit)
+{
+  auto cursor = slot_cursor;
+  for (size_type i=0,w=cursor>>5; i<=num_slot_masks; ++i,w=(w+1<num_slot_masks ? w+1 : 0)) {
+    auto mask = slots.get_mask(w);
+    if (i==0)
+      mask &= ~0u << (cursor & 0x1F);
+    else if (i==num_slot_masks)
+      mask &= ~(~0u << (cursor & 0x1F));
+    for (; mask; mask &= mask-1) {
+      auto slot_idx = (w<<5) + lowest_bit(mask);
+      if (slots.test(slot_idx))
+        visit(slot_idx);
+    }
+  }
+}
+
+/**
+ * Transition a new command to queued and start it right away unless
+ * other commands are waiting for a CU
+ */
+inline void
+queue_new_slot(size_type slot_idx)
+{
+  slot_cursor = (slot_idx+1<num_slots) ? slot_idx+1 : 0;
+  if (new_to_queued(slot_idx) && num_queued==1)
+    start_queued_slots();
+}
+
 /**
  * Main routine executed by embedded scheduler loop
  *
- * For each command slot do
- *  1. If status is free (0x4), then read new command header
- *     Status remains free (0x4), or transitions to new (0x1)
- *  2. If status is new (0x1), then read CUs in command
+ * Each pass visits only the slots that have a possible transition
+ * per the slot bitmaps, in this order
+ *  1. If status is running (0x3) and CU has no interrupt, then check
+ *     CU status.  Status remains running (0x3) if CU is still
+ *     running, or transitions to free (0x4) if CU is done.  Chained
+ *     CUs are checked for AP_READY and for the oldest invocation
+ *     being done
+ *  2. If status is free (0x4) and host does not signal new commands
+ *     through CQ status registers, then read new command header.
+ *     Status remains free (0x4), or transitions to new (0x1) and
+ *     then immediately to queued (0x2)
+ *  3. If status is new (0x1), then read CUs in command
  *     Status transitions to queued (0x2)
- *  3. If status is queued (0x2), then start command on available CU
+ *  4. If status is queued (0x2), then start command on available CU
  *     Status remains queued if no CUs available, or transitions to running (0x3)
- *  4. If status is running (0x4), then check CU status
- *     Status remains running (0x4) if CU is still running, or
- *     transitions to free if CU is done
+ *     Queued commands are visited in order of arrival
+ *
+ * Slots transitioned by the interrupt handler (CQ status, CU
+ * interrupts) are collected at the beginning of each pass.
  */
 ERT_UNUSED // don't warn when unused
 static void
@@ -1023,46 +1318,57 @@ scheduler_loop()
   setup();
 
   while (1) {
-    for (size_type slot_idx=0; slot_idx<num_slots; ++slot_idx) {
-      auto& slot = command_slots[slot_idx];
-#ifdef ERT_HW_EMU
-      if(sim_embedded_scheduler_sw_imp::getSchedularPtr()!=nullptr) {
-      sim_embedded_scheduler_sw_imp* sch=sim_embedded_scheduler_sw_imp::getSchedularPtr();
-        wait(sch->maxi_lite_mb_aclk.posedge_event());
-      } else {
-        sc_time t(1,SC_NS);
-        wait(t);
-      }
+#if defined(ERT_SIM)
+    if (!sim::tick())
+      return;
+#elif defined(ERT_HW_EMU)
+    slot_wait();
 #endif
-      // CQ_STATUS_ENABLED CHECK WON'T WORK IF HOST TRANSITIONS
-      // FROM ENABLED -> DISABLED IN CONFIGURE COMMAND
-      if (!cq_status_enabled && ((slot.header_value & 0xF) == 0x4)) { // free
-        if (!free_to_new(slot_idx))
-          continue;
-      }
+    collect_isr_slots();
 
-      if ((slot.header_value & 0xF) == 0x1) { // new
-        if (!new_to_queued(slot_idx))
-          continue;
+    if (!cu_interrupt_enabled) {
+      for (size_type w=0,offset=0; w<num_slot_masks; ++w,offset+=32) {
+        for (auto mask = slot_running.get_mask(w); mask; mask &= mask-1) {
+          slot_wait();
+          running_to_free(offset + lowest_bit(mask));
+        }
       }
+    }
 
-      if ((slot.header_value & 0xF) == 0x2) { // queued
-        if (!queued_to_running(slot_idx))
-          continue;
+    for (size_type w=0,offset=0; w<num_cu_masks; ++w,offset+=32) {
+      for (auto mask = cu_chain_active.get_mask(w); mask; mask &= mask-1) {
+        slot_wait();
+        check_chain_cu(offset + lowest_bit(mask));
       }
+    }
 
-      if (!cu_interrupt_enabled && ((slot.header_value & 0xF) == 0x3)) { // running
-        if (!running_to_free(slot_idx))
-          continue;
-      }
+    // CQ_STATUS_ENABLED CHECK WON'T WORK IF HOST TRANSITIONS
+    // FROM ENABLED -> DISABLED IN CONFIGURE COMMAND
+    if (!cq_status_enabled) {
+      visit_slots(slot_free,[](size_type slot_idx) {
+        slot_wait();
+        if (free_to_new(slot_idx)) {
+          slot_free.clear(slot_idx);
+          queue_new_slot(slot_idx);
+        }
+      });
     }
+
+    visit_slots(slot_new,[](size_type slot_idx) {
+      slot_wait();
+      queue_new_slot(slot_idx);
+    });
+
+    start_queued_slots();
   } // while
 }
 
 /**
  * CU interrupt service routine
  */
+#ifndef ERT_SIM
 void cu_interrupt_handler() __attribute__((interrupt_handler));
+#endif
 void
 cu_interrupt_handler()
 {
@@ -1090,9 +1396,11 @@ cu_interrupt_handler()
       auto slot_mask = read_reg(CQ_STATUS_REGISTER_ADDR[w]);
       ERT_DEBUGF("command queue interrupt from host: 0x%x\n",slot_mask);
       // Transition each new command into new state
-      for (size_type slot_idx=offset; slot_mask; slot_mask >>= 1, ++slot_idx)
-        if (slot_mask & 0x1)
-          free_to_new(slot_idx);
+      for (; slot_mask; slot_mask &= slot_mask-1) {
+        auto slot_idx = offset + lowest_bit(slot_mask);
+        if (free_to_new(slot_idx))
+          isr_slot_new.toggle(slot_idx);
+      }
     }
   }
 
@@ -1113,8 +1421,16 @@ cu_interrupt_handler()
   write_reg(ERT_INTC_IAR_ADDR,intc_mask);
 }
 
+#ifdef ERT_SIM
+void
+sim::scheduler_main()
+{
+  scheduler_loop();
+}
+#endif
+
 } // ert
-#ifndef ERT_HW_EMU
+#if !defined(ERT_HW_EMU) && !defined(ERT_SIM)
 int main()
 {
   ert::scheduler_loop();
@@ -0,0 +1,462 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "device.h"
+#include "ert_sim.h"
+#include "driver/include/ert.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// The one and only device, target of firmware register accesses
+static ert::sim::device* s_device = nullptr;
+
+static ert::sim::device::addr_type
+index_of(ert::sim::device::addr_type addr, ert::sim::device::addr_type base)
+{
+  return (addr - base) >> 2;
+}
+
+[[noreturn]] static void
+fail(const std::string& msg)
+{
+  std::cerr << "ert_sim: " << msg << "\n";
+  std::exit(1);
+}
+
+}
+
+namespace ert { namespace sim {
+
+latency_model::
+latency_model(const std::string& spec)
+  : m_spec(spec)
+{
+  std::istringstream is(spec);
+  std::string name, a, b;
+  std::getline(is,name,':');
+  std::getline(is,a,':');
+  std::getline(is,b,':');
+
+  try {
+    if (name=="fixed" && !a.empty()) {
+      m_kind = kind::fixed;
+      m_a = std::stod(a);
+      return;
+    }
+    if (name=="uniform" && !a.empty() && !b.empty()) {
+      m_kind = kind::uniform;
+      m_a = std::stod(a);
+      m_b = std::stod(b);
+      if (m_b>=m_a)
+        return;
+    }
+    if (name=="exp" && !a.empty()) {
+      m_kind = kind::exponential;
+      m_a = std::stod(a);
+      return;
+    }
+  }
+  catch (const std::exception&) {
+  }
+  throw std::runtime_error("bad latency model '" + spec + "'");
+}
+
+uint64_t
+latency_model::
+operator()(std::mt19937_64& rng) const
+{
+  switch (m_kind) {
+  case kind::fixed:
+    return static_cast<uint64_t>(m_a);
+  case kind::uniform:
+    return static_cast<uint64_t>(std::uniform_real_distribution<double>(m_a,m_b)(rng));
+  case kind::exponential:
+    return static_cast<uint64_t>(std::exponential_distribution<double>(1.0/m_a)(rng));
+  }
+  return 0;
+}
+
+device::
+device(const config& cfg)
+  : m_config(cfg), m_rng(cfg.seed), m_cq(ERT_CQ_SIZE/4,0), m_cus(cfg.num_cus)
+{
+  if (!cfg.num_cus || cfg.num_cus>128)
+    throw std::runtime_error("number of cus must be in [1,128]");
+  if (!cfg.num_slots || cfg.num_slots>128 || ERT_CQ_SIZE % cfg.num_slots)
+    throw std::runtime_error("number of slots must be a power of 2 in [1,128]");
+
+  for (unsigned int idx=0; idx<cfg.num_cus; ++idx)
+    m_cus[idx].addr = get_cu_addr(idx);
+
+  s_device = this;
+}
+
+device::
+~device()
+{
+  if (s_device==this)
+    s_device = nullptr;
+}
+
+device::addr_type
+device::
+get_slot_addr(unsigned int slot_idx) const
+{
+  return ERT_CQ_BASE_ADDR + slot_idx * (ERT_CQ_SIZE / m_config.num_slots);
+}
+
+bool
+device::
+is_cq(addr_type addr) const
+{
+  return addr>=ERT_CQ_BASE_ADDR && addr<ERT_CQ_BASE_ADDR+ERT_CQ_SIZE;
+}
+
+device::cu*
+device::
+get_cu(addr_type addr)
+{
+  if (addr<cu_base_addr)
+    return nullptr;
+  auto idx = (addr - cu_base_addr) >> cu_shift;
+  return idx<m_cus.size() ? &m_cus[idx] : nullptr;
+}
+
+void
+device::
+schedule(uint64_t time, event_type fn)
+{
+  m_events.push({time,m_seq++,std::move(fn)});
+}
+
+void
+device::
+advance(uint64_t ns)
+{
+  m_now += ns;
+  while (!m_events.empty() && m_events.top().time<=m_now) {
+    auto ev = m_events.top();
+    m_events.pop();
+    ev.fn(ev.time);
+  }
+  interrupt();
+}
+
+void
+device::
+interrupt()
+{
+  // Handler is not reentrant, the MicroBlaze clears MSR[IE] on entry
+  while (!m_in_handler && m_msr_ie && (m_mer & 0x1) && (m_isr & m_ier)) {
+    m_in_handler = true;
+    ++m_counters.interrupts;
+    advance(m_config.irq_ns);
+    cu_interrupt_handler();
+    m_in_handler = false;
+  }
+}
+
+void
+device::
+update_intc()
+{
+  // Interrupt sources are level sensitive
+  for (unsigned int w=0; w<4; ++w) {
+    if (m_cu_status[w])
+      m_isr |= 0x2;
+    if (m_cq_status[w])
+      m_isr |= 0x1;
+  }
+}
+
+void
+device::
+start_cu(unsigned int cu_idx)
+{
+  if (m_config.cu_ii) {
+    start_chain_cu(cu_idx);
+    return;
+  }
+
+  auto& cu = m_cus[cu_idx];
+  if (cu.running)
+    fail("cu(" + std::to_string(cu_idx) + ") started while running");
+  cu.running = true;
+  cu.done = false;
+  ++cu.starts;
+  auto latency = m_config.cu_latency(m_rng);
+  cu.busy_ns += latency;
+  schedule(m_now+latency,[this,cu_idx](uint64_t) { complete_cu(cu_idx); });
+}
+
+void
+device::
+complete_cu(unsigned int cu_idx)
+{
+  auto& cu = m_cus[cu_idx];
+  auto isr = m_regs[ERT_CU_ISR_HANDLER_ENABLE_ADDR];
+  if (isr && cu.gie && cu.ier) {
+    // CU ISR peripheral acknowledges the CU and latches its status
+    cu.running = false;
+    m_cu_status[cu_idx>>5] |= 1u << (cu_idx & 0x1F);
+    update_intc();
+    return;
+  }
+  cu.done = true;
+}
+
+void
+device::
+start_chain_cu(unsigned int cu_idx)
+{
+  auto& cu = m_cus[cu_idx];
+  if (!cu.accepting)
+    fail("chained cu(" + std::to_string(cu_idx) + ") started before AP_READY");
+  cu.accepting = false;
+  ++cu.inflight;
+  ++cu.starts;
+  cu.busy_ns += m_config.cu_ii;
+  schedule(m_now+m_config.cu_ii,[this,cu_idx](uint64_t) {
+      auto& cu = m_cus[cu_idx];
+      cu.ready = cu.accepting = true;
+    });
+
+  // Invocations complete in order
+  cu.last_done = std::max(m_now+m_config.cu_latency(m_rng),cu.last_done);
+  schedule(cu.last_done,[this,cu_idx](uint64_t) { ++m_cus[cu_idx].done_pending; });
+}
+
+void
+device::
+continue_chain_cu(unsigned int cu_idx)
+{
+  auto& cu = m_cus[cu_idx];
+  if (!cu.done_pending)
+    fail("chained cu(" + std::to_string(cu_idx) + ") continued without AP_DONE");
+  --cu.done_pending;
+  --cu.inflight;
+}
+
+void
+device::
+dma(unsigned int slot_idx)
+{
+  // CU section of slot identifies the CU to start
+  auto cu_section = index_of(get_slot_addr(slot_idx)+4,ERT_CQ_BASE_ADDR);
+  for (unsigned int w=0; w<=(m_config.num_cus-1)>>5; ++w) {
+    auto mask = m_cq[cu_section+w];
+    for (unsigned int cu_idx=w<<5; mask; mask>>=1, ++cu_idx) {
+      if (mask & 0x1) {
+        schedule(m_now+m_config.dma_ns,[this,cu_idx](uint64_t) { start_cu(cu_idx); });
+        return;
+      }
+    }
+  }
+  fail("cu dma of slot(" + std::to_string(slot_idx) + ") without cu");
+}
+
+device::value_type
+device::
+read(addr_type addr)
+{
+  if (is_cq(addr)) {
+    ++m_counters.cq_reads;
+    advance(m_config.cq_ns);
+    return m_cq[index_of(addr,ERT_CQ_BASE_ADDR)];
+  }
+
+  ++m_counters.reg_reads;
+  advance(m_config.reg_ns);
+
+  if (auto cu = get_cu(addr)) {
+    if ((addr - cu->addr) != 0)
+      return 0;
+    // AP_READY is cleared on read, AP_DONE by AP_CONTINUE
+    if (m_config.cu_ii) {
+      value_type value = (cu->done_pending ? 0x2 : 0) | (cu->ready ? 0x8 : 0) | (cu->inflight ? 0x1 : 0x4);
+      cu->ready = false;
+      return value;
+    }
+    // AP_DONE is cleared on read
+    if (cu->running && cu->done) {
+      cu->running = cu->done = false;
+      return 0x6; // AP_DONE | AP_IDLE
+    }
+    return cu->running ? 0x1 : 0x4;
+  }
+
+  if (addr>=ERT_CU_STATUS_REGISTER_ADDR0 && addr<=ERT_CU_STATUS_REGISTER_ADDR3) {
+    auto& status = m_cu_status[index_of(addr,ERT_CU_STATUS_REGISTER_ADDR0)];
+    auto value = status;
+    status = 0;
+    return value;
+  }
+
+  if (addr>=ERT_CQ_STATUS_REGISTER_ADDR0 && addr<=ERT_CQ_STATUS_REGISTER_ADDR3) {
+    auto& status = m_cq_status[index_of(addr,ERT_CQ_STATUS_REGISTER_ADDR0)];
+    auto value = status;
+    status = 0;
+    return value;
+  }
+
+  switch (addr) {
+  case ERT_INTC_IPR_ADDR:
+    return m_isr & m_ier;
+  case ERT_INTC_IER_ADDR:
+    return m_ier;
+  case ERT_INTC_MER_ADDR:
+    return m_mer;
+  }
+
+  auto itr = m_regs.find(addr);
+  return itr!=m_regs.end() ? itr->second : 0;
+}
+
+void
+device::
+write(addr_type addr, value_type value)
+{
+  if (is_cq(addr)) {
+    auto offset = addr - ERT_CQ_BASE_ADDR;
+    auto slot_size = ERT_CQ_SIZE / m_config.num_slots;
+    auto state = value & 0xF;
+
+    // Slot states 0x2, 0x3, 0x4 are written to the slot header only
+    // with DEBUG_SLOT_STATE, they are traced but not charged.
+    // Header 0xF is written by free_to_new when a new command is
+    // picked up.
+    bool header = (offset % slot_size)==0;
+    bool trace = header && (state==0x2 || state==0x3 || state==0x4);
+    if (!trace) {
+      ++m_counters.cq_writes;
+      advance(m_config.cq_ns);
+    }
+    m_cq[offset>>2] = value;
+    if (header && (trace || state==0xF) && m_trace)
+      m_trace(offset/slot_size, state==0xF ? value_type(ERT_CMD_STATE_NEW) : state);
+    return;
+  }
+
+  ++m_counters.reg_writes;
+  advance(m_config.reg_ns);
+
+  if (auto cu = get_cu(addr)) {
+    switch (addr - cu->addr) {
+    case 0x0:
+      if (value & 0x1)
+        start_cu((addr - cu_base_addr) >> cu_shift);
+      if ((value & 0x10) && m_config.cu_ii)
+        continue_chain_cu((addr - cu_base_addr) >> cu_shift);
+      break;
+    case 0x4:
+      cu->gie = value & 0x1;
+      break;
+    case 0x8:
+      cu->ier = value & 0x1;
+      break;
+    }
+    return;
+  }
+
+  if (addr>=ERT_STATUS_REGISTER_ADDR0 && addr<=ERT_STATUS_REGISTER_ADDR3) {
+    auto offset = index_of(addr,ERT_STATUS_REGISTER_ADDR0) << 5;
+    for (unsigned int slot_idx=offset; value; value>>=1, ++slot_idx)
+      if ((value & 0x1) && m_notify)
+        m_notify(slot_idx);
+    return;
+  }
+
+  if (addr>=ERT_CU_DMA_REGISTER_ADDR0 && addr<=ERT_CU_DMA_REGISTER_ADDR3) {
+    auto offset = index_of(addr,ERT_CU_DMA_REGISTER_ADDR0) << 5;
+    for (unsigned int slot_idx=offset; value; value>>=1, ++slot_idx)
+      if (value & 0x1)
+        dma(slot_idx);
+    return;
+  }
+
+  switch (addr) {
+  case ERT_INTC_IAR_ADDR:
+    m_isr &= ~value;
+    update_intc();
+    return;
+  case ERT_INTC_IER_ADDR:
+    m_ier = value;
+    return;
+  case ERT_INTC_MER_ADDR:
+    m_mer = value;
+    return;
+  }
+
+  m_regs[addr] = value;
+}
+
+void
+device::
+host_write(addr_type addr, value_type value)
+{
+  if (!is_cq(addr))
+    fail("host write outside command queue");
+  m_cq[index_of(addr,ERT_CQ_BASE_ADDR)] = value;
+}
+
+void
+device::
+host_signal(unsigned int slot_idx)
+{
+  if (!m_regs[ERT_CQ_STATUS_ENABLE_ADDR])
+    return;
+  m_cq_status[slot_idx>>5] |= 1u << (slot_idx & 0x1F);
+  update_intc();
+}
+
+}} // sim,ert
+
+////////////////////////////////////////////////////////////////
+// Firmware board support
+////////////////////////////////////////////////////////////////
+void
+microblaze_enable_interrupts()
+{
+  s_device->enable_interrupts(true);
+}
+
+void
+microblaze_disable_interrupts()
+{
+  s_device->enable_interrupts(false);
+}
+
+namespace ert {
+
+uint32_t
+read_reg(uint32_t addr)
+{
+  return s_device->read(addr);
+}
+
+void
+write_reg(uint32_t addr, uint32_t value)
+{
+  s_device->write(addr,value);
+}
+
+} // ert
@@ -0,0 +1,319 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef ert_sim_device_h_
+#define ert_sim_device_h_
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ert { namespace sim {
+
+/**
+ * CU latency model, time from CU start to AP_DONE
+ *
+ * Constructed from a spec string:
+ *  fixed:<ns>
+ *  uniform:<min ns>:<max ns>
+ *  exp:<mean ns>
+ */
+class latency_model
+{
+public:
+  /**
+   * @exception std::runtime_error if spec cannot be parsed
+   */
+  explicit
+  latency_model(const std::string& spec);
+
+  uint64_t
+  operator()(std::mt19937_64& rng) const;
+
+  const std::string&
+  get_spec() const
+  {
+    return m_spec;
+  }
+
+private:
+  enum class kind { fixed, uniform, exponential };
+  kind m_kind = kind::fixed;
+  double m_a = 0;
+  double m_b = 0;
+  std::string m_spec;
+};
+
+/**
+ * Configuration of simulated device
+ *
+ * Costs are in ns of simulated time and are charged to the firmware
+ * when it accesses the corresponding resource.
+ */
+struct config
+{
+  unsigned int num_cus = 4;
+  unsigned int num_slots = 16;
+
+  // configure_mb features
+  bool cu_dma = false;
+  bool cu_isr = false;
+  bool cq_int = false;
+
+  latency_model cu_latency {"fixed:10000"};
+
+  // Chained CUs (ap_ctrl_chain) accept the next start cu_ii ns after
+  // previous start, 0 for ap_ctrl_hs CUs
+  uint64_t cu_ii = 0;
+  unsigned int seed = 0;
+
+  uint64_t reg_ns = 100;   // axi-lite access of CSR, CU, and INTC registers
+  uint64_t cq_ns = 40;     // access of command queue memory
+  uint64_t loop_ns = 20;   // scheduler loop overhead per slot iteration
+  uint64_t irq_ns = 400;   // interrupt entry and exit
+  uint64_t dma_ns = 500;   // CU DMA transfer of register map and CU start
+};
+
+/**
+ * Simulated device seen by the ERT firmware
+ *
+ * Models command queue memory, the ERT CSRs, the interrupt controller,
+ * and the CUs along with their interrupt (CU ISR) and register map
+ * transfer (CU DMA) peripherals.  Time is simulated, it advances when
+ * the firmware accesses a register and when the firmware scheduler
+ * loop ticks.  Device and host activity is scheduled as timed events
+ * that are dispatched as simulated time advances.
+ *
+ * There can be only one device, firmware register accesses are routed
+ * to the device most recently constructed.
+ */
+class device
+{
+public:
+  using addr_type = uint32_t;
+  using value_type = uint32_t;
+  using event_type = std::function<void(uint64_t time)>;
+
+  // Firmware notified host of completed command in slot
+  using notify_type = std::function<void(unsigned int slot_idx)>;
+
+  // Firmware traced state of command in slot (DEBUG_SLOT_STATE)
+  using trace_type = std::function<void(unsigned int slot_idx, value_type state)>;
+
+  struct counters
+  {
+    uint64_t reg_reads = 0;
+    uint64_t reg_writes = 0;
+    uint64_t cq_reads = 0;
+    uint64_t cq_writes = 0;
+    uint64_t interrupts = 0;
+    uint64_t ticks = 0;
+  };
+
+  struct cu
+  {
+    addr_type addr = 0;
+    bool running = false;
+    bool done = false;
+    bool gie = false;
+    bool ier = false;
+    uint64_t starts = 0;
+    uint64_t busy_ns = 0;          // cu_ii per start for chained CUs
+
+    // Chained CU, invocations complete in order
+    bool ready = false;            // AP_READY, cleared on read
+    bool accepting = true;         // can be started
+    unsigned int inflight = 0;     // started and not acknowledged
+    unsigned int done_pending = 0; // AP_DONE not acknowledged with AP_CONTINUE
+    uint64_t last_done = 0;
+  };
+
+  static const addr_type cu_base_addr = 0x1800000;
+  static const unsigned int cu_shift = 16;
+
+  explicit
+  device(const config& cfg);
+
+  ~device();
+
+  const config&
+  get_config() const
+  {
+    return m_config;
+  }
+
+  uint64_t
+  now() const
+  {
+    return m_now;
+  }
+
+  const counters&
+  get_counters() const
+  {
+    return m_counters;
+  }
+
+  const std::vector<cu>&
+  get_cus() const
+  {
+    return m_cus;
+  }
+
+  addr_type
+  get_cu_addr(unsigned int cu_idx) const
+  {
+    return cu_base_addr + (cu_idx << cu_shift);
+  }
+
+  addr_type
+  get_slot_addr(unsigned int slot_idx) const;
+
+  /**
+   * Advance simulated time, dispatch due events, and deliver pending
+   * interrupts to the firmware
+   */
+  void
+  advance(uint64_t ns);
+
+  /**
+   * Scheduler loop iteration, charged per config
+   */
+  void
+  tick()
+  {
+    ++m_counters.ticks;
+    advance(m_config.loop_ns);
+  }
+
+  /**
+   * Schedule an event at absolute simulated time
+   */
+  void
+  schedule(uint64_t time, event_type fn);
+
+  void
+  on_notify(notify_type fn)
+  {
+    m_notify = std::move(fn);
+  }
+
+  void
+  on_trace(trace_type fn)
+  {
+    m_trace = std::move(fn);
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // Firmware side, charged per config
+  ////////////////////////////////////////////////////////////////
+  value_type
+  read(addr_type addr);
+
+  void
+  write(addr_type addr, value_type value);
+
+  void
+  enable_interrupts(bool enable)
+  {
+    m_msr_ie = enable;
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // Host side, not charged
+  ////////////////////////////////////////////////////////////////
+  /**
+   * Write command queue memory
+   */
+  void
+  host_write(addr_type addr, value_type value);
+
+  /**
+   * Signal new command in slot via CQ status register (cq_int)
+   */
+  void
+  host_signal(unsigned int slot_idx);
+
+private:
+  struct event
+  {
+    uint64_t time;
+    uint64_t seq;
+    event_type fn;
+    bool operator> (const event& rhs) const
+    {
+      return time!=rhs.time ? time>rhs.time : seq>rhs.seq;
+    }
+  };
+
+  bool
+  is_cq(addr_type addr) const;
+
+  cu*
+  get_cu(addr_type addr);
+
+  void
+  start_cu(unsigned int cu_idx);
+
+  void
+  complete_cu(unsigned int cu_idx);
+
+  void
+  start_chain_cu(unsigned int cu_idx);
+
+  void
+  continue_chain_cu(unsigned int cu_idx);
+
+  void
+  dma(unsigned int slot_idx);
+
+  void
+  update_intc();
+
+  void
+  interrupt();
+
+  config m_config;
+  std::mt19937_64 m_rng;
+  uint64_t m_now = 0;
+  uint64_t m_seq = 0;
+  std::priority_queue<event,std::vector<event>,std::greater<event>> m_events;
+
+  std::vector<value_type> m_cq;
+  std::vector<cu> m_cus;
+  std::unordered_map<addr_type,value_type> m_regs;
+  value_type m_cu_status[4] = {0};
+  value_type m_cq_status[4] = {0};
+
+  // Interrupt controller
+  value_type m_isr = 0;
+  value_type m_ier = 0;
+  value_type m_mer = 0;
+  bool m_msr_ie = false;
+  bool m_in_handler = false;
+
+  notify_type m_notify;
+  trace_type m_trace;
+  counters m_counters;
+};
+
+}} // sim,ert
+
+#endif
@@ -0,0 +1,75 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef ert_sim_ert_sim_h_
+#define ert_sim_ert_sim_h_
+
+/**
+ * Board support replacement for compiling the ERT scheduler firmware
+ * on the host (ERT_SIM).
+ *
+ * Register accesses made by the firmware are routed to the simulated
+ * device (see device.h), which advances simulated time, models the
+ * CUs, the interrupt controller and the command queue, and delivers
+ * interrupts by calling the firmware interrupt handler.
+ */
+
+#include <cstdint>
+#include <cstdio>
+
+#define xil_printf printf
+#define print printf
+
+void
+microblaze_enable_interrupts();
+
+void
+microblaze_disable_interrupts();
+
+namespace ert {
+
+uint32_t
+read_reg(uint32_t addr);
+
+void
+write_reg(uint32_t addr, uint32_t value);
+
+// Defined by firmware
+void
+cu_interrupt_handler();
+
+namespace sim {
+
+/**
+ * Called by firmware once per slot iteration of the scheduler loop
+ *
+ * @return
+ *   false when the simulation is done and the scheduler loop
+ *   should return
+ */
+bool
+tick();
+
+/**
+ * Firmware entry point, runs the scheduler loop until tick()
+ * returns false
+ */
+void
+scheduler_main();
+
+}} // sim,ert
+
+#endif
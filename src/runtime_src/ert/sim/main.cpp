@@ -0,0 +1,473 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * Host side simulation of the ERT scheduler firmware
+ *
+ * The firmware (ert/scheduler/scheduler.cpp) is compiled for the host
+ * with ERT_SIM and DEBUG_SLOT_STATE and runs against a simulated
+ * device (device.h).  The host model configures the firmware, then
+ * replays a synthetic stream of start kernel commands keeping up to
+ * a given number of commands in flight.  When all commands have
+ * completed, throughput, slot occupancy, and per state command
+ * latency are reported in simulated time.
+ *
+ * % ert_sim --cus 8 --slots 32 --commands 100000 --latency exp:5000 --cu-isr
+ */
+
+#include "device.h"
+#include "ert_sim.h"
+#include "driver/include/ert.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+using ert::sim::device;
+
+// Command state as seen by host, in the order commands progress
+enum state { submitted, picked, queued, running, done, num_states };
+
+const char* state_names[] = {
+  "submit -> new"
+ ,"new -> queued"
+ ,"queued -> running"
+ ,"running -> notify"
+};
+
+struct options
+{
+  ert::sim::config config;
+  unsigned long commands = 10000;
+  unsigned int depth = 0;           // 0 is all slots
+  bool round_robin = false;         // one CU per command, else any CU
+  unsigned int regmap_words = 8;
+  uint64_t host_ns = 1000;          // host time to write a command
+};
+
+/**
+ * Host model
+ *
+ * Owns the command queue slots from the host point of view, submits
+ * commands to free slots, and records command state transitions
+ * traced by the firmware along with time weighted occupancy.
+ */
+class host
+{
+  struct command
+  {
+    bool busy = false;
+    uint64_t time[num_states] = {0};
+  };
+
+public:
+  host(device& dev, const options& opt)
+    : m_device(dev), m_options(opt), m_slots(opt.config.num_slots)
+  {
+    m_depth = opt.depth ? std::min(opt.depth,opt.config.num_slots) : opt.config.num_slots;
+    dev.on_notify([this](unsigned int slot_idx) { notify(slot_idx); });
+    dev.on_trace([this](unsigned int slot_idx, uint32_t state) { trace(slot_idx,state); });
+  }
+
+  /**
+   * Start the command stream by configuring the firmware, called
+   * once the firmware has completed its initial setup
+   */
+  void
+  start()
+  {
+    if (!m_started) {
+      m_started = true;
+      configure();
+    }
+  }
+
+  bool
+  is_done() const
+  {
+    return m_completed==m_options.commands;
+  }
+
+  uint64_t
+  last_progress() const
+  {
+    return m_last_progress;
+  }
+
+  void
+  report(std::ostream& os) const;
+
+private:
+  void
+  configure()
+  {
+    auto& cfg = m_options.config;
+    std::vector<uint32_t> packet(6+cfg.num_cus,0);
+    auto cmd = reinterpret_cast<ert_configure_cmd*>(packet.data());
+    cmd->state = ERT_CMD_STATE_NEW;
+    cmd->count = 5 + cfg.num_cus;
+    cmd->opcode = ERT_CONFIGURE;
+    cmd->slot_size = ERT_CQ_SIZE / cfg.num_slots;
+    cmd->num_cus = cfg.num_cus;
+    cmd->cu_shift = device::cu_shift;
+    cmd->cu_base_addr = device::cu_base_addr;
+    cmd->ert = 1;
+    cmd->polling = 1;
+    cmd->cu_dma = cfg.cu_dma;
+    cmd->cu_isr = cfg.cu_isr;
+    cmd->cq_int = cfg.cq_int;
+    for (unsigned int idx=0; idx<cfg.num_cus; ++idx)
+      cmd->data[idx] = m_device.get_cu_addr(idx) | (cfg.cu_ii ? ERT_CU_CTRL_CHAIN : ERT_CU_CTRL_HS);
+
+    // Firmware starts with default 4K slots, configure is in slot 0
+    write_packet(ERT_CQ_BASE_ADDR,packet);
+    m_configuring = true;
+  }
+
+  void
+  write_packet(uint32_t slot_addr, const std::vector<uint32_t>& packet)
+  {
+    // Header last, it makes the command visible to firmware
+    for (size_t idx=1; idx<packet.size(); ++idx)
+      m_device.host_write(slot_addr + (idx<<2),packet[idx]);
+    m_device.host_write(slot_addr,packet[0]);
+  }
+
+  void
+  submit(uint64_t time)
+  {
+    auto itr = std::find_if(m_slots.begin(),m_slots.end(),[](const command& c) { return !c.busy; });
+    if (itr==m_slots.end())
+      throw std::runtime_error("no free slot");
+    auto slot_idx = static_cast<unsigned int>(itr - m_slots.begin());
+
+    auto& cfg = m_options.config;
+    auto masks = ((cfg.num_cus-1)>>5) + 1;
+    std::vector<uint32_t> packet(1+masks+m_options.regmap_words,0);
+    auto cmd = reinterpret_cast<ert_start_kernel_cmd*>(packet.data());
+    cmd->state = ERT_CMD_STATE_NEW;
+    cmd->count = masks + m_options.regmap_words;
+    cmd->extra_cu_masks = masks - 1;
+    cmd->opcode = ERT_START_KERNEL;
+    if (m_options.round_robin) {
+      auto cu_idx = m_submitted % cfg.num_cus;
+      packet[1 + (cu_idx>>5)] = 1u << (cu_idx & 0x1F);
+    }
+    else {
+      for (unsigned int cu_idx=0; cu_idx<cfg.num_cus; ++cu_idx)
+        packet[1 + (cu_idx>>5)] |= 1u << (cu_idx & 0x1F);
+    }
+    for (unsigned int idx=0; idx<m_options.regmap_words; ++idx)
+      packet[1+masks+idx] = idx;
+
+    write_packet(m_device.get_slot_addr(slot_idx),packet);
+    m_device.host_signal(slot_idx);
+
+    itr->busy = true;
+    itr->time[submitted] = time;
+    ++m_submitted;
+    occupy(time,submitted,1);
+  }
+
+  void
+  schedule_submit(uint64_t time)
+  {
+    if (m_scheduled==m_options.commands)
+      return;
+    ++m_scheduled;
+    m_device.schedule(time,[this](uint64_t t) { submit(t); });
+  }
+
+  void
+  trace(unsigned int slot_idx, uint32_t value)
+  {
+    if (m_configuring || slot_idx>=m_slots.size() || !m_slots[slot_idx].busy)
+      return;
+
+    state s = value==ERT_CMD_STATE_NEW ? picked
+      : value==ERT_CMD_STATE_QUEUED ? queued
+      : value==ERT_CMD_STATE_RUNNING ? running
+      : num_states;
+    if (s==num_states)
+      return;
+
+    auto now = m_device.now();
+    m_slots[slot_idx].time[s] = now;
+    occupy(now,state(s-1),-1);
+    occupy(now,s,1);
+  }
+
+  void
+  notify(unsigned int slot_idx)
+  {
+    auto now = m_device.now();
+    m_last_progress = now;
+
+    if (m_configuring) {
+      m_configuring = false;
+      m_start = now;
+      m_last = now;
+      for (unsigned int i=0; i<m_depth; ++i)
+        schedule_submit(now + (i+1)*m_options.host_ns);
+      return;
+    }
+
+    auto& cmd = m_slots[slot_idx];
+    if (!cmd.busy)
+      throw std::runtime_error("notify of free slot " + std::to_string(slot_idx));
+    cmd.time[done] = now;
+    occupy(now,running,-1);
+    cmd.busy = false;
+
+    for (int s=submitted; s<done; ++s)
+      m_latency[s].push_back(cmd.time[s+1] - cmd.time[s]);
+    m_latency[done].push_back(cmd.time[done] - cmd.time[submitted]);
+
+    if (++m_completed==m_options.commands)
+      m_end = now;
+    else
+      schedule_submit(now + m_options.host_ns);
+  }
+
+  // Accumulate time weighted number of commands per state
+  void
+  occupy(uint64_t time, state s, int delta)
+  {
+    if (time>m_last) {
+      for (int i=submitted; i<done; ++i)
+        m_occupancy[i] += double(m_count[i]) * (time - m_last);
+      m_inflight_time += double(m_inflight) * (time - m_last);
+      m_last = time;
+    }
+    m_count[s] += delta;
+    if (s==submitted && delta>0)
+      m_max_inflight = std::max(++m_inflight,m_max_inflight);
+    if (s==running && delta<0)
+      --m_inflight;
+  }
+
+  device& m_device;
+  const options& m_options;
+  std::vector<command> m_slots;
+  unsigned int m_depth = 0;
+  bool m_started = false;
+  bool m_configuring = false;
+
+  unsigned long m_scheduled = 0;
+  unsigned long m_submitted = 0;
+  unsigned long m_completed = 0;
+  uint64_t m_start = 0;
+  uint64_t m_end = 0;
+  uint64_t m_last_progress = 0;
+
+  // Per state latency samples, [done] is end to end
+  std::vector<uint64_t> m_latency[num_states];
+
+  // Occupancy
+  uint64_t m_last = 0;
+  int m_count[num_states] = {0};
+  double m_occupancy[num_states] = {0};
+  unsigned int m_inflight = 0;
+  unsigned int m_max_inflight = 0;
+  double m_inflight_time = 0;
+};
+
+void
+host::
+report(std::ostream& os) const
+{
+  auto& cfg = m_options.config;
+  auto& counters = m_device.get_counters();
+  double elapsed = double(m_end - m_start);
+  double commands = double(m_options.commands);
+
+  os << std::fixed << std::setprecision(2);
+  os << "ert_sim: " << cfg.num_cus << " cus, " << cfg.num_slots << " slots, depth " << m_depth
+     << ", cu_dma=" << cfg.cu_dma << " cu_isr=" << cfg.cu_isr << " cq_int=" << cfg.cq_int
+     << ", cu latency " << cfg.cu_latency.get_spec()
+     << ", cu mask " << (m_options.round_robin ? "rr" : "any");
+  if (cfg.cu_ii)
+    os << ", chained ii " << cfg.cu_ii;
+  os << "\n";
+  os << "commands:       " << m_options.commands << "\n";
+  os << "simulated time: " << elapsed/1e6 << " ms\n";
+  os << "throughput:     " << commands*1e9/elapsed << " commands/s\n";
+
+  uint64_t busy = 0;
+  for (auto& cu : m_device.get_cus())
+    busy += cu.busy_ns;
+  os << "cu utilization: " << 100.0*busy/(elapsed*cfg.num_cus) << "%\n";
+
+  os << "slot occupancy: avg " << m_inflight_time/elapsed << ", max " << m_max_inflight
+     << " of " << cfg.num_slots << " slots\n";
+  os << "  submitted " << m_occupancy[submitted]/elapsed
+     << ", new " << m_occupancy[picked]/elapsed
+     << ", queued " << m_occupancy[queued]/elapsed
+     << ", running " << m_occupancy[running]/elapsed << "\n";
+
+  os << "latency (us)         avg       p50       p99       max\n";
+  auto row = [&os](const char* name, std::vector<uint64_t> samples) {
+    std::sort(samples.begin(),samples.end());
+    double sum = 0;
+    for (auto s : samples)
+      sum += s;
+    auto pct = [&samples](double p) { return samples[size_t(p*(samples.size()-1))]/1e3; };
+    os << "  " << std::left << std::setw(18) << name << std::right
+       << std::setw(8) << sum/samples.size()/1e3 << "  "
+       << std::setw(8) << pct(0.5) << "  "
+       << std::setw(8) << pct(0.99) << "  "
+       << std::setw(8) << samples.back()/1e3 << "\n";
+  };
+  for (int s=submitted; s<done; ++s)
+    row(state_names[s],m_latency[s]);
+  row("end to end",m_latency[done]);
+
+  os << "firmware per command: "
+     << counters.reg_reads/commands << " reg reads, "
+     << counters.reg_writes/commands << " reg writes, "
+     << counters.cq_reads/commands << " cq reads, "
+     << counters.cq_writes/commands << " cq writes, "
+     << counters.interrupts/commands << " interrupts, "
+     << counters.ticks/commands << " loop iterations\n";
+}
+
+host* s_host = nullptr;
+device* s_dev = nullptr;
+
+// Simulated time without a command completing before giving up
+const uint64_t watchdog_ns = 1000000000;
+
+void
+usage()
+{
+  std::cout
+    << "usage: ert_sim [options]\n"
+    << "  --cus <n>          number of CUs (4)\n"
+    << "  --slots <n>        number of command queue slots, power of 2 (16)\n"
+    << "  --commands <n>     number of commands to execute (10000)\n"
+    << "  --depth <n>        max commands in flight, 0 for all slots (0)\n"
+    << "  --cu-mask <any|rr> command can use any CU, or one CU round robin (any)\n"
+    << "  --regmap <n>       register map words per command (8)\n"
+    << "  --latency <model>  CU latency fixed:<ns>, uniform:<min>:<max>, exp:<mean> (fixed:10000)\n"
+    << "  --chain <ns>       chained CUs (ap_ctrl_chain) with initiation interval\n"
+    << "  --cu-dma           enable CU DMA\n"
+    << "  --cu-isr           enable CU interrupts\n"
+    << "  --cq-int           enable host to firmware interrupts\n"
+    << "  --host-ns <ns>     host time to submit a command (1000)\n"
+    << "  --reg-ns <ns>      firmware register access (100)\n"
+    << "  --cq-ns <ns>       firmware command queue access (40)\n"
+    << "  --loop-ns <ns>     firmware loop overhead per slot (20)\n"
+    << "  --irq-ns <ns>      firmware interrupt entry and exit (400)\n"
+    << "  --dma-ns <ns>      CU DMA transfer and start (500)\n"
+    << "  --seed <n>         random seed (0)\n";
+}
+
+options
+parse(int argc, char** argv)
+{
+  options opt;
+  auto& cfg = opt.config;
+  for (int i=1; i<argc; ++i) {
+    std::string arg = argv[i];
+    auto value = [&]() -> std::string {
+      if (++i>=argc)
+        throw std::runtime_error("missing value for " + arg);
+      return argv[i];
+    };
+    auto number = [&]() { return std::stoul(value()); };
+
+    if (arg=="--help" || arg=="-h") {
+      usage();
+      std::exit(0);
+    }
+    else if (arg=="--cus")      cfg.num_cus = number();
+    else if (arg=="--slots")    cfg.num_slots = number();
+    else if (arg=="--commands") opt.commands = number();
+    else if (arg=="--depth")    opt.depth = number();
+    else if (arg=="--regmap")   opt.regmap_words = number();
+    else if (arg=="--latency")  cfg.cu_latency = ert::sim::latency_model(value());
+    else if (arg=="--chain")    cfg.cu_ii = number();
+    else if (arg=="--cu-dma")   cfg.cu_dma = true;
+    else if (arg=="--cu-isr")   cfg.cu_isr = true;
+    else if (arg=="--cq-int")   cfg.cq_int = true;
+    else if (arg=="--host-ns")  opt.host_ns = number();
+    else if (arg=="--reg-ns")   cfg.reg_ns = number();
+    else if (arg=="--cq-ns")    cfg.cq_ns = number();
+    else if (arg=="--loop-ns")  cfg.loop_ns = number();
+    else if (arg=="--irq-ns")   cfg.irq_ns = number();
+    else if (arg=="--dma-ns")   cfg.dma_ns = number();
+    else if (arg=="--seed")     cfg.seed = number();
+    else if (arg=="--cu-mask") {
+      auto mask = value();
+      if (mask!="any" && mask!="rr")
+        throw std::runtime_error("bad cu mask '" + mask + "'");
+      opt.round_robin = (mask=="rr");
+    }
+    else
+      throw std::runtime_error("unknown option '" + arg + "'");
+  }
+
+  // Firmware statically sizes its CU arrays with max_cus, which is 32
+  // since ERT_DEBUG is always defined as a macro by scheduler.cpp
+  if (cfg.num_cus>32)
+    throw std::runtime_error("firmware supports at most 32 cus");
+  if (!opt.commands)
+    throw std::runtime_error("number of commands must be positive");
+  auto slot_words = ERT_CQ_SIZE / (cfg.num_slots ? cfg.num_slots : 1) / 4;
+  if (opt.regmap_words<4 || 1 + 4 + opt.regmap_words > slot_words)
+    throw std::runtime_error("register map does not fit in slot");
+  return opt;
+}
+
+}
+
+bool
+ert::sim::
+tick()
+{
+  s_dev->tick();
+  s_host->start();
+  if (s_host->is_done())
+    return false;
+  if (s_dev->now() - s_host->last_progress() > watchdog_ns)
+    throw std::runtime_error("no command completed in " + std::to_string(watchdog_ns/1000000) + "ms");
+  return true;
+}
+
+int
+main(int argc, char** argv)
+{
+  try {
+    auto opt = parse(argc,argv);
+    device dev(opt.config);
+    host h(dev,opt);
+    s_dev = &dev;
+    s_host = &h;
+    ert::sim::scheduler_main();
+    h.report(std::cout);
+    return 0;
+  }
+  catch (const std::exception& ex) {
+    std::cerr << "ert_sim: " << ex.what() << "\n";
+  }
+  return 1;
+}
@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+
+#include "../xclbindata.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+// Runs each test in a scratch directory, extraction writes some
+// files (runtime_data.rtd, mcs images) to the current directory
+class ExtractTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      char cwd[4096];
+      ASSERT_NE(getcwd(cwd, sizeof(cwd)), nullptr);
+      m_cwd = cwd;
+      char dir[] = "/tmp/xclbintestXXXXXX";
+      ASSERT_NE(mkdtemp(dir), nullptr);
+      m_dir = dir;
+      ASSERT_EQ(chdir(dir), 0);
+    }
+
+    void TearDown() override {
+      ASSERT_EQ(chdir(m_cwd.c_str()), 0);
+      std::string cmd = "rm -rf " + m_dir;
+      ASSERT_EQ(std::system(cmd.c_str()), 0);
+    }
+
+    std::string m_cwd;
+    std::string m_dir;
+};
+
+std::vector<char>
+randomData(size_t size, unsigned int seed)
+{
+  std::mt19937 rng(seed);
+  std::vector<char> data(size);
+  for (size_t i = 0; i < size; i += sizeof(uint32_t)) {
+    uint32_t value = rng();
+    memcpy(&data[i], &value, std::min(sizeof(value), size - i));
+  }
+  return data;
+}
+
+std::vector<char>
+memTopology(int count)
+{
+  std::vector<char> data(offsetof(mem_topology, m_mem_data) + count * sizeof(mem_data), 0);
+  mem_topology* topology = reinterpret_cast<mem_topology*>(data.data());
+  topology->m_count = count;
+  for (int i = 0; i < count; ++i) {
+    topology->m_mem_data[i].m_type = MEM_DDR4;
+    topology->m_mem_data[i].m_used = 1;
+    topology->m_mem_data[i].m_size = 16 * 1024 * 1024;
+    topology->m_mem_data[i].m_base_address = i * 0x400000000ULL;
+    snprintf((char*) topology->m_mem_data[i].m_tag, sizeof(topology->m_mem_data[i].m_tag), "bank%d", i);
+  }
+  return data;
+}
+
+void
+addSection(XclBinData& writer, axlf_section_kind kind, const std::vector<char>& data)
+{
+  axlf_section_header header = {0};
+  header.m_sectionKind = kind;
+  writer.addSection(header, data.data(), data.size());
+}
+
+// Generated xclbin: primary bitstream, debug data and memory topology
+struct GeneratedXclbin {
+  std::string file;
+  std::vector<char> bitstream;
+  std::vector<char> debug;
+};
+
+GeneratedXclbin
+generate(const std::string& file, size_t bitstreamSize, unsigned int seed)
+{
+  GeneratedXclbin xclbin;
+  xclbin.file = file;
+  xclbin.bitstream = randomData(bitstreamSize, seed);
+  xclbin.debug = randomData(bitstreamSize / 16 + 3, seed + 1);
+
+  XclBinData writer;
+  writer.initWrite(file, 3);
+  addSection(writer, BITSTREAM, xclbin.bitstream);
+  addSection(writer, MEM_TOPOLOGY, memTopology(4));
+  addSection(writer, DEBUG_DATA, xclbin.debug);
+  writer.finishWrite();
+  return xclbin;
+}
+
+std::vector<char>
+readFile(const std::string& file)
+{
+  std::ifstream is(file, std::ifstream::binary);
+  return std::vector<char>(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+}
+
+bool
+exists(const std::string& file)
+{
+  return access(file.c_str(), F_OK) == 0;
+}
+
+} // namespace
+
+TEST_F(ExtractTest, SplitMatchesSections) {
+  auto xclbin = generate("a.xclbin", 1024 * 1024 + 5, 1);
+
+  XclBinData reader;
+  ASSERT_TRUE(reader.initRead("a.xclbin"));
+  ASSERT_TRUE(reader.extractAll("out"));
+
+  EXPECT_EQ(readFile("out-primary.bit"), xclbin.bitstream);
+  EXPECT_EQ(readFile("out-debug.bin"), xclbin.debug);
+  EXPECT_EQ(readFile("out-mem_topology.bin"), memTopology(4));
+  EXPECT_TRUE(exists("runtime_data.rtd"));
+}
+
+TEST_F(ExtractTest, SectionFilter) {
+  auto xclbin = generate("a.xclbin", 4096, 2);
+
+  XclBinData reader;
+  reader.setSectionFilter({"primary"});
+  ASSERT_TRUE(reader.initRead("a.xclbin"));
+  ASSERT_TRUE(reader.extractAll("out"));
+
+  EXPECT_EQ(readFile("out-primary.bit"), xclbin.bitstream);
+  EXPECT_FALSE(exists("out-debug.bin"));
+  EXPECT_FALSE(exists("out-mem_topology.bin"));
+  // Metadata was not requested, so it is not parsed
+  EXPECT_FALSE(exists("runtime_data.rtd"));
+}
+
+TEST_F(ExtractTest, UnknownSection) {
+  XclBinData reader;
+  EXPECT_THROW(reader.setSectionFilter({"primary", "bogus"}), std::runtime_error);
+}
+
+TEST_F(ExtractTest, TruncatedXclbin) {
+  generate("a.xclbin", 64 * 1024, 3);
+  ASSERT_EQ(truncate("a.xclbin", 32 * 1024), 0);
+
+  XclBinData reader;
+  ASSERT_TRUE(reader.initRead("a.xclbin"));
+  EXPECT_FALSE(reader.extractAll("out"));
+}
+
+// Benchmark over a corpus of generated xclbins, full split and a split
+// of the memory topology only
+TEST_F(ExtractTest, CorpusBenchmark) {
+  const int count = 8;
+  const size_t bitstreamSize = 16 * 1024 * 1024;
+
+  std::vector<GeneratedXclbin> corpus;
+  for (int i = 0; i < count; ++i)
+    corpus.push_back(generate("c" + std::to_string(i) + ".xclbin", bitstreamSize, 10 + i));
+
+  auto split = [&](const std::vector<std::string>& sections) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i) {
+      XclBinData reader;
+      reader.setSectionFilter(sections);
+      EXPECT_TRUE(reader.initRead(corpus[i].file.c_str()));
+      EXPECT_TRUE(reader.extractAll(("c" + std::to_string(i)).c_str()));
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+  };
+
+  auto all = split({});
+  auto topology = split({"mem_topology"});
+
+  for (int i = 0; i < count; ++i)
+    EXPECT_EQ(readFile("c" + std::to_string(i) + "-primary.bit"), corpus[i].bitstream);
+
+  std::cout << "xclbinsplit of " << count << " xclbins (" << bitstreamSize / (1024 * 1024)
+            << "MB bitstreams): all sections " << all << "ms, mem_topology only " << topology << "ms\n";
+}
+
+// Update an xclbin with new memory topology, the bitstream and debug
+// data are copied by range from the original
+TEST_F(ExtractTest, UpdateReusesSections) {
+  auto xclbin = generate("a.xclbin", 8 * 1024 * 1024 + 5, 4);
+
+  XclBinData base;
+  ASSERT_TRUE(base.initRead("a.xclbin"));
+  std::vector<axlf_section_header> headers;
+  ASSERT_TRUE(base.getSectionHeaders(headers));
+  ASSERT_EQ(headers.size(), 3u);
+
+  auto start = std::chrono::steady_clock::now();
+  XclBinData writer;
+  writer.initWrite("b.xclbin", 3);
+  for (auto& header : headers) {
+    if (header.m_sectionKind == MEM_TOPOLOGY)
+      continue;
+    axlf_section_header copy = header;
+    writer.addSectionFromXclbin(copy, base, header);
+  }
+  addSection(writer, MEM_TOPOLOGY, memTopology(2));
+  writer.finishWrite();
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+  // Unchanged content is found in the original
+  axlf_section_header found;
+  EXPECT_TRUE(base.findSection(BITSTREAM, xclbin.bitstream.data(), xclbin.bitstream.size(), found));
+  EXPECT_FALSE(base.findSection(MEM_TOPOLOGY, memTopology(2).data(), memTopology(2).size(), found));
+
+  XclBinData reader;
+  ASSERT_TRUE(reader.initRead("b.xclbin"));
+  ASSERT_TRUE(reader.extractAll("out"));
+  EXPECT_EQ(readFile("out-primary.bit"), xclbin.bitstream);
+  EXPECT_EQ(readFile("out-debug.bin"), xclbin.debug);
+  EXPECT_EQ(readFile("out-mem_topology.bin"), memTopology(2));
+
+  std::cout << "xclbin update of " << xclbin.bitstream.size() / (1024 * 1024) << "MB bitstream: " << ms << "ms\n";
+}
@@ -26,7 +26,9 @@
 #include <getopt.h>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <regex>
+#include <set>
 #include <vector>
  
 #include <boost/property_tree/json_parser.hpp>
@@ -66,6 +68,8 @@ namespace xclbincat1 {
     std::cout << "         -n/--binaryheader <file>         Add binary header file\n" ;
     std::cout << "         -r/--runtime_data <file>         Read 'rtd' formatted data segment(s)\n";
     std::cout << "         -o/--output                      Specify output filename (e.g. -o example.xclbin)\n" ;
+    std::cout << "         -u/--update       <file>         Update the given xclbin, sections of a kind not specified\n";
+    std::cout << "                                          are reused from it, as are specified sections that are unchanged\n";
     std::cout << "         -s/--segment_type <type> <file>  Specifies segment type and file. \n";
     std::cout << "                                          Valid segment types:  \n";
     std::cout << "                                             BITSTREAM, CLEAR_BITSTREAM, FIRMWARE, SCHEDULER,   \n";
@@ -247,12 +251,13 @@ namespace xclbincat1 {
       {"output",          required_argument,  0, 'o'},
       {"segment_type",    required_argument,  0, 's'},
       {"runtime_data",    required_argument,  0, 'r'},
+      {"update",          required_argument,  0, 'u'},
       {0,                 0,                  0, 0}
     };
 
     while ( 1 )
     {
-      optCode = getopt_long( argc, argv, "hvb:c:r:d:f:p:k:m:n:o:s:", longOptions, &optionIndex );
+      optCode = getopt_long( argc, argv, "hvb:c:r:d:f:p:k:m:n:o:s:u:", longOptions, &optionIndex );
       
       if ( optCode == -1 )
         break;
@@ -335,6 +340,11 @@ namespace xclbincat1 {
           bDisablePositionalArguments = true;
           break;
 
+        // Xclbin to update
+        case 'u':
+          m_update = optarg;
+          break;
+
         // Segment Type
         case 's':
           {
@@ -449,9 +459,26 @@ namespace xclbincat1 {
     return "UNKNOWN";
   }
 
+  // Sections identical to a section of the xclbin being updated are
+  // copied from it by range rather than rewritten
+  bool addSectionFromBase( XclBinData & _xclBinData,
+                           XclBinData * _pBase,
+                           axlf_section_header & _header,
+                           const char * _data )
+  {
+    axlf_section_header baseHeader;
+    if ( _pBase == nullptr || ! _pBase->findSection( _header.m_sectionKind, _data, _header.m_sectionSize, baseHeader ) )
+      return false;
+
+    std::cout << "INFO: Reusing section [" << getKindStr((axlf_section_kind) _header.m_sectionKind) << " (" << _header.m_sectionKind << ")] (" << (unsigned int)_header.m_sectionSize << " Bytes) unchanged\n";
+    _xclBinData.addSectionFromXclbin( _header, *_pBase, baseHeader );
+    return true;
+  }
+
   void addSectionsWithType( XclBinData & _xclBinData, 
                             const std::vector< std::string > & _files,
-                            axlf_section_kind _ekind )
+                            axlf_section_kind _ekind,
+                            XclBinData * _pBase = nullptr )
   {
     // Cycle through each file
     for ( const std::string & file : _files ) {
@@ -488,6 +515,9 @@ namespace xclbincat1 {
       fs.seekg( 0, fs.beg );
       fs.read( (char*) memBuffer.get(), header.m_sectionSize );
 
+      if ( addSectionFromBase( _xclBinData, _pBase, header, (const char*) memBuffer.get() ) )
+        continue;
+
       // -- Write contents out --
       std::cout << "INFO: Adding section [" << getKindStr(_ekind) << " (" << _ekind << ")] using: '" << (const char*)&header.m_sectionName << "' (" << (unsigned int)header.m_sectionSize << " Bytes)\n";
       _xclBinData.addSection( header, (const char*) memBuffer.get(), header.m_sectionSize );
@@ -496,7 +526,8 @@ namespace xclbincat1 {
 
   void addSectionBufferWithType( XclBinData & _xclBinData, 
                                  std::ostringstream &_buf,
-                                 axlf_section_kind _ekind )
+                                 axlf_section_kind _ekind,
+                                 XclBinData * _pBase = nullptr )
   {
     if ( _buf.tellp() == 0)
       return;
@@ -524,6 +555,9 @@ namespace xclbincat1 {
 
     memcpy( (char*) memBuffer.get(), _buf.str().c_str(), header.m_sectionSize);
 
+    if ( addSectionFromBase( _xclBinData, _pBase, header, (const char*) memBuffer.get() ) )
+      return;
+
     // -- Write contents out --
     if ( (_ekind == MCS) || (_ekind == BMC) ) {
       std::cout << "INFO: Adding section [" << getKindStr(_ekind) << " (" << _ekind << ")] (" << (unsigned int)header.m_sectionSize << " Bytes)\n";
@@ -656,6 +690,36 @@ namespace xclbincat1 {
     writeData.getHead().m_header.m_length = 0;
   }
 
+  std::unique_ptr<XclBinData> openXclbinToUpdate( const OptionParser & _parser,
+                                                  XclBinData & writeData )
+  {
+    // The sections reused are copied out of the xclbin being updated, it
+    // can't also be the output
+    struct stat input, output;
+    if ( stat( _parser.m_update.c_str(), &input ) == 0 && stat( _parser.m_output.c_str(), &output ) == 0
+         && input.st_dev == output.st_dev && input.st_ino == output.st_ino ) {
+      std::string errMsg = "ERROR: The xclbin to update '" + _parser.m_update + "' can't also be the output.";
+      throw std::runtime_error(errMsg);
+    }
+
+    std::unique_ptr<XclBinData> pBase( new XclBinData );
+    if ( ! pBase->initRead( _parser.m_update.c_str() ) ) {
+      std::string errMsg = "ERROR: Could not read the xclbin to update '" + _parser.m_update + "'.";
+      throw std::runtime_error(errMsg);
+    }
+
+    memcpy( &writeData.getHead(), &pBase->getHead(), sizeof(axlf) );
+    // We must reset the section count as this is updated when sections are added...
+    writeData.getHead().m_header.m_numSections = 0;
+    writeData.getHead().m_header.m_length = 0;
+
+    // This is a new xclbin
+    writeData.getHead().m_uniqueId = time( nullptr );
+    writeData.getHead().m_header.m_timeStamp = time( nullptr );
+    populateXclbinUUID( writeData );
+    return pBase;
+  }
+
   void populateDataFromKvp( const OptionParser & _parser,
                             XclBinData & _data )
   {
@@ -733,6 +797,11 @@ namespace xclbincat1 {
 
     populateDataWithDefaults(data);
 
+    // An update starts from the header of the xclbin being updated
+    std::unique_ptr<XclBinData> pBase;
+    if ( ! parser.m_update.empty() )
+      pBase = openXclbinToUpdate( parser, data );
+
     if ( parser.m_binaryHeader.empty() ) {
       populateDataFromKvp( parser, data );
     } else {
@@ -785,29 +854,66 @@ namespace xclbincat1 {
     sectionTotal += data.getJSONBufferSegmentCount();
     if (parser.m_mcs.size() > 0) ++sectionTotal;
 
+    // Sections of the updated xclbin are kept unless sections of the
+    // same kind are specified
+    std::vector< axlf_section_header > baseSections;
+    if ( pBase ) {
+      std::set< uint32_t > kinds;
+      auto addKind = [&kinds]( bool _present, axlf_section_kind _ekind ) { if ( _present ) kinds.insert( _ekind ); };
+      addKind( ! parser.m_bitstreams.empty(), BITSTREAM );
+      addKind( ! parser.m_clearstreams.empty(), CLEARING_BITSTREAM );
+      addKind( ! parser.m_metadata.empty(), EMBEDDED_METADATA );
+      addKind( ! parser.m_firmware.empty(), FIRMWARE );
+      addKind( ! parser.m_scheduler.empty(), SCHED_FIRMWARE );
+      addKind( ! parser.m_debugdata.empty(), DEBUG_DATA );
+      addKind( ! parser.m_memTopology.empty() || data.m_memTopologyBuf.tellp() > 0, MEM_TOPOLOGY );
+      addKind( ! parser.m_connectivity.empty() || data.m_connectivityBuf.tellp() > 0, CONNECTIVITY );
+      addKind( ! parser.m_ipLayout.empty() || data.m_ipLayoutBuf.tellp() > 0, IP_LAYOUT );
+      addKind( ! parser.m_debugIpLayout.empty() || data.m_debugIpLayoutBuf.tellp() > 0, DEBUG_IP_LAYOUT );
+      addKind( ! parser.m_clockFreqTopology.empty() || data.m_clockFreqTopologyBuf.tellp() > 0, CLOCK_FREQ_TOPOLOGY );
+      addKind( data.m_mcsBuf.tellp() > 0, MCS );
+      addKind( data.m_bmcBuf.tellp() > 0, BMC );
+
+      std::vector< axlf_section_header > headers;
+      if ( ! pBase->getSectionHeaders( headers ) )
+        throw std::runtime_error("ERROR: Could not read the sections of the xclbin to update '" + parser.m_update + "'.");
+      for ( const auto & header : headers )
+        if ( kinds.find( header.m_sectionKind ) == kinds.end() )
+          baseSections.push_back( header );
+      sectionTotal += baseSections.size();
+    }
+
     if ( parser.isVerbose() )
       std::cout << "INFO: Creating xclbin (with '" << sectionTotal << "' sections): '" << parser.m_output.c_str() << "'\n";
 
     data.initWrite( parser.m_output, sectionTotal );
-    addSectionsWithType( data, parser.m_bitstreams, BITSTREAM );
-    addSectionsWithType( data, parser.m_clearstreams, CLEARING_BITSTREAM );
-    addSectionsWithType( data, parser.m_metadata, EMBEDDED_METADATA );
-    addSectionsWithType( data, parser.m_firmware, FIRMWARE );
-    addSectionsWithType( data, parser.m_scheduler, SCHED_FIRMWARE );
-    addSectionsWithType( data, parser.m_memTopology, MEM_TOPOLOGY );
-    addSectionsWithType( data, parser.m_connectivity, CONNECTIVITY );
-    addSectionsWithType( data, parser.m_ipLayout, IP_LAYOUT );
-    addSectionsWithType( data, parser.m_debugIpLayout, DEBUG_IP_LAYOUT );
-    addSectionsWithType( data, parser.m_clockFreqTopology, CLOCK_FREQ_TOPOLOGY );
-    addSectionsWithType( data, parser.m_debugdata, DEBUG_DATA );
-
-    addSectionBufferWithType( data, data.m_memTopologyBuf, MEM_TOPOLOGY );
-    addSectionBufferWithType( data, data.m_connectivityBuf, CONNECTIVITY );
-    addSectionBufferWithType( data, data.m_ipLayoutBuf, IP_LAYOUT );
-    addSectionBufferWithType( data, data.m_debugIpLayoutBuf, DEBUG_IP_LAYOUT );
-    addSectionBufferWithType( data, data.m_clockFreqTopologyBuf, CLOCK_FREQ_TOPOLOGY );
-    addSectionBufferWithType( data, data.m_mcsBuf, MCS );
-    addSectionBufferWithType( data, data.m_bmcBuf, BMC );
+
+    for ( const auto & baseHeader : baseSections ) {
+      axlf_section_header header = baseHeader;
+      std::cout << "INFO: Keeping section [" << getKindStr((axlf_section_kind) header.m_sectionKind) << " (" << header.m_sectionKind << ")] (" << (unsigned int)header.m_sectionSize << " Bytes)\n";
+      data.addSectionFromXclbin( header, *pBase, baseHeader );
+    }
+
+    XclBinData * pBaseData = pBase.get();
+    addSectionsWithType( data, parser.m_bitstreams, BITSTREAM, pBaseData );
+    addSectionsWithType( data, parser.m_clearstreams, CLEARING_BITSTREAM, pBaseData );
+    addSectionsWithType( data, parser.m_metadata, EMBEDDED_METADATA, pBaseData );
+    addSectionsWithType( data, parser.m_firmware, FIRMWARE, pBaseData );
+    addSectionsWithType( data, parser.m_scheduler, SCHED_FIRMWARE, pBaseData );
+    addSectionsWithType( data, parser.m_memTopology, MEM_TOPOLOGY, pBaseData );
+    addSectionsWithType( data, parser.m_connectivity, CONNECTIVITY, pBaseData );
+    addSectionsWithType( data, parser.m_ipLayout, IP_LAYOUT, pBaseData );
+    addSectionsWithType( data, parser.m_debugIpLayout, DEBUG_IP_LAYOUT, pBaseData );
+    addSectionsWithType( data, parser.m_clockFreqTopology, CLOCK_FREQ_TOPOLOGY, pBaseData );
+    addSectionsWithType( data, parser.m_debugdata, DEBUG_DATA, pBaseData );
+
+    addSectionBufferWithType( data, data.m_memTopologyBuf, MEM_TOPOLOGY, pBaseData );
+    addSectionBufferWithType( data, data.m_connectivityBuf, CONNECTIVITY, pBaseData );
+    addSectionBufferWithType( data, data.m_ipLayoutBuf, IP_LAYOUT, pBaseData );
+    addSectionBufferWithType( data, data.m_debugIpLayoutBuf, DEBUG_IP_LAYOUT, pBaseData );
+    addSectionBufferWithType( data, data.m_clockFreqTopologyBuf, CLOCK_FREQ_TOPOLOGY, pBaseData );
+    addSectionBufferWithType( data, data.m_mcsBuf, MCS, pBaseData );
+    addSectionBufferWithType( data, data.m_bmcBuf, BMC, pBaseData );
 
     data.finishWrite();
 
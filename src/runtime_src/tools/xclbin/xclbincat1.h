@@ -85,6 +85,7 @@ class OptionParser {
     bool m_help;
     std::string m_binaryHeader;
     std::string m_output;
+    std::string m_update;
     void printHelp( char* program );
 
   private:
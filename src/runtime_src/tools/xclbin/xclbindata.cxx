@@ -27,7 +27,13 @@
 #include "xclbinutil.h"
 #include <iostream>
 #include <memory>
+#include <future>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/foreach.hpp>
 #include <boost/uuid/uuid.hpp>          // for uuid
@@ -95,6 +101,9 @@ XclBinData::XclBinData()
   : m_mode( FM_UNINITIALIZED )
   , m_numSections( 0 )
   , m_trace( false )
+  , m_xclbinFd( -1 )
+  , m_pXclbinMap( nullptr )
+  , m_xclbinMapSize( 0 )
   , m_xclBinHead( (axlf){0} )
   , m_schemaVersion( (XclBinData::SchemaVersion) {0} )
 {
@@ -108,6 +117,10 @@ XclBinData::XclBinData()
 XclBinData::~XclBinData() {
   if ( m_xclbinFile.is_open() )
     m_xclbinFile.close();
+  if ( m_pXclbinMap != nullptr )
+    munmap( const_cast<char*>(m_pXclbinMap), m_xclbinMapSize );
+  if ( m_xclbinFd != -1 )
+    close( m_xclbinFd );
   m_sections.clear();
   m_sectionCounts.clear();
 }
@@ -128,6 +141,14 @@ XclBinData::align()
   }
 }
 
+void
+XclBinData::pad( size_t size )
+{
+  std::vector<char> zero( size, 0 );
+  m_xclbinFile.write( zero.data(), size );
+  m_xclBinHead.m_header.m_length += size;
+}
+
 bool 
 XclBinData::initRead( const char* file )
 {
@@ -135,13 +156,30 @@ XclBinData::initRead( const char* file )
     std::cerr << "ERROR: The xclbin reader has already been initialized - calling '" << __FUNCTION__ << "' doesn't make sense.\n";
     return false;
   }
-  m_mode = FM_READ;
-  m_xclbinFile.open( file, std::ifstream::in | std::ifstream::binary );
-  if ( ! m_xclbinFile.is_open() ) {
+
+  // The xclbin is mapped rather than read, sections are extracted
+  // straight from the mapping
+  m_xclbinFd = open( file, O_RDONLY );
+  if ( m_xclbinFd == -1 ) {
     std::cerr << "ERROR: Could not open " << file << " for reading\n";
     return false;
   }
-  readHead( m_xclBinHead );
+  struct stat st;
+  if ( fstat( m_xclbinFd, &st ) == -1 || (size_t) st.st_size < sizeof(axlf) ) {
+    std::cerr << "ERROR: " << file << " is not a valid xclbin, too small to contain a header\n";
+    return false;
+  }
+  void* addr = mmap( nullptr, st.st_size, PROT_READ, MAP_PRIVATE, m_xclbinFd, 0 );
+  if ( addr == MAP_FAILED ) {
+    std::cerr << "ERROR: Could not map " << file << " for reading\n";
+    return false;
+  }
+  m_pXclbinMap = static_cast<const char*>(addr);
+  m_xclbinMapSize = st.st_size;
+  if ( ! readHead( m_xclBinHead ) )
+    return false;
+
+  m_mode = FM_READ;
   return true;
 }
 
@@ -160,6 +198,7 @@ XclBinData::initWrite( const std::string &_file, int _numSections )
 
   m_mode = FM_WRITE;
   m_numSections = _numSections;
+  m_xclbinFileName = _file;
   m_xclbinFile.open( _file.c_str(), std::ofstream::out | std::ofstream::binary | std::ofstream::trunc );
 
   if ( ! m_xclbinFile.is_open() ) {
@@ -224,6 +263,94 @@ XclBinData::addSection( axlf_section_header& sh, const char* data, size_t size )
   m_xclBinHead.m_header.m_numSections++;
 }
 
+void
+XclBinData::addSectionFromXclbin( axlf_section_header& sh, const XclBinData& source, const axlf_section_header& sourceHeader )
+{
+  if ( m_xclBinHead.m_header.m_numSections == m_numSections ) {
+    std::string errMsg = "ERROR: Trying to add more sections than were reserved in memory with the initWrite() call.\n";
+    throw std::runtime_error(errMsg);
+  }
+
+  align();
+
+  // Keep the section at the same offset within a page as in the
+  // source so the file system can share whole blocks between the two
+  static const uint64_t pageSize = 4096;
+  uint64_t current = m_xclbinFile.tellp();
+  uint64_t hole = ( sourceHeader.m_sectionOffset - current ) & ( pageSize - 1 );
+  if ( hole )
+    pad( hole );
+
+  sh.m_sectionSize = sourceHeader.m_sectionSize;
+  sh.m_sectionOffset = m_xclbinFile.tellp();
+  m_sections.push_back(sh);
+
+  copyFileRange( source.m_xclbinFd, sourceHeader.m_sectionOffset, source.m_pXclbinMap + sourceHeader.m_sectionOffset, sourceHeader.m_sectionSize );
+  m_xclBinHead.m_header.m_numSections++;
+}
+
+void
+XclBinData::copyFileRange( int fdIn, uint64_t offsetIn, const char* data, size_t size )
+{
+  // Copy the range between the files in the kernel, on file systems
+  // with reflink support the data is shared rather than copied.  Any
+  // part not copied is written from the source mapping.
+  size_t copied = 0;
+#ifdef SYS_copy_file_range
+  m_xclbinFile.flush();
+  uint64_t offsetOut = m_xclbinFile.tellp();
+  int fdOut = open( m_xclbinFileName.c_str(), O_WRONLY );
+  if ( fdOut != -1 ) {
+    loff_t in = offsetIn;
+    loff_t out = offsetOut;
+    while ( copied < size ) {
+      ssize_t count = syscall( SYS_copy_file_range, fdIn, &in, fdOut, &out, size - copied, 0 );
+      if ( count <= 0 )
+        break;
+      copied += count;
+    }
+    close( fdOut );
+  }
+  TRACE(XclBinUtil::format("Copied %ld of %ld bytes by range.", copied, size ));
+  m_xclbinFile.seekp( offsetOut + copied );
+#endif
+
+  writeSectionData( data + copied, size - copied );
+  m_xclBinHead.m_header.m_length += copied;
+}
+
+bool
+XclBinData::getSectionHeaders( std::vector< axlf_section_header > & headers )
+{
+  if ( m_mode != FM_READ ) {
+    std::cerr << "ERROR: The xclbin reader was never initialized - calling '" << __FUNCTION__ << "' doesn't make sense (call initRead first).\n";
+    return false;
+  }
+
+  headers.resize( m_xclBinHead.m_header.m_numSections );
+  for ( unsigned int i = 0; i < headers.size(); ++i )
+    if ( ! readHeader( headers[i], i ) )
+      return false;
+  return true;
+}
+
+bool
+XclBinData::findSection( uint32_t kind, const char* data, size_t size, axlf_section_header & header )
+{
+  std::vector< axlf_section_header > headers;
+  if ( ! getSectionHeaders( headers ) )
+    return false;
+
+  for ( const auto & candidate : headers ) {
+    if ( candidate.m_sectionKind == kind && candidate.m_sectionSize == size
+         && memcmp( m_pXclbinMap + candidate.m_sectionOffset, data, size ) == 0 ) {
+      header = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
 bool 
 XclBinData::writeSectionData( const char* data, size_t size )
 {
@@ -263,6 +390,26 @@ XclBinData::extractBinaryHeader( const char* file, const char* name )
   return true;
 }
 
+void
+XclBinData::setSectionFilter( const std::vector< std::string > & _sections )
+{
+  static const std::set< std::string > validTypes = {
+    "primary", "secondary", "xclbin", "mgmt", "sched", "debug", "mem_topology",
+    "connectivity", "ip_layout", "debug_ip_layout", "clock_freq_topology", "mcs", "bmc"
+  };
+
+  m_sectionFilter.clear();
+  for ( const auto & section : _sections ) {
+    if ( validTypes.find( section ) == validTypes.end() ) {
+      std::string errMsg = "ERROR: Unknown section '" + section + "', expected one of:";
+      for ( const auto & type : validTypes )
+        errMsg += " " + type;
+      throw std::runtime_error(errMsg);
+    }
+    m_sectionFilter.insert( section );
+  }
+}
+
 bool 
 XclBinData::extractAll( const char* name )
 {
@@ -274,11 +421,49 @@ XclBinData::extractAll( const char* name )
   // Prepare for extraction
   m_ptree_extract.clear();
 
+  // Name the output of each section up front, numbering depends on
+  // section order.  Sections not selected by the filter are skipped
+  // entirely, their metadata is never parsed.
+  std::vector< SectionExtract > sections;
   for( unsigned int i = 0; i < m_xclBinHead.m_header.m_numSections; ++i ) {
-    if( ! extractSectionData( i, name ) ) 
+    SectionExtract section;
+    if ( ! readHeader( section.header, i ) )
       return false;
+
+    std::string ext;
+    getSectionType( section.header.m_sectionKind, section.type, ext );
+
+    int count = ++m_sectionCounts[ section.header.m_sectionKind ];
+    if ( ! m_sectionFilter.empty() && m_sectionFilter.find( section.type ) == m_sectionFilter.end() )
+      continue;
+
+    std::string id = "";
+    if ( count > 1 )
+      id = std::string( "-" ) + std::to_string( count );
+
+    section.file = name + std::string( "-" ) + section.type + id + ext;
+    sections.push_back( section );
   }
 
+  // Sections are independent, extract them concurrently each into its
+  // own property tree.  Tracing is serialized to keep the log readable.
+  auto policy = m_trace ? std::launch::deferred : std::launch::async;
+  std::vector< boost::property_tree::ptree > ptrees( sections.size() );
+  std::vector< std::future<bool> > results;
+  for ( unsigned int i = 0; i < sections.size(); ++i )
+    results.push_back( std::async( policy, &XclBinData::extractSectionData, this, std::cref( sections[i] ), std::ref( ptrees[i] ) ) );
+
+  bool success = true;
+  for ( auto & result : results )
+    success = result.get() && success;
+  if ( ! success )
+    return false;
+
+  // Merge in section order
+  for ( auto & ptree : ptrees )
+    for ( auto & child : ptree )
+      m_ptree_extract.add_child( child.first, child.second );
+
   if ( m_ptree_extract.begin() != m_ptree_extract.end()) {
     addPTreeSchemaVersion(m_ptree_extract, m_schemaVersion);
 
@@ -292,103 +477,71 @@ XclBinData::extractAll( const char* name )
   return true;
 }
 
-
-
+bool
+XclBinData::getSectionType( uint32_t _kind, std::string & _type, std::string & _ext ) const
+{
+  switch ( _kind ) {
+    case BITSTREAM:           _type = "primary";             _ext = ".bit"; break;
+    case CLEARING_BITSTREAM:  _type = "secondary";           _ext = ".bit"; break;
+    case EMBEDDED_METADATA:   _type = "xclbin";              _ext = ".xml"; break;
+    case FIRMWARE:            _type = "mgmt";                _ext = ".bin"; break;
+    case SCHED_FIRMWARE:      _type = "sched";               _ext = ".bin"; break;
+    case DEBUG_DATA:          _type = "debug";               _ext = ".bin"; break;
+    case MEM_TOPOLOGY:        _type = "mem_topology";        _ext = ".bin"; break;
+    case CONNECTIVITY:        _type = "connectivity";        _ext = ".bin"; break;
+    case IP_LAYOUT:           _type = "ip_layout";           _ext = ".bin"; break;
+    case DEBUG_IP_LAYOUT:     _type = "debug_ip_layout";     _ext = ".bin"; break;
+    case CLOCK_FREQ_TOPOLOGY: _type = "clock_freq_topology"; _ext = ".bin"; break;
+    case MCS:                 _type = "mcs";                 _ext = "";     break;
+    case BMC:                 _type = "bmc";                 _ext = "";     break;
+    default:
+      _type = "";
+      _ext = "";
+      return false;
+  }
+  return true;
+}
 
 bool 
-XclBinData::extractSectionData( int sectionNum, const char* name ) 
+XclBinData::extractSectionData( const SectionExtract & _section, boost::property_tree::ptree & _ptree ) 
 {
-  long long sectionOffset = sizeof(axlf) + sectionNum * sizeof(axlf_section_header) - sizeof(axlf_section_header) /*See top of file*/;
-  m_xclbinFile.seekg( sectionOffset );
-  axlf_section_header header;
-  m_xclbinFile.read( (char*)&header, sizeof(axlf_section_header) );
-  long long dataOffset = header.m_sectionOffset;
-  m_xclbinFile.seekg( dataOffset );
-
+  const axlf_section_header & header = _section.header;
   unsigned sectionSize = header.m_sectionSize;
 
-  std::unique_ptr<char> data( new char[ sectionSize ] );
-  m_xclbinFile.read( data.get(), sectionSize );
+  // The section is used in place, the extract helpers only read from it
+  char* data = const_cast<char*>( m_pXclbinMap + header.m_sectionOffset );
 
-  std::string type;
-  std::string ext;
-  if ( m_sectionCounts.find( header.m_sectionKind ) == m_sectionCounts.end() )
-    m_sectionCounts[ header.m_sectionKind ] = 0;
-
-  m_sectionCounts[ header.m_sectionKind ] += 1;
-
-  if ( header.m_sectionKind == BITSTREAM ) {
-    type = "primary";
-    ext = ".bit";
-  }
-  else if ( header.m_sectionKind == CLEARING_BITSTREAM ) {
-    type = "secondary";
-    ext = ".bit";
-  }
-  else if ( header.m_sectionKind == EMBEDDED_METADATA ) {
-    type = "xclbin";
-    ext = ".xml";
-  }
-  else if ( header.m_sectionKind == FIRMWARE ) {
-    type = "mgmt";
-    ext = ".bin";
-  }
-  else if (header.m_sectionKind == SCHED_FIRMWARE) {
-    type = "sched";
-    ext = ".bin";
-  }
-  else if ( header.m_sectionKind == DEBUG_DATA ) {
-    type = "debug";
-    ext = ".bin";
-  }
-  else if ( header.m_sectionKind == MEM_TOPOLOGY ) {
-    type = "mem_topology";
-    ext = ".bin";
-    extractMemTopologyData((char*) data.get(), sectionSize, m_ptree_extract);
+  if ( header.m_sectionKind == MEM_TOPOLOGY ) {
+    extractMemTopologyData(data, sectionSize, _ptree);
   }
   else if ( header.m_sectionKind == CONNECTIVITY ) {
-    type = "connectivity";
-    ext = ".bin";
-    extractConnectivityData((char*) data.get(), sectionSize, m_ptree_extract);
+    extractConnectivityData(data, sectionSize, _ptree);
   }
   else if ( header.m_sectionKind == IP_LAYOUT ) {
-    type = "ip_layout";
-    ext = ".bin";
-    extractIPLayoutData((char*) data.get(), sectionSize, m_ptree_extract);
+    extractIPLayoutData(data, sectionSize, _ptree);
   }
   else if ( header.m_sectionKind == DEBUG_IP_LAYOUT ) {
-    type = "debug_ip_layout";
-    ext = ".bin";
-    extractDebugIPLayoutData((char*) data.get(), sectionSize, m_ptree_extract);
+    extractDebugIPLayoutData(data, sectionSize, _ptree);
   }
   else if ( header.m_sectionKind == CLOCK_FREQ_TOPOLOGY ) {
-    type = "clock_freq_topology";
-    ext = ".bin";
-    extractClockFreqTopology((char*) data.get(), sectionSize, m_ptree_extract);
+    extractClockFreqTopology(data, sectionSize, _ptree);
   }
   else if ( header.m_sectionKind == MCS ) {
-    extractAndWriteMCSImages((char*) data.get(), sectionSize);
+    extractAndWriteMCSImages(data, sectionSize);
     return true;
   }
   else if ( header.m_sectionKind == BMC ) {
-    extractAndWriteBMCImages((char*) data.get(), sectionSize);
+    extractAndWriteBMCImages(data, sectionSize);
     return true;
   }
 
-
-  std::string id = "";
-  if ( m_sectionCounts[ header.m_sectionKind ] > 1 )
-    id = std::string( "-" ) + std::to_string( m_sectionCounts[ header.m_sectionKind ] );
-
-  std::string file = name + std::string( "-" ) + type + id + ext;
-
   std::fstream fs;
-  fs.open( file, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc );
+  fs.open( _section.file, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc );
   if ( ! fs.is_open() ) {
-    std::cerr << "ERROR: Could not open " << file << " for writing" << "\n";
+    std::cerr << "ERROR: Could not open " << _section.file << " for writing" << "\n";
     return false;
   }
-  fs.write( data.get(), sectionSize );
+  fs.write( data, sectionSize );
 
   return true;
 }
@@ -419,8 +572,13 @@ XclBinData::report()
 bool 
 XclBinData::readHead( axlf & xclBinHead ) 
 {
-  m_xclbinFile.seekg( 0 );
-  m_xclbinFile.read( (char*)&xclBinHead, sizeof(axlf) );
+  memcpy( &xclBinHead, m_pXclbinMap, sizeof(axlf) );
+
+  size_t headersEnd = sizeof(axlf) + xclBinHead.m_header.m_numSections * sizeof(axlf_section_header) - sizeof(axlf_section_header) /*See top of file*/;
+  if ( xclBinHead.m_header.m_numSections != 0 && headersEnd > m_xclbinMapSize ) {
+    std::cerr << "ERROR: Section headers (" << xclBinHead.m_header.m_numSections << ") exceed the xclbin size (" << m_xclbinMapSize << ")\n";
+    return false;
+  }
   return true;
 }
 
@@ -428,8 +586,13 @@ bool
 XclBinData::readHeader( axlf_section_header & header, int sectionNum )
 {
   long long sectionOffset = sizeof(axlf) + sectionNum * sizeof(axlf_section_header) - sizeof(axlf_section_header) /*See top of file*/;
-  m_xclbinFile.seekg( sectionOffset );
-  m_xclbinFile.read( (char*)&header, sizeof(axlf_section_header) );
+  memcpy( &header, m_pXclbinMap + sectionOffset, sizeof(axlf_section_header) );
+
+  if ( header.m_sectionOffset > m_xclbinMapSize || header.m_sectionSize > m_xclbinMapSize - header.m_sectionOffset ) {
+    std::cerr << "ERROR: Section " << sectionNum << " (offset: " << header.m_sectionOffset << ", size: " << header.m_sectionSize
+              << ") exceeds the xclbin size (" << m_xclbinMapSize << ")\n";
+    return false;
+  }
   return true;
 }
 
@@ -500,7 +663,8 @@ bool
 XclBinData::reportSectionHeader( int sectionNum )
 {
   axlf_section_header header;
-  readHeader( header, sectionNum );
+  if ( ! readHeader( header, sectionNum ) )
+    return false;
   std::cout << "Section Name: " << header.m_sectionName << "\n";
   std::cout << "Section Size: " << header.m_sectionSize << "\n";
   std::cout << "Section Data Offset: " << header.m_sectionOffset << "\n";
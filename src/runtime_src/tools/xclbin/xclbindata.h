@@ -27,6 +27,7 @@
 #include "xclbin.h"
 
 #include <map>
+#include <set>
 #include <vector>
 #include <string.h>
 #include <fstream>
@@ -65,6 +66,7 @@ class XclBinData
     bool report();
     bool extractBinaryHeader( const char* file, const char* name );
     bool extractAll( const char* name );
+    void setSectionFilter( const std::vector< std::string > & _sections );
 
     void parseJSONFiles(const std::vector< std::string > & _files);
     unsigned int getJSONBufferSegmentCount();
@@ -74,7 +76,15 @@ class XclBinData
     void createBMCSegmentBuffer(const std::vector< std::string > & _mps);
  
   private:
-    bool extractSectionData( int sectionNum, const char* name );
+    // A section selected for extraction along with its output file name
+    struct SectionExtract {
+      axlf_section_header header;
+      std::string type;
+      std::string file;
+    };
+
+    bool getSectionType( uint32_t _kind, std::string & _type, std::string & _ext ) const;
+    bool extractSectionData( const SectionExtract & _section, boost::property_tree::ptree & _ptree );
     void TRACE(const std::string &_msg, bool _endl = true);
     void TRACE_PrintTree(const std::string &_msg, boost::property_tree::ptree &_pt);
     void addPTreeSchemaVersion( boost::property_tree::ptree &_pt, SchemaVersion const &_schemaVersion );
@@ -116,15 +126,27 @@ class XclBinData
   public:
     axlf& getHead() { return m_xclBinHead; }
     void addSection( axlf_section_header& sh, const char* data, size_t size );
+    void addSectionFromXclbin( axlf_section_header& sh, const XclBinData& source, const axlf_section_header& sourceHeader );
+
+    // Read mode, sections of the mapped xclbin
+    bool getSectionHeaders( std::vector< axlf_section_header > & headers );
+    bool findSection( uint32_t kind, const char* data, size_t size, axlf_section_header & header );
 
   private:
     void align(); // Will align m_xclbinFile to 8 byte boundary.
+    void pad( size_t size );
+    void copyFileRange( int fdIn, uint64_t offsetIn, const char* data, size_t size );
 
   private:
     FileMode m_mode;
     unsigned int m_numSections;
     bool m_trace;
     std::fstream m_xclbinFile;
+    std::string m_xclbinFileName;
+    int m_xclbinFd;               // Read mode, the file is mapped
+    const char* m_pXclbinMap;
+    size_t m_xclbinMapSize;
+    std::set< std::string > m_sectionFilter;
     axlf m_xclBinHead;
     std::vector< axlf_section_header > m_sections;
     std::map< /*axlf_section_kind*/ uint32_t, int > m_sectionCounts;
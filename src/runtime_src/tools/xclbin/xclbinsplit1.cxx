@@ -28,6 +28,7 @@
 #include "xclbinutil.h"
 #include <getopt.h>
 #include <iostream>
+#include <boost/algorithm/string.hpp>
 
 namespace xclbinsplit1 {
 
@@ -53,6 +54,7 @@ namespace xclbinsplit1 {
     std::cout << "         -n/--binaryheader     Specify binary header filename (e.g. -n header > header.bin)\n";
     std::cout << "         -o/--output           Specify output filename (e.g. -o test > test-primary.bit)\n";
     std::cout << "         -i/--input            Specify input filename (e.g. example.xclbin)\n";
+    std::cout << "         -s/--sections         Only extract the given comma separated sections (e.g. -s primary,mem_topology)\n";
     std::cout << "         -v/--verbose          Verbose messaging\n";
   }
 
@@ -69,12 +71,13 @@ namespace xclbinsplit1 {
       {"binaryheader",  required_argument,  0, 'n'},
       {"output",        required_argument,  0, 'o'},
       {"input",         required_argument,  0, 'i'},
+      {"sections",      required_argument,  0, 's'},
       {0,               0,                  0, 0}
     };
 
     while ( 1 )
     {
-      optCode = getopt_long( argc, argv, "hvn:o:i:", longOptions, &optionIndex );
+      optCode = getopt_long( argc, argv, "hvn:o:i:s:", longOptions, &optionIndex );
       
       if ( optCode == -1 )
         break;
@@ -97,6 +100,14 @@ namespace xclbinsplit1 {
         case 'o':
           m_output = optarg;
           break;
+        case 's': {
+          std::vector< std::string > sections;
+          boost::split( sections, optarg, boost::is_any_of( "," ), boost::token_compress_on );
+          for ( auto & section : sections )
+            if ( ! section.empty() )
+              m_sections.push_back( section );
+          break;
+        }
         case 'v':
           m_verbose = true;
           break;
@@ -142,7 +153,11 @@ namespace xclbinsplit1 {
     if ( verbose )
       data.enableTrace();
 
-    data.initRead(file);
+    data.setSectionFilter( parser.m_sections );
+    if ( ! data.initRead(file) ) {
+      std::cerr << "ERROR: Failed to read '" << file << "'\n";
+      return false;
+    }
     if ( verbose && ( ! data.report() ) ) {
       std::cerr << "ERROR: Failed to read '" << file << "'\n";
       return false;
@@ -40,6 +40,7 @@ class OptionParser {
     std::string m_output;
     std::string m_input;
     std::string m_binaryHeader;
+    std::vector<std::string> m_sections;
     bool m_verbose;
     bool m_help;
 };
@@ -121,16 +121,7 @@ namespace appdebug {
 void cb_scheduler_cmd_start (const xrt::command* aCommand, const xocl::execution_context* aContext)
 {
   //update the datastructure associated with the given event
-  try {
-    app_debug_track<cl_event>::event_data_t& edt = app_debug_track<cl_event>::getInstance()->get_data(static_cast<cl_event>(const_cast<xocl::event*>(aContext->get_event())));
-    edt.m_start = true;
-  }
-  catch (const xocl::error & ex) {
-    //INVALID_OBJECT is the only expected exception, anything else rethrow
-    if(ex.get_code() != DBG_EXCEPT_INVALID_OBJECT) {
-      throw;
-    }
-  }
+  app_debug_track<cl_event>::getInstance()->set_started(static_cast<cl_event>(const_cast<xocl::event*>(aContext->get_event())));
 }
 
 
@@ -139,16 +130,7 @@ void cb_scheduler_cmd_start (const xrt::command* aCommand, const xocl::execution
 void cb_scheduler_cmd_done (const xrt::command* aCommand, const xocl::execution_context* aContext)
 {
   //update the datastructure associated with the given event
-  try {
-    app_debug_track<cl_event>::event_data_t& edt = app_debug_track<cl_event>::getInstance()->get_data(static_cast<cl_event>(const_cast<xocl::event*>(aContext->get_event())));
-    ++edt.m_ncomplete;
-  }
-  catch (const xocl::error & ex) {
-    //INVALID_OBJECT is the only expected exception, anything else rethrow
-    if(ex.get_code() != DBG_EXCEPT_INVALID_OBJECT) {
-      throw;
-    }
-  }
+  app_debug_track<cl_event>::getInstance()->add_completed(static_cast<cl_event>(const_cast<xocl::event*>(aContext->get_event())));
 }
 
 bool app_debug_view_base::isInValid() const
@@ -558,8 +540,9 @@ cb_action_ndrange (xocl::event* event, cl_kernel kernel)
       nworkgroups = exctx->get_num_work_groups();
       issubmitted = true;
     }
-    uint32_t ncomplete = app_debug_track<cl_event>::getInstance()->try_get_data(event).m_ncomplete;
-    bool has_started = app_debug_track<cl_event>::getInstance()->try_get_data(event).m_start;
+    auto edt = app_debug_track<cl_event>::getInstance()->try_get_data(event);
+    uint32_t ncomplete = edt.m_ncomplete;
+    bool has_started = edt.m_start;
     if (evstatus == CL_COMPLETE) {
       //There could be completed lingering events in the system, so need to handle completed events
       nworkgroups = ncomplete;
@@ -991,8 +974,9 @@ clGetKernelInfo()
           auto exctx = event->get_execution_context();
           std::string kname = exctx->get_kernel()->get_name();
 
-          bool is_scheduled = app_debug_track<cl_event>::getInstance()->try_get_data(event).m_start;
-          uint32_t ncomplete = app_debug_track<cl_event>::getInstance()->try_get_data(event).m_ncomplete;
+          auto edt = app_debug_track<cl_event>::getInstance()->try_get_data(event);
+          bool is_scheduled = edt.m_start;
+          uint32_t ncomplete = edt.m_ncomplete;
           std::string evstatusstr = is_scheduled ? "Scheduled" : "Waiting";
           v->push_back(new kernel_debug_view (kname, evstatusstr, exctx->get_num_work_groups(), ncomplete, getArgValueString(event)));
         }
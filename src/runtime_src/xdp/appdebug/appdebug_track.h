@@ -27,14 +27,112 @@
 #include <utility>
 #include <string>
 #include <algorithm>
-#include <set>
-#include <map>
+#include <array>
+#include <functional>
+#include <unordered_map>
+#include <vector>
 #include <mutex>
+#include <cstdint>
 
 namespace appdebug {
 void cb_scheduler_cmd_start (const xrt::command*,const xocl::execution_context*);
 void cb_scheduler_cmd_done (const xrt::command*,const xocl::execution_context*);
 
+namespace detail {
+
+//Objects are spread over a fixed number of shards selected from the
+//object address, each shard has its own lock. Runtime threads creating
+//and releasing objects concurrently rarely contend on the same shard.
+//Debug queries from gdb try to lock every shard so that they observe a
+//consistent snapshot, and fail rather than suspend if a shard is busy.
+static const unsigned int track_shards = 64;
+
+inline unsigned int
+track_shard_index(const void* aObj)
+{
+  //objects are heap allocated, skip the low alignment bits
+  auto addr = reinterpret_cast<uintptr_t>(aObj);
+  return static_cast<unsigned int>((addr >> 4) ^ (addr >> 12)) % track_shards;
+}
+
+struct no_track_data {};
+
+template <typename T, typename V>
+class sharded_tracker {
+  struct alignas(64) shard {
+    std::mutex m_mutex;
+    std::unordered_map<T, V> m_objs;
+  };
+
+  shard& get_shard(T aObj) {
+    return m_shards[track_shard_index(aObj)];
+  }
+
+public:
+  //Locks held on all shards for the duration of a debug query
+  using snapshot_lock = std::vector<std::unique_lock<std::mutex>>;
+
+  void insert(T aObj, const V& aData) {
+    auto& s = get_shard(aObj);
+    std::lock_guard<std::mutex> lk (s.m_mutex);
+    s.m_objs.emplace(aObj, aData);
+  }
+  void erase(T aObj) {
+    auto& s = get_shard(aObj);
+    std::lock_guard<std::mutex> lk (s.m_mutex);
+    s.m_objs.erase(aObj);
+  }
+
+  //Suspends on the shard lock, returns false if the object is unknown
+  template <typename F>
+  bool update(T aObj, F&& fn) {
+    auto& s = get_shard(aObj);
+    std::lock_guard<std::mutex> lk (s.m_mutex);
+    auto it = s.m_objs.find(aObj);
+    if (it == s.m_objs.end())
+      return false;
+    fn(it->second);
+    return true;
+  }
+
+  //Never suspends, throws if the shard lock is busy or the object is unknown
+  V try_find(T aObj) {
+    auto& s = get_shard(aObj);
+    std::unique_lock<std::mutex> lk(s.m_mutex, std::defer_lock);
+    if (!lk.try_lock())
+      throw xocl::error(DBG_EXCEPT_LOCK_FAILED, "Failed to secure lock on data structure");
+    auto it = s.m_objs.find(aObj);
+    if (it == s.m_objs.end())
+      throw xocl::error(DBG_EXCEPT_INVALID_OBJECT, "Unknown OpenCL object");
+    return it->second;
+  }
+
+  //Never suspends, throws if any shard lock is busy
+  snapshot_lock try_lock_all() {
+    snapshot_lock locks;
+    locks.reserve(track_shards);
+    for (auto& s : m_shards) {
+      locks.emplace_back(s.m_mutex, std::defer_lock);
+      if (!locks.back().try_lock())
+        throw xocl::error(DBG_EXCEPT_LOCK_FAILED, "Failed to secure lock on data structure");
+    }
+    return locks;
+  }
+
+  //Caller must hold the snapshot_lock
+  template <typename F>
+  void for_each_locked(F&& fn) {
+    for (auto& s : m_shards)
+      for (auto& obj : s.m_objs)
+        fn(obj.first);
+  }
+
+private:
+  std::array<shard, track_shards> m_shards;
+};
+
+} // detail
+
 template <typename T>
 class app_debug_track {
 public:
@@ -47,16 +145,14 @@ public:
   }
 
   //Runtime calls these functions from constructor and destructor of opencl objects
-  //these can suspend to get access to the data structure
+  //these can suspend to get access to the shard holding the object
   void add_object (T aObj) {
     if (m_set) {
-      std::lock_guard<std::mutex> lk (m_mutex);
-      m_objs.insert(aObj);
+      m_objs.insert(aObj, detail::no_track_data());
     }
   }
   void remove_object (T aObj) {
     if (m_set) {
-      std::lock_guard<std::mutex> lk (m_mutex);
       m_objs.erase(aObj);
     }
   }
@@ -64,11 +160,7 @@ public:
   //Following 2 function called during debug by user, this should never suspend
   void validate_object (T aObj) {
     if (m_set) {
-      std::unique_lock<std::mutex> lk(m_mutex, std::defer_lock);
-      if (!lk.try_lock())
-        throw xocl::error(DBG_EXCEPT_LOCK_FAILED, "Failed to secure lock on data structure");
-      if (m_objs.find(aObj) == m_objs.end() )
-        throw xocl::error(DBG_EXCEPT_INVALID_OBJECT, "Unknown OpenCL object");
+      m_objs.try_find(aObj);
     }
     else {
       throw xocl::error(DBG_EXCEPT_INVALID_OBJECT, "Invalid object tracker");
@@ -77,10 +169,8 @@ public:
 
   void for_each(std::function<void(T aObj)>&& fn) {
     if (m_set) {
-      std::unique_lock<std::mutex> lk(m_mutex, std::defer_lock);
-      if (!lk.try_lock())
-        throw xocl::error(DBG_EXCEPT_LOCK_FAILED, "Failed to secure lock on data structure");
-      std::for_each(m_objs.begin(), m_objs.end(), fn);
+      auto lk = m_objs.try_lock_all();
+      m_objs.for_each_locked(fn);
     }
     else {
       throw xocl::error(DBG_EXCEPT_INVALID_OBJECT, "Invalid object tracker");
@@ -91,16 +181,15 @@ public:
   //disallow access to the data structure after the object is deleted
   static bool m_set;
 private:
-  std::set <T> m_objs;
-  std::mutex m_mutex;
+  detail::sharded_tracker<T, detail::no_track_data> m_objs;
 };
 
 template <>
 class app_debug_track <cl_event> {
 public:
   struct event_data_t {
-    bool m_start;
-    uint32_t m_ncomplete;
+    bool m_start = false;
+    uint32_t m_ncomplete = 0;
   };
   static app_debug_track* getInstance() {
     static app_debug_track singleton;
@@ -115,39 +204,33 @@ public:
     m_set = false;
   }
   //Runtime calls these functions from constructor and destructor of opencl objects
-  //these can suspend to get access to the data structure
+  //these can suspend to get access to the shard holding the object
   void add_object (cl_event aObj) {
     if (m_set) {
-      std::lock_guard<std::mutex> lk (m_mutex);
-      m_objs.insert(std::pair<cl_event, event_data_t>(aObj, event_data_t()));
+      m_objs.insert(aObj, event_data_t());
     }
   }
   void remove_object (cl_event aObj) {
     if (m_set) {
-      std::lock_guard<std::mutex> lk (m_mutex);
       m_objs.erase(aObj);
     }
   }
 
-  //Suspends on lock, returns a reference and throws exception in cases that cannot be handled
-  event_data_t& get_data (const cl_event aObj) {
-    if (!m_set)
-      throw xocl::error(DBG_EXCEPT_INVALID_OBJECT, "Appdebug singleton is deleted");
-
-    std::lock_guard<std::mutex> lk (m_mutex);
-    if (m_objs.find(aObj) == m_objs.end() )
-      throw xocl::error(DBG_EXCEPT_INVALID_OBJECT, "Unknown OpenCL object");
-    return m_objs[aObj];
+  //Called by the scheduler callbacks, these suspend on the shard lock.
+  //Unknown events are ignored
+  void set_started (const cl_event aObj) {
+    if (m_set)
+      m_objs.update(aObj, [](event_data_t& edt) { edt.m_start = true; });
+  }
+  void add_completed (const cl_event aObj) {
+    if (m_set)
+      m_objs.update(aObj, [](event_data_t& edt) { ++edt.m_ncomplete; });
   }
 
   //Following 2 function called during debug by user, this should never suspend
   void validate_object (cl_event aObj) {
     if (m_set) {
-      std::unique_lock<std::mutex> lk(m_mutex, std::defer_lock);
-      if (!lk.try_lock())
-        throw xocl::error(DBG_EXCEPT_LOCK_FAILED, "Failed to secure lock on data structure");
-      if (m_objs.find(aObj) == m_objs.end() )
-        throw xocl::error(DBG_EXCEPT_INVALID_OBJECT, "Unknown OpenCL object");
+      m_objs.try_find(aObj);
     }
     else {
       throw xocl::error(DBG_EXCEPT_INVALID_OBJECT, "Invalid object tracker");
@@ -156,29 +239,19 @@ public:
 
   void for_each(std::function<void(cl_event aObj)>&& fn) {
     if (m_set) {
-      std::unique_lock<std::mutex> lk(m_mutex, std::defer_lock);
-      if (!lk.try_lock())
-        throw xocl::error(DBG_EXCEPT_LOCK_FAILED, "Failed to secure lock on data structure");
-      //std::for_each(m_objs.begin(), m_objs.end(), fn);
-      for (auto it = m_objs.begin(); it!=m_objs.end(); ++it) {
-        fn(it->first);
-      }
+      auto lk = m_objs.try_lock_all();
+      m_objs.for_each_locked(fn);
     }
     else {
       throw xocl::error(DBG_EXCEPT_INVALID_OBJECT, "Invalid object tracker");
     }
   }
 
-  event_data_t& try_get_data (const cl_event aObj) {
+  //Returns a copy of the event data, never suspends
+  event_data_t try_get_data (const cl_event aObj) {
     if (!m_set)
       throw xocl::error(DBG_EXCEPT_INVALID_OBJECT, "Appdebug singleton is deleted");
-
-    std::unique_lock<std::mutex> lk(m_mutex, std::defer_lock);
-    if (!lk.try_lock())
-      throw xocl::error(DBG_EXCEPT_LOCK_FAILED, "Failed to secure lock on data structure");
-    if (m_objs.find(aObj) == m_objs.end() )
-      throw xocl::error(DBG_EXCEPT_INVALID_OBJECT, "Unknown OpenCL object");
-    return m_objs[aObj];
+    return m_objs.try_find(aObj);
   }
 
   //When the program exits, the static singleton object could get deleted
@@ -186,8 +259,7 @@ public:
   //disallow access to the data structure after the object is deleted
   static bool m_set;
 private:
-  std::map<cl_event, event_data_t> m_objs;
-  std::mutex m_mutex;
+  detail::sharded_tracker<cl_event, event_data_t> m_objs;
 };
 ////////////////////////Command queue////////////////////
 inline
@@ -53,6 +53,13 @@ bool isProfilingOn() {
   return xdp::profile::isApplicationProfilingOn();
 }
 
+// All state transitions of an event are either traced or skipped
+// depending on the Debug.profile_sampling setting
+bool isEventSampled(xocl::event* event) {
+  auto profiler = XCL::RTSingleton::Instance()->getProfileManager();
+  return !profiler->isSamplingOn() || profiler->sampleObject(event->get_uid());
+}
+
 // Create string to uniquely identify event
 std::string get_event_string(xocl::event* currEvent) {
 #if 0
@@ -133,7 +140,8 @@ cb_action_ndrange (xocl::event* event,cl_int status,const std::string& cu_name,
     // Create string to specify event and its dependencies
     std::string eventStr;
     std::string dependStr;
-    if (status == CL_RUNNING || status == CL_COMPLETE) {
+    bool sampled = isEventSampled(event);
+    if (sampled && (status == CL_RUNNING || status == CL_COMPLETE)) {
       eventStr = get_event_string(event);
       dependStr = get_event_dependencies_string(event);
       XOCL_DEBUGF("KERNEL status: %d, event: %s, depend: %s\n", status, eventStr.c_str(), dependStr.c_str());
@@ -166,7 +174,8 @@ cb_action_ndrange (xocl::event* event,cl_int status,const std::string& cu_name,
        ,cu_name
        ,eventStr
        ,dependStr
-       ,timestampMsec);
+       ,timestampMsec
+       ,sampled);
 }
 
 void
@@ -178,7 +187,8 @@ cb_action_read (xocl::event* event,cl_int status, cl_mem buffer, size_t size, ui
     // Create string to specify event and its dependencies
     std::string eventStr;
     std::string dependStr;
-    if (status == CL_RUNNING || status == CL_COMPLETE) {
+    bool sampled = isEventSampled(event);
+    if (sampled && (status == CL_RUNNING || status == CL_COMPLETE)) {
       eventStr = get_event_string(event);
       dependStr = get_event_dependencies_string(event);
       XOCL_DEBUGF("READ status: %d, event: %s, depend: %s\n", status, eventStr.c_str(), dependStr.c_str());
@@ -207,7 +217,8 @@ cb_action_read (xocl::event* event,cl_int status, cl_mem buffer, size_t size, ui
        ,threadId
        ,eventStr
        ,dependStr
-       ,timestampMsec);
+       ,timestampMsec
+       ,sampled);
 }
 
 void
@@ -227,7 +238,8 @@ cb_action_map(xocl::event* event,cl_int status, cl_mem buffer, size_t size, uint
     // Create string to specify event and its dependencies
     std::string eventStr;
     std::string dependStr;
-    if (status == CL_RUNNING || status == CL_COMPLETE) {
+    bool sampled = isEventSampled(event);
+    if (sampled && (status == CL_RUNNING || status == CL_COMPLETE)) {
       eventStr = get_event_string(event);
       dependStr = get_event_dependencies_string(event);
       XOCL_DEBUGF("MAP status: %d, event: %s, depend: %s\n", status, eventStr.c_str(), dependStr.c_str());
@@ -255,7 +267,8 @@ cb_action_map(xocl::event* event,cl_int status, cl_mem buffer, size_t size, uint
        ,threadId
        ,eventStr
        ,dependStr
-       ,timestampMsec);
+       ,timestampMsec
+       ,sampled);
 }
 
 void cb_action_write (xocl::event* event,cl_int status, cl_mem buffer, size_t size, uint64_t address, const std::string& bank)
@@ -273,7 +286,8 @@ void cb_action_write (xocl::event* event,cl_int status, cl_mem buffer, size_t si
     // Create string to specify event and its dependencies
     std::string eventStr;
     std::string dependStr;
-    if (status == CL_RUNNING || status == CL_COMPLETE) {
+    bool sampled = isEventSampled(event);
+    if (sampled && (status == CL_RUNNING || status == CL_COMPLETE)) {
       eventStr = get_event_string(event);
       dependStr = get_event_dependencies_string(event);
       XOCL_DEBUGF("WRITE event: %s, depend: %s\n", eventStr.c_str(), dependStr.c_str());
@@ -301,7 +315,8 @@ void cb_action_write (xocl::event* event,cl_int status, cl_mem buffer, size_t si
        ,threadId
        ,eventStr
        ,dependStr
-       ,timestampMsec);
+       ,timestampMsec
+       ,sampled);
 }
 void
 cb_action_unmap (xocl::event* event,cl_int status, cl_mem buffer, size_t size, uint64_t address, const std::string& bank)
@@ -319,7 +334,8 @@ cb_action_unmap (xocl::event* event,cl_int status, cl_mem buffer, size_t size, u
     // Create string to specify event and its dependencies
     std::string eventStr;
     std::string dependStr;
-    if (status == CL_RUNNING || status == CL_COMPLETE) {
+    bool sampled = isEventSampled(event);
+    if (sampled && (status == CL_RUNNING || status == CL_COMPLETE)) {
       eventStr = get_event_string(event);
       dependStr = get_event_dependencies_string(event);
       XOCL_DEBUGF("UNMAP status: %d, event: %s, depend: %s\n", status, eventStr.c_str(), dependStr.c_str());
@@ -347,7 +363,8 @@ cb_action_unmap (xocl::event* event,cl_int status, cl_mem buffer, size_t size, u
        ,threadId
        ,eventStr
        ,dependStr
-       ,timestampMsec);
+       ,timestampMsec
+       ,sampled);
 
 }
 
@@ -385,7 +402,8 @@ cb_action_ndrange_migrate (xocl::event* event,cl_int status, cl_mem mem0, size_t
     // Create string to specify event and its dependencies
     std::string eventStr;
     std::string dependStr;
-    if (status == CL_RUNNING || status == CL_COMPLETE) {
+    bool sampled = isEventSampled(event);
+    if (sampled && (status == CL_RUNNING || status == CL_COMPLETE)) {
       eventStr = get_event_string(event);
       dependStr = get_event_dependencies_string(event);
       XOCL_DEBUGF("NDRANGE MIGRATE status: %d, event: %s, depend: %s, address: 0x%X, size: %d\n", status, eventStr.c_str(), dependStr.c_str(), address, totalSize);
@@ -414,7 +432,8 @@ cb_action_ndrange_migrate (xocl::event* event,cl_int status, cl_mem mem0, size_t
        ,threadId
        ,eventStr
        ,dependStr
-       ,timestampMsec);
+       ,timestampMsec
+       ,sampled);
 }
 
 void cb_action_migrate (xocl::event* event,cl_int status, cl_mem mem0, size_t totalSize, uint64_t address,
@@ -448,7 +467,8 @@ void cb_action_migrate (xocl::event* event,cl_int status, cl_mem mem0, size_t to
     // Create string to specify event and its dependencies
     std::string eventStr;
     std::string dependStr;
-    if (status == CL_RUNNING || status == CL_COMPLETE) {
+    bool sampled = isEventSampled(event);
+    if (sampled && (status == CL_RUNNING || status == CL_COMPLETE)) {
       eventStr = get_event_string(event);
       dependStr = get_event_dependencies_string(event);
       XOCL_DEBUGF("MIGRATE status: %d, event: %s, depend: %s, address: 0x%X, size: %d\n", status, eventStr.c_str(), dependStr.c_str(), address, totalSize);
@@ -478,7 +498,8 @@ void cb_action_migrate (xocl::event* event,cl_int status, cl_mem mem0, size_t to
        ,threadId
        ,eventStr
        ,dependStr
-       ,timestampMsec);
+       ,timestampMsec
+       ,sampled);
 }
 
 void cb_log_function_start (const char* functionName, long long queueAddress)
@@ -497,6 +518,9 @@ void cb_log_dependencies (xocl::event* event,  cl_uint num_deps, const cl_event*
     return;
   }
 
+  if (!isEventSampled(event))
+    return;
+
   for (auto e :  xocl::get_range(deps, deps+num_deps)) {
     XCL::RTSingleton::Instance()->getProfileManager()->logDependency(XCL::RTProfile::DEPENDENCY_EVENT,
                   xocl::xocl(e)->get_suid(), event->get_suid());
@@ -142,20 +142,60 @@ namespace XCL {
       DeviceKernelWriteSummaryStats[name].log(size, duration, bitWidth, clockFreqMhz);
   }
 
-  void PerformanceCounter::logFunctionCallStart(const std::string& functionName, double timePoint)
+  uint32_t PerformanceCounter::getFunctionId(const char* functionName)
   {
-    CallCount[functionName].logStart(timePoint);
+    // Function names are static strings, so look up by address first
+    auto itr = FunctionIds.find(functionName);
+    if (itr != FunctionIds.end())
+      return itr->second;
+
+    auto id = FunctionNames.getId(functionName);
+    FunctionIds.emplace(functionName, id);
+    if (CallCount.size() <= id)
+      CallCount.resize(id + 1);
+    return id;
+  }
+
+  uint32_t PerformanceCounter::getKernelId(const std::string& kernelName)
+  {
+    auto id = KernelNames.getId(kernelName);
+    if (KernelExecutionStats.size() <= id)
+      KernelExecutionStats.resize(id + 1);
+    return id;
+  }
+
+  uint32_t PerformanceCounter::getComputeUnitId(const std::string& cuName)
+  {
+    auto id = ComputeUnitNames.getId(cuName);
+    if (ComputeUnitExecutionStats.size() <= id)
+      ComputeUnitExecutionStats.resize(id + 1);
+    return id;
+  }
+
+  void PerformanceCounter::logFunctionCallStart(uint32_t functionId, double timePoint)
+  {
+    CallCount[functionId].logStart(timePoint);
+  }
+
+  void PerformanceCounter::logFunctionCallEnd(uint32_t functionId, double timePoint)
+  {
+    CallCount[functionId].logEnd(timePoint);
   }
 
-  void PerformanceCounter::logFunctionCallEnd(const std::string& functionName, double timePoint)
+  void PerformanceCounter::logFunctionCallStats(const std::map<std::string, TimeStats>& callStats)
   {
-    CallCount[functionName].logEnd(timePoint);
+    for (const auto& pair : callStats) {
+      auto id = FunctionNames.getId(pair.first);
+      if (CallCount.size() <= id)
+        CallCount.resize(id + 1);
+      CallCount[id] = pair.second;
+    }
   }
 
-  void PerformanceCounter::logKernelExecutionStart(const std::string& kernelName, const std::string& deviceName,
+  void PerformanceCounter::logKernelExecutionStart(uint32_t kernelId, const std::string& deviceName,
                                                    double timePoint)
   {
-    KernelExecutionStats[kernelName].logStart(timePoint);
+    KernelExecutionStats[kernelId].logStart(timePoint);
 
     auto iter = DeviceStartTimes.find(deviceName);
     if (iter == DeviceStartTimes.end())
@@ -164,10 +204,10 @@ namespace XCL {
       DeviceStartTimes[deviceName] = timePoint;
   }
 
-  void PerformanceCounter::logKernelExecutionEnd(const std::string& kernelName, const std::string& deviceName,
+  void PerformanceCounter::logKernelExecutionEnd(uint32_t kernelId, const std::string& deviceName,
                                                  double timePoint)
   {
-    KernelExecutionStats[kernelName].logEnd(timePoint);
+    KernelExecutionStats[kernelId].logEnd(timePoint);
 
     auto iter = DeviceEndTimes.find(deviceName);
     if (iter == DeviceEndTimes.end())
@@ -185,14 +225,14 @@ namespace XCL {
       DeviceCUStartTimes[deviceName] = timePoint;
   }
 
-  void PerformanceCounter::logComputeUnitExecutionStart(const std::string& cuName, double timePoint)
+  void PerformanceCounter::logComputeUnitExecutionStart(uint32_t cuId, double timePoint)
   {
-    ComputeUnitExecutionStats[cuName].logStart(timePoint);
+    ComputeUnitExecutionStats[cuId].logStart(timePoint);
   }
 
-  void PerformanceCounter::logComputeUnitExecutionEnd(const std::string& cuName, double timePoint)
+  void PerformanceCounter::logComputeUnitExecutionEnd(uint32_t cuId, double timePoint)
   {
-    ComputeUnitExecutionStats[cuName].logEnd(timePoint);
+    ComputeUnitExecutionStats[cuId].logEnd(timePoint);
   }
 
   void PerformanceCounter::logComputeUnitStats(const std::string& cuName, const std::string& kernelName, double totalTimeStat,
@@ -200,8 +240,8 @@ namespace XCL {
   {
     std::string newCU;
     bool foundKernel = false;
-    for (const auto &pair : ComputeUnitExecutionStats) {
-      auto fullName = pair.first;
+    for (uint32_t id = 0; id < ComputeUnitNames.size(); ++id) {
+      auto fullName = ComputeUnitNames.getName(id);
       size_t first_index = fullName.find_first_of("|");
       size_t second_index = fullName.find('|', first_index+1);
       size_t third_index = fullName.find('|', second_index+1);
@@ -210,7 +250,7 @@ namespace XCL {
       std::string currCUName = fullName.substr(fourth_index + 1, fifth_index - fourth_index - 1);
       std::string currKernelName = fullName.substr(first_index + 1, second_index - first_index - 1);
       if (currCUName == cuName) {
-        ComputeUnitExecutionStats[fullName].logStats(totalTimeStat, maxTimeStat, minTimeStat, totalCalls, clockFreqMhz);
+        ComputeUnitExecutionStats[id].logStats(totalTimeStat, maxTimeStat, minTimeStat, totalCalls, clockFreqMhz);
         return;
       }
       else if (currKernelName == kernelName) {
@@ -220,7 +260,7 @@ namespace XCL {
     }
     // CR 1003380 - Runtime does not send all CU Names so we create a key
     if (foundKernel && totalTimeStat > 0.0) {
-      ComputeUnitExecutionStats[newCU].logStats(totalTimeStat, maxTimeStat, minTimeStat, totalCalls, clockFreqMhz);
+      ComputeUnitExecutionStats[getComputeUnitId(newCU)].logStats(totalTimeStat, maxTimeStat, minTimeStat, totalCalls, clockFreqMhz);
     }
   }
 
@@ -366,8 +406,7 @@ namespace XCL {
 #else
     // FYI, method used pre-2015.4
     double totalTime = 0.0;
-    for (const auto &pair : KernelExecutionStats) {
-      TimeStats stats = pair.second;
+    for (const auto &stats : KernelExecutionStats) {
       totalTime += stats.getTotalTime();
     }
 #endif
@@ -380,18 +419,12 @@ namespace XCL {
   uint32_t PerformanceCounter::getComputeUnitCalls(const std::string& deviceName,
       const std::string& cuName) const
   {
-    auto cuIter = ComputeUnitExecutionStats.begin();
-    auto cuEnd  = ComputeUnitExecutionStats.end();
-
-    while (cuIter != cuEnd) {
+    for (uint32_t id = 0; id < ComputeUnitNames.size(); ++id) {
       //"name" is of the form "deviceName|kernelName|globalSize|localSize|cuName|objId"
-      std::string name = cuIter->first;
+      std::string name = ComputeUnitNames.getName(id);
       name = name.substr(0, name.find_last_of("|"));
-      if (name.find(deviceName) != std::string::npos && name.find(cuName) != std::string::npos) {
-        TimeStats cuStats = cuIter->second;
-        return cuStats.getNoOfCalls();
-      }
-      cuIter++;
+      if (name.find(deviceName) != std::string::npos && name.find(cuName) != std::string::npos)
+        return ComputeUnitExecutionStats[id].getNoOfCalls();
     }
 
     // If CU is not found, return 0
@@ -401,12 +434,11 @@ namespace XCL {
   double PerformanceCounter::getComputeUnitTotalTime(const std::string& deviceName,
                                                      const std::string& cuName) const
   {
-    for (const auto &pair : ComputeUnitExecutionStats) {
-      auto fullName = pair.first;
+    for (uint32_t id = 0; id < ComputeUnitNames.size(); ++id) {
+      auto& fullName = ComputeUnitNames.getName(id);
       if (fullName.find(deviceName) != std::string::npos
           && fullName.find(cuName)  != std::string::npos) {
-        auto stat = pair.second;
-        return stat.getTotalTime();
+        return ComputeUnitExecutionStats[id].getTotalTime();
       }
     }
     return getTotalKernelExecutionTime(deviceName);
@@ -414,49 +446,46 @@ namespace XCL {
 
   void PerformanceCounter::writeKernelSummary(WriterI* writer) const
   {
-    for (const auto &pair : KernelExecutionStats) {
-      auto fullName = pair.first;
+    for (auto id : KernelNames.getSortedIds()) {
+      auto& fullName = KernelNames.getName(id);
       auto kernelName = fullName.substr(0, fullName.find_first_of("|"));
-      writer->writeSummary(kernelName, pair.second);
+      writer->writeSummary(kernelName, KernelExecutionStats[id]);
     }
   }
 
   void PerformanceCounter::writeComputeUnitSummary(WriterI* writer) const
   {
-    for (const auto &pair : ComputeUnitExecutionStats) {
-      auto fullName = pair.first;
+    for (auto id : ComputeUnitNames.getSortedIds()) {
+      auto& fullName = ComputeUnitNames.getName(id);
       auto cuName = fullName.substr(0, fullName.find_last_of("|"));
-      writer->writeComputeUnitSummary(cuName, pair.second);
+      writer->writeComputeUnitSummary(cuName, ComputeUnitExecutionStats[id]);
     }
   }
 
   void PerformanceCounter::writeAcceleratorSummary(WriterI* writer) const
   {
-    for (const auto &pair : ComputeUnitExecutionStats) {
-      auto fullName = pair.first;
+    for (auto id : ComputeUnitNames.getSortedIds()) {
+      auto& fullName = ComputeUnitNames.getName(id);
       auto cuName = fullName.substr(0, fullName.find_last_of("|"));
-      writer->writeAcceleratorSummary(cuName, pair.second);
+      writer->writeAcceleratorSummary(cuName, ComputeUnitExecutionStats[id]);
     }
   }
 
   void PerformanceCounter::writeAPISummary(WriterI* writer) const
   {
     using std::vector;
-    using std::pair;
-    using std::sort;
-    using std::string;
+    using std::stable_sort;
     // Print it in sorted order of Total Time. To sort it by duration
     // populate a vector and then using lambda function sort it by duration
 
-    vector<pair<string, TimeStats>> callPairs(CallCount.begin(),
-        CallCount.end());
-    sort(callPairs.begin(), callPairs.end(),
-        [](const pair<string, TimeStats>& A, const pair<string, TimeStats>& B) {
-      return A.second.getTotalTime() > B.second.getTotalTime();
+    vector<uint32_t> callIds = FunctionNames.getSortedIds();
+    stable_sort(callIds.begin(), callIds.end(),
+        [this](uint32_t A, uint32_t B) {
+      return CallCount[A].getTotalTime() > CallCount[B].getTotalTime();
     });
 
-    for (const auto &pair : callPairs) {
-      writer->writeSummary(pair.first, pair.second);
+    for (auto id : callIds) {
+      writer->writeSummary(FunctionNames.getName(id), CallCount[id]);
     }
   }
 
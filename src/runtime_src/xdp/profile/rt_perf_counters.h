@@ -18,12 +18,15 @@
 #define __XILINX_RT_PERF_COUNTERS_H
 
 #include "rt_profile_results.h"
+#include "rt_profile_stats.h"
 
 #include <limits>
 #include <cstdint>
 #include <map>
 #include <list>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 //#define BUFFER_STAT_PER_CONTEXT 1
 
@@ -69,6 +72,12 @@ namespace XCL {
 
     double getComputeUnitTotalTime(const std::string& deviceName, const std::string& cuName) const;
 
+  public:
+    // Dense ids used by the logging functions below
+    uint32_t getFunctionId(const char* functionName);
+    uint32_t getKernelId(const std::string& kernelName);
+    uint32_t getComputeUnitId(const std::string& cuName);
+
   public:
     void logBufferRead(size_t size, double duration, uint32_t contextId, uint32_t numDevices);
     void logBufferWrite(size_t size, double duration, uint32_t contextId, uint32_t numDevices);
@@ -77,13 +86,14 @@ namespace XCL {
     void logDeviceKernel(size_t size, double duration);
     void logDeviceKernelTransfer(std::string& deviceName, std::string& kernelName, size_t size, double duration,
                                  uint32_t bitWidth, double clockFreqMhz, bool isRead);
-    void logFunctionCallStart(const std::string& functionName, double timePoint);
-    void logFunctionCallEnd(const std::string& functionName, double timePoint);
-    void logKernelExecutionStart(const std::string& kernelName, const std::string& deviceName, double timePoint);
-    void logKernelExecutionEnd(const std::string& kernelName, const std::string& deviceName, double timePoint);
+    void logFunctionCallStart(uint32_t functionId, double timePoint);
+    void logFunctionCallEnd(uint32_t functionId, double timePoint);
+    void logFunctionCallStats(const std::map<std::string, TimeStats>& callStats);
+    void logKernelExecutionStart(uint32_t kernelId, const std::string& deviceName, double timePoint);
+    void logKernelExecutionEnd(uint32_t kernelId, const std::string& deviceName, double timePoint);
     void logComputeUnitDeviceStart(const std::string& deviceName, double timePoint);
-    void logComputeUnitExecutionStart(const std::string& cuName, double timePoint);
-    void logComputeUnitExecutionEnd(const std::string& cuName, double timePoint);
+    void logComputeUnitExecutionStart(uint32_t cuId, double timePoint);
+    void logComputeUnitExecutionEnd(uint32_t cuId, double timePoint);
     void logComputeUnitStats(const std::string& cuName, const std::string& kernelName, double totalTimeStat, 
                               double maxTimeStat, double minTimeStat, uint32_t totalCalls, uint32_t clockFreqMhz);
     void logDeviceEvent(std::string deviceName, std::string kernelName, size_t size,
@@ -137,9 +147,14 @@ namespace XCL {
     std::map<std::string, double> DeviceCUStartTimes;
     std::map<std::string, double> DeviceStartTimes;
     std::map<std::string, double> DeviceEndTimes;
-    std::map<std::string, TimeStats> CallCount;
-    std::map<std::string, TimeStats> KernelExecutionStats;
-    std::map<std::string, TimeStats> ComputeUnitExecutionStats;
+    // Stats indexed by the ids of the corresponding registry
+    NameRegistry FunctionNames;
+    NameRegistry KernelNames;
+    NameRegistry ComputeUnitNames;
+    std::unordered_map<const char*, uint32_t> FunctionIds;
+    std::vector<TimeStats> CallCount;
+    std::vector<TimeStats> KernelExecutionStats;
+    std::vector<TimeStats> ComputeUnitExecutionStats;
     std::map<std::string, BufferStats> DeviceKernelReadSummaryStats;
     std::map<std::string, BufferStats> DeviceKernelWriteSummaryStats;
     TimeTraceSortedTopUsage<KernelTrace> TopKernelTimes;
@@ -36,6 +36,7 @@
 #include <algorithm>
 #include <ctime>
 #include <cassert>
+#include <cstring>
 
 // Uncomment to use device-based timestamps in timeline trace
 //#define USE_DEVICE_TIMELINE
@@ -277,7 +278,8 @@ namespace XCL {
       e_profile_command_state objStage, size_t objSize, uint32_t contextId,
       uint32_t numDevices, std::string deviceName, uint32_t commandQueueId,
       uint64_t address, const std::string& bank, std::thread::id threadId,
-      const std::string eventString, const std::string dependString, double timestampMsec)
+      const std::string eventString, const std::string dependString, double timestampMsec,
+      bool sampled)
   {
     double timeStamp = (timestampMsec > 0.0) ? timestampMsec : getTraceTime();
     double deviceTimeStamp = getDeviceTimeStamp(timeStamp, deviceName);
@@ -311,12 +313,14 @@ namespace XCL {
       switch (objKind) {
       case READ_BUFFER: {
         PerfCounters.logBufferRead(objSize, (traceObject->End - traceObject->Start), contextId, numDevices);
-        PerfCounters.pushToSortedTopUsage(traceObject, true);
+        if (sampled)
+          PerfCounters.pushToSortedTopUsage(traceObject, true);
         break;
       }
       case WRITE_BUFFER: {
         PerfCounters.logBufferWrite(objSize, (traceObject->End - traceObject->Start), contextId, numDevices);
-        PerfCounters.pushToSortedTopUsage(traceObject, false);
+        if (sampled)
+          PerfCounters.pushToSortedTopUsage(traceObject, false);
         break;
       }
       default:
@@ -335,8 +339,16 @@ namespace XCL {
 
       // Store thread IDs into set
       addToThreadIds(threadId);
+
+      // Not kept in top usage list, so recycle right away
+      if (!sampled)
+        BufferTrace::recycle(traceObject);
     }
 
+    // Summary counters above are exact, only tracing is sampled
+    if (!sampled)
+      return;
+
     writeTimelineTrace(timeStamp, commandString, stageString, eventString, dependString,
                        objSize, address, bank, threadId);
 
@@ -356,7 +368,7 @@ namespace XCL {
       std::string kernelName, std::string xclbinName, uint32_t contextId, uint32_t commandQueueId,
       const std::string& deviceName, uid_t uid, const size_t* globalWorkSize, size_t workGroupSize,
       const size_t* localWorkDim, const std::string& cu_name, const std::string eventString,
-      const std::string dependString, double timeStampMsec)
+      const std::string dependString, double timeStampMsec, bool sampled)
   {
     double timeStamp = (timeStampMsec > 0.0) ? timeStampMsec : getTraceTime();
     //if (GetFirstCUTimestamp && !cu_name.empty()) {
@@ -405,18 +417,21 @@ namespace XCL {
       // Collect stats for max/min/average kernel times
       // NOTE: create unique kernel name using object ID
       std::string newKernelName = kernelName + "|" + std::to_string(objId) + "|"  + std::to_string(programId);
+      auto kernelId = PerfCounters.getKernelId(newKernelName);
+      if (KernelStarts.size() <= kernelId)
+        KernelStarts.resize(kernelId + 1);
+      auto& kernelStarts = KernelStarts[kernelId];
       if (objStage == START) {
         // Queue STARTS because events come in async order
-        KernelStartsMap[newKernelName].push(deviceTimeStamp);
+        kernelStarts.push(deviceTimeStamp);
         XOCL_DEBUGF("logKernelExecution: kernel START @ %.3f msec for %s\n", deviceTimeStamp, newKernelName.c_str());
       }
       else if (objStage == END) {
-        auto it = KernelStartsMap.find(newKernelName);
-        if (it != KernelStartsMap.end() && !it->second.empty()) {
+        if (!kernelStarts.empty()) {
           XOCL_DEBUGF("logKernelExecution: kernel END @ %.3f msec for %s\n", deviceTimeStamp, newKernelName.c_str());
-          PerfCounters.logKernelExecutionStart(newKernelName, newDeviceName, it->second.front());
-          PerfCounters.logKernelExecutionEnd(newKernelName, newDeviceName, deviceTimeStamp);
-          it->second.pop();
+          PerfCounters.logKernelExecutionStart(kernelId, newDeviceName, kernelStarts.front());
+          PerfCounters.logKernelExecutionEnd(kernelId, newDeviceName, deviceTimeStamp);
+          kernelStarts.pop();
         }
       }
 
@@ -447,12 +462,17 @@ namespace XCL {
         auto itr = KernelTraceMap.find(eventId);
         KernelTraceMap.erase(itr);
         // Only log Valid trace objects
-        if (traceObject->getStart() > 0.0 && traceObject->getStart() < deviceTimeStamp) {
+        if (!sampled) {
+          KernelTrace::recycle(traceObject);
+        }
+        else if (traceObject->getStart() > 0.0 && traceObject->getStart() < deviceTimeStamp) {
           PerfCounters.pushToSortedTopUsage(traceObject);
         }
       }
 
       // Write all states to timeline trace
+      if (!sampled)
+        return;
       std::string uniqueCUName("KERNEL|");
       uniqueCUName += newDeviceName + "|" + xclbinName + "|" + kernelName + "|" + localSize + "|all";
       commandString = uniqueCUName;
@@ -471,7 +491,7 @@ namespace XCL {
       if (objStage == START) {
         XOCL_DEBUGF("logKernelExecution: CU START @ %.3f msec for %s\n", deviceTimeStamp, cuName.c_str());
         if (XCL::RTSingleton::Instance()->getFlowMode() == XCL::RTSingleton::CPU) {
-          PerfCounters.logComputeUnitExecutionStart(cuName, deviceTimeStamp);
+          PerfCounters.logComputeUnitExecutionStart(PerfCounters.getComputeUnitId(cuName), deviceTimeStamp);
           PerfCounters.logComputeUnitDeviceStart(newDeviceName, timeStamp);
         }
       }
@@ -480,7 +500,7 @@ namespace XCL {
         // This is updated through HAL
         if (XCL::RTSingleton::Instance()->getFlowMode() != XCL::RTSingleton::CPU)
           deviceTimeStamp = 0;
-        PerfCounters.logComputeUnitExecutionEnd(cuName, deviceTimeStamp);
+        PerfCounters.logComputeUnitExecutionEnd(PerfCounters.getComputeUnitId(cuName), deviceTimeStamp);
       }
 
       // Store mapping of CU name to kernel name
@@ -494,6 +514,8 @@ namespace XCL {
       commandString = uniqueCUName + std::to_string(workGroupSize);
       ComputeUnitKernelTraceMap [cu_name] = commandString;
 
+      if (!sampled)
+        return;
       if (XCL::RTSingleton::Instance()->getFlowMode() == XCL::RTSingleton::CPU)
         writeTimelineTrace(timeStamp, uniqueCUName, stageString, eventString, dependString,
                             objId, workGroupSize);
@@ -594,16 +616,25 @@ else if (functionName.find("clEnqueueMigrateMemObjects") != std::string::npos)
     double timeStamp = getTraceTime();
 #endif
 
-    std::string name(functionName);
-    if (name.find("MigrateMem") != std::string::npos)
+    if (std::strstr(functionName, "MigrateMem"))
       MigrateMemCalls++;
 
+    // In sampling mode call statistics are kept per thread and
+    // only the sampled calls are traced
+    if (Sampler.isOn()) {
+      FunctionStartLogged = true;
+      if (!Sampler.logFunctionCallStart(functionName, timeStamp))
+        return;
+    }
+
+    std::string name(functionName);
     if (queueAddress == 0)
       name += "|General";
     else
       (name += "|") +=std::to_string(queueAddress);
     std::lock_guard<std::mutex> lock(LogMutex);
-    PerfCounters.logFunctionCallStart(functionName, timeStamp);
+    if (!Sampler.isOn())
+      PerfCounters.logFunctionCallStart(PerfCounters.getFunctionId(functionName), timeStamp);
     writeTimelineTrace(timeStamp, name.c_str(), "START");
     FunctionStartLogged = true;
 
@@ -628,6 +659,9 @@ else if (functionName.find("clEnqueueMigrateMemObjects") != std::string::npos)
     double timeStamp = getTraceTime();
 #endif
 
+    if (Sampler.isOn() && !Sampler.logFunctionCallEnd(functionName, timeStamp))
+      return;
+
     std::string name(functionName);
     if (queueAddress == 0)
       name += "|General";
@@ -635,7 +669,8 @@ else if (functionName.find("clEnqueueMigrateMemObjects") != std::string::npos)
       (name += "|") +=std::to_string(queueAddress);
 
     std::lock_guard<std::mutex> lock(LogMutex);
-    PerfCounters.logFunctionCallEnd(functionName, timeStamp);
+    if (!Sampler.isOn())
+      PerfCounters.logFunctionCallEnd(PerfCounters.getFunctionId(functionName), timeStamp);
     writeTimelineTrace(timeStamp, name.c_str(), "END");
 
     // Write host event to trace buffer
@@ -1436,6 +1471,10 @@ else if (functionName.find("clEnqueueMigrateMemObjects") != std::string::npos)
     if(!this->isApplicationProfileOn())
       return;
 
+    // Fold the exact per-thread API call statistics into the summary
+    if (Sampler.isOn())
+      PerfCounters.logFunctionCallStats(Sampler.getFunctionCallStats());
+
     for (auto w : Writers) {
       w->writeSummary(this);
     }
@@ -20,6 +20,7 @@
 #include "rt_perf_counters.h"
 #include "rt_profile_device.h"
 #include "rt_profile_results.h"
+#include "rt_profile_sampler.h"
 #include "rt_profile_xocl.h"
 #include "xrt/util/time.h"
 //#include <chrono>
@@ -34,6 +35,7 @@
 #include <string>
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <queue>
 
 namespace XCL {
@@ -127,6 +129,11 @@ namespace XCL {
     e_device_trace getTransferTrace() {return DeviceTraceOption;}
     e_stall_trace getStallTrace() {return StallTraceOption;}
 
+    void setSampling(const std::string samplingStr) { Sampler.setSampling(samplingStr); }
+    bool isSamplingOn() const { return Sampler.isOn(); }
+    std::string getSamplingDescription() const { return Sampler.getDescription(); }
+    bool sampleObject(uint64_t objId) const { return Sampler.sampleObject(objId); }
+
   public:
     // Following functions are thread safe
     // attach or detach observer writers
@@ -154,7 +161,7 @@ namespace XCL {
         uint32_t numDevices, std::string deviceName, uint32_t commandQueueId,
         uint64_t address, const std::string& bank, std::thread::id threadId,
         const std::string eventString = "", const std::string dependString = "",
-        double timestampMsec = 0.0);
+        double timestampMsec = 0.0, bool sampled = true);
     void logBufferWrite(size_t size, double duration, uint32_t contextId, uint32_t numDevices) {
         PerfCounters.logBufferWrite(size, duration, contextId, numDevices);
     }
@@ -166,7 +173,7 @@ namespace XCL {
         const size_t* globalWorkSize, size_t workGroupSize,
         const size_t* localWorkDim, const std::string& cu_name,
         const std::string eventString = "", const std::string dependString = "",
-        double timeStampMsec = 0.0);
+        double timeStampMsec = 0.0, bool sampled = true);
 
   void logDependency(e_profile_command_kind objKind,
       const std::string eventString, const std::string dependString);
@@ -282,7 +289,7 @@ namespace XCL {
   private:
     bool IsZynq = false;
     bool GetFirstCUTimestamp = true;
-    bool FunctionStartLogged;
+    std::atomic<bool> FunctionStartLogged;
     int& ProfileFlags;
     int FileFlags; //Which files we want to write out.
     int OclSlotIndex;
@@ -295,9 +302,10 @@ namespace XCL {
     std::string CurrentDeviceName;
     std::string CurrentBinaryName;
     PerformanceCounter PerfCounters;
+    ProfileSampler Sampler;
     std::set<std::thread::id> ThreadIdSet;
     std::map<int, std::string> SlotComputeUnitNameMap;
-    std::map<std::string, std::queue<double>> KernelStartsMap;
+    std::vector<std::queue<double>> KernelStarts;
     std::map<std::string, std::string> ComputeUnitKernelNameMap;
     std::map<std::string, std::string> ComputeUnitKernelTraceMap;
     std::map<std::string, xclCounterResults> FinalCounterResultsMap;
@@ -81,6 +81,7 @@ namespace XCL {
       MaxTime = time;
     if (MinTime > time)
       MinTime = time;
+    Histogram.record(time);
   }
 
   void TimeStats::logStats(double totalTimeStat, double maxTimeStat, 
@@ -98,6 +99,21 @@ namespace XCL {
     ClockFreqMhz = clockFreqMhz;
   }
 
+  void TimeStats::merge(const TimeStats& other)
+  {
+    if (other.NoOfCalls == 0)
+      return;
+
+    TotalTime += other.TotalTime;
+    NoOfCalls += other.NoOfCalls;
+    AveTime = TotalTime / NoOfCalls;
+    if (MaxTime < other.MaxTime)
+      MaxTime = other.MaxTime;
+    if (MinTime > other.MinTime)
+      MinTime = other.MinTime;
+    Histogram.merge(other.Histogram);
+  }
+
   //
   // Kernel Trace
   //
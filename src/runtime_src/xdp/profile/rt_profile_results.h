@@ -29,6 +29,7 @@
 #include <thread>
 #include <mutex>
 #include <CL/opencl.h>
+#include "rt_profile_stats.h"
 
 // Use these classes to store results from run time user
 // services functions such as debugging and profiling
@@ -125,12 +126,16 @@ namespace XCL {
     void logEnd(double timePoint);
     void logStats(double totalTimeStat, double maxTimeStat, 
                   double minTimeStat, uint32_t totalCalls, uint32_t clockFreqMhz);
+    void merge(const TimeStats& other);
     inline double getTotalTime() const { return TotalTime; }
     inline double getAveTime() const {return AveTime; }
     inline double getMaxTime() const {return MaxTime; }
     inline double getMinTime() const {return MinTime; }
     inline uint32_t getNoOfCalls() const {return NoOfCalls; }
     inline uint32_t getClockFreqMhz() const { return ClockFreqMhz; }
+    // Percentiles are only known for individually logged calls
+    inline bool hasPercentiles() const { return !Histogram.empty(); }
+    inline double getPercentileTime(double percentile) const { return Histogram.getPercentile(percentile); }
   private:
     double TotalTime;
     double StartTime;
@@ -140,6 +145,7 @@ namespace XCL {
     double MinTime;
     uint32_t NoOfCalls;
     uint32_t ClockFreqMhz;
+    LatencyHistogram Histogram;
   };
 
   // Class to store time trace of kernel execution, buffer read, or buffer write
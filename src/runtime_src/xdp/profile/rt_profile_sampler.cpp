@@ -0,0 +1,175 @@
+/**
+ * Copyright (C) 2016-2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "rt_profile_sampler.h"
+#include "xrt/util/message.h"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// Scramble object ids so that periodic allocation patterns in the
+// application do not alias with the sampling rate
+inline uint64_t
+mix(uint64_t x)
+{
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+}
+
+namespace XCL {
+
+  ProfileSampler::ProfileSampler()
+  : Mode(SAMPLING_OFF),
+    Rate(1),
+    WindowMsec(0.0),
+    PeriodMsec(0.0)
+  {
+  }
+
+  void ProfileSampler::setSampling(const std::string& option)
+  {
+    Mode = SAMPLING_OFF;
+    if (option.empty() || option == "off")
+      return;
+
+    try {
+      auto slash = option.find('/');
+      if (slash == std::string::npos) {
+        auto rate = std::stoul(option);
+        if (rate > 1) {
+          Rate = static_cast<uint32_t>(rate);
+          Mode = SAMPLING_COUNT;
+        }
+        return;
+      }
+
+      auto window = std::stod(option.substr(0, slash));
+      auto period = std::stod(option.substr(slash + 1));
+      if (window <= 0.0 || period <= 0.0 || window > period)
+        throw std::invalid_argument(option);
+      if (window < period) {
+        WindowMsec = window;
+        PeriodMsec = period;
+        Mode = SAMPLING_WINDOW;
+      }
+    }
+    catch (const std::exception&) {
+      xrt::message::send(xrt::message::severity_level::WARNING,
+          "Invalid profile_sampling setting '" + option + "', sampling is disabled.");
+      Mode = SAMPLING_OFF;
+    }
+  }
+
+  std::string ProfileSampler::getDescription() const
+  {
+    std::stringstream ss;
+    if (Mode == SAMPLING_COUNT)
+      ss << "1 in " << Rate;
+    else if (Mode == SAMPLING_WINDOW)
+      ss << WindowMsec << " ms every " << PeriodMsec << " ms";
+    return ss.str();
+  }
+
+  bool ProfileSampler::sampleObject(uint64_t objId) const
+  {
+    switch (Mode) {
+    case SAMPLING_COUNT:
+      return (mix(objId) % Rate) == 0;
+    case SAMPLING_WINDOW:
+      return (mix(objId) % 1000) < static_cast<uint64_t>(1000.0 * WindowMsec / PeriodMsec);
+    default:
+      return true;
+    }
+  }
+
+  bool ProfileSampler::sampleCall(ThreadStats* threadStats, double timePoint)
+  {
+    switch (Mode) {
+    case SAMPLING_COUNT:
+      return (threadStats->Calls++ % Rate) == 0;
+    case SAMPLING_WINDOW:
+      return std::fmod(timePoint, PeriodMsec) < WindowMsec;
+    default:
+      return true;
+    }
+  }
+
+  ProfileSampler::ThreadStats* ProfileSampler::getThreadStats()
+  {
+    // The thread keeps a reference to its stats, the sampler keeps
+    // another one so that stats of exited threads are still reported
+    struct ThreadStatsHandle {
+      const ProfileSampler* Owner = nullptr;
+      std::shared_ptr<ThreadStats> Stats;
+    };
+    static thread_local ThreadStatsHandle handle;
+
+    if (handle.Owner != this) {
+      handle.Stats = std::make_shared<ThreadStats>();
+      handle.Owner = this;
+      std::lock_guard<std::mutex> lock(ThreadStatsMutex);
+      AllThreadStats.push_back(handle.Stats);
+    }
+    return handle.Stats.get();
+  }
+
+  bool ProfileSampler::logFunctionCallStart(const char* functionName, double timePoint)
+  {
+    auto threadStats = getThreadStats();
+    std::lock_guard<std::mutex> lock(threadStats->Mutex);
+    auto& call = threadStats->CallMap[functionName];
+    call.Stats.logStart(timePoint);
+    call.Pending = true;
+    call.Sampled = sampleCall(threadStats, timePoint);
+    return call.Sampled;
+  }
+
+  bool ProfileSampler::logFunctionCallEnd(const char* functionName, double timePoint)
+  {
+    auto threadStats = getThreadStats();
+    std::lock_guard<std::mutex> lock(threadStats->Mutex);
+    auto itr = threadStats->CallMap.find(functionName);
+    if (itr == threadStats->CallMap.end() || !itr->second.Pending)
+      return false;
+
+    auto& call = itr->second;
+    call.Stats.logEnd(timePoint);
+    call.Pending = false;
+    return call.Sampled;
+  }
+
+  std::map<std::string, TimeStats> ProfileSampler::getFunctionCallStats() const
+  {
+    std::map<std::string, TimeStats> stats;
+    std::lock_guard<std::mutex> lock(ThreadStatsMutex);
+    for (auto& threadStats : AllThreadStats) {
+      std::lock_guard<std::mutex> tlock(threadStats->Mutex);
+      for (auto& call : threadStats->CallMap)
+        stats[call.first].merge(call.second.Stats);
+    }
+    return stats;
+  }
+
+};
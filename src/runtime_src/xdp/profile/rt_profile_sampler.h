@@ -0,0 +1,103 @@
+/**
+ * Copyright (C) 2016-2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __XILINX_RT_PROFILE_SAMPLER_H
+#define __XILINX_RT_PROFILE_SAMPLER_H
+
+#include "rt_profile_results.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace XCL {
+
+  // Sampling of API calls and event state transitions
+  //
+  // Controlled by Debug.profile_sampling in sdaccel.ini:
+  //   off           : trace every call and every event (default)
+  //   <N>           : trace 1 in N calls and 1 in N events
+  //   <on>/<period> : trace calls made during the first <on> msec of
+  //                   every <period> msec window, and the same fraction
+  //                   of events
+  //
+  // Only tracing (timeline, host trace events, top usage lists) is
+  // sampled.  The API call summary is kept exact using per-thread
+  // counters that are merged when the summary is written.
+  class ProfileSampler {
+  public:
+    enum e_sampling_mode {
+      SAMPLING_OFF = 0x0,
+      SAMPLING_COUNT = 0x1,
+      SAMPLING_WINDOW = 0x2
+    };
+
+  public:
+    ProfileSampler();
+    ~ProfileSampler() {};
+
+  public:
+    void setSampling(const std::string& option);
+    bool isOn() const { return Mode != SAMPLING_OFF; }
+    e_sampling_mode getMode() const { return Mode; }
+    std::string getDescription() const;
+
+    // Sample decision for an event object.  The decision depends only
+    // on the object id so that all state transitions of an event are
+    // either traced or skipped together.
+    bool sampleObject(uint64_t objId) const;
+
+    // Exact per-thread API call statistics.  Returns true if the call
+    // should also be traced.
+    bool logFunctionCallStart(const char* functionName, double timePoint);
+    bool logFunctionCallEnd(const char* functionName, double timePoint);
+
+    // Merged per-thread API call statistics keyed by function name
+    std::map<std::string, TimeStats> getFunctionCallStats() const;
+
+  private:
+    struct CallStats {
+      TimeStats Stats;
+      bool Pending = false;
+      bool Sampled = false;
+    };
+
+    // Only the owning thread writes, the lock is uncontended except
+    // when the summary is collected
+    struct ThreadStats {
+      std::mutex Mutex;
+      uint64_t Calls = 0;
+      std::unordered_map<const char*, CallStats> CallMap;
+    };
+
+    ThreadStats* getThreadStats();
+    bool sampleCall(ThreadStats* threadStats, double timePoint);
+
+  private:
+    e_sampling_mode Mode;
+    uint32_t Rate;
+    double WindowMsec;
+    double PeriodMsec;
+    mutable std::mutex ThreadStatsMutex;
+    std::vector<std::shared_ptr<ThreadStats>> AllThreadStats;
+  };
+
+};
+#endif
@@ -0,0 +1,127 @@
+/**
+ * Copyright (C) 2016-2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "rt_profile_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace XCL {
+
+  //
+  // LatencyHistogram
+  //
+
+  // Values below 2*SUB_BUCKETS map to their own bucket; larger values
+  // use SUB_BUCKETS buckets per power of two
+  unsigned int LatencyHistogram::getBucketIndex(uint64_t valueNsec)
+  {
+    if (valueNsec < 2 * SUB_BUCKETS)
+      return static_cast<unsigned int>(valueNsec);
+
+    unsigned int magnitude = 63 - __builtin_clzll(valueNsec);
+    unsigned int shift = magnitude - SUB_BUCKET_BITS;
+    return shift * SUB_BUCKETS + static_cast<unsigned int>(valueNsec >> shift);
+  }
+
+  // Midpoint of the bucket range
+  uint64_t LatencyHistogram::getBucketValue(unsigned int index)
+  {
+    if (index < 2 * SUB_BUCKETS)
+      return index;
+
+    unsigned int shift = index / SUB_BUCKETS - 1;
+    uint64_t lower = static_cast<uint64_t>(index - shift * SUB_BUCKETS) << shift;
+    return lower + ((1ULL << shift) >> 1);
+  }
+
+  void LatencyHistogram::record(double timeMsec)
+  {
+    if (Buckets.empty())
+      Buckets.resize(NUM_BUCKETS, 0);
+
+    uint64_t valueNsec = (timeMsec > 0.0) ? static_cast<uint64_t>(std::llround(timeMsec * 1.0e6)) : 0;
+    ++Buckets[getBucketIndex(valueNsec)];
+    ++Count;
+  }
+
+  void LatencyHistogram::merge(const LatencyHistogram& other)
+  {
+    if (other.Buckets.empty())
+      return;
+    if (Buckets.empty())
+      Buckets.resize(NUM_BUCKETS, 0);
+
+    for (unsigned int i = 0; i < NUM_BUCKETS; ++i)
+      Buckets[i] += other.Buckets[i];
+    Count += other.Count;
+  }
+
+  double LatencyHistogram::getPercentile(double percentile) const
+  {
+    if (Count == 0)
+      return 0.0;
+
+    // Rank of the requested sample, 1-based
+    uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * Count));
+    if (rank == 0)
+      rank = 1;
+
+    uint64_t seen = 0;
+    for (unsigned int i = 0; i < NUM_BUCKETS; ++i) {
+      seen += Buckets[i];
+      if (seen >= rank)
+        return getBucketValue(i) / 1.0e6;
+    }
+    return getBucketValue(NUM_BUCKETS - 1) / 1.0e6;
+  }
+
+  //
+  // NameRegistry
+  //
+
+  uint32_t NameRegistry::getId(const std::string& name)
+  {
+    auto itr = Ids.find(name);
+    if (itr != Ids.end())
+      return itr->second;
+
+    uint32_t id = static_cast<uint32_t>(Names.size());
+    Names.push_back(name);
+    Ids.emplace(name, id);
+    return id;
+  }
+
+  bool NameRegistry::findId(const std::string& name, uint32_t& id) const
+  {
+    auto itr = Ids.find(name);
+    if (itr == Ids.end())
+      return false;
+    id = itr->second;
+    return true;
+  }
+
+  std::vector<uint32_t> NameRegistry::getSortedIds() const
+  {
+    std::vector<uint32_t> ids(Names.size());
+    for (uint32_t id = 0; id < ids.size(); ++id)
+      ids[id] = id;
+    std::sort(ids.begin(), ids.end(),
+        [this](uint32_t A, uint32_t B) { return Names[A] < Names[B]; });
+    return ids;
+  }
+
+};
@@ -0,0 +1,78 @@
+/**
+ * Copyright (C) 2016-2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __XILINX_RT_PROFILE_STATS_H
+#define __XILINX_RT_PROFILE_STATS_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace XCL {
+
+  // Latency histogram with HDR style buckets
+  //
+  // Values are recorded in nsec.  Each power of two range is split in
+  // 16 linear sub-buckets, so any reported percentile is within ~6% of
+  // the recorded value while the histogram stays a flat array of
+  // counters.  Storage is allocated on the first recorded value.
+  class LatencyHistogram {
+  public:
+    LatencyHistogram() : Count(0) {}
+
+  public:
+    void record(double timeMsec);
+    void merge(const LatencyHistogram& other);
+    uint64_t getCount() const { return Count; }
+    bool empty() const { return Count == 0; }
+
+    // Value at percentile (0.0 - 100.0) in msec
+    double getPercentile(double percentile) const;
+
+  private:
+    static const unsigned int SUB_BUCKET_BITS = 4;
+    static const unsigned int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const unsigned int NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    static unsigned int getBucketIndex(uint64_t valueNsec);
+    static uint64_t getBucketValue(unsigned int index);
+
+  private:
+    uint64_t Count;
+    std::vector<uint64_t> Buckets;
+  };
+
+  // Dense integer ids for kernel, compute unit, and function names
+  //
+  // A name is hashed once when its id is looked up, after which all
+  // statistics are kept in flat arrays indexed by id.
+  class NameRegistry {
+  public:
+    uint32_t getId(const std::string& name);
+    bool findId(const std::string& name, uint32_t& id) const;
+    const std::string& getName(uint32_t id) const { return Names[id]; }
+    uint32_t size() const { return static_cast<uint32_t>(Names.size()); }
+    // Ids in name order, for reporting
+    std::vector<uint32_t> getSortedIds() const;
+
+  private:
+    std::unordered_map<std::string, uint32_t> Ids;
+    std::vector<std::string> Names;
+  };
+
+};
+#endif
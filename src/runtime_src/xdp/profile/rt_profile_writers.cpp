@@ -93,6 +93,33 @@ namespace XCL {
     return execName;
   }
 
+  // Tables built from traced events only cover the sampled events
+  std::string WriterI::getSampledCaption(RTProfile* profile, const std::string& caption)
+  {
+    if (!profile->isSamplingOn())
+      return caption;
+    return caption + " (sampled " + profile->getSamplingDescription() + ")";
+  }
+
+  // Percentiles are not available for stats read back from device counters
+  std::string WriterI::getPercentileCell(const TimeStats& stats, double percentile)
+  {
+    if (!stats.hasPercentiles())
+      return "N/A";
+    std::stringstream ss;
+    ss << stats.getPercentileTime(percentile);
+    return ss.str();
+  }
+
+  // Only the tables captioned as sampled are built from sampled events,
+  // all other counts and totals are collected for every call and event
+  void WriterI::writeSamplingNote(std::ofstream& ofs, RTProfile* profile)
+  {
+    ofs << "Trace sampling: " << profile->getSamplingDescription() << "\n";
+    ofs << "Sampled data: timeline trace and tables captioned (sampled ...), "
+        << "other tables are exact and not scaled\n";
+  }
+
   void WriterI::openStream(std::ofstream& ofs, const std::string& fileName)
   {
     ofs.open(fileName);
@@ -112,7 +139,8 @@ namespace XCL {
     //Table 1: API Call summary
     std::vector<std::string> APICallSummaryColumnLabels = { "API Name",
         "Number Of Calls", "Total Time (ms)", "Minimum Time (ms)",
-        "Average Time (ms)", "Maximum Time (ms)" };
+        "Average Time (ms)", "Maximum Time (ms)", "P50 Time (ms)",
+        "P99 Time (ms)", "P99.9 Time (ms)" };
 
     writeTableHeader(getSummaryStream(), "OpenCL API Calls", APICallSummaryColumnLabels);
     profile->writeAPISummary(this);
@@ -121,7 +149,8 @@ namespace XCL {
     // Table 2: Kernel Execution Summary
     std::vector<std::string> KernelExecutionSummaryColumnLabels = {
         "Kernel", "Number Of Enqueues", "Total Time (ms)",
-        "Minimum Time (ms)", "Average Time (ms)", "Maximum Time (ms)" };
+        "Minimum Time (ms)", "Average Time (ms)", "Maximum Time (ms)",
+        "P50 Time (ms)", "P99 Time (ms)", "P99.9 Time (ms)" };
 
     std::string table2Caption = (flowMode == XCL::RTSingleton::HW_EM) ?
         "Kernel Execution (includes estimated device times)" : "Kernel Execution";
@@ -133,7 +162,8 @@ namespace XCL {
     std::vector<std::string> ComputeUnitExecutionSummaryColumnLabels = {
         "Device", "Compute Unit", "Kernel", "Global Work Size", "Local Work Size",
         "Number Of Calls", "Total Time (ms)", "Minimum Time (ms)",
-        "Average Time (ms)", "Maximum Time (ms)", "Clock Frequency (MHz)" };
+        "Average Time (ms)", "Maximum Time (ms)", "Clock Frequency (MHz)",
+        "P50 Time (ms)", "P99 Time (ms)", "P99.9 Time (ms)" };
 
     std::string table3Caption = (flowMode == XCL::RTSingleton::HW_EM) ?
         "Compute Unit Utilization (includes estimated device times)" : "Compute Unit Utilization";
@@ -213,7 +243,9 @@ namespace XCL {
     writeTableRowStart(getSummaryStream());
     writeTableCells(getSummaryStream(), name, stats.getNoOfCalls(),
         stats.getTotalTime(), stats.getMinTime(),
-        stats.getAveTime(), stats.getMaxTime());
+        stats.getAveTime(), stats.getMaxTime(),
+        getPercentileCell(stats, 50.0), getPercentileCell(stats, 99.0),
+        getPercentileCell(stats, 99.9));
     writeTableRowEnd(getSummaryStream());
   }
 
@@ -434,7 +466,9 @@ namespace XCL {
         name.substr(second_index+1, third_index - second_index -1), // globalSize
         name.substr(third_index+1, fourth_index - third_index -1), // localSize
         stats.getNoOfCalls(), stats.getTotalTime(), stats.getMinTime(),
-        stats.getAveTime(), stats.getMaxTime(), stats.getClockFreqMhz());
+        stats.getAveTime(), stats.getMaxTime(), stats.getClockFreqMhz(),
+        getPercentileCell(stats, 50.0), getPercentileCell(stats, 99.0),
+        getPercentileCell(stats, 99.9));
     writeTableRowEnd(getSummaryStream());
   }
 
@@ -1085,7 +1119,7 @@ namespace XCL {
         "Kernel Instance Address", "Kernel", "Context ID", "Command Queue ID",
         "Device", "Start Time (ms)", "Duration (ms)",
         "Global Work Size", "Local Work Size"};
-    writeTableHeader(getSummaryStream(), "Top Kernel Execution",
+    writeTableHeader(getSummaryStream(), getSampledCaption(profile, "Top Kernel Execution"),
         TopKernelSummaryColumnLabels);
     profile->writeTopKernelSummary(this);
     writeTableFooter(getSummaryStream());
@@ -1094,7 +1128,7 @@ namespace XCL {
     std::vector<std::string> TopBufferWritesColumnLabels = {
         "Buffer Address", "Context ID", "Command Queue ID", "Start Time (ms)",
         "Duration (ms)", "Buffer Size (KB)", "Writing Rate(MB/s)"};
-    writeTableHeader(getSummaryStream(), "Top Buffer Writes",
+    writeTableHeader(getSummaryStream(), getSampledCaption(profile, "Top Buffer Writes"),
         TopBufferWritesColumnLabels);
     profile->writeTopDataTransferSummary(this, false); // Writes
     writeTableFooter(getSummaryStream());
@@ -1103,7 +1137,7 @@ namespace XCL {
     std::vector<std::string> TopBufferReadsColumnLabels = {
         "Buffer Address", "Context ID", "Command Queue ID", "Start Time (ms)",
         "Duration (ms)", "Buffer Size (KB)", "Reading Rate(MB/s)"};
-    writeTableHeader(getSummaryStream(), "Top Buffer Reads",
+    writeTableHeader(getSummaryStream(), getSampledCaption(profile, "Top Buffer Reads"),
         TopBufferReadsColumnLabels);
     profile->writeTopDataTransferSummary(this, true); // Reads
     writeTableFooter(getSummaryStream());
@@ -1147,6 +1181,8 @@ namespace XCL {
     std::string flowMode;
     XCL::RTSingleton::Instance()->getFlowModeName(flowMode);
     ofs << "Flow mode: " << flowMode << "\n";
+    if (profile->isSamplingOn())
+      writeSamplingNote(ofs, profile);
   }
 
   void CSVWriter::writeTableHeader(
@@ -1301,7 +1337,8 @@ namespace XCL {
     // Table 1: Software Functions
     std::vector<std::string> SoftwareFunctionColumnLabels = { 
         "Function", "Number Of Calls", "Total Time (ms)", "Minimum Time (ms)",
-        "Average Time (ms)", "Maximum Time (ms)" };
+        "Average Time (ms)", "Maximum Time (ms)", "P50 Time (ms)",
+        "P99 Time (ms)", "P99.9 Time (ms)" };
 
     writeTableHeader(getSummaryStream(), "Software Functions", SoftwareFunctionColumnLabels);
     profile->writeAPISummary(this);
@@ -1310,7 +1347,8 @@ namespace XCL {
     // Table 2: Hardware Functions
     std::vector<std::string> HardwareFunctionColumnLabels = {
         "Function", "Number Of Calls", "Total Time (ms)", "Minimum Time (ms)", 
-        "Average Time (ms)", "Maximum Time (ms)" };
+        "Average Time (ms)", "Maximum Time (ms)", "P50 Time (ms)",
+        "P99 Time (ms)", "P99.9 Time (ms)" };
 
     std::string table2Caption = (XCL::RTSingleton::Instance()->getFlowMode() == XCL::RTSingleton::HW_EM) ?
         "Hardware Functions (includes estimated device times)" : "Hardware Functions";
@@ -1332,7 +1370,7 @@ namespace XCL {
     // Table 4: Top Hardware Function Executions
     std::vector<std::string> TopHardwareColumnLabels = {
         "Location", "Function", "Start Time (ms)", "Duration (ms)"};
-    writeTableHeader(getSummaryStream(), "Top Hardware Function Executions",
+    writeTableHeader(getSummaryStream(), getSampledCaption(profile, "Top Hardware Function Executions"),
         TopHardwareColumnLabels);
     profile->writeTopHardwareSummary(this);
     writeTableFooter(getSummaryStream());
@@ -1380,7 +1418,7 @@ namespace XCL {
     std::vector<std::string> TopHostWriteColumnLabels = {
         "Address", "Start Time (ms)", "Duration (ms)", 
         "Size (KB)", "Transfer Rate (MB/s)"};
-    writeTableHeader(getSummaryStream(), "Top Memory Writes: Host and DDR Memory",
+    writeTableHeader(getSummaryStream(), getSampledCaption(profile, "Top Memory Writes: Host and DDR Memory"),
         TopHostWriteColumnLabels);
     profile->writeTopDataTransferSummary(this, false); // Writes
     writeTableFooter(getSummaryStream());
@@ -1389,7 +1427,7 @@ namespace XCL {
     std::vector<std::string> TopHostReadColumnLabels = {
         "Address", "Start Time (ms)", "Duration (ms)", 
         "Size (KB)", "Transfer Rate (MB/s)"};
-    writeTableHeader(getSummaryStream(), "Top Memory Reads: Host and DDR Memory",
+    writeTableHeader(getSummaryStream(), getSampledCaption(profile, "Top Memory Reads: Host and DDR Memory"),
         TopHostReadColumnLabels);
     profile->writeTopDataTransferSummary(this, true); // Reads
     writeTableFooter(getSummaryStream());
@@ -1433,6 +1471,8 @@ namespace XCL {
     std::string flowMode;
     XCL::RTSingleton::Instance()->getFlowModeName(flowMode);
     ofs << "Flow mode: " << flowMode << "\n";
+    if (profile->isSamplingOn())
+      writeSamplingNote(ofs, profile);
   }
 
   void UnifiedCSVWriter::writeTableHeader(
@@ -125,6 +125,9 @@ namespace XCL {
 	    static std::string getCurrentDateTime();
 	    static std::string getCurrentTimeMsec();
 	    static std::string getCurrentExecutableName();
+	    static std::string getSampledCaption(RTProfile* profile, const std::string& caption);
+	    static void writeSamplingNote(std::ofstream& ofs, RTProfile* profile);
+	    static std::string getPercentileCell(const TimeStats& stats, double percentile);
 
 	protected:
 	    // Veraidic args function to take n number of any type of args and
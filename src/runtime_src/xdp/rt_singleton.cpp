@@ -116,6 +116,7 @@ namespace XCL {
     std::string stall_trace = xrt::config::get_stall_trace();
     ProfileMgr->setTransferTrace(data_transfer_trace);
     ProfileMgr->setStallTrace(stall_trace);
+    ProfileMgr->setSampling(xrt::config::get_profile_sampling());
 
     turnOnProfile(RTProfile::PROFILE_DEVICE_COUNTERS);
     // HW trace is controlled at HAL layer
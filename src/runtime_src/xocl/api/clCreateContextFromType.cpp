@@ -106,16 +106,19 @@ clCreateContextFromType(const cl_context_properties* properties,
     //todo cl_device_type_default
     validdevice = validdevice || (device_type==CL_DEVICE_TYPE_ALL);
 
-    if(validdevice) {
+    if(validdevice)
       devices.push_back(device);
-      if (!device->lock())
-        throw xocl::error(CL_DEVICE_NOT_AVAILABLE,"device unavailable");
-    }
   }
 
   if (devices.empty())
     throw xocl::error(CL_DEVICE_NOT_FOUND,"No devices found");
 
+  // Ensure devices are available for current process
+  for (auto device : devices) {
+    if (!xocl(device)->lock())
+      throw xocl::error(CL_DEVICE_NOT_AVAILABLE,"device unavailable");
+  }
+
   // allocate the context, use unique_ptr until we are done throwing or returning
   auto notify = (pfn_notify 
     ? [pfn_notify,user_data](const char* s) { 
@@ -34,6 +34,7 @@
 #include "api.h"
 
 #include "xrt/util/memory.h"
+#include "xrt/util/config_reader.h"
 
 #include "printf/rt_printf.h"
 
@@ -483,6 +484,14 @@ clEnqueueNDRangeKernel(cl_command_queue command_queue,
   // Schedule execution
   ueEvent->queue();
 
+  // Migration is a no-op if the arguments are resident, in which case
+  // it can complete ahead of kernels it depends on, while this kernel
+  // is started on device after those kernels are done.  This must be
+  // after execution is queued so that no other event depends on the
+  // migration only.
+  if (xrt::config::get_kernel_wait_list())
+    umEvent->set_device_chain_predicate(xocl::enqueue::predicate_ndrange_migrate(mEvent,kernel));
+
   // Schdule the printf buffer retrieval to happen AFTER the kernel
   // execution completes (wait on ueEvent).  The execution event may
   // have already completed (it was queued above), but this function
@@ -22,6 +22,7 @@
 #include "xocl/core/context.h"
 #include "xocl/core/device.h"
 #include "xocl/core/event.h"
+#include "enqueue.h"
 #include "detail/command_queue.h"
 #include "detail/memory.h"
 #include "detail/event.h"
@@ -29,6 +30,32 @@
 
 namespace xocl {
 
+static void
+setIfZero(size_t& buffer_row_pitch,
+          size_t& buffer_slice_pitch,
+          size_t& host_row_pitch,
+          size_t& host_slice_pitch,
+          const size_t* region)
+{
+  // If buffer_row_pitch is 0, buffer_row_pitch is computed as region[0].
+  if (!buffer_row_pitch)
+    buffer_row_pitch = region[0];
+
+  // If buffer_slice_pitch is 0, buffer_slice_pitch is computed as
+  // region[1] * buffer_row_pitch.
+  if (!buffer_slice_pitch)
+    buffer_slice_pitch = region[1]*buffer_row_pitch;
+
+  // If host_row_pitch is 0, host_row_pitch is computed as region[0].
+  if (!host_row_pitch)
+    host_row_pitch = region[0];
+
+  // If host_slice_pitch is 0, host_slice_pitch is computed as
+  // region[1] * host_row_pitch.
+  if (!host_slice_pitch)
+    host_slice_pitch = region[1]*host_row_pitch;
+}
+
 static void
 validOrError(cl_command_queue     command_queue ,
              cl_mem               buffer ,
@@ -85,57 +112,22 @@ clEnqueueReadBufferRect(cl_command_queue     command_queue ,
                ,buffer_row_pitch,buffer_slice_pitch,host_row_pitch,host_slice_pitch
                ,ptr,num_events_in_wait_list ,event_wait_list,event);
 
-  size_t buffer_origin_in_bytes = 
-    buffer_origin[2]*buffer_slice_pitch+
-    buffer_origin[1]*buffer_row_pitch+
-    buffer_origin[0];
-  size_t host_origin_in_bytes = 
-    host_origin[2]*host_slice_pitch+
-    host_origin[1]*host_row_pitch+
-    host_origin[0];
-
-  //allocate and aggregate event
-  if(event) {
+  setIfZero(buffer_row_pitch,buffer_slice_pitch,host_row_pitch,host_slice_pitch,region);
 
-    // Soft event
-    auto cmd = CL_COMMAND_WRITE_BUFFER_RECT;
-    auto context = xocl(command_queue)->get_context();
-    auto uevent = xocl::create_soft_event(context,cmd,num_events_in_wait_list,event_wait_list);
+  // Rows contiguous in both buffer and host memory are transferred as one
+  xocl::rect_transfer rect(buffer_origin,host_origin,region
+                           ,buffer_row_pitch,buffer_slice_pitch
+                           ,host_row_pitch,host_slice_pitch);
 
-    // this is a user visible event, user retains a reference
-    xocl::assign(event,uevent.get());
-
-    // queue the event, block until successfully submitted
-    xocl::xocl(*event)->queue(true /*wait*/);
-  }
-
-  // Now the event is running, this should be hard_event and handle asynchronously
-  auto device = xocl::xocl(command_queue)->get_device();
-  auto xdevice = device->get_xrt_device();
-  auto boh = xocl::xocl(buffer)->get_buffer_object_or_error(device);
-  void* host_ptr = xdevice->map(boh);
-  
-  size_t yit,zit;
-  for(zit=0;zit<region[2];zit++){
-    for(yit=0;yit<region[1];yit++){
-      size_t buffer_row_origin_in_bytes =
-        buffer_origin_in_bytes+
-        zit*buffer_slice_pitch+
-        yit*buffer_row_pitch;
-      size_t host_row_origin_in_bytes =
-        host_origin_in_bytes+
-        zit*host_slice_pitch+
-        yit*host_row_pitch;
-      memcpy( &((uint8_t *)(ptr))[host_row_origin_in_bytes],
-              &((uint8_t *)(host_ptr))[buffer_row_origin_in_bytes],
-              region[0]);
-    }
-  }
-  xdevice->unmap(boh);
+  auto uevent = xocl::create_hard_event
+    (command_queue,CL_COMMAND_READ_BUFFER_RECT,num_events_in_wait_list,event_wait_list);
+  xocl::enqueue::set_event_action(uevent.get(),xocl::enqueue::action_read_buffer_rect,buffer,std::move(rect),ptr);
 
-  if (event)
-    xocl::xocl(*event)->set_status(CL_COMPLETE);
+  uevent->queue();
+  if (blocking)
+    uevent->wait();
 
+  xocl::assign(event,uevent.get());
   return CL_SUCCESS;
 }
 
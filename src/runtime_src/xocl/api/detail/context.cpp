@@ -51,6 +51,13 @@ validOrError(const cl_context_properties* properties)
       ;
     else if (key==CL_CONTEXT_INTEROP_USER_SYNC)
       ;
+    else if (key==CL_CONTEXT_MEM_PLACEMENT_XILINX) {
+      auto value = prop.get_value();
+      if (value!=CL_MEM_PLACEMENT_FIRST_XILINX
+          && value!=CL_MEM_PLACEMENT_BALANCE_XILINX
+          && value!=CL_MEM_PLACEMENT_STRIPE_XILINX)
+        throw error(CL_INVALID_PROPERTY,"bad memory placement '" + std::to_string(value) + "'");
+    }
     else
       throw error(CL_INVALID_PROPERTY,"bad context property '" + std::to_string(key) + "'");
   }
@@ -30,6 +30,8 @@
 #include "xocl/core/device.h"
 #include "xocl/core/kernel.h"
 
+#include <algorithm>
+
 namespace {
 
 // Exception pointer for device exceptions during enqueue tasks.  The
@@ -198,6 +200,34 @@ write_buffer(xocl::event* event,xocl::device* device
   }
 }
 
+static void
+read_buffer_rect(xocl::event* event,xocl::device* device
+                 ,cl_mem buffer,std::shared_ptr<const xocl::rect_transfer> rect,void* ptr)
+{
+  try {
+    event->set_status(CL_RUNNING);
+    device->read_buffer_rect(xocl::xocl(buffer),*rect,ptr);
+    event->set_status(CL_COMPLETE);
+  }
+  catch (const std::exception& ex) {
+    handle_device_exception(event,ex);
+  }
+}
+
+static void
+write_buffer_rect(xocl::event* event,xocl::device* device
+                  ,cl_mem buffer,std::shared_ptr<const xocl::rect_transfer> rect,const void* ptr)
+{
+  try {
+    event->set_status(CL_RUNNING);
+    device->write_buffer_rect(xocl::xocl(buffer),*rect,ptr);
+    event->set_status(CL_COMPLETE);
+  }
+  catch (const std::exception& ex) {
+    handle_device_exception(event,ex);
+  }
+}
+
 static void
 unmap_buffer(xocl::event* event,xocl::device* device
              ,cl_mem buffer, void* mapped_ptr)
@@ -362,6 +392,24 @@ action_ndrange_migrate(cl_event event,cl_kernel kernel)
   };
 }
 
+xocl::event::device_chain_predicate_type
+predicate_ndrange_migrate(cl_event event,cl_kernel kernel)
+{
+  auto device = xocl::xocl(event)->get_command_queue()->get_device();
+
+  std::vector<xocl::memory*> kernel_args;
+  for (auto& arg : xocl::xocl(kernel)->get_argument_range())
+    if (auto mem = arg->get_memory_object())
+      if (!arg->is_progvar() || arg->get_address_qualifier()!=CL_KERNEL_ARG_ADDRESS_GLOBAL)
+        kernel_args.push_back(mem);
+
+  return [device,kernel_args]() {
+    return std::all_of(kernel_args.begin(),kernel_args.end(),[device](xocl::memory* mem) {
+        return (mem->get_flags() & (CL_MEM_WRITE_ONLY|CL_MEM_HOST_NO_ACCESS)) || mem->is_resident(device);
+      });
+  };
+}
+
 xocl::event::action_enqueue_type
 action_read_buffer(cl_mem buffer,size_t offset, size_t size, const void* ptr)
 {
@@ -439,6 +487,34 @@ action_write_buffer(cl_mem buffer,size_t offset, size_t size, const void* ptr)
   };
 }
 
+xocl::event::action_enqueue_type
+action_read_buffer_rect(cl_mem buffer,xocl::rect_transfer rect,void* ptr)
+{
+  throw_if_error();
+  auto shared_rect = std::make_shared<const xocl::rect_transfer>(std::move(rect));
+  return [=](xocl::event* ev) {
+    XOCL_DEBUG(std::cout,"launching read buffer rect DMA event(",ev->get_uid(),")\n");
+    auto command_queue = ev->get_command_queue();
+    auto device = command_queue->get_device();
+    auto xdevice = device->get_xrt_device();
+    xdevice->schedule(read_buffer_rect,async_type::read,ev,device,buffer,shared_rect,ptr);
+  };
+}
+
+xocl::event::action_enqueue_type
+action_write_buffer_rect(cl_mem buffer,xocl::rect_transfer rect,const void* ptr)
+{
+  throw_if_error();
+  auto shared_rect = std::make_shared<const xocl::rect_transfer>(std::move(rect));
+  return [=](xocl::event* ev) {
+    XOCL_DEBUG(std::cout,"launching write buffer rect DMA event(",ev->get_uid(),")\n");
+    auto command_queue = ev->get_command_queue();
+    auto device = command_queue->get_device();
+    auto xdevice = device->get_xrt_device();
+    xdevice->schedule(write_buffer_rect,async_type::write,ev,device,buffer,shared_rect,ptr);
+  };
+}
+
 xocl::event::action_enqueue_type
 action_unmap_buffer(cl_mem memobj,void* mapped_ptr)
 {
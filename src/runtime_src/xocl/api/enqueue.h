@@ -27,6 +27,7 @@
 
 #include "xocl/core/object.h"
 #include "xocl/core/event.h"
+#include "xocl/core/rect.h"
 #include <utility>
 
 namespace xocl { namespace enqueue {
@@ -44,6 +45,15 @@ action_copy_p2p_buffer(cl_mem src_buffer,cl_mem dst_buffer,size_t src_offset,siz
 xocl::event::action_enqueue_type
 action_ndrange_migrate(cl_event event,cl_kernel kernel);
 
+/**
+ * Predicate for action_ndrange_migrate being a no-op
+ *
+ * The predicate is true if all kernel arguments are resident on the
+ * device or will not be migrated.
+ */
+xocl::event::device_chain_predicate_type
+predicate_ndrange_migrate(cl_event event,cl_kernel kernel);
+
 xocl::event::action_enqueue_type
 action_read_buffer(cl_mem buffer,size_t offset, size_t size, const void* ptr);
 
@@ -56,6 +66,12 @@ action_map_svm_buffer(cl_event event,cl_map_flags map_flags,void* svm_ptr,size_t
 xocl::event::action_enqueue_type
 action_write_buffer(cl_mem buffer,size_t offset, size_t size, const void* ptr);
 
+xocl::event::action_enqueue_type
+action_read_buffer_rect(cl_mem buffer,xocl::rect_transfer rect,void* ptr);
+
+xocl::event::action_enqueue_type
+action_write_buffer_rect(cl_mem buffer,xocl::rect_transfer rect,const void* ptr);
+
 xocl::event::action_enqueue_type
 action_unmap_buffer(cl_mem memobj,void* mapped_ptr);
 
@@ -25,6 +25,9 @@
 #include <stdexcept>
 #include <iomanip>
 #include <algorithm>
+#include <future>
+#include <mutex>
+#include <thread>
 
 #ifdef _WINDOWS
 #define snprintf _snprintf
@@ -670,13 +673,48 @@ void FormatString::dbgDump(std::ostream& str) const
 
 /////////////////////////////////////////////////////////////////////////
 
+CompiledFormat::CompiledFormat(const std::string& format)
+  : m_format(format), m_recordSize(BufferPrintf::getFormatByteCount())
+{
+  try {
+    FormatString formatString(format);
+    if ( !formatString.isValid() ) {
+      m_error = "Invalid format: " + format;
+      return;
+    }
+    formatString.getSplitFormatString(m_splitFormatString);
+    formatString.getSpecifiers(m_specVec);
+  }
+  catch ( const std::exception& ex ) {
+    m_error = ex.what();
+    return;
+  }
+
+  for ( auto& conversion : m_specVec ) {
+    m_conversionFormat.push_back(getConversionFormat(conversion));
+    m_argOffset.push_back(m_recordSize);
+    m_recordSize += BufferPrintf::getElementByteCount(conversion) * conversion.m_vectorSize;
+    // HACK: Special handling for vec3 packed strangely from compiler
+    //    float3 += 32 bits
+    //    others += 64 bits
+    if ( conversion.isVector() && conversion.m_vectorSize == 3) {
+      if ( conversion.isFloatClass() ) {
+        m_recordSize += 4;
+      }
+      else {
+        m_recordSize += 8;
+      }
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////
+
 BufferPrintf::BufferPrintf()
-  : m_currentOffset(0)
 {
 }
 
 BufferPrintf::BufferPrintf(const MemBuffer& buf, const StringTable& table)
-  : m_currentOffset(0)
 {
   setBuffer(buf);
   setStringTable(table);
@@ -684,13 +722,12 @@ BufferPrintf::BufferPrintf(const MemBuffer& buf, const StringTable& table)
 
 BufferPrintf::~BufferPrintf()
 {
-  m_currentOffset = 0;
   m_buf.clear();
   m_stringTable.clear();
+  m_formatTable.clear();
 }
         
 BufferPrintf::BufferPrintf(const uint8_t* buf, size_t bufLen, const StringTable& table)
-  : m_currentOffset(0)
 {
   setBuffer(buf, bufLen);
   setStringTable(table);
@@ -716,39 +753,52 @@ void BufferPrintf::setBuffer(const MemBuffer& buf)
 void BufferPrintf::setStringTable(const StringTable& table) 
 {
   m_stringTable = table;
+  m_formatTable.clear();
+  for ( auto& entry : m_stringTable ) {
+    m_formatTable[entry.first] = compileFormat(entry.second);
+  }
 }
 
 void BufferPrintf::print(std::ostream& os)
 {
-  moveToFirstRecord();
-  while ( hasNextRecord() ) {
-    std::string formatStr = getFormat();
-    FormatString format(formatStr);
-    if ( format.isValid() ) {
-      std::vector<XCL::Printf::ConversionSpec> conversionVec;
-      format.getSpecifiers(conversionVec);
-      std::vector<PrintfArg> argVec;
-      int argOffset = getFormatByteCount();
-      for ( auto conversion : conversionVec ) {
-        PrintfArg arg = buildArg(m_currentOffset + argOffset, conversion);
-        argVec.push_back(arg);
-        argOffset += getElementByteCount(conversion) * conversion.m_vectorSize;
-        // HACK: Special handling for vec3 packed strangely from compiler
-        //    float3 += 32 bits
-        //    others += 64 bits
-        if ( conversion.isVector() && conversion.m_vectorSize == 3) {
-          if ( conversion.isFloatClass() ) {
-            argOffset += 4;
-          }
-          else {
-            argOffset += 8;
-          }
-        }
+  size_t segmentSize = getWorkItemPrintfBufferSize();
+  size_t segments = (m_buf.size() + segmentSize - 1) / segmentSize;
+  size_t perTask = getSegmentsPerTask();
+
+  // Buffers of a few work items are decoded by the calling thread
+  size_t tasks = 1;
+  if ( segments > perTask ) {
+    tasks = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  std::vector<DecodedText> decoded(tasks);
+  size_t chunk = tasks * perTask;
+  for ( size_t first = 0; first < segments; first += chunk ) {
+    size_t last = std::min(segments, first + chunk);
+
+    // First task runs in the calling thread
+    std::vector<std::future<void>> workers;
+    size_t used = 0;
+    for ( size_t begin = first; begin < last; begin += perTask, ++used ) {
+      size_t end = std::min(last, begin + perTask);
+      if ( used == 0 ) {
+        continue;
+      }
+      workers.push_back(std::async(std::launch::async, &BufferPrintf::decodeSegments,
+                                   this, begin, end, std::ref(decoded[used])));
+    }
+    decodeSegments(first, std::min(last, first + perTask), decoded[0]);
+    for ( auto& worker : workers ) {
+      worker.get();
+    }
+
+    // Output in segment order up to the first error
+    for ( size_t idx = 0; idx < used; ++idx ) {
+      os << decoded[idx].m_text;
+      if ( decoded[idx].m_error ) {
+        std::rethrow_exception(decoded[idx].m_error);
       }
-      std::string result = string_printf(formatStr, argVec);
-      os << result;
     }
-    nextRecord();
   }
 }
 
@@ -817,123 +867,108 @@ int BufferPrintf::getElementByteCount(const ConversionSpec& conversion)
   return 8;
 }
 
-int BufferPrintf::nextRecordOffset(int currentOffset) const
+void BufferPrintf::decodeSegments(size_t first, size_t last, DecodedText& out) const
 {
-  // Given a currentOffset, return a pointer to the next valid record
-  // If we are already at the start of a valid record, just return
-  // the current offset. If we are not at the beginning, step across
-  // to the next record
-  int segmentSize = getWorkItemPrintfBufferSize();
-  int offset = currentOffset;
-  if ( offset < 0 ) {
-    return -1;
-  }
-  if ( offset >= (int)m_buf.size() ) {
-    return -1;
-  }
-  // format entry of 0xFFFFFFFFFFFFFFFF or 0x0 means this work item is finished
-  uint64_t val = extractField(offset, 8); 
-  bool endOfWorkItem = (val == 0xFFFFFFFFFFFFFFFF ) || (val == 0x0000000000000000);
-  if ( endOfWorkItem ) {
-    offset = ((offset+segmentSize-1) / segmentSize) * segmentSize;
-    if ( offset >= (int)m_buf.size() ) {
-      return -1;
-    }
-    val = extractField(offset, 8); 
-    endOfWorkItem = (val == 0xFFFFFFFFFFFFFFFF ) || (val == 0x0000000000000000);
-    while ( endOfWorkItem ) {
-      // Round up to next segment - in this loop we are guaranteed the 
-      // offset is aligned on a segmentSize segment start so just quickly
-      // step one to the next looking for a valid format field to print.
-      offset += segmentSize;
-      if ( offset >= (int)m_buf.size() ) {
-        return -1;
-      }
-      val = extractField(offset, 8); 
-      endOfWorkItem = (val == 0xFFFFFFFFFFFFFFFF ) || (val == 0x0000000000000000);
+  out.m_text.clear();
+  out.m_error = nullptr;
+  try {
+    for ( size_t segment = first; segment < last; ++segment ) {
+      decodeSegment(segment, out.m_text);
     }
   }
-  return offset;
-}
-
-bool BufferPrintf::hasNextRecord() const
-{
-  bool eof = (nextRecordOffset(m_currentOffset) == -1);
-  return ( !eof );
+  catch ( ... ) {
+    out.m_error = std::current_exception();
+  }
 }
 
-
-void BufferPrintf::moveToFirstRecord()
+void BufferPrintf::decodeSegment(size_t segment, std::string& out) const
 {
-  if ( hasNextRecord() ) {
-    m_currentOffset = nextRecordOffset(0);
+  size_t segmentSize = getWorkItemPrintfBufferSize();
+  size_t end = std::min(m_buf.size(), (segment + 1) * segmentSize);
+  size_t offset = segment * segmentSize;
+  while ( offset + getFormatByteCount() <= end ) {
+    // format entry of 0xFFFFFFFFFFFFFFFF or 0x0 means this work item is finished
+    uint64_t val = extractField(offset, getFormatByteCount());
+    if ( (val == 0xFFFFFFFFFFFFFFFF) || (val == 0x0000000000000000) ) {
+      break;
+    }
+    const CompiledFormat& format = lookup((uint32_t)val);
+    if ( !format.isValid() ) {
+      throwError("BufferPrintf - " + format.m_error);
+    }
+    if ( offset + format.m_recordSize > m_buf.size() ) {
+      throwError("BufferPrintf - record exceeds the printf buffer: " + format.m_format);
+    }
+    decodeRecord(offset, format, out);
+    offset += format.m_recordSize;
   }
 }
 
-void BufferPrintf::nextRecord()
+void BufferPrintf::decodeRecord(size_t offset, const CompiledFormat& format, std::string& out) const
 {
-  // Assume we are pointing at a valid record and want to move to the next one
-  if (! hasNextRecord() ) {
-    throwError("nextRecord - No next record");
-  }
-
-  std::string formatStr = getFormat();
-  FormatString format(formatStr);
-  if ( !format.isValid() ) {
-    std::string msg = "nextRecord - Invalid format: ";
-    msg += formatStr;
-    throwError(msg);
-  }
-  std::vector<ConversionSpec> conversionVec;
-  format.getSpecifiers(conversionVec);
-  // skip format ID
-  m_currentOffset += getFormatByteCount();  
-  // Skip all arguments
-  for (auto conversion : conversionVec) {
-    m_currentOffset += getElementByteCount(conversion) * conversion.m_vectorSize;
-    // HACK: Special handling for vec3 packed strangely from compiler
-    //    float3 += 32 bits
-    //    others += 64 bits
-    if ( conversion.isVector() && conversion.m_vectorSize == 3) {
-      if ( conversion.isFloatClass() ) {
-        m_currentOffset += 4;
+  // TODO: later make this dynamically size... for now 1024 should be sufficient
+  char printBuf[1024];
+  out += format.m_splitFormatString[0];
+  for ( size_t idx = 0; idx < format.m_specVec.size(); ++idx ) {
+    const ConversionSpec& conversion = format.m_specVec[idx];
+    const char *formatStr = format.m_conversionFormat[idx].c_str();
+    size_t bufIdx = offset + format.m_argOffset[idx];
+    int elementBytes = getElementByteCount(conversion);
+
+    if ( conversion.isIntClass() ) {
+      for ( int i = 0; i < conversion.m_vectorSize; ++i ) {
+        uint64_t val = extractField(bufIdx + i*elementBytes, elementBytes);
+        snprintf(printBuf, sizeof(printBuf), formatStr, val);
+        if ( i > 0 ) {
+          out += ",";
+        }
+        out += printBuf;
       }
-      else {
-        m_currentOffset += 8;
+    }
+    else if ( conversion.isFloatClass() && conversion.isVector() ) {
+      for ( int i = 0; i < conversion.m_vectorSize; ++i ) {
+        float val = 0;
+        std::memcpy(&val, &m_buf[bufIdx + i*elementBytes], sizeof(val));
+        snprintf(printBuf, sizeof(printBuf), formatStr, static_cast<double>(val));
+        if ( i > 0 ) {
+          out += ",";
+        }
+        out += printBuf;
       }
     }
+    else if ( conversion.isFloatClass() ) {
+      double val = 0;
+      std::memcpy(&val, &m_buf[bufIdx], sizeof(val));
+      snprintf(printBuf, sizeof(printBuf), formatStr, val);
+      out += printBuf;
+    }
+    else if ( conversion.isStringClass() ) {
+      // Temporary error - remove when %s works
+      std::cout << std::endl << "ERROR: Printf conversion specifier '%s' is not allowed" << std::endl;
+      snprintf(printBuf, sizeof(printBuf), formatStr, "");
+      out += printBuf;
+    }
+    else {
+      // TODO: probably best to throw an exception here...
+      snprintf(printBuf, sizeof(printBuf), formatStr, static_cast<int64_t>(0));
+      out += printBuf;
+    }
+    out += format.m_splitFormatString[idx+1];
   }
-  m_currentOffset = nextRecordOffset(m_currentOffset);
-}
-
-std::string BufferPrintf::getFormat() const
-{
-  uint32_t id = getFormatID();
-  std::string retval;
-  lookup(id, retval);
-  return retval;
 }
 
-uint32_t BufferPrintf::getFormatID() const
+const CompiledFormat& BufferPrintf::lookup(uint32_t id) const
 {
-  uint32_t id = (uint32_t)extractField(m_currentOffset, getFormatByteCount());
-  return id;
-}
-
-void BufferPrintf::lookup(int id, std::string& retval) const
-{
-  auto found = m_stringTable.find(id);
-  if ( found != m_stringTable.end() ) {
-    retval = found->second;
-  }
-  else {
+  auto found = m_formatTable.find(id);
+  if ( found == m_formatTable.end() ) {
     std::ostringstream oss;
     oss << "BufferPrintf lookup() - id " << id << " does not exist in the string table";
     throwError(oss.str());
   }
+  return *(found->second);
 }
 
-uint64_t BufferPrintf::extractField(int idx, int byteCount) const
+uint64_t BufferPrintf::extractField(size_t idx, int byteCount) const
 {
   uint64_t val = 0;
   for (int i = byteCount-1; i >= 0; --i) {
@@ -943,69 +978,11 @@ uint64_t BufferPrintf::extractField(int idx, int byteCount) const
   return val;
 }
 
-PrintfArg BufferPrintf::buildArg(int bufIdx, ConversionSpec& conversion) const
-{
-  int elementBytes = getElementByteCount(conversion);
-  if ( conversion.isIntClass() ) {
-    if ( conversion.isVector() ) {
-      std::vector<uint64_t> vec;
-      for ( int i = 0; i < conversion.m_vectorSize; ++i ) {
-        uint64_t val = extractField(bufIdx + i*elementBytes, elementBytes);
-        vec.push_back(val);
-      }
-      PrintfArg arg(vec);
-      return arg;
-    }
-    else {
-      uint64_t val = extractField(bufIdx, elementBytes);
-      PrintfArg arg(val);
-      return arg;
-    }
-  }
-  else if ( conversion.isFloatClass() ) {
-    if ( conversion.isVector() ) {
-      std::vector<float> vec;
-      for ( int i = 0; i < conversion.m_vectorSize; ++i ) {
-        float val = 0;
-        uint8_t *ptr = (uint8_t*)&val;
-        for ( int ii = elementBytes-1; ii >= 0; --ii ) {
-          ptr[ii] = m_buf[bufIdx+ii+(i*elementBytes)];
-        }
-        vec.push_back(val);
-      }
-      PrintfArg arg(vec);
-      return arg;
-    }
-    else {
-      double val = 0;
-      uint8_t *ptr = (uint8_t*)&val;
-      for ( int i = elementBytes; i >= 0; --i ) {
-        ptr[i] = m_buf[bufIdx+i];
-      }
-      PrintfArg arg(val);
-      return arg;
-    }
-  }
-  else if ( conversion.isStringClass() ) {
-    /*uint64_t idx = */ (void)extractField(bufIdx, elementBytes);
-    std::string str = "";
-    // Temporary error - remove when %s works
-    std::cout << std::endl << "ERROR: Printf conversion specifier '%s' is not allowed" << std::endl;
-//    lookup(idx, str);
-    PrintfArg arg(str);
-    return arg;
-  }
-  // TODO: probably best to throw an exception here...
-  PrintfArg arg(0);
-  return arg;
-}
-
 
 /////////////////////////////////////////////////////////////////////////
 
-std::string convertArg(PrintfArg& arg, ConversionSpec& conversion)
+std::string getConversionFormat(const ConversionSpec& conversion)
 {
-  std::string retval = "";
   char formatStr[32];
   strcpy(formatStr, "%");
   if (conversion.m_leftJustify)
@@ -1053,6 +1030,26 @@ std::string convertArg(PrintfArg& arg, ConversionSpec& conversion)
   
   strcat(formatStr, " ");
   formatStr[strlen(formatStr)-1] = conversion.m_specifier;
+  return formatStr;
+}
+
+std::shared_ptr<const CompiledFormat> compileFormat(const std::string& format)
+{
+  static std::mutex mutex;
+  static std::map<std::string, std::shared_ptr<const CompiledFormat>> cache;
+  std::lock_guard<std::mutex> lk(mutex);
+  auto& compiled = cache[format];
+  if ( !compiled ) {
+    compiled = std::make_shared<const CompiledFormat>(format);
+  }
+  return compiled;
+}
+
+std::string convertArg(PrintfArg& arg, ConversionSpec& conversion)
+{
+  std::string retval = "";
+  std::string conversionFormat = getConversionFormat(conversion);
+  const char *formatStr = conversionFormat.c_str();
   // TODO: later make this dynamically size... for now 1024 should be sufficient
   int bufLen = 1024;
   char *printBuf = new char[bufLen];
@@ -21,7 +21,9 @@
 
 #include <iostream>
 #include <vector>
+#include <exception>
 #include <map>
+#include <memory>
 #include <string>
 #include <stdint.h>
 
@@ -160,6 +162,31 @@ private:
 
 };
 
+/////////////////////////////////////////////////////////////////////////
+// CompiledFormat -
+//
+// A format string prepared for decoding printf buffer records. The
+// format string is parsed once, and the snprintf format of each
+// conversion and the offset of each argument in a record are computed
+// up front. An invalid format string is not an error until a record
+// using it is decoded.
+//
+// Compiled formats are shared by all buffers through compileFormat()
+struct CompiledFormat
+{
+  explicit CompiledFormat(const std::string& format);
+
+  bool isValid() const { return m_error.empty(); }
+
+  std::string m_format;
+  std::string m_error;
+  std::vector<std::string> m_splitFormatString;
+  std::vector<ConversionSpec> m_specVec;
+  std::vector<std::string> m_conversionFormat; // snprintf format of each conversion
+  std::vector<int> m_argOffset;                // argument offset from record start
+  int m_recordSize;                            // format id plus all arguments
+};
+
 /////////////////////////////////////////////////////////////////////////
 // A decoded printf argument. This is just a convenient way to quickly 
 // store anything that a printf argument is allowed to be. Arguments are 
@@ -223,8 +250,9 @@ struct PrintfArg
 // String table entries are numbered from 1..N (0 is reserved and
 // 0xFFFFFFFFFFFFFFFF is reserved)
 //
-// Printf buffer records repeat in the following format for each
-// printf to execute on the host:
+// The buffer is made of one segment of getWorkItemPrintfBufferSize()
+// bytes per work item. Printf buffer records repeat in the following
+// format for each printf to execute on the host:
 //     FIELD       BITS   DESCRIPTION
 //     Format_ID   64     ID of the format string in table
 //     Arguments   N*64   Arguments, N is number of aguments
@@ -233,13 +261,17 @@ struct PrintfArg
 //     Arguments   N*64   Arguments, N is number of aguments
 //     0xFF filling to end of buffer
 //
-// TODO: - Exception when invalid format_id is found in record
+// Segments are decoded independently of each other. Large buffers are
+// decoded in chunks of segments, each chunk split over several threads,
+// and the output of a chunk is written in segment order before the next
+// chunk is decoded.
 //
 class BufferPrintf {
 
 public:
     typedef std::vector<uint8_t> MemBuffer;
     typedef std::map<uint32_t,std::string> StringTable;
+    typedef std::map<uint32_t,std::shared_ptr<const CompiledFormat>> FormatTable;
 
 public:
     BufferPrintf();
@@ -267,37 +299,32 @@ public:
     // Number of bytes in a format string ID
     static int getFormatByteCount() { return 8; }
 
-private:
-    // Set the current offset to the first record
-    void moveToFirstRecord();
-
-    // Returns offset of next record or -1 if no more records found
-    int nextRecordOffset(int currentOffset) const;
+    // Number of work item segments decoded by one thread at a time
+    static size_t getSegmentsPerTask() { return 256; }
 
-    // Returns true if we have another record, false if no more exist
-    bool hasNextRecord() const;
+private:
+    // Output of a range of segments, and the error that stopped the
+    // decoding if any
+    struct DecodedText
+    {
+      std::string m_text;
+      std::exception_ptr m_error;
+    };
 
-    // Move m_currentOffset to the next record start. Assumes we are either
-    // on a record start position -or- we are positioned on the gap between
-    // records (because we advanced to the first byte after the last record
-    // which lies in the gap between work item segments).
-    void nextRecord();
+    // Decode all records of segments [first,last) and append the text
+    void decodeSegments(size_t first, size_t last, DecodedText& out) const;
 
-    // Extracts the Format for the current record
-    std::string getFormat() const;
+    // Decode the records of one segment, append the text to out
+    void decodeSegment(size_t segment, std::string& out) const;
 
-    // Extracts the Format_ID for the current record
-    uint32_t getFormatID() const;
+    // Append the text of the record at offset to out
+    void decodeRecord(size_t offset, const CompiledFormat& format, std::string& out) const;
 
-    // Find an ID in the string table and return the string 
-    void lookup(int id, std::string& retval) const;
+    // Find an ID in the string table and return its compiled format
+    const CompiledFormat& lookup(uint32_t id) const;
 
     // Extract a value from buffer
-    uint64_t extractField(int idx, int byteCount) const;
-
-    // Build up a printf argument given the conversion specifier
-    // and memory buffer and string table
-    PrintfArg buildArg(int bufIdx, ConversionSpec& conversion) const;
+    uint64_t extractField(size_t idx, int byteCount) const;
     
     // Convert escape sequences \n, \r, \t, \ to text representation
     // Newline replaced by string: "\n"
@@ -306,10 +333,9 @@ private:
     static std::string escape(const std::string& s);
 
 private:
-    // currentOffset always points at the current format string
-    int m_currentOffset;
     MemBuffer m_buf;
     StringTable m_stringTable;
+    FormatTable m_formatTable;
 };
 
 
@@ -321,6 +347,13 @@ private:
 // during string_printf to build the complete output string.
 std::string convertArg(PrintfArg& arg, ConversionSpec& conversion);
 
+// Return the snprintf format string for one element of a conversion
+std::string getConversionFormat(const ConversionSpec& conversion);
+
+// Return the compiled form of a format string. Formats are compiled
+// once and cached for the life of the process.
+std::shared_ptr<const CompiledFormat> compileFormat(const std::string& format);
+
 // Given format string and args, create and return a string (similar to sprintf). 
 // This exercises the round trip internal printf and is used to test breaking down
 // a format and printing arguments.
@@ -0,0 +1,71 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CL/opencl.h>
+#include "xocl/config.h"
+#include "xocl/core/command_queue.h"
+#include "xocl/core/command_graph.h"
+#include "xocl/core/error.h"
+#include "detail/command_queue.h"
+
+#include "plugin/xdp/profile.h"
+
+namespace xocl {
+
+static void
+validOrError(cl_command_queue command_queue,
+             cl_int*          errcode_ret)
+{
+  if (!config::api_checks())
+    return;
+
+  // CL_INVALID_COMMAND_QUEUE if command_queue is not a valid host command-queue.
+  detail::command_queue::validOrError(command_queue);
+}
+
+static cl_command_graph_xilinx
+clEndCommandGraphRecordingXilinx(cl_command_queue command_queue,
+                                 cl_int*          errcode_ret)
+{
+  validOrError(command_queue,errcode_ret);
+
+  // CL_INVALID_OPERATION if command_queue is not recording, or if
+  // a command failed to record
+  auto graph = xocl(command_queue)->end_recording();
+  xocl::assign(errcode_ret,CL_SUCCESS);
+  return graph;
+}
+
+} // xocl
+
+CL_API_ENTRY cl_command_graph_xilinx CL_API_CALL
+clEndCommandGraphRecordingXilinx(cl_command_queue command_queue,
+                                 cl_int*          errcode_ret) CL_API_SUFFIX__VERSION_1_0
+{
+  try {
+    PROFILE_LOG_FUNCTION_CALL;
+    return xocl::clEndCommandGraphRecordingXilinx(command_queue,errcode_ret);
+  }
+  catch (const xrt::error& ex) {
+    xocl::send_exception_message(ex.what());
+    xocl::assign(errcode_ret,ex.get_code());
+  }
+  catch (const std::exception& ex) {
+    xocl::send_exception_message(ex.what());
+    xocl::assign(errcode_ret,CL_INVALID_VALUE);
+  }
+  return nullptr;
+}
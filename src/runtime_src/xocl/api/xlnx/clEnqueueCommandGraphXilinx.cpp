@@ -0,0 +1,130 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CL/opencl.h>
+#include "xocl/config.h"
+#include "xocl/core/event.h"
+#include "xocl/core/kernel.h"
+#include "xocl/core/command_queue.h"
+#include "xocl/core/command_graph.h"
+#include "xocl/core/execution_context.h"
+#include "detail/command_queue.h"
+#include "detail/event.h"
+
+#include "enqueue.h"
+#include "plugin/xdp/profile.h"
+
+namespace xocl {
+
+static void
+validOrError(cl_command_queue         command_queue,
+             cl_command_graph_xilinx  graph,
+             cl_uint                  num_events_in_wait_list,
+             const cl_event *         event_wait_list,
+             cl_event *               event_parameter)
+{
+  if (!config::api_checks())
+    return;
+
+  // CL_INVALID_COMMAND_QUEUE if command_queue is not a valid host command-queue.
+  detail::command_queue::validOrError(command_queue);
+
+  // CL_INVALID_VALUE if graph is nullptr
+  if (!graph)
+    throw error(CL_INVALID_VALUE,"graph is nullptr");
+
+  // CL_INVALID_COMMAND_QUEUE if graph was not recorded on command_queue
+  if (xocl(graph)->get_command_queue()!=xocl(command_queue))
+    throw error(CL_INVALID_COMMAND_QUEUE,"graph was not recorded on command queue");
+
+  // CL_INVALID_OPERATION if command_queue is recording
+  if (xocl(command_queue)->is_recording())
+    throw error(CL_INVALID_OPERATION,"command queue is recording");
+
+  // CL_INVALID_CONTEXT if context associated with command_queue and
+  // events in event_wait_list are not the same.
+  // CL_INVALID_EVENT_WAIT_LIST if event_wait_list is NULL and
+  // num_events_in_wait_list > 0, or event_wait_list is not NULL and
+  // num_events_in_wait_list is 0, or if event objects in
+  // event_wait_list are not valid events.
+  detail::event::validOrError(command_queue,num_events_in_wait_list,event_wait_list);
+}
+
+// Rebind kernel arguments changed with clSetKernelArg after the node
+// was recorded or last replayed.  The NDRange execution context gets
+// a new copy of the arguments, and the migration event recorded along
+// with the NDRange gets a new migration action
+static void
+rebind(command_graph::node& node)
+{
+  auto ec = node.ev->get_execution_context();
+  if (!ec)
+    return;
+
+  auto kernel = ec->get_kernel();
+  auto generation = kernel->get_argument_generation();
+  if (generation==node.argument_generation)
+    return;
+
+  XOCL_DEBUG(std::cout,"rebind arguments of event(",node.ev->get_uid(),")\n");
+  ec->bind_arguments();
+  node.argument_generation = generation;
+
+  // The migration event is recorded first of the NDRange dependencies
+  auto itr = std::find_if(node.predecessors.begin(),node.predecessors.end(),
+                          [](event* ev) { return ev->get_command_type()==CL_COMMAND_MIGRATE_MEM_OBJECTS; });
+  if (itr!=node.predecessors.end())
+    enqueue::set_event_action(*itr,enqueue::action_ndrange_migrate,*itr,kernel);
+}
+
+static cl_int
+clEnqueueCommandGraphXilinx(cl_command_queue         command_queue,
+                            cl_command_graph_xilinx  graph,
+                            cl_uint                  num_events_in_wait_list,
+                            const cl_event *         event_wait_list,
+                            cl_event *               event_parameter)
+{
+  validOrError(command_queue,graph,num_events_in_wait_list,event_wait_list,event_parameter);
+
+  // CL_INVALID_OPERATION if graph failed to record
+  auto event = xocl(graph)->replay(num_events_in_wait_list,event_wait_list,rebind);
+  xocl::assign(event_parameter,event.get());
+  return CL_SUCCESS;
+}
+
+} // xocl
+
+CL_API_ENTRY cl_int CL_API_CALL
+clEnqueueCommandGraphXilinx(cl_command_queue         command_queue,
+                            cl_command_graph_xilinx  graph,
+                            cl_uint                  num_events_in_wait_list,
+                            const cl_event *         event_wait_list,
+                            cl_event *               event_parameter) CL_API_SUFFIX__VERSION_1_0
+{
+  try {
+    PROFILE_LOG_FUNCTION_CALL;
+    return xocl::clEnqueueCommandGraphXilinx
+      (command_queue,graph,num_events_in_wait_list,event_wait_list,event_parameter);
+  }
+  catch (const xrt::error& ex) {
+    xocl::send_exception_message(ex.what());
+    return ex.get_code();
+  }
+  catch (const std::exception& ex) {
+    xocl::send_exception_message(ex.what());
+  }
+  return CL_INVALID_VALUE;
+}
@@ -0,0 +1,93 @@
+/**
+ * Copyright (C) 2018-2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include <CL/opencl.h>
+#include "xocl/core/error.h"
+#include "plugin/xdp/profile.h"
+#include "xocl/core/device.h"
+
+#include <cerrno>
+
+namespace xocl {
+
+static void
+validOrError(cl_device_id                     device,
+             cl_streams_poll_req_completions* completions,
+             cl_int                           min_num_completion,
+             cl_int                           max_num_completion,
+             cl_int*                          num_completion,
+             cl_int                           timeout,
+             cl_int*                          errcode_ret)
+{
+  if (!device)
+    throw xocl::error(CL_INVALID_DEVICE,"clPollStreams: invalid device");
+  if (!completions || !num_completion)
+    throw xocl::error(CL_INVALID_VALUE,"clPollStreams: invalid completions");
+  if (min_num_completion < 0 || max_num_completion <= 0 || min_num_completion > max_num_completion)
+    throw xocl::error(CL_INVALID_VALUE,"clPollStreams: invalid number of completions");
+}
+
+static cl_int
+clPollStreams(cl_device_id                     device,
+              cl_streams_poll_req_completions* completions,
+              cl_int                           min_num_completion,
+              cl_int                           max_num_completion,
+              cl_int*                          num_completion,
+              cl_int                           timeout,
+              cl_int*                          errcode_ret)
+{
+  static_assert(sizeof(cl_streams_poll_req_completions) == sizeof(xrt::hal::StreamXferCompletion),
+                "cl_streams_poll_req_completions must match xrt::hal::StreamXferCompletion");
+  validOrError(device,completions,min_num_completion,max_num_completion,num_completion,timeout,errcode_ret);
+  auto ret = xocl::xocl(device)->poll_streams
+    (reinterpret_cast<xrt::hal::StreamXferCompletion*>(completions),
+     min_num_completion,max_num_completion,num_completion,timeout);
+  if (ret == -ETIMEDOUT)
+    throw xocl::error(CL_INVALID_OPERATION,"clPollStreams: timed out");
+  if (ret < 0)
+    throw xocl::error(CL_INVALID_OPERATION,"clPollStreams: failed with " + std::to_string(ret));
+  xocl::assign(errcode_ret,CL_SUCCESS);
+  return CL_SUCCESS;
+}
+
+} //xocl
+
+CL_API_ENTRY cl_int CL_API_CALL
+clPollStreams(cl_device_id                     device,
+              cl_streams_poll_req_completions* completions,
+              cl_int                           min_num_completion,
+              cl_int                           max_num_completion,
+              cl_int*                          num_completion,
+              cl_int                           timeout,
+              cl_int*                          errcode_ret) CL_API_SUFFIX__VERSION_1_0
+{
+  try {
+    PROFILE_LOG_FUNCTION_CALL;
+    return xocl::clPollStreams
+      (device,completions,min_num_completion,max_num_completion,num_completion,timeout,errcode_ret);
+  }
+  catch (const xrt::error& ex) {
+    xocl::send_exception_message(ex.what());
+    xocl::assign(errcode_ret,ex.get_code());
+    return ex.get_code();
+  }
+  catch (const std::exception& ex) {
+    xocl::send_exception_message(ex.what());
+    xocl::assign(errcode_ret,CL_INVALID_VALUE);
+  }
+  return CL_INVALID_VALUE;
+}
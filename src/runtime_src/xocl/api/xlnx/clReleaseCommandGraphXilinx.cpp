@@ -0,0 +1,65 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CL/opencl.h>
+#include "xocl/config.h"
+#include "xocl/core/command_graph.h"
+#include "xocl/core/error.h"
+
+#include "plugin/xdp/profile.h"
+
+namespace xocl {
+
+static void
+validOrError(cl_command_graph_xilinx graph)
+{
+  if (!config::api_checks())
+    return;
+
+  if (!graph)
+    throw error(CL_INVALID_VALUE,"graph is nullptr");
+}
+
+static cl_int
+clReleaseCommandGraphXilinx(cl_command_graph_xilinx graph)
+{
+  validOrError(graph);
+
+  // Destruction waits for an outstanding replay to complete
+  if (xocl(graph)->release())
+    delete xocl(graph);
+
+  return CL_SUCCESS;
+}
+
+} // xocl
+
+CL_API_ENTRY cl_int CL_API_CALL
+clReleaseCommandGraphXilinx(cl_command_graph_xilinx graph) CL_API_SUFFIX__VERSION_1_0
+{
+  try {
+    PROFILE_LOG_FUNCTION_CALL;
+    return xocl::clReleaseCommandGraphXilinx(graph);
+  }
+  catch (const xrt::error& ex) {
+    xocl::send_exception_message(ex.what());
+    return ex.get_code();
+  }
+  catch (const std::exception& ex) {
+    xocl::send_exception_message(ex.what());
+  }
+  return CL_INVALID_VALUE;
+}
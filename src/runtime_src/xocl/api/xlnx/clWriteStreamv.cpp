@@ -0,0 +1,88 @@
+/**
+ * Copyright (C) 2018-2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include <CL/opencl.h>
+#include "xocl/core/stream.h"
+#include "xocl/core/error.h"
+#include "plugin/xdp/profile.h"
+#include "xocl/core/device.h"
+
+namespace xocl {
+
+static void
+validOrError(cl_device_id              device,
+             cl_stream                 stream,
+             const cl_stream_xfer_buf* bufs,
+             cl_uint                   num_bufs,
+             cl_stream_xfer_req        attributes,
+             void*                     priv_data,
+             cl_int*                   errcode_ret)
+{
+  if (!device)
+    throw xocl::error(CL_INVALID_DEVICE,"clWriteStreamv: invalid device");
+  if (!stream)
+    throw xocl::error(CL_INVALID_VALUE,"clWriteStreamv: invalid stream");
+  if (!bufs || !num_bufs)
+    throw xocl::error(CL_INVALID_VALUE,"clWriteStreamv: no buffers");
+}
+
+static cl_int
+clWriteStreamv(cl_device_id              device,
+               cl_stream                 stream,
+               const cl_stream_xfer_buf* bufs,
+               cl_uint                   num_bufs,
+               cl_stream_xfer_req        attributes,
+               void*                     priv_data,
+               cl_int*                   errcode_ret)
+{
+  static_assert(sizeof(cl_stream_xfer_buf) == sizeof(xrt::hal::StreamXferBuf),
+                "cl_stream_xfer_buf must match xrt::hal::StreamXferBuf");
+  validOrError(device,stream,bufs,num_bufs,attributes,priv_data,errcode_ret);
+  auto ret = xocl::xocl(stream)->write
+    (xocl::xocl(device),reinterpret_cast<const xrt::hal::StreamXferBuf*>(bufs),num_bufs,attributes,priv_data);
+  if (ret < 0)
+    throw xocl::error(CL_INVALID_OPERATION,"clWriteStreamv: write failed with " + std::to_string(ret));
+  xocl::assign(errcode_ret,CL_SUCCESS);
+  return static_cast<cl_int>(ret);
+}
+
+} //xocl
+
+CL_API_ENTRY cl_int CL_API_CALL
+clWriteStreamv(cl_device_id              device,
+               cl_stream                 stream,
+               const cl_stream_xfer_buf* bufs,
+               cl_uint                   num_bufs,
+               cl_stream_xfer_req        attributes,
+               void*                     priv_data,
+               cl_int*                   errcode_ret) CL_API_SUFFIX__VERSION_1_0
+{
+  try {
+    PROFILE_LOG_FUNCTION_CALL;
+    return xocl::clWriteStreamv
+      (device,stream,bufs,num_bufs,attributes,priv_data,errcode_ret);
+  }
+  catch (const xrt::error& ex) {
+    xocl::send_exception_message(ex.what());
+    xocl::assign(errcode_ret,ex.get_code());
+  }
+  catch (const std::exception& ex) {
+    xocl::send_exception_message(ex.what());
+    xocl::assign(errcode_ret,CL_INVALID_VALUE);
+  }
+  return CL_INVALID_VALUE;
+}
@@ -0,0 +1,198 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "command_graph.h"
+#include "command_queue.h"
+#include "event.h"
+#include "kernel.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace xocl {
+
+command_graph::
+command_graph(command_queue* cq)
+  : m_command_queue(cq)
+{
+  static unsigned int uid_count = 0;
+  m_uid = uid_count++;
+
+  XOCL_DEBUG(std::cout,"xocl::command_graph::command_graph(",m_uid,")\n");
+}
+
+command_graph::
+~command_graph()
+{
+  XOCL_DEBUG(std::cout,"xocl::command_graph::~command_graph(",m_uid,")\n");
+
+  // Recorded events may outlive the graph if retained by application
+  if (m_done.get())
+    m_done->wait();
+  for (auto& n : m_nodes)
+    n.ev->m_graph = nullptr;
+}
+
+void
+command_graph::
+record(event* ev)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+
+  try {
+    if (!m_error.empty())
+      throw xocl::error(CL_INVALID_OPERATION,"command graph is invalid: " + m_error);
+
+    auto ec = ev->get_execution_context();
+    if (ec && ec->get_kernel()->has_printf())
+      throw xocl::error(CL_INVALID_OPERATION,"kernel '" + ec->get_kernel()->get_name() + "' with printf cannot be recorded");
+
+    // Implicit dependencies per command queue properties, same as
+    // command_queue::queue()
+    if (m_command_queue->get_properties().test(CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE)) {
+      if (m_last_barrier)
+        m_last_barrier->chain(ev);
+      if (ev->get_command_type()==CL_COMMAND_BARRIER)
+        m_last_barrier = ev;
+    }
+    else if (!m_nodes.empty()) {
+      m_nodes.back().ev->chain(ev);
+    }
+
+    node n;
+    n.ev = ev;
+    for (auto& p : m_nodes) {
+      std::lock_guard<std::mutex> plk(p.ev->m_mutex);
+      auto count = std::count(p.ev->m_chain.begin(),p.ev->m_chain.end(),ev);
+      n.predecessors.insert(n.predecessors.end(),count,p.ev.get());
+    }
+
+    {
+      std::lock_guard<std::mutex> elk(ev->m_mutex);
+      n.wait_count = ev->m_wait_count;
+    }
+
+    // The event was created with 1 + one count per incomplete dependency,
+    // all of which must be recorded events
+    if (n.wait_count != n.predecessors.size() + 1)
+      throw xocl::error(CL_INVALID_OPERATION,"event(" + ev->get_suid() + ") depends on incomplete event outside command graph");
+
+    if (ec)
+      n.argument_generation = ec->get_kernel()->get_argument_generation();
+
+    XOCL_DEBUG(std::cout,"command_graph(",m_uid,") records event(",ev->get_uid(),")\n");
+    ev->m_graph = this;
+    m_nodes.push_back(std::move(n));
+  }
+  catch (const std::exception& ex) {
+    if (m_error.empty())
+      m_error = ex.what();
+    throw;
+  }
+}
+
+void
+command_graph::
+end_recording()
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  m_recording = false;
+
+  if (!m_error.empty())
+    throw xocl::error(CL_INVALID_OPERATION,"command graph is invalid: " + m_error);
+
+  // A recorded event can only chain other recorded events, otherwise
+  // the other event would be submitted by every replay
+  for (auto& n : m_nodes) {
+    std::lock_guard<std::mutex> elk(n.ev->m_mutex);
+    for (auto& c : n.ev->m_chain) {
+      if (c->m_graph!=this) {
+        m_error = "event(" + c->get_suid() + ") outside command graph waits on recorded event(" + n.ev->get_suid() + ")";
+        throw xocl::error(CL_INVALID_OPERATION,"command graph is invalid: " + m_error);
+      }
+    }
+  }
+}
+
+ptr<event>
+command_graph::
+replay(cl_uint num_deps, const cl_event* deps, const std::function<void(node&)>& rebind)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+
+  if (m_recording)
+    throw xocl::error(CL_INVALID_OPERATION,"command graph is still recording");
+  if (!m_error.empty())
+    throw xocl::error(CL_INVALID_OPERATION,"command graph is invalid: " + m_error);
+
+  // The recorded events are reused, so previous replay must be done
+  if (m_done.get())
+    m_done->wait();
+
+  for (auto& n : m_nodes) {
+    {
+      std::lock_guard<std::mutex> elk(n.ev->m_mutex);
+      n.ev->m_status = -1;
+      n.ev->m_wait_count = n.wait_count;
+      n.ev->m_signaled = false;
+    }
+    if (auto ec = n.ev->get_execution_context())
+      ec->reset();
+    rebind(n);
+  }
+
+  cl_command_queue cq = m_command_queue.get();
+
+  // Marker that orders the replay after the dependencies and after
+  // previously enqueued commands per the queue properties
+  auto start = create_hard_event(cq,CL_COMMAND_MARKER,num_deps,deps);
+
+  // Completion event of this replay is completed when all recorded
+  // events have completed (see complete()), unless there are none.
+  m_done = create_hard_event(cq,CL_COMMAND_MARKER);
+  if (!m_nodes.empty())
+    m_done->set_enqueue_action([](event*){});
+  m_pending = m_nodes.size();
+  ++m_replays;
+
+  start->queue();
+  m_done->queue();
+
+  for (auto& n : m_nodes)
+    if (n.predecessors.empty())
+      start->chain(n.ev.get());
+
+  for (auto& n : m_nodes)
+    n.ev->queue();
+
+  XOCL_DEBUG(std::cout,"command_graph(",m_uid,") replay(",m_replays,") event(",m_done->get_uid(),")\n");
+  return m_done;
+}
+
+void
+command_graph::
+complete(event*)
+{
+  if (--m_pending)
+    return;
+
+  // Last access to this graph, once m_done is complete the graph
+  // can be deleted by the application
+  auto done = m_done;
+  done->set_status(CL_COMPLETE);
+}
+
+} // xocl
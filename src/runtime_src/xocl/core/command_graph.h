@@ -0,0 +1,187 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef xocl_core_command_graph_h_
+#define xocl_core_command_graph_h_
+
+#include "xocl/core/object.h"
+#include "xocl/core/refcount.h"
+#include "xocl/core/range.h"
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <functional>
+
+namespace xocl {
+
+/**
+ * A command graph is a recorded sequence of commands (events) enqueued
+ * on a command queue along with their dependencies.
+ *
+ * While a command queue is recording, enqueued commands are fully
+ * constructed (validated, buffers allocated, actions created) but
+ * are captured by the graph instead of being queued.  Once recording
+ * ends the graph is immutable and can be replayed any number of times
+ * on the recording queue.  A replay resets the recorded events and
+ * queues them again, the only work done per replay is rebinding of
+ * kernel arguments that were changed with clSetKernelArg since the
+ * last replay.
+ *
+ * A graph replay is itself ordered with respect to other commands in
+ * the queue through a marker event queued before the recorded
+ * commands, and a completion event that completes when all recorded
+ * commands have completed.
+ */
+class command_graph : public refcount, public _cl_command_graph_xilinx
+{
+public:
+  struct node
+  {
+    ptr<event> ev;
+
+    // Wait count of the event when not queued (1 + in-graph dependencies)
+    unsigned int wait_count = 0;
+
+    // Recorded events that this event waits on
+    std::vector<event*> predecessors;
+
+    // Argument generation of the kernel when the execution context
+    // of the event was last bound to the kernel arguments
+    unsigned long argument_generation = 0;
+  };
+
+  using node_vector_type = std::vector<node>;
+  using node_iterator_type = node_vector_type::iterator;
+
+  command_graph(command_queue* cq);
+  virtual ~command_graph();
+
+  unsigned int
+  get_uid() const
+  {
+    return m_uid;
+  }
+
+  command_queue*
+  get_command_queue() const
+  {
+    return m_command_queue.get();
+  }
+
+  /**
+   * Record an event being enqueued on the recording command queue.
+   *
+   * The event is chained to the previously recorded event per the
+   * command queue properties.  Events that depend on incomplete
+   * events outside the graph cannot be recorded, nor can kernels with
+   * printf.  A failure to record invalidates the graph.
+   *
+   * @exception xocl::error
+   *   CL_INVALID_OPERATION if the event cannot be recorded
+   */
+  void
+  record(event* ev);
+
+  /**
+   * End recording of this graph
+   *
+   * After recording has ended the graph is immutable and can be
+   * replayed.
+   *
+   * @exception xocl::error
+   *   CL_INVALID_OPERATION if an event could not be recorded, or if a
+   *   recorded event is waited on by an event outside the graph.
+   */
+  void
+  end_recording();
+
+  /**
+   * @return
+   *   true if the graph is still recording
+   */
+  bool
+  is_recording() const
+  {
+    return m_recording;
+  }
+
+  /**
+   * @return
+   *   true if graph was replayed at least once
+   */
+  bool
+  is_replayed() const
+  {
+    return m_replays>0;
+  }
+
+  /**
+   * @return
+   *   Range of recorded nodes in the order they were enqueued
+   */
+  range<node_iterator_type>
+  get_node_range()
+  {
+    return range<node_iterator_type>(m_nodes.begin(),m_nodes.end());
+  }
+
+  /**
+   * Replay the graph
+   *
+   * Waits for a previous replay to complete, then resets all recorded
+   * events and queues them on the command queue.  Caller is
+   * responsible for rebinding arguments (see get_node_range()) after
+   * the graph is reset and before it is queued.
+   *
+   * @param num_deps
+   *   Number of events in dependency list
+   * @param deps
+   *   Events that must complete before the graph can execute
+   * @param rebind
+   *   Function called after reset for each node before queuing
+   * @return
+   *   Event that completes when all recorded commands have completed
+   */
+  ptr<event>
+  replay(cl_uint num_deps, const cl_event* deps, const std::function<void(node&)>& rebind);
+
+  /**
+   * Called when a recorded event completes
+   */
+  void
+  complete(event* ev);
+
+private:
+  unsigned int m_uid = 0;
+  ptr<command_queue> m_command_queue;
+
+  std::mutex m_mutex;
+  node_vector_type m_nodes;
+  event* m_last_barrier = nullptr;
+  std::string m_error;
+  std::atomic<bool> m_recording {true};
+
+  // Replay state
+  std::atomic<unsigned long> m_replays {0};
+  std::atomic<size_t> m_pending {0};
+  ptr<event> m_done;
+};
+
+} // xocl
+
+#endif
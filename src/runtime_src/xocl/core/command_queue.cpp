@@ -15,9 +15,11 @@
  */
 
 #include "command_queue.h"
+#include "command_graph.h"
 #include "context.h"
 #include "device.h"
 #include "event.h"
+#include "wait.h"
 
 #include "xocl/api/plugin/xdp/profile.h"
 
@@ -77,6 +79,14 @@ queue(event* ev)
   XOCL_DEBUG(std::cout,"queue(",m_uid,") queues event(",ev->get_uid(),")\n");
 
   std::lock_guard<std::mutex> lk(m_events_mutex);
+
+  // Replay of recorded event, the dependencies were recorded and the
+  // graph replay itself is ordered with other events in this queue.
+  // Recorded events are owned by the graph and are not added to the
+  // queue, the completion event of the replay stands in for them.
+  if (ev->m_graph)
+    return true;
+
   if (!ooo && m_last_queued_event.get()) {
     m_last_queued_event->chain(ev);
 
@@ -84,17 +94,18 @@ queue(event* ev)
     xocl::profile::log_dependencies(ev, 1, &tmp_lval);
   }
 
-  if (ooo) {
-    for (auto b: m_barriers)
-      b->chain(ev);
+  if (ooo && m_last_barrier.get()) {
+    m_last_barrier->chain(ev);
 
-    xocl::profile::log_dependencies(ev, m_barriers.size(), reinterpret_cast<cl_event*>(m_barriers.data()) );
-
-    if (ev->get_command_type()==CL_COMMAND_BARRIER)
-      m_barriers.push_back(ev);
+    auto tmp_lval = static_cast<cl_event>(m_last_barrier.get());
+    xocl::profile::log_dependencies(ev, 1, &tmp_lval);
   }
 
-  m_events.insert(ev);
+  if (ooo && ev->get_command_type()==CL_COMMAND_BARRIER)
+    m_last_barrier = ev;
+
+  m_events.push_back(*ev);
+  m_num_events = m_events.size();
   m_last_queued_event = ev;
   ev->retain();
 
@@ -133,22 +144,22 @@ bool
 command_queue::
 remove(event* ev)
 {
+  // Replayed recorded event, never added to the queue
+  if (ev->m_graph)
+    return true;
+
   std::lock_guard<std::mutex> lk(m_events_mutex);
 
-  auto it = m_events.find(ev);
-  if (it==m_events.end())
+  if (!ev->m_queue_hook.is_linked())
     throw xocl::error(CL_INVALID_EVENT,"event " + ev->get_suid() + " never submitted");
-  m_events.erase(it);
+  m_events.erase(m_events.iterator_to(*ev));
   if (m_last_queued_event==ev)
     m_last_queued_event = nullptr;
-
-  if ((ev->get_command_type()==CL_COMMAND_BARRIER) && (m_props.test(CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE)))  {
-    auto bit = std::find(m_barriers.begin(),m_barriers.end(),ev);
-    assert(bit!=m_barriers.end());
-    m_barriers.erase(bit);
-  }
+  if (m_last_barrier==ev)
+    m_last_barrier = nullptr;
 
   ev->release();
+  m_num_events = m_events.size();
   if (m_events.empty())
     m_has_events.notify_all();
 
@@ -171,11 +182,53 @@ abort(event* ev,bool)
   return remove(ev);
 }
 
+void
+command_queue::
+begin_recording()
+{
+  std::lock_guard<std::mutex> lk(m_events_mutex);
+  if (m_recording)
+    throw xocl::error(CL_INVALID_OPERATION,"command queue is already recording");
+  XOCL_DEBUG(std::cout,"queue(",m_uid,") begins recording\n");
+  m_recording.reset(new command_graph(this));
+}
+
+command_graph*
+command_queue::
+end_recording()
+{
+  std::unique_ptr<command_graph> graph;
+  {
+    std::lock_guard<std::mutex> lk(m_events_mutex);
+    if (!m_recording)
+      throw xocl::error(CL_INVALID_OPERATION,"command queue is not recording");
+    graph = std::move(m_recording);
+  }
+  XOCL_DEBUG(std::cout,"queue(",m_uid,") ends recording of graph(",graph->get_uid(),")\n");
+  graph->end_recording();
+  return graph.release();
+}
+
+bool
+command_queue::
+record(event* ev)
+{
+  std::lock_guard<std::mutex> lk(m_events_mutex);
+
+  // Events of a replayed graph are queued as usual
+  if (!m_recording || ev->m_graph)
+    return false;
+
+  m_recording->record(ev);
+  return true;
+}
+
 void
 command_queue::
 wait() const
 {
   XOCL_DEBUG(std::cout,"xocl::command_queue::wait(",m_uid,")\n");
+  spin_wait([this] { return m_num_events==0; });
   std::unique_lock<std::mutex> lk(m_events_mutex);
   while (m_events.size())
     m_has_events.wait(lk);
@@ -186,6 +239,7 @@ command_queue::
 flush() const
 {
   XOCL_DEBUG(std::cout,"xocl::command_queue::flush(",m_uid,")\n");
+  spin_wait([this] { return m_num_events==0; });
   std::unique_lock<std::mutex> lk(m_events_mutex);
   while (m_events.size())
     m_has_events.wait(lk);
@@ -196,6 +250,7 @@ command_queue::
 wait_and_lock() const
 {
   XOCL_DEBUG(std::cout,"xocl::command_queue::wait_and_lock(",m_uid,")\n");
+  spin_wait([this] { return m_num_events==0; });
   std::unique_lock<std::mutex> lk(m_events_mutex);
   while (m_events.size())
     m_has_events.wait(lk);
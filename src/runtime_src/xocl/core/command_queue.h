@@ -20,13 +20,15 @@
 #include "xocl/core/object.h"
 #include "xocl/core/refcount.h"
 #include "xocl/core/property.h"
+#include "xocl/core/event.h"
 
 #include <vector>
 #include <set>
-#include <unordered_set>
 #include <mutex>
 #include <condition_variable>
 #include <functional>
+#include <memory>
+#include <atomic>
 
 namespace xocl {
 
@@ -39,8 +41,28 @@ class command_queue : public refcount, public _cl_command_queue
   // it retains the event upon queuing and releases it when the
   // event is removed.
 public:
-  using event_queue_type = std::unordered_set<event*>;
-  using event_iterator_type = event_queue_type::iterator;
+  // Queued events are linked through the events themselves, the
+  // queue does not allocate per event
+  using event_queue_type = event::queue_list_type;
+
+  // Iterator over queued events that dereferences to event pointer
+  struct event_iterator_type : public event_queue_type::iterator
+  {
+    using value_type = event*;
+    using reference = event*;
+    using pointer = event**;
+
+    // implicit
+    event_iterator_type(event_queue_type::iterator itr)
+      : event_queue_type::iterator(itr)
+    {}
+
+    event*
+    operator*() const
+    {
+      return &event_queue_type::iterator::operator*();
+    }
+  };
 
   using commandqueue_callback_type = std::function<void(command_queue*)>;
   using commandqueue_callback_list = std::vector<commandqueue_callback_type>;
@@ -103,6 +125,9 @@ public:
 
   /**
    * Get range with events that are queued or submitted
+   *
+   * Events of a replayed command graph are not in the range, the
+   * completion event of the replay is.
    */
   range_lock<event_iterator_type>
   get_event_range()
@@ -154,6 +179,50 @@ public:
   bool
   abort(event* ev,bool fatal=false);
 
+  /**
+   * Start recording a command graph
+   *
+   * Events enqueued while recording are captured by the graph
+   * instead of being queued.
+   *
+   * @exception xocl::error
+   *   CL_INVALID_OPERATION if the queue is already recording
+   */
+  void
+  begin_recording();
+
+  /**
+   * End recording of command graph
+   *
+   * @return
+   *   The recorded graph, ownership is transferred to caller
+   * @exception xocl::error
+   *   CL_INVALID_OPERATION if the queue is not recording or if the
+   *   recorded graph is invalid
+   */
+  command_graph*
+  end_recording();
+
+  /**
+   * @return
+   *   true if this queue is recording a command graph
+   */
+  bool
+  is_recording() const
+  {
+    std::lock_guard<std::mutex> lk(m_events_mutex);
+    return m_recording!=nullptr;
+  }
+
+  /**
+   * Record event in current command graph if recording
+   *
+   * @return
+   *   true if event was recorded, false otherwise
+   */
+  bool
+  record(event* ev);
+
   /**
    * Wait for all events to complete
    */
@@ -201,9 +270,19 @@ private:
   mutable std::mutex m_events_mutex;
   mutable std::condition_variable m_has_events;
   event_queue_type m_events;
-  std::vector<event*> m_barriers;
+
+  // Number of events in m_events, for waiters spinning without lock
+  std::atomic<size_t> m_num_events {0};
   ptr<event> m_last_queued_event;
+
+  // Latest incomplete barrier of an out-of-order queue.  A barrier
+  // waits on the barrier before it, so events queued after a barrier
+  // need only depend on the latest barrier.
+  ptr<event> m_last_barrier;
   property_type m_props;
+
+  // Command graph being recorded, if any
+  std::unique_ptr<command_graph> m_recording;
 };
 
 } // xocl
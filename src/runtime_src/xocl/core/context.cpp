@@ -17,6 +17,7 @@
 #include "context.h"
 #include "device.h"
 #include "platform.h"
+#include "xrt/config.h"
 #include <iostream>
 
 namespace xocl {
@@ -59,4 +60,34 @@ get_platform() const
   return get_global_platform();
 }
 
+placement_policy*
+context::
+get_placement_policy()
+{
+  std::lock_guard<std::mutex> lk(m_placement_mutex);
+  if (m_placement)
+    return m_placement.get();
+
+  auto name = xrt::config::get_mem_placement();
+  for (auto prop : m_props) {
+    if (prop.get_key()!=CL_CONTEXT_MEM_PLACEMENT_XILINX)
+      continue;
+    switch (prop.get_value()) {
+    case CL_MEM_PLACEMENT_FIRST_XILINX:
+      name = "first";
+      break;
+    case CL_MEM_PLACEMENT_BALANCE_XILINX:
+      name = "balance";
+      break;
+    case CL_MEM_PLACEMENT_STRIPE_XILINX:
+      name = "stripe";
+      break;
+    }
+  }
+
+  m_placement = create_placement_policy(name);
+  XOCL_DEBUG(std::cout,"xocl::context(",m_uid,") memory placement '",name,"'\n");
+  return m_placement.get();
+}
+
 } // xocl
@@ -21,8 +21,11 @@
 #include "xocl/core/refcount.h"
 #include "xocl/core/range.h"
 #include "xocl/core/property.h"
+#include "xocl/core/placement.h"
 #include <vector>
 #include <functional>
+#include <memory>
+#include <mutex>
 
 namespace xocl {
 
@@ -147,6 +150,16 @@ public:
   platform*
   get_platform() const;
 
+  /**
+   * Placement policy for buffers allocated in this context
+   *
+   * The policy is created on first use from the value of
+   * CL_CONTEXT_MEM_PLACEMENT_XILINX if specified, or else from
+   * Runtime.mem_placement.
+   */
+  placement_policy*
+  get_placement_policy();
+
 private:
   unsigned int m_uid = 0;
   property_list_type m_props;
@@ -166,6 +179,9 @@ private:
   // However, the program shares ownership of this context.
   program_vector_type m_programs;
   std::mutex m_program_mutex;
+
+  std::unique_ptr<placement_policy> m_placement;
+  std::mutex m_placement_mutex;
 };
 
 } // xocl
@@ -16,6 +16,7 @@
 
 #include "device.h"
 #include "memory.h"
+#include "context.h"
 #include "program.h"
 #include "compute_unit.h"
 
@@ -23,7 +24,9 @@
 #include "xocl/api/plugin/xdp/debug.h"
 #include "xocl/xclbin/xclbin.h"
 #include "xrt/util/memory.h"
+#include "xrt/util/config_reader.h"
 #include "xrt/scheduler/scheduler.h"
+#include "driver/include/ert.h"
 
 #include <iostream>
 #include <fstream>
@@ -150,6 +153,12 @@ init_scheduler(xocl::device* device)
 
   auto cu2addr = xclbin.cu_base_address_map();
 
+  // Schedulers get the CU control protocol in the low bits of the
+  // CU address, chained CUs are restarted on AP_READY
+  for (auto& addr : cu2addr)
+    if (xclbin.cu_address_to_control(addr)==AP_CTRL_CHAIN)
+      addr |= ERT_CU_CTRL_CHAIN;
+
   size_t regmap_size = xclbin.kernel_max_regmap_size();
   XOCL_DEBUG(std::cout,"max regmap size:",regmap_size,"\n");
 
@@ -305,6 +314,27 @@ read_stream(xrt::device::stream_handle stream, void* ptr, size_t offset, size_t
   return m_xdevice->readStream(stream, ptr, offset, size, flags);
 }
 
+ssize_t
+device::
+write_stream(xrt::device::stream_handle stream, const xrt::device::stream_xfer_buf* bufs, size_t count, xrt::device::stream_xfer_flags flags, void* priv_data)
+{
+  return m_xdevice->writeStream(stream, bufs, count, flags, priv_data);
+}
+
+ssize_t
+device::
+read_stream(xrt::device::stream_handle stream, const xrt::device::stream_xfer_buf* bufs, size_t count, xrt::device::stream_xfer_flags flags, void* priv_data)
+{
+  return m_xdevice->readStream(stream, bufs, count, flags, priv_data);
+}
+
+int
+device::
+poll_streams(xrt::device::stream_xfer_completion* comps, int min_compl, int max_compl, int* actual_compl, int timeout)
+{
+  return m_xdevice->pollStreams(comps, min_compl, max_compl, actual_compl, timeout);
+}
+
 xrt::device::stream_buf
 device::
 alloc_stream_buf(size_t size, xrt::device::stream_buf_handle* handle)
@@ -415,9 +445,7 @@ set_xrt_device(xrt::device* xd,bool final)
     throw std::runtime_error("temp device already set");
   m_xdevice = xd;
 
-  // start the DMA threads if necessary
-  if (final)
-    m_xdevice->setup();
+  // DMA threads are started by the xrt device on first use
 }
 
 void
@@ -543,10 +571,11 @@ allocate_buffer_object(memory* mem)
   }
 
   // If buffer could not be allocated on the requested bank,
-  // or if no bank was specified, then allocate on the bank
-  // (memidx) matching the CU connectivity of CUs in device.
-  auto memidx = get_cu_memidx();
-  if (memidx>=0) {
+  // or if no bank was specified, then allocate on a bank (memidx)
+  // matching the CU connectivity of CUs in device as chosen by
+  // the placement policy of the context.
+  auto memidx_mask = get_cu_memidx_mask();
+  for (auto memidx : rank_banks(mem,memidx_mask)) {
     try {
       auto boh = alloc(mem,memidx);
       XOCL_DEBUG(std::cout,"memory(",mem->get_uid(),") allocated on device(",m_uid,") in bank with idx(",memidx,")\n");
@@ -600,6 +629,62 @@ allocate_buffer_object(memory* mem, uint64_t memidx)
   return boh;
 }
 
+xrt::device::BufferObjectHandle
+device::
+place_buffer_object(memory* mem, const memidx_bitmask_type& memidx_mask)
+{
+  for (auto memidx : rank_banks(mem,memidx_mask)) {
+    try {
+      auto boh = allocate_buffer_object(mem,memidx);
+      XOCL_DEBUG(std::cout,"memory(",mem->get_uid(),") placed on device(",m_uid,") in bank with idx(",memidx,")\n");
+      return boh;
+    }
+    catch (const std::bad_alloc&) {
+    }
+  }
+  throw std::bad_alloc();
+}
+
+std::vector<placement_policy::memidx_type>
+device::
+rank_banks(memory* mem, const memidx_bitmask_type& memidx_mask) const
+{
+  if (memidx_mask.none())
+    return {};
+  auto policy = mem->get_context()->get_placement_policy();
+  return policy->rank(get_bank_info(memidx_mask,policy->needs_usage()),mem->get_size());
+}
+
+std::vector<placement_policy::bank_info>
+device::
+get_bank_info(const memidx_bitmask_type& memidx_mask, bool usage) const
+{
+  std::vector<placement_policy::bank_info> banks;
+  auto mem_topo = m_xclbin.get_mem_topology();
+  std::vector<uint64_t> used;
+  if (usage) {
+    auto bank_usage = get_xrt_device()->getBankUsage();
+    if (bank_usage.valid())
+      used = bank_usage.get();
+  }
+
+  for (size_t idx=0; idx<memidx_mask.size(); ++idx) {
+    if (!memidx_mask.test(idx))
+      continue;
+
+    placement_policy::bank_info bank {static_cast<placement_policy::memidx_type>(idx),0,0};
+    if (mem_topo && idx<static_cast<size_t>(mem_topo->m_count)) {
+      if (!mem_topo->m_mem_data[idx].m_used)
+        continue;
+      bank.size = mem_topo->m_mem_data[idx].m_size * 1024; // KB
+    }
+    if (idx<used.size())
+      bank.used = used[idx];
+    banks.push_back(bank);
+  }
+  return banks;
+}
+
 void
 device::
 free(const memory* mem)
@@ -660,25 +745,32 @@ get_cu_memidx() const
   if (m_cu_memidx == -2) {
     m_cu_memidx = -1;
 
-    if (get_num_cus()) {
-      // compute intersection of all CU memory masks
-      memidx_bitmask_type mask;
-      mask.set();
-      for (auto& cu : get_cu_range())
-        mask &= cu->get_memidx_intersect();
-
-      // select first common memory bank index if any
-      for (size_t idx=0; idx<mask.size(); ++idx) {
-        if (mask.test(idx)) {
-          m_cu_memidx = idx;
-          break;
-        }
+    // select first common memory bank index if any
+    auto mask = get_cu_memidx_mask();
+    for (size_t idx=0; idx<mask.size(); ++idx) {
+      if (mask.test(idx)) {
+        m_cu_memidx = idx;
+        break;
       }
     }
   }
   return m_cu_memidx;
 }
 
+device::memidx_bitmask_type
+device::
+get_cu_memidx_mask() const
+{
+  memidx_bitmask_type mask;
+  if (get_num_cus()) {
+    // compute intersection of all CU memory masks
+    mask.set();
+    for (auto& cu : get_cu_range())
+      mask &= cu->get_memidx_intersect();
+  }
+  return mask;
+}
+
 device::memidx_bitmask_type
 device::
 get_cu_memidx(kernel* kernel, int argidx) const
@@ -898,51 +990,84 @@ fill_buffer(memory* buffer, const void* pattern, size_t pattern_size, size_t off
   unmap_buffer(buffer,hbuf);
 }
 
+// Sync the spans of a rect transfer only.  The gaps between rows and
+// slices are not part of the transfer, their host copy can be older
+// than the device copy and vice versa.
+static void
+sync_spans(const rect_transfer& rect, xrt::device* xdevice,
+           const xrt::device::BufferObjectHandle& boh, xrt::hal::device::direction dir)
+{
+  for (auto& span : rect.get_spans())
+    xdevice->sync(boh,span.size,span.buffer_offset,dir,false);
+}
+
+void
+device::
+write_buffer_rect(memory* buffer, const rect_transfer& rect, const void* ptr)
+{
+  auto xdevice = get_xrt_device();
+  auto boh = buffer->get_buffer_object(this);
+
+  auto hbuf = xdevice->map(boh);
+  rect.copy_to_buffer(hbuf,ptr,xrt::config::get_rect_copy_threads());
+  xdevice->unmap(boh);
+
+  // Update unaligned ubuf if necessary
+  for (auto& span : rect.get_spans())
+    sync_to_ubuf(buffer,span.buffer_offset,span.size,xdevice,boh);
+
+  if (buffer->is_resident(this))
+    // Sync written spans to device
+    sync_spans(rect,xdevice,boh,xrt::hal::device::direction::HOST2DEVICE);
+}
+
+void
+device::
+read_buffer_rect(memory* buffer, const rect_transfer& rect, void* ptr)
+{
+  auto xdevice = get_xrt_device();
+  auto boh = buffer->get_buffer_object(this);
+
+  if (buffer->is_resident(this))
+    // Sync back spans to read from device
+    sync_spans(rect,xdevice,boh,xrt::hal::device::direction::DEVICE2HOST);
+
+  auto hbuf = xdevice->map(boh);
+  rect.copy_to_host(hbuf,ptr,xrt::config::get_rect_copy_threads());
+  xdevice->unmap(boh);
+
+  // Update unaligned ubuf if necessary
+  for (auto& span : rect.get_spans())
+    sync_to_ubuf(buffer,span.buffer_offset,span.size,xdevice,boh);
+}
+
+static rect_transfer
+image_rect(memory* image,const size_t* origin,const size_t* region,size_t row_pitch,size_t slice_pitch)
+{
+  auto bpp = image->get_image_bytes_per_pixel();
+  size_t image_origin[3] = {image->get_image_data_offset() + bpp*origin[0], origin[1], origin[2]};
+  size_t host_origin[3] = {0,0,0};
+  size_t bytes_region[3] = {bpp*region[0], region[1], region[2]};
+  return rect_transfer(image_origin,host_origin,bytes_region
+                       ,image->get_image_row_pitch(),image->get_image_slice_pitch()
+                       ,row_pitch,slice_pitch ? slice_pitch : row_pitch*region[1]);
+}
+
 static void
 rw_image(device* device,
-         memory* image,const size_t* origin,const size_t* region,size_t row_pitch,size_t slice_pitch
+         memory* image,const rect_transfer& rect
          ,char* read_to,const char* write_from)
 {
   auto boh = image->get_buffer_object(device);
   auto xdevice = device->get_xrt_device();
 
-  size_t image_offset = image->get_image_data_offset()
-    + image->get_image_bytes_per_pixel()*origin[0]
-    + image->get_image_row_pitch()*origin[1]
-    + image->get_image_slice_pitch()*origin[2];
-
-  if (!origin[0] && region[0]==image->get_image_width() && row_pitch==image->get_image_row_pitch()
-      && (region[2]==1
-          || (!origin[1] && region[1]==image->get_image_height() && slice_pitch==image->get_image_slice_pitch())
-          )
-      ) {
-    size_t sz = region[2]==1 ? row_pitch*region[1] : slice_pitch*region[2];
+  // One read or write per span of rows contiguous in both image and
+  // host memory
+  for (auto& span : rect.get_spans()) {
     if (read_to)
-      xdevice->read(boh,read_to,sz,image_offset,false);
+      xdevice->read(boh,read_to+span.host_offset,span.size,span.buffer_offset,false);
     else
-      xdevice->write(boh,write_from,sz,image_offset,false);
-  }
-  else {
-    size_t image_offset_tmp = image_offset;
-    for (unsigned int j=0; j<region[2]; ++j) {
-      size_t offset = image_offset_tmp;
-      for (unsigned int i=0; i<region[1]; ++i) {
-        if (read_to) {
-          xdevice->read(boh,read_to,image->get_image_bytes_per_pixel()*region[0],offset,false);
-          read_to += row_pitch;
-        }
-        else {
-          xdevice->write(boh,write_from,image->get_image_bytes_per_pixel()*region[0],offset, false);
-          write_from += row_pitch;
-        }
-        offset += image->get_image_row_pitch();
-      }
-      image_offset_tmp += image->get_image_slice_pitch();
-      if (read_to)
-        read_to += slice_pitch;
-      else
-        write_from += slice_pitch;
-    }
+      xdevice->write(boh,write_from+span.host_offset,span.size,span.buffer_offset,false);
   }
 }
 
@@ -950,13 +1075,15 @@ void
 device::
 write_image(memory* image,const size_t* origin,const size_t* region,size_t row_pitch,size_t slice_pitch,const void *ptr)
 {
+  auto rect = image_rect(image,origin,region,row_pitch,slice_pitch);
+
   // Write from ptr into image
-  rw_image(this,image,origin,region,row_pitch,slice_pitch,nullptr,static_cast<const char*>(ptr));
+  rw_image(this,image,rect,nullptr,static_cast<const char*>(ptr));
 
-  // Sync newly writte data to device if image is resident
+  // Sync newly written spans to device if image is resident
   if (image->is_resident(this)) {
     auto boh = image->get_buffer_object_or_error(this);
-    get_xrt_device()->sync(boh, image->get_size(), 0,xrt::hal::device::direction::HOST2DEVICE,false);
+    sync_spans(rect,get_xrt_device(),boh,xrt::hal::device::direction::HOST2DEVICE);
   }
 }
 
@@ -964,14 +1091,16 @@ void
 device::
 read_image(memory* image,const size_t* origin,const size_t* region,size_t row_pitch,size_t slice_pitch,void *ptr)
 {
-  // Sync back from device if image is resident
+  auto rect = image_rect(image,origin,region,row_pitch,slice_pitch);
+
+  // Sync back spans from device if image is resident
   if (image->is_resident(this)) {
     auto boh = image->get_buffer_object_or_error(this);
-    get_xrt_device()->sync(boh,image->get_size(),0,xrt::hal::device::direction::DEVICE2HOST,false);
+    sync_spans(rect,get_xrt_device(),boh,xrt::hal::device::direction::DEVICE2HOST);
   }
 
   // Now read from image into ptr
-  rw_image(this,image,origin,region,row_pitch,slice_pitch,static_cast<char*>(ptr),nullptr);
+  rw_image(this,image,rect,static_cast<char*>(ptr),nullptr);
 }
 
 void
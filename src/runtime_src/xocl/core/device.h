@@ -21,6 +21,8 @@
 #include "xocl/core/refcount.h"
 #include "xocl/core/error.h"
 #include "xocl/core/compute_unit.h"
+#include "xocl/core/placement.h"
+#include "xocl/core/rect.h"
 #include "xocl/xclbin/xclbin.h"
 #include "xrt/device/device.h"
 
@@ -278,6 +280,40 @@ public:
   xrt::device::BufferObjectHandle
   allocate_buffer_object(memory* mem, uint64_t memidx);
 
+  /**
+   * Allocate and return buffer object in one of several memory banks
+   *
+   * The banks are tried in the order chosen by the placement policy
+   * of the context of the memory object.
+   *
+   * @param mem
+   *   The cl_mem object to allocate a buffer object from.
+   * @param memidx_mask
+   *   The memory banks the buffer can be allocated in.
+   * @return
+   *   The buffer object that was created, throws std::bad_alloc if
+   *   none of the banks can hold the buffer.
+   */
+  xrt::device::BufferObjectHandle
+  place_buffer_object(memory* mem, const memidx_bitmask_type& memidx_mask);
+
+  /**
+   * Get size and usage of memory banks
+   *
+   * The size is from the mem topology of the current xclbin and the
+   * usage is as reported by the driver.  Either is 0 if unknown.
+   * Banks not used by the xclbin are skipped.
+   *
+   * @param memidx_mask
+   *   The memory banks to report
+   * @param usage
+   *   Query bank usage from the driver, else usage is 0
+   * @return
+   *   Bank information ordered by memory index
+   */
+  std::vector<placement_policy::bank_info>
+  get_bank_info(const memidx_bitmask_type& memidx_mask, bool usage=true) const;
+
   /**
    * Special interface to allocate a buffer object undconditionally
    *
@@ -341,6 +377,15 @@ public:
   int
   get_cu_memidx() const;
 
+  /**
+   * Get the indices of memory banks connected to all CUs in this device
+   *
+   * @return Bitset with bank indices connected to all arguments of all
+   *  CUs, none() if there are no CUs or no common banks
+   */
+  memidx_bitmask_type
+  get_cu_memidx_mask() const;
+
   /**
    * Get the indices of memory banks which CU argument is connected to
    * for specified kernel.
@@ -415,6 +460,36 @@ public:
   void
   read_buffer(memory* buffer, size_t offset, size_t size, void* data);
 
+  /**
+   * Write rectangular region from host memory to buffer
+   *
+   * @param buffer
+   *  Buffer write to.  The range of the buffer touched by the region
+   *  is synced to device after write if and only if the buffer is
+   *  currently resident on the device.
+   * @param rect
+   *  Planned transfer of the region
+   * @param ptr
+   *  The host memory to write from
+   */
+  void
+  write_buffer_rect(memory* buffer, const rect_transfer& rect, const void* ptr);
+
+  /**
+   * Read rectangular region from buffer to host memory
+   *
+   * @param buffer
+   *  Buffer read from.  The range of the buffer touched by the region
+   *  is synced from device first if and only if the buffer is
+   *  currently resident on the device.
+   * @param rect
+   *  Planned transfer of the region
+   * @param ptr
+   *  The host memory to read into
+   */
+  void
+  read_buffer_rect(memory* buffer, const rect_transfer& rect, void* ptr);
+
   /**
    * Copy size data from from src buffer to dst buffer at specified offsets
    *
@@ -479,6 +554,16 @@ public:
   ssize_t
   read_stream(xrt::device::stream_handle stream, void* ptr, size_t offset, size_t size, xrt::device::stream_xfer_flags flags);
 
+  // Scatter-gather request, see xrt::hal::device::writeStream
+  ssize_t
+  write_stream(xrt::device::stream_handle stream, const xrt::device::stream_xfer_buf* bufs, size_t count, xrt::device::stream_xfer_flags flags, void* priv_data);
+
+  ssize_t
+  read_stream(xrt::device::stream_handle stream, const xrt::device::stream_xfer_buf* bufs, size_t count, xrt::device::stream_xfer_flags flags, void* priv_data);
+
+  int
+  poll_streams(xrt::device::stream_xfer_completion* comps, int min_compl, int max_compl, int* actual_compl, int timeout);
+
   xrt::device::stream_buf
   alloc_stream_buf(size_t size, xrt::device::stream_buf_handle* handle);
 
@@ -703,6 +788,19 @@ private:
   xrt::device::BufferObjectHandle
   alloc(memory* mem);
 
+  /**
+   * Order memory banks per placement policy of context of memory
+   *
+   * @param mem
+   *  Memory object to place
+   * @param memidx_mask
+   *  The memory banks the buffer can be allocated in
+   * @return
+   *  Memory indices in the order allocation should be tried
+   */
+  std::vector<placement_policy::memidx_type>
+  rank_banks(memory* mem, const memidx_bitmask_type& memidx_mask) const;
+
 
 private:
   struct mapinfo {
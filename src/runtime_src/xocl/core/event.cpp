@@ -16,7 +16,10 @@
 
 #include "event.h"
 #include "command_queue.h"
+#include "command_graph.h"
 #include "context.h"
+#include "device.h"
+#include "wait.h"
 
 #include "xrt/config.h"
 #include "xrt/util/task.h"
@@ -24,6 +27,7 @@
 
 #include "xocl/api/plugin/xdp/profile.h"
 
+#include <algorithm>
 #include <iostream>
 #include <cassert>
 
@@ -50,6 +54,77 @@ to_string(cl_int status)
 
 static xocl::event::event_callback_list sg_constructor_callbacks;
 static xocl::event::event_callback_list sg_destructor_callbacks;
+
+// Recycled storage for events.  Events are constructed and destroyed
+// at the rate of enqueued commands, often in different threads, so
+// storage of deleted events is kept on free lists per size class
+// rather than returned to the heap.  The size classes cover all event
+// types (event_with_profiling, event_with_debugging, etc.), larger
+// allocations go to the heap.
+class event_pool
+{
+  static constexpr size_t granularity = 64;
+  static constexpr size_t classes = 16;
+  static constexpr size_t max_free = 4096;
+
+  struct block { block* next; };
+
+  std::mutex m_mutex;
+  block* m_free[classes] = {nullptr};
+  size_t m_count[classes] = {0};
+
+  static size_t
+  size_class(size_t sz)
+  {
+    return (sz+granularity-1)/granularity;
+  }
+
+public:
+  void*
+  allocate(size_t sz)
+  {
+    auto idx = size_class(sz);
+    if (idx>=classes)
+      return ::operator new(sz);
+
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      if (auto b = m_free[idx]) {
+        m_free[idx] = b->next;
+        --m_count[idx];
+        return b;
+      }
+    }
+
+    return ::operator new(idx*granularity);
+  }
+
+  void
+  deallocate(void* p, size_t sz)
+  {
+    auto idx = size_class(sz);
+    if (idx<classes) {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      if (m_count[idx]<max_free) {
+        auto b = static_cast<block*>(p);
+        b->next = m_free[idx];
+        m_free[idx] = b;
+        ++m_count[idx];
+        return;
+      }
+    }
+    ::operator delete(p);
+  }
+};
+
+// Never destroyed, events may be deleted during static destruction
+static event_pool*
+get_event_pool()
+{
+  static auto pool = new event_pool;
+  return pool;
+}
+
 } // namespace
 
 namespace xocl {
@@ -72,6 +147,14 @@ event::
 event(command_queue* cq, context* ctx, cl_command_type cmd, cl_uint num_deps, const cl_event* deps)
   : event(cq,ctx,cmd)
 {
+  // Recorded events are reset by every replay of their graph, only
+  // events recorded in the same graph can depend on them
+  for (auto dep : get_range(deps,deps+num_deps)) {
+    auto graph = xocl(dep)->m_graph;
+    if (graph && !graph->is_recording())
+      throw xocl::error(CL_INVALID_EVENT_WAIT_LIST,"event(" + xocl(dep)->get_suid() + ") is recorded in command graph");
+  }
+
   for (auto dep : get_range(deps,deps+num_deps)) {
     XOCL_DEBUG(std::cout,"event(",m_uid,") depends on event(",xocl(dep)->get_uid(),")\n");
     xocl(dep)->chain(this);
@@ -80,6 +163,20 @@ event(command_queue* cq, context* ctx, cl_command_type cmd, cl_uint num_deps, co
   profile::log_dependencies(this, num_deps, deps);
 }
 
+void*
+event::
+operator new(size_t sz)
+{
+  return get_event_pool()->allocate(sz);
+}
+
+void
+event::
+operator delete(void* p, size_t sz)
+{
+  get_event_pool()->deallocate(p,sz);
+}
+
 event::
 ~event()
 {
@@ -102,6 +199,9 @@ set_status(cl_int s)
   bool complete = (s==CL_COMPLETE);
   ptr<xocl::event> retain(complete?this:nullptr);
 
+  std::condition_variable* waiters = nullptr;
+  bool issued = false;
+  bool early = false;
   {
     std::lock_guard<std::mutex> lk(m_mutex);
 
@@ -117,6 +217,9 @@ set_status(cl_int s)
 
     std::swap(m_status,s);
     time_set(m_status);
+    waiters = m_waiters.get();
+    issued = m_issued;
+    early = m_early;
   } // lk
 
   //Make the profile logging calls before notifying the event
@@ -131,13 +234,29 @@ set_status(cl_int s)
     // proceed (or exit main() as in CR-1002026) with the assumption that callback finished.
     run_callbacks(CL_COMPLETE);
 
-    m_event_complete.notify_all();
+    // A thread that blocks after status was changed sees CL_COMPLETE
+    m_signaled = true;
+    if (waiters)
+      waiters->notify_all();
 
     // remove the completed event from queue (submitted queue)
     // before event_scheduler attempts to submit next event.
     queue_remove();   // 1 (order matters)
     for (auto& c : m_chain) // not a race, since m_chain is blocked by CL_COMPLETE
-      c->submit();
+      c->submit(issued,early ? &m_device_wait_list : nullptr);
+
+    // Device commands are no longer referenced by other events
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      std::lock_guard<std::mutex> dlk(m_device_mutex);
+      m_issued_commands.clear();
+      m_device_wait_list.clear();
+    }
+
+    // Recorded event of a replayed graph, this must be last access
+    // to graph as it may complete the replay
+    if (m_graph)
+      m_graph->complete(this);
   }
 
   return s;
@@ -147,6 +266,11 @@ bool
 event::
 queue(bool blocking_submit)
 {
+  // A command queue that is recording a command graph captures the
+  // event, it is queued when the graph is replayed
+  if (is_hard() && m_command_queue->record(this))
+    return true;
+
   bool queued = false;
   {
     std::lock_guard<std::mutex> lk(m_mutex);
@@ -167,8 +291,10 @@ queue(bool blocking_submit)
   if (blocking_submit) {
     // block current thread until event has truly submitted
     std::unique_lock<std::mutex> lk(m_mutex);
+    if (m_status==CL_QUEUED && !m_waiters)
+      m_waiters = xrt::make_unique<std::condition_variable>();
     while (m_status==CL_QUEUED)
-      m_event_submitted.wait(lk);
+      m_waiters->wait(lk);
   }
 
   return queued;
@@ -176,30 +302,151 @@ queue(bool blocking_submit)
 
 bool
 event::
-submit()
+submit(bool dep_issued, const command_list_type* dep_wait_list)
 {
+  std::condition_variable* waiters = nullptr;
   {
     std::lock_guard<std::mutex> lk(m_mutex);
+    if (!m_early) {
+      std::lock_guard<std::mutex> dlk(m_device_mutex);
+      if (dep_issued)
+        --m_issued_wait_count;
+      if (dep_wait_list)
+        m_device_wait_list.insert(m_device_wait_list.end(),dep_wait_list->begin(),dep_wait_list->end());
+    }
+
     if (--m_wait_count) {
-      XOCL_DEBUG(std::cout,"event(",m_uid,") cannot submit wait_count(",m_wait_count,")\n");
+      if (!can_submit_early()) {
+        XOCL_DEBUG(std::cout,"event(",m_uid,") cannot submit wait_count(",m_wait_count,")\n");
+        return false;
+      }
+    }
+    else if (m_early) {
+      XOCL_DEBUG(std::cout,"event(",m_uid,") was submitted ahead of dependencies\n");
       return false;
     }
 
-    XOCL_UNUSED auto submitted = queue_submit();
-    assert(submitted);
+    waiters = set_submitted();
+  }
+
+  run_submitted(waiters);
+  return true;
+}
+
+bool
+event::
+can_submit_early() const
+{
+  if (!m_device_chain_predicate || m_early || m_graph || m_status!=CL_QUEUED || m_chain.empty())
+    return false;
+
+  // The forwarded device commands are honored only by NDRange events
+  if (!std::all_of(m_chain.begin(),m_chain.end(),[](const ptr<event>& ev) { return ev->get_execution_context()!=nullptr; }))
+    return false;
+
+  {
+    std::lock_guard<std::mutex> dlk(m_device_mutex);
+    if (m_issued_wait_count<0 || static_cast<unsigned int>(m_issued_wait_count)!=m_wait_count)
+      return false;
 
-    XOCL_DEBUG(std::cout,"event(",m_uid,") [",to_string(m_status),"->",to_string(CL_SUBMITTED),"]\n");
-    m_status = CL_SUBMITTED;
-    profile::log(this,m_status);
-    time_set(CL_SUBMITTED);
+    // The device scheduler can wait only on commands of its own device
+    for (auto& ev : m_chain) {
+      auto xdevice = ev->get_command_queue()->get_device()->get_xrt_device();
+      if (!std::all_of(m_device_wait_list.begin(),m_device_wait_list.end(),
+                       [xdevice](const execution_context::command_type& cmd) { return cmd->get_device()==xdevice; }))
+        return false;
+    }
   }
 
-  m_event_submitted.notify_all();
+  return m_device_chain_predicate();
+}
+
+std::condition_variable*
+event::
+set_submitted()
+{
+  XOCL_UNUSED auto submitted = queue_submit();
+  assert(submitted);
+
+  m_early = (m_wait_count>0);
+  m_device_chain_predicate = nullptr;
+  XOCL_DEBUG(std::cout,"event(",m_uid,") [",to_string(m_status),"->",to_string(CL_SUBMITTED),"]",m_early ? " early" : "","\n");
+  m_status = CL_SUBMITTED;
+  profile::log(this,m_status);
+  time_set(CL_SUBMITTED);
+  return m_waiters.get();
+}
+
+void
+event::
+run_submitted(std::condition_variable* waiters)
+{
+  if (waiters)
+    waiters->notify_all();
 
   if (is_hard())
     trigger_enqueue_action();
+}
 
-  return true;
+void
+event::
+set_device_chain_predicate(device_chain_predicate_type&& pred)
+{
+  std::condition_variable* waiters = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_device_chain_predicate = std::move(pred);
+    if (!m_wait_count || !can_submit_early())
+      return;
+    waiters = set_submitted();
+  }
+
+  run_submitted(waiters);
+}
+
+void
+event::
+issue(const command_list_type& cmds)
+{
+  event_vector_type chain;
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    if (m_graph || m_status==CL_COMPLETE)
+      return;
+    m_issued = true;
+    m_issued_commands = cmds;
+    chain = m_chain;
+  }
+
+  // An event chained after this point sees m_issued, see chain()
+  for (auto& c : chain)
+    c->dependency_issued(cmds);
+}
+
+void
+event::
+dependency_issued(const command_list_type& cmds)
+{
+  std::condition_variable* waiters = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+
+    // Only events that are not yet submitted care
+    if (m_status!=-1 && m_status!=CL_QUEUED)
+      return;
+
+    {
+      std::lock_guard<std::mutex> dlk(m_device_mutex);
+      ++m_issued_wait_count;
+      m_device_wait_list.insert(m_device_wait_list.end(),cmds.begin(),cmds.end());
+    }
+
+    if (!can_submit_early())
+      return;
+    waiters = set_submitted();
+  }
+
+  run_submitted(waiters);
 }
 
 bool
@@ -209,36 +456,27 @@ abort(cl_int status,bool fatal)
   if (status>=0)
     throw xocl::error(CL_INVALID_VALUE,"event::abort() called with non negative value");
 
-  // This function feels overly complicated
-  std::lock_guard<std::mutex> lk(m_mutex);
-
-  // Collect all events in current context
-  std::vector<event*> events;
-  for (auto q : m_context->get_queue_range())
-    range_copy(q->get_event_range(),std::back_inserter(events));
-
-  // Abort the chain of events
-  std::vector<event*> aborts(1,this);
+  // Abort this event and the events that depend on it.  The events
+  // that depend on an event are the events it chains, so there is
+  // no need to look at other events in the context.
+  std::vector<ptr<event>> aborts(1,this);
   while (aborts.size()) {
-    auto abort_ev = aborts.back();
+    auto abort_ev = std::move(aborts.back());
     aborts.pop_back();
-    XOCL_DEBUG(std::cout,"event(",m_uid,") [",to_string(m_status),"->",to_string(status),"]\n");
+
+    std::lock_guard<std::mutex> lk(abort_ev->m_mutex);
+    XOCL_DEBUG(std::cout,"event(",abort_ev->m_uid,") [",to_string(abort_ev->m_status),"->",to_string(status),"]\n");
 
     // Only abort queued events unless fatal abort
-    if (abort_ev==this && (fatal || abort_ev->m_status==CL_QUEUED)) {
+    if (fatal || abort_ev->m_status==CL_QUEUED) {
       abort_ev->m_status = status;  // abort ev
       abort_ev->queue_abort(fatal); // remove from queue if any
-      m_event_complete.notify_all();
-    }
-    else if (abort_ev!=this) {
-      // recursively abort event that depends on this
-      abort_ev->abort(status,fatal);
+      abort_ev->m_signaled = true;
+      if (abort_ev->m_waiters)
+        abort_ev->m_waiters->notify_all();
     }
 
-    for (auto ev : events) {
-      if (ev->waits_on(abort_ev))
-        aborts.push_back(ev);
-    }
+    aborts.insert(aborts.end(),abort_ev->m_chain.begin(),abort_ev->m_chain.end());
   }
 
   return true;
@@ -249,9 +487,22 @@ event::
 wait() const
 {
   XOCL_DEBUG(std::cout,"xocl::event::wait(",m_uid,")\n");
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    if (m_status==-1 && m_graph && !m_graph->is_replayed())
+      throw xocl::error(CL_INVALID_OPERATION,"event(" + get_suid() + ") is recorded in command graph that was never enqueued");
+    if (m_status<=0)
+      return;
+  }
+
+  // Spin per wait policy before blocking
+  spin_wait([this] { return m_signaled.load(); });
+
   std::unique_lock<std::mutex> lk(m_mutex);
+  if (m_status>0 && !m_waiters)
+    m_waiters = xrt::make_unique<std::condition_variable>();
   while (m_status>0)  // (<0 => aborted) (==0 => CL_COMPLETE)
-    m_event_complete.wait(lk);
+    m_waiters->wait(lk);
 }
 
 void
@@ -328,21 +579,13 @@ chain(event* ev)
     return;
   m_chain.push_back(ev);
   ++ev->m_wait_count;
-}
 
-bool
-event::
-chains(const event* ev) const
-{
-  std::lock_guard<std::mutex> lk(m_mutex);
-  return std::find(m_chain.begin(),m_chain.end(),ev)!=m_chain.end();
-}
-
-bool
-event::
-waits_on(const event* ev) const
-{
-  return ev->chains(this);
+  // Device commands of this event are already issued, see issue()
+  if (m_issued) {
+    std::lock_guard<std::mutex> dlk(ev->m_device_mutex);
+    ++ev->m_issued_wait_count;
+    ev->m_device_wait_list.insert(ev->m_device_wait_list.end(),m_issued_commands.begin(),m_issued_commands.end());
+  }
 }
 
 bool
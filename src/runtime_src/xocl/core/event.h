@@ -27,9 +27,15 @@
 
 #include "xrt/config.h"
 
+#include <boost/container/small_vector.hpp>
+#include <boost/intrusive/list.hpp>
+
 #include <vector>
 #include <functional>
 #include <iostream>
+#include <memory>
+#include <atomic>
+#include <condition_variable>
 
 namespace xocl {
 
@@ -48,15 +54,25 @@ class event : public refcount, public _cl_event
   using callback_list = std::vector<callback_function_type>;
 
   friend class command_queue;
+  friend class command_graph;
+
+  // Link in the command queue's list of queued and submitted events
+  boost::intrusive::list_member_hook<> m_queue_hook;
 
 public:
-  using event_vector_type = std::vector<ptr<event>>;
+  // Most events chain one or two events, which are stored inline
+  using event_vector_type = boost::container::small_vector<ptr<event>,2>;
   using event_iterator_type = ptr_iterator<event_vector_type::iterator>;
 
+  using queue_list_type = boost::intrusive::list
+    <event,boost::intrusive::member_hook<event,boost::intrusive::list_member_hook<>,&event::m_queue_hook>>;
+
   using event_callback_type = std::function<void(event*)>;
   using event_callback_list = std::vector<event_callback_type>;
 
   using action_enqueue_type = std::function<void (event*)>;
+  using device_chain_predicate_type = std::function<bool ()>;
+  using command_list_type = std::vector<execution_context::command_type>;
   using action_profile_type = std::function<void (event*, cl_int, const std::string&)>;
   using action_debug_type = std::function<void (event*)>;
 
@@ -64,6 +80,15 @@ public:
   event(command_queue* cq, context* ctx, cl_command_type cmd, cl_uint num_deps, const cl_event* deps);
   virtual ~event();
 
+  /**
+   * Events are allocated from recycled storage, see event.cpp
+   */
+  static void*
+  operator new(size_t sz);
+
+  static void
+  operator delete(void* p, size_t sz);
+
   /**
    */
   unsigned int
@@ -376,6 +401,50 @@ public:
     return m_execution_context.get();
   }
 
+  /**
+   * Allow this event to be submitted ahead of its dependencies
+   *
+   * The event is submitted without waiting for its dependencies to
+   * complete if all incomplete dependencies have issued their device
+   * commands (see issue()) and the predicate returns true.  The
+   * predicate must ensure that the event completes without waiting
+   * for the device.  The event forwards the issued commands of its
+   * dependencies to the events it chains, which must be NDRange
+   * events on the same device as the forwarded commands, and that
+   * start their commands on the device only after the forwarded
+   * commands complete.  A chained NDRange event is then submitted and
+   * reports CL_RUNNING before its dependencies have completed.
+   *
+   * The event is submitted by this function if possible.
+   */
+  void
+  set_device_chain_predicate(device_chain_predicate_type&& pred);
+
+  /**
+   * Record that the execution context of this event has issued all
+   * its commands to the device scheduler
+   *
+   * The event completes when the argument commands complete, events
+   * that wait on this event can be submitted ahead of its completion.
+   *
+   * @param cmds
+   *   The commands of this event that may still be running
+   */
+  void
+  issue(const command_list_type& cmds);
+
+  /**
+   * Get commands that must complete on device before commands of
+   * this event can start
+   *
+   * The list is not changed once the event is submitted.
+   */
+  const command_list_type&
+  get_device_wait_list() const
+  {
+    return m_device_wait_list;
+  }
+
   /**
    * Register callback function for event construction
    *
@@ -405,28 +474,51 @@ private:
   /**
    * Submit this event for execution if possible
    *
+   * Called when the event is queued and when a dependency completes.
+   *
+   * @param dep_issued
+   *   The completed dependency had issued its device commands
+   * @param dep_wait_list
+   *   Device commands forwarded by a dependency that was submitted
+   *   ahead of its own dependencies
    * @return
    *   true if submitted, false otherwise.
    */
   bool
-  submit();
+  submit(bool dep_issued=false, const command_list_type* dep_wait_list=nullptr);
+
+  /**
+   * A dependency of this event has issued its device commands
+   */
+  void
+  dependency_issued(const command_list_type& cmds);
 
   /**
-   * Check if this event chains argument event
+   * Check if this event can be submitted ahead of its dependencies
+   *
+   * Pre-condition: event is locked
    */
   bool
-  chains(const event* ev) const;
+  can_submit_early() const;
 
   /**
-   * Check if this event depends on argument event
+   * Change status to CL_SUBMITTED
+   *
+   * Pre-condition: event is locked
    *
-   * @param ev
-   *   Event dependency to check for
    * @return
-   *   true if argument event's chain contains this
+   *   Waiters to notify once the event is unlocked
    */
-  bool
-  waits_on(const event* ev) const;
+  std::condition_variable*
+  set_submitted();
+
+  /**
+   * Notify waiters and run the enqueue action of submitted event
+   *
+   * Pre-condition: event is not locked
+   */
+  void
+  run_submitted(std::condition_variable* waiters);
 
   /**
    * If a profiling event, then record time at status change
@@ -509,8 +601,14 @@ private:
   cl_int m_status = -1;
   cl_command_type m_command_type = 0;
   mutable std::mutex m_mutex;
-  mutable std::condition_variable m_event_complete;
-  mutable std::condition_variable m_event_submitted;
+
+  // Notified when event is submitted or completes.  Created when a
+  // thread first blocks on this event, most events are never waited on.
+  mutable std::unique_ptr<std::condition_variable> m_waiters;
+
+  // Set when waiters are notified that the event has completed or
+  // was aborted.  Spinning waiters poll this without locking.
+  std::atomic<bool> m_signaled {false};
 
   // List of callback functions. On heap to avoid
   // allocation unless needed.
@@ -519,9 +617,35 @@ private:
   // List of chained events (events to submit upon completion)
   event_vector_type m_chain;
 
+  // Command graph that recorded this event, if any
+  command_graph* m_graph = nullptr;
+
   // Number of events this event is waiting on.  This includes
   // explicit event depedencies and events that chain this
   unsigned int m_wait_count = 0;
+
+  // Protects m_issued_wait_count and m_device_wait_list, which are
+  // updated by chain() without locking this event.  Lock order is
+  // m_mutex before m_device_mutex.
+  mutable std::mutex m_device_mutex;
+
+  // Number of events this event is waiting on that have issued all
+  // their device commands.  Can be transiently negative when an
+  // issued dependency completes before it notifies this event.
+  int m_issued_wait_count = 0;
+
+  // Set when the execution context of this event has issued all its
+  // commands, which are kept until the event completes
+  bool m_issued = false;
+  command_list_type m_issued_commands;
+
+  // Commands of dependencies that must complete on device before the
+  // commands of this event start
+  command_list_type m_device_wait_list;
+  device_chain_predicate_type m_device_chain_predicate;
+
+  // Submitted ahead of its dependencies
+  bool m_early = false;
 };
 
 /**
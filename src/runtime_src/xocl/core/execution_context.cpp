@@ -233,13 +233,30 @@ execution_context(device* device
 
   // Bind the kernel arguments to this context so that the same kernel
   // object can be reused while this context is executing
-  for (auto& arg : m_kernel->get_argument_range())
-    m_kernel_args.push_back(arg->clone());
+  bind_arguments();
 
   // Compute units to use
   add_compute_units(device);
 }
 
+void
+execution_context::
+bind_arguments()
+{
+  m_kernel_args = m_kernel->get_argument_snapshot();
+}
+
+void
+execution_context::
+reset()
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  assert(m_active.empty());
+  m_cu_global_id = {{0,0,0}};
+  m_cu_group_id = {{0,0,0}};
+  m_done = false;
+}
+
 void
 execution_context::
 add_compute_units(device* device)
@@ -290,7 +307,13 @@ write(const command_type& cmd)
       ostr << "0x" << std::uppercase << std::setfill('0') << std::setw(8) << std::hex << packet[i] << std::dec << "\n";
   }
 
-  xrt::scheduler::schedule(cmd);
+  // Commands of events this context waits on that may still be
+  // running on the device, see xocl::event::issue()
+  auto& waitlist = m_event->get_device_wait_list();
+  if (waitlist.empty())
+    xrt::scheduler::schedule(cmd);
+  else
+    xrt::scheduler::schedule(cmd,waitlist);
   return true;
 }
 
@@ -331,6 +354,15 @@ get_compute_unit(unsigned int cu_idx) const
   return nullptr;
 }
 
+void
+execution_context::
+remove_active(const xrt::command* cmd)
+{
+  auto itr = std::find_if(m_active.begin(),m_active.end(),[cmd](const command_type& c) { return c.get()==cmd; });
+  assert(itr!=m_active.end());
+  m_active.erase(itr);
+}
+
 void
 execution_context::
 update_work()
@@ -368,7 +400,7 @@ start()
   auto cmd = conformance::on()
     ? std::make_shared<start_kernel_conformance>(xdevice,this)
     : std::make_shared<start_kernel>(xdevice,this);
-  ++m_active;
+  m_active.push_back(cmd);
   auto& packet = cmd->get_packet();
 
   // Encode CUs in cu bitmasks with bits in position according to the
@@ -387,7 +419,7 @@ start()
 
   // Push kernel args
   xocl::memory* printf_buffer = nullptr;
-  for (auto& arg : m_kernel_args) {
+  for (auto& arg : *m_kernel_args) {
     if (arg->is_printf()) {
       printf_buffer = arg->get_memory_object();
       assert(printf_buffer);
@@ -482,14 +514,15 @@ start()
 
 bool
 execution_context::
-done(const xrt::command*)
+done(const xrt::command* cmd)
 {
   // Care must be taken not to mark event complete and later reference
   // any data members of context which is owned (and deleted) with event
   bool ctx_done = false;
   {
     std::lock_guard<std::mutex> lk(m_mutex);
-    if (--m_active==0 && m_done)
+    remove_active(cmd);
+    if (m_active.empty() && m_done)
       ctx_done=true;
   }
 
@@ -509,33 +542,49 @@ bool
 execution_context::
 execute()
 {
-  // Mutual exclusion as multiple start_kernel commands could call execute.
-  std::lock_guard<std::mutex> lk(m_mutex);
+  // Commands that are active when the last workgroup is scheduled
+  std::vector<command_type> issued;
+  ptr<event> retain;
+  {
+    // Mutual exclusion as multiple start_kernel commands could call execute.
+    std::lock_guard<std::mutex> lk(m_mutex);
 
-  // Conformance mode hook
-  if (conformance::on()) {
-    conformance_execute();
-    assert(m_done);
-  }
+    // Conformance mode hook
+    if (conformance::on()) {
+      conformance_execute();
+      assert(m_done);
+    }
 
-  if (m_done)
-    return true;
+    if (m_done)
+      return true;
+
+    // Schedule workgroups.  But don't blindly schedule all workgroups
+    // because that would fill the command queue with commands that
+    // compete for same CUs and block (CQ full) other kernel calls that
+    // may want to use other CUs.
+    //
+    // In order to keep scheduler busy, we need more than just one
+    // workgroup at a time, so here we try to ensure that the scheduled
+    // commands at any given time is twice the number of available CUs.
+    auto limit = 2*m_cus.size();
+    for (size_t i=m_active.size(); !m_done && i<limit; ++i) {
+      start();
+      update_work();
+    }
 
-  // Schedule workgroups.  But don't blindly schedule all workgroups
-  // because that would fill the command queue with commands that
-  // compete for same CUs and block (CQ full) other kernel calls that
-  // may want to use other CUs.
-  //
-  // In order to keep scheduler busy, we need more than just one
-  // workgroup at a time, so here we try to ensure that the scheduled
-  // commands at any given time is twice the number of available CUs.
-  auto limit = 2*m_cus.size();
-  for (size_t i=m_active; !m_done && i<limit; ++i) {
-    start();
-    update_work();
+    if (!m_done || m_active.empty())
+      return m_done;
+
+    // The event cannot complete while commands are active, retain it
+    // so that it (and this context) remains alive after unlocking
+    issued = m_active;
+    retain = m_event;
   }
 
-  return m_done;
+  // All workgroups are scheduled, events that wait on this event can
+  // be submitted with the issued commands as device wait list
+  retain->issue(issued);
+  return true;
 }
 
 ////////////////////////////////////////////////////////////////
@@ -543,7 +592,7 @@ execute()
 ////////////////////////////////////////////////////////////////
 bool
 execution_context::
-conformance_done(const xrt::command*)
+conformance_done(const xrt::command* cmd)
 {
   // Global conformance lock
   std::lock_guard<std::recursive_mutex> lk(conformance::s_mutex);
@@ -553,7 +602,8 @@ conformance_done(const xrt::command*)
   bool ctx_done = false;
   {
     std::lock_guard<std::mutex> lk(m_mutex);
-    if (--m_active==0) {
+    remove_active(cmd);
+    if (m_active.empty()) {
       assert(m_done);
       conformance::remove(this);
       ctx_done = true;
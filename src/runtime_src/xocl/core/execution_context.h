@@ -88,18 +88,18 @@ private:
   // The device associated with this context
   device* m_device;
 
-  // Kernel state
-  using argument_vector_type = std::vector<std::unique_ptr<xocl::kernel::argument>>;
-  using argument_iterator_type = argument_vector_type::const_iterator;
-  argument_vector_type m_kernel_args;
+  // Kernel state, shared with the kernel and other contexts
+  // launched with the same argument values
+  using argument_iterator_type = xocl::kernel::argument_iterator_type;
+  xocl::kernel::argument_snapshot_type m_kernel_args;
 
   // The context maintains a list of kernel compute units represented
   // by xcl::cu.  These cus (their base addresses) are used in the command
   // that starts the mbs. 
   std::vector<const compute_unit*> m_cus;
 
-  // Number of active start_kernel commands in this context
-  size_t m_active = 0;
+  // Active start_kernel commands in this context
+  std::vector<command_type> m_active;
 
   // Flag to indicate the execution context has no more work 
   // to be scheduled
@@ -125,6 +125,14 @@ private:
   void
   update_work();
 
+  /**
+   * Remove a done start_kernel command from active commands
+   *
+   * Pre-condition: context is locked
+   */
+  void
+  remove_active(const xrt::command* cmd);
+
   void
   start();
 
@@ -209,6 +217,12 @@ public:
     return m_kernel.get();
   }
 
+  kernel*
+  get_kernel()
+  {
+    return m_kernel.get();
+  }
+
   /**
    * Get the kernel event associated with this context
    *
@@ -248,6 +262,25 @@ public:
   bool
   execute();
 
+  /**
+   * Bind the current kernel argument values to this context.
+   *
+   * Arguments are bound when the context is constructed, and again
+   * when a recorded context is replayed after its kernel arguments
+   * have changed.
+   */
+  void
+  bind_arguments();
+
+  /**
+   * Reset a completed context for execution of all work groups again.
+   *
+   * Used when the command graph that recorded the context's event is
+   * replayed.
+   */
+  void
+  reset();
+
 private:
   // Call back for start_kernel_conformance comands
   bool
@@ -103,11 +103,11 @@ set(size_t size, const void* cvalue)
   if (size != m_sz)
     throw error(CL_INVALID_ARG_SIZE,"Invalid scalar argument size, expected "
                 + std::to_string(m_sz) + " got " + std::to_string(size));
-  // construct vector from iterator range.
+  // construct value from iterator range.
   // the value can be gathered with m_value.data()
   // the value bytes can be manipulated with std:: algorithms
-  auto value = const_cast<void*>(cvalue);
-  m_value = { reinterpret_cast<uint8_t*>(value), reinterpret_cast<uint8_t*>(value) + size };
+  auto value = reinterpret_cast<const uint8_t*>(cvalue);
+  m_value.assign(value,value+size);
   m_set = true;
 }
 
@@ -378,6 +378,37 @@ get_context() const
   return m_program->get_context();
 }
 
+kernel::argument_snapshot_type
+kernel::
+get_argument_snapshot() const
+{
+  std::lock_guard<std::mutex> lk(m_snapshot_mutex);
+  if (!m_snapshot) {
+    auto snapshot = std::make_shared<std::vector<std::shared_ptr<const argument>>>();
+    snapshot->reserve(m_indexed_args.size()+m_printf_args.size()+m_progvar_args.size());
+    for (auto& arg : get_argument_range())
+      snapshot->push_back(arg);
+    m_snapshot = std::move(snapshot);
+  }
+  return m_snapshot;
+}
+
+kernel::argument_value_type&
+kernel::
+writable(argument_value_type& arg)
+{
+  {
+    std::lock_guard<std::mutex> lk(m_snapshot_mutex);
+    m_snapshot.reset();
+  }
+
+  // An argument referenced only by this kernel cannot be shared
+  // again behind our back, otherwise copy on write
+  if (arg.use_count()>1)
+    arg = arg->clone();
+  return arg;
+}
+
 std::vector<std::string>
 kernel::
 get_instance_names() const
@@ -23,7 +23,10 @@
 #include "xocl/xclbin/xclbin.h"
 
 #include "xrt/util/td.h"
+#include <boost/container/small_vector.hpp>
 #include <limits>
+#include <memory>
+#include <mutex>
 
 #include <iostream>
 
@@ -111,10 +114,10 @@ public:
     virtual ~argument() {}
 
     /**
-     * Clone an argument when a kernel object is bound to an
-     * execution context.   This allows the same kernel object
-     * to be used by multiple contexts at the same time, per
-     * OpenCL requirements.
+     * Clone an argument that is changed while it is referenced by
+     * an argument snapshot bound to an execution context.  This
+     * allows the same kernel object to be used by multiple contexts
+     * at the same time, per OpenCL requirements.
      *
      * Asserts that the argument has been set, otherwise
      * it makes no sense to clone it.
@@ -250,7 +253,9 @@ public:
     { return arginfo_range_type(m_components.begin(),m_components.end()); }
   private:
     size_t m_sz;
-    std::vector<uint8_t> m_value;
+
+    // inline storage for up to 16 bytes (long2, int4, etc)
+    boost::container::small_vector<uint8_t,16> m_value;
 
     // components of the argument (long2, int4, etc)
     arginfo_vector_type m_components;
@@ -359,11 +364,20 @@ public:
   };
 
 private:
-  using argument_value_type = std::unique_ptr<argument>;
+  using argument_value_type = std::shared_ptr<argument>;
   using argument_vector_type = std::vector<argument_value_type>;
-  using argument_iterator_type = argument_vector_type::const_iterator;
   using argument_filter_type = std::function<bool(const argument_value_type&)>;
 
+public:
+  using argument_iterator_type = argument_vector_type::const_iterator;
+
+  /**
+   * Immutable snapshot of the dynamic arguments in the order of
+   * get_argument_range().  A snapshot is shared by all execution
+   * contexts launched with the same argument values.
+   */
+  using argument_snapshot_type = std::shared_ptr<const std::vector<std::shared_ptr<const argument>>>;
+
 public:
   // only program constructs kernels, but private doesn't work as long
   // xrt::make_unique is used
@@ -501,21 +515,45 @@ public:
   void
   set_argument(unsigned long idx, size_t sz, const void* arg)
   {
-    m_indexed_args.at(idx)->set(idx,sz,arg);
+    writable(m_indexed_args.at(idx))->set(idx,sz,arg);
+    ++m_argument_generation;
   }
 
   void
   set_svm_argument(unsigned long idx, size_t sz, const void* arg)
   {
-    m_indexed_args.at(idx)->set_svm(sz,arg);
+    writable(m_indexed_args.at(idx))->set_svm(sz,arg);
+    ++m_argument_generation;
   }
 
   void
   set_printf_argument(size_t sz, const void* arg)
   {
-    m_printf_args.at(0)->set(sz,arg);
+    writable(m_printf_args.at(0))->set(sz,arg);
+    ++m_argument_generation;
+  }
+
+  /**
+   * Generation of argument values, incremented each time an argument
+   * is set.  Used to detect arguments that changed since a command
+   * graph was recorded.
+   */
+  unsigned long
+  get_argument_generation() const
+  {
+    return m_argument_generation;
   }
 
+  /**
+   * Get snapshot of current argument values
+   *
+   * The snapshot is created on first call after an argument was
+   * changed, subsequent calls return the same snapshot.  Arguments
+   * are shared with the kernel until changed by the application.
+   */
+  argument_snapshot_type
+  get_argument_snapshot() const;
+
   /**
    * Get range of all arguments that have a dynamic value
    * rtinfo args and progvars do not matter, they are static per kernel
@@ -569,6 +607,17 @@ public:
     return boost::join(m_printf_args,m_rtinfo_args);
   }
 
+private:
+  /**
+   * Prepare an argument for modification
+   *
+   * Invalidates the current snapshot and clones the argument if it
+   * is still referenced by a previous snapshot.
+   */
+  argument_value_type&
+  writable(argument_value_type& arg);
+
+public:
   ////////////////////////////////////////////////////////////////
   // Conformance helpers
   ////////////////////////////////////////////////////////////////
@@ -586,6 +635,10 @@ private:
   argument_vector_type m_printf_args;
   argument_vector_type m_progvar_args;
   argument_vector_type m_rtinfo_args;
+  unsigned long m_argument_generation = 0;
+
+  mutable std::mutex m_snapshot_mutex;
+  mutable argument_snapshot_type m_snapshot;
 };
 
 } // xocl
@@ -159,17 +159,9 @@ get_buffer_object(kernel* kernel, unsigned long argidx)
     }
     else {
       // This buffer is not currently allocated on device, allocate
-      // in first available bank for argument
-      for (size_t idx=0; idx<cu_memidx_mask.size(); ++idx) {
-        if (cu_memidx_mask.test(idx)) {
-          try {
-            return (m_bomap[device] = device->allocate_buffer_object(this,idx));
-          }
-          catch (const std::bad_alloc&) {
-          }
-        }
-      }
-      throw std::bad_alloc();
+      // in a bank connected to the argument as chosen by the context
+      // placement policy
+      return (m_bomap[device] = device->place_buffer_object(this,cu_memidx_mask));
     }
   }
   return nullptr;
@@ -40,6 +40,7 @@ class sampler;
 class memory;
 class stream;
 class stream_mem;
+class command_graph;
 
 /**
  * Base class for all CL API object types
@@ -174,6 +175,7 @@ class _xcl_sampler;
 class _xcl_mem;
 class _xcl_stream;
 class _xcl_stream_mem;
+class _xcl_command_graph_xilinx;
 
 struct _cl_platform_id :   public xocl::object<xocl::platform,     _xcl_platform_id,  _cl_platform_id> {};
 struct _cl_device_id :     public xocl::object<xocl::device,       _xcl_device_id,    _cl_device_id> {};
@@ -186,5 +188,6 @@ struct _cl_kernel :        public xocl::object<xocl::kernel,       _xcl_kernel,
 struct _cl_mem :           public xocl::object<xocl::memory,       _xcl_mem,          _cl_mem> {};
 struct _cl_stream :        public xocl::object<xocl::stream,       _xcl_stream,       _cl_stream> {};
 struct _cl_stream_mem :    public xocl::object<xocl::stream_mem,   _xcl_stream_mem,   _cl_stream_mem> {};
+struct _cl_command_graph_xilinx : public xocl::object<xocl::command_graph,_xcl_command_graph_xilinx,_cl_command_graph_xilinx> {};
 
 #endif
@@ -0,0 +1,113 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "placement.h"
+#include "xocl/core/error.h"
+
+#include <CL/opencl.h>
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+namespace {
+
+using placement_policy = xocl::placement_policy;
+
+static std::mutex s_mutex;
+
+static std::map<std::string,xocl::placement_factory>&
+registry()
+{
+  static std::map<std::string,xocl::placement_factory> policies {
+    {"first",   []() { return std::unique_ptr<placement_policy>(new xocl::first_placement()); }},
+    {"balance", []() { return std::unique_ptr<placement_policy>(new xocl::balance_placement()); }},
+    {"stripe",  []() { return std::unique_ptr<placement_policy>(new xocl::stripe_placement()); }}
+  };
+  return policies;
+}
+
+}
+
+namespace xocl {
+
+std::vector<placement_policy::memidx_type>
+first_placement::
+rank(const std::vector<bank_info>& banks, size_t size)
+{
+  std::vector<memidx_type> order;
+  order.reserve(banks.size());
+  for (auto& bank : banks)
+    order.push_back(bank.memidx);
+  return order;
+}
+
+std::vector<placement_policy::memidx_type>
+balance_placement::
+rank(const std::vector<bank_info>& banks, size_t size)
+{
+  auto load = [](const bank_info& bank) {
+    return bank.size
+      ? static_cast<double>(bank.used)/bank.size
+      : static_cast<double>(bank.used);
+  };
+
+  auto sorted = banks;
+  std::stable_sort(sorted.begin(),sorted.end(),
+                   [load](const bank_info& b1, const bank_info& b2) {
+                     return load(b1) < load(b2);
+                   });
+
+  std::vector<memidx_type> order;
+  order.reserve(sorted.size());
+  for (auto& bank : sorted)
+    order.push_back(bank.memidx);
+  return order;
+}
+
+std::vector<placement_policy::memidx_type>
+stripe_placement::
+rank(const std::vector<bank_info>& banks, size_t size)
+{
+  std::vector<memidx_type> order;
+  if (banks.empty())
+    return order;
+
+  order.reserve(banks.size());
+  auto first = m_next++ % banks.size();
+  for (size_t idx=0; idx<banks.size(); ++idx)
+    order.push_back(banks[(first+idx) % banks.size()].memidx);
+  return order;
+}
+
+void
+register_placement_policy(const std::string& name, placement_factory factory)
+{
+  std::lock_guard<std::mutex> lk(s_mutex);
+  registry()[name] = std::move(factory);
+}
+
+std::unique_ptr<placement_policy>
+create_placement_policy(const std::string& name)
+{
+  std::lock_guard<std::mutex> lk(s_mutex);
+  auto itr = registry().find(name);
+  if (itr==registry().end())
+    throw xocl::error(CL_INVALID_VALUE,"unknown memory placement policy '" + name + "'");
+  return (*itr).second();
+}
+
+} // xocl
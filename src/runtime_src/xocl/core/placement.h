@@ -0,0 +1,147 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef xocl_core_placement_h_
+#define xocl_core_placement_h_
+
+#include "xocl/xclbin/xclbin.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace xocl {
+
+/**
+ * Placement of buffers in device memory banks
+ *
+ * A placement policy ranks the memory banks in which a buffer without
+ * an explicit bank assignment can be allocated.  The candidate banks
+ * are those connected to the compute units that will use the buffer,
+ * and the device tries them in the order returned by the policy.
+ *
+ * Policies are created by name, a context selects its policy with
+ * CL_CONTEXT_MEM_PLACEMENT_XILINX or else Runtime.mem_placement.
+ * Additional policies can be added with register_placement_policy.
+ */
+class placement_policy
+{
+public:
+  using memidx_type = xclbin::memidx_type;
+
+  /**
+   * Size and current usage of a candidate bank
+   */
+  struct bank_info
+  {
+    memidx_type memidx;
+    uint64_t size;   // bytes, 0 if unknown
+    uint64_t used;   // bytes, 0 if unknown
+  };
+
+  virtual ~placement_policy() {}
+
+  /**
+   * Check if the policy ranks banks by usage
+   *
+   * Bank usage is queried from the driver only for policies that
+   * need it, otherwise bank_info::used is 0.
+   */
+  virtual bool
+  needs_usage() const
+  {
+    return false;
+  }
+
+  /**
+   * Rank candidate banks for a buffer
+   *
+   * @param banks
+   *   Candidate banks ordered by memory index
+   * @param size
+   *   Size of the buffer to allocate
+   * @return
+   *   Memory indices in the order allocation should be tried
+   */
+  virtual std::vector<memidx_type>
+  rank(const std::vector<bank_info>& banks, size_t size) = 0;
+};
+
+/**
+ * Lowest memory index first.  This is the default.
+ */
+class first_placement : public placement_policy
+{
+public:
+  virtual std::vector<memidx_type>
+  rank(const std::vector<bank_info>& banks, size_t size);
+};
+
+/**
+ * Least used bank first, relative to bank size when known.  Spreads the
+ * bytes allocated, and therefore the memory bandwidth, evenly across
+ * the banks.
+ */
+class balance_placement : public placement_policy
+{
+public:
+  virtual bool
+  needs_usage() const
+  {
+    return true;
+  }
+
+  virtual std::vector<memidx_type>
+  rank(const std::vector<bank_info>& banks, size_t size);
+};
+
+/**
+ * Round robin over the candidate banks.  Consecutive buffers, for
+ * example the inputs and outputs of a kernel, land in different banks.
+ */
+class stripe_placement : public placement_policy
+{
+  std::atomic<unsigned int> m_next {0};
+public:
+  virtual std::vector<memidx_type>
+  rank(const std::vector<bank_info>& banks, size_t size);
+};
+
+using placement_factory = std::function<std::unique_ptr<placement_policy>()>;
+
+/**
+ * Register a placement policy
+ *
+ * @param name
+ *   Name used in Runtime.mem_placement.  An existing policy with the
+ *   same name is replaced.
+ */
+void
+register_placement_policy(const std::string& name, placement_factory factory);
+
+/**
+ * Create a placement policy by name
+ *
+ * @return
+ *   The policy, throws xocl::error if the name is unknown
+ */
+std::unique_ptr<placement_policy>
+create_placement_policy(const std::string& name);
+
+} // xocl
+
+#endif
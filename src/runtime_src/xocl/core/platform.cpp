@@ -20,10 +20,13 @@
 
 #include "xocl/xclbin/xclbin.h"
 #include "xrt/util/memory.h"
+#include "xrt/util/time.h"
+#include "xrt/config.h"
 #include "xrt/scheduler/scheduler.h"
 
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <cassert>
@@ -212,6 +215,7 @@ platform::
 platform()
   : m_device_mgr(xrt::make_unique<xrt_device_manager>())
 {
+  auto start = xrt::time_ns();
   static unsigned int uid_count = 0;
   m_uid = uid_count++;
 
@@ -242,6 +246,20 @@ platform()
     }
   }
 
+  // Open the boards in parallel, their DMA workers are started on first
+  // use.  A board that fails to open is not listed by the platform.
+  std::vector<xrt::device*> xdevices;
+  for (auto& device : m_devices)
+    if (auto xdevice = device->get_xrt_device())
+      xdevices.push_back(xdevice);
+  if (!xrt::completeOpen(xdevices))
+    m_devices.erase(std::remove_if(m_devices.begin(),m_devices.end(),
+                                   [](const ptr<device>& d) {
+                                     auto xdevice = d->get_xrt_device();
+                                     return xdevice && !xdevice->completeOpen();
+                                   }),
+                    m_devices.end());
+
   try {
     xrt::scheduler::start();
   }
@@ -250,6 +268,12 @@ platform()
   }
 
   init_conformance();
+
+  // Time spent opening each device and starting its workers is
+  // reported by the devices
+  if (xrt::config::get_xrt_debug())
+    XRT_PRINT(std::cout,"platform (",m_uid,"): devices: ",m_devices.size()
+              ,", time (ms): ",(xrt::time_ns()-start)*1e-6,"\n");
 }
 
 platform::
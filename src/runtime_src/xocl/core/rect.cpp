@@ -0,0 +1,145 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include "rect.h"
+
+#include <algorithm>
+#include <thread>
+#include <cstring>
+
+namespace {
+
+using span = xocl::rect_transfer::span;
+
+// Bytes below which a copy is not split into another thread
+const size_t min_thread_bytes = 1024*1024;
+
+// Copy bytes [begin,end) of the concatenated spans
+template <typename Copy>
+void
+copy_range(const std::vector<span>& spans, size_t begin, size_t end, Copy copy)
+{
+  size_t pos = 0;
+  for (auto& s : spans) {
+    if (pos>=end)
+      break;
+    auto next = pos + s.size;
+    if (next>begin) {
+      auto b = std::max(begin,pos) - pos;
+      auto e = std::min(end,next) - pos;
+      copy(s.buffer_offset+b,s.host_offset+b,e-b);
+    }
+    pos = next;
+  }
+}
+
+template <typename Copy>
+void
+parallel_copy(const std::vector<span>& spans, size_t size, unsigned int threads, Copy copy)
+{
+  threads = static_cast<unsigned int>(std::min<size_t>(threads,size/min_thread_bytes));
+  if (threads<=1) {
+    copy_range(spans,0,size,copy);
+    return;
+  }
+
+  std::vector<std::thread> workers;
+  try {
+    for (unsigned int t=1; t<threads; ++t)
+      workers.emplace_back(copy_range<Copy>,std::cref(spans),t*size/threads,(t+1)*size/threads,copy);
+  }
+  catch (...) {
+    for (auto& w : workers)
+      w.join();
+    throw;
+  }
+  copy_range(spans,0,size/threads,copy);
+  for (auto& w : workers)
+    w.join();
+}
+
+}
+
+namespace xocl {
+
+rect_transfer::
+rect_transfer(const size_t* buffer_origin, const size_t* host_origin, const size_t* region
+              ,size_t buffer_row_pitch, size_t buffer_slice_pitch
+              ,size_t host_row_pitch, size_t host_slice_pitch)
+{
+  size_t buffer_offset = buffer_origin[2]*buffer_slice_pitch + buffer_origin[1]*buffer_row_pitch + buffer_origin[0];
+  size_t host_offset = host_origin[2]*host_slice_pitch + host_origin[1]*host_row_pitch + host_origin[0];
+
+  // Merge rows that are contiguous in both memories, then slices
+  size_t bytes = region[0];
+  size_t rows = region[1];
+  size_t slices = region[2];
+  if (rows==1 || (buffer_row_pitch==bytes && host_row_pitch==bytes)) {
+    bytes *= rows;
+    rows = 1;
+    if (slices==1 || (buffer_slice_pitch==bytes && host_slice_pitch==bytes)) {
+      bytes *= slices;
+      slices = 1;
+    }
+  }
+
+  m_size = bytes*rows*slices;
+  if (!m_size)
+    return;
+
+  m_spans.reserve(rows*slices);
+  for (size_t z=0; z<slices; ++z)
+    for (size_t y=0; y<rows; ++y)
+      m_spans.push_back({buffer_offset + z*buffer_slice_pitch + y*buffer_row_pitch
+                         ,host_offset + z*host_slice_pitch + y*host_row_pitch
+                         ,bytes});
+}
+
+std::pair<size_t,size_t>
+rect_transfer::
+get_buffer_range() const
+{
+  if (m_spans.empty())
+    return {0,0};
+  auto begin = m_spans.front().buffer_offset;
+  auto end = m_spans.back().buffer_offset + m_spans.back().size;
+  return {begin,end-begin};
+}
+
+void
+rect_transfer::
+copy_to_host(const void* buffer, void* host, unsigned int threads) const
+{
+  auto src = static_cast<const char*>(buffer);
+  auto dst = static_cast<char*>(host);
+  parallel_copy(m_spans,m_size,threads,[src,dst](size_t boffset,size_t hoffset,size_t size) {
+    std::memcpy(dst+hoffset,src+boffset,size);
+  });
+}
+
+void
+rect_transfer::
+copy_to_buffer(void* buffer, const void* host, unsigned int threads) const
+{
+  auto dst = static_cast<char*>(buffer);
+  auto src = static_cast<const char*>(host);
+  parallel_copy(m_spans,m_size,threads,[src,dst](size_t boffset,size_t hoffset,size_t size) {
+    std::memcpy(dst+boffset,src+hoffset,size);
+  });
+}
+
+} // xocl
@@ -0,0 +1,115 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#ifndef xocl_core_rect_h_
+#define xocl_core_rect_h_
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+namespace xocl {
+
+/**
+ * Plan of a rectangular (2D or 3D) transfer between a buffer and
+ * host memory.
+ *
+ * A rectangular region is a sequence of rows laid out at a row pitch
+ * and slice pitch in the buffer and at another row pitch and slice
+ * pitch in host memory.  The plan coalesces rows, and slices, that
+ * are contiguous in both memories into spans, so that the transfer
+ * is done with as few copy operations as possible.
+ *
+ * Origins and regions follow clEnqueueReadBufferRect, the first
+ * dimension is in bytes.  Pitches must already be resolved, zero is
+ * not a valid pitch.
+ */
+class rect_transfer
+{
+public:
+  /**
+   * Contiguous bytes of the region at an offset in the buffer and
+   * at an offset in host memory.
+   */
+  struct span
+  {
+    size_t buffer_offset;
+    size_t host_offset;
+    size_t size;
+  };
+
+  rect_transfer(const size_t* buffer_origin, const size_t* host_origin, const size_t* region
+                ,size_t buffer_row_pitch, size_t buffer_slice_pitch
+                ,size_t host_row_pitch, size_t host_slice_pitch);
+
+  const std::vector<span>&
+  get_spans() const
+  {
+    return m_spans;
+  }
+
+  /**
+   * @return
+   *   Total number of bytes transferred
+   */
+  size_t
+  get_size() const
+  {
+    return m_size;
+  }
+
+  /**
+   * Range of buffer bytes touched by the transfer.  The range
+   * includes the gaps between rows and slices, syncing a buffer
+   * with a device must be done per span.
+   *
+   * @return
+   *   Pair of buffer offset and size of range
+   */
+  std::pair<size_t,size_t>
+  get_buffer_range() const;
+
+  /**
+   * Copy the region from mapped buffer to host memory
+   *
+   * @param buffer
+   *   Host address of buffer (offset 0)
+   * @param host
+   *   Host memory of region (offset 0)
+   * @param threads
+   *   Max number of threads used for copying, large transfers are
+   *   split evenly over the threads
+   */
+  void
+  copy_to_host(const void* buffer, void* host, unsigned int threads=1) const;
+
+  /**
+   * Copy the region from host memory to mapped buffer
+   *
+   * See copy_to_host()
+   */
+  void
+  copy_to_buffer(void* buffer, const void* host, unsigned int threads=1) const;
+
+private:
+  std::vector<span> m_spans;
+  size_t m_size = 0;
+};
+
+} // xocl
+
+#endif
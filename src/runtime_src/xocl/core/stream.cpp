@@ -17,6 +17,22 @@
 #include "stream.h"
 #include "device.h"
 
+namespace {
+
+// cl_stream_xfer_req to hal transfer flags
+inline xrt::hal::StreamXferFlags
+get_xfer_flags(xrt::hal::StreamXferFlags flags)
+{
+  xrt::hal::StreamXferFlags xfer_flags = xrt::hal::STREAM_XFER_DEFAULT;
+  if (flags & CL_STREAM_NONBLOCKING)
+    xfer_flags |= xrt::hal::STREAM_XFER_NONBLOCKING;
+  if (flags & CL_STREAM_EOT)
+    xfer_flags |= xrt::hal::STREAM_XFER_EOT;
+  return xfer_flags;
+}
+
+}
+
 namespace xocl { 
 
 stream::
@@ -43,7 +59,7 @@ stream
 {
   if(device != m_device)
     throw xocl::error(CL_INVALID_OPERATION,"Stream read on a bad device");
-  return m_device->read_stream(m_handle, ptr, offset, size, flags);
+  return m_device->read_stream(m_handle, ptr, offset, size, get_xfer_flags(flags));
 }
 
 ssize_t 
@@ -52,7 +68,25 @@ stream
 {
   if(device != m_device)
     throw xocl::error(CL_INVALID_OPERATION,"Stream write on a bad device");
-  return m_device->write_stream(m_handle, ptr, offset, size, flags);
+  return m_device->write_stream(m_handle, ptr, offset, size, get_xfer_flags(flags));
+}
+
+ssize_t
+stream
+::read(device* device, const stream_xfer_buf* bufs, size_t count, stream_xfer_flags flags, void* priv_data)
+{
+  if(device != m_device)
+    throw xocl::error(CL_INVALID_OPERATION,"Stream read on a bad device");
+  return m_device->read_stream(m_handle, bufs, count, get_xfer_flags(flags), priv_data);
+}
+
+ssize_t
+stream
+::write(device* device, const stream_xfer_buf* bufs, size_t count, stream_xfer_flags flags, void* priv_data)
+{
+  if(device != m_device)
+    throw xocl::error(CL_INVALID_OPERATION,"Stream write on a bad device");
+  return m_device->write_stream(m_handle, bufs, count, get_xfer_flags(flags), priv_data);
 }
 
 int
@@ -32,6 +32,7 @@ class stream : public _cl_stream // TODO: public refcount
 protected:
   using stream_handle = xrt::hal::StreamHandle;
   using stream_xfer_flags = xrt::hal::StreamXferFlags;
+  using stream_xfer_buf = xrt::hal::StreamXferBuf;
 public:
   stream(stream_flags_type flags, stream_attributes_type attr, cl_mem_ext_ptr_t* ext);
 private:
@@ -45,6 +46,9 @@ public:
   int get_stream(device* device); 
   ssize_t read(device* device, void* ptr, size_t offset, size_t size, stream_xfer_flags flags);
   ssize_t write(device* device, const void* ptr, size_t offset, size_t size, stream_xfer_flags flags);
+  // Scatter-gather request, flags are cl_stream_xfer_req
+  ssize_t read(device* device, const stream_xfer_buf* bufs, size_t count, stream_xfer_flags flags, void* priv_data);
+  ssize_t write(device* device, const stream_xfer_buf* bufs, size_t count, stream_xfer_flags flags, void* priv_data);
   int close();
 };
 
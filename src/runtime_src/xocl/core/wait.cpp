@@ -0,0 +1,64 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include "wait.h"
+
+#include "xrt/util/config_reader.h"
+#include "xrt/util/message.h"
+
+#include <atomic>
+#include <string>
+
+namespace {
+
+static xocl::wait_policy
+to_wait_policy(const std::string& name)
+{
+  if (name=="spin")
+    return xocl::wait_policy::spin;
+  if (name=="adaptive")
+    return xocl::wait_policy::adaptive;
+  if (name!="block")
+    xrt::message::send(xrt::message::severity_level::WARNING,
+                       "unknown wait policy '" + name + "', using block");
+  return xocl::wait_policy::block;
+}
+
+static std::atomic<xocl::wait_policy>&
+policy()
+{
+  static std::atomic<xocl::wait_policy> value(to_wait_policy(xrt::config::get_wait_policy()));
+  return value;
+}
+
+}
+
+namespace xocl {
+
+wait_policy
+get_wait_policy()
+{
+  return policy().load(std::memory_order_relaxed);
+}
+
+void
+set_wait_policy(wait_policy p)
+{
+  policy() = p;
+}
+
+} // xocl
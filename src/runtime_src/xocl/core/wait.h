@@ -0,0 +1,108 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#ifndef xocl_core_wait_h_
+#define xocl_core_wait_h_
+
+#include "xrt/util/config_reader.h"
+
+#include <chrono>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+# include <immintrin.h>
+#endif
+
+namespace xocl {
+
+/**
+ * Policy of host threads waiting for events and command queues
+ *
+ * A blocking wait sleeps on a condition variable and pays for a
+ * context switch when woken up, which dominates the latency of short
+ * commands.  A waiter that first spins on the completion state sees
+ * the completion as soon as it happens.
+ *
+ *  block:    block right away (default)
+ *  spin:     spin, then yield, until the wait is satisfied, never block
+ *  adaptive: spin, then yield, for at most Runtime.wait_spin_us, then block
+ *
+ * The policy is Runtime.wait_policy unless set with set_wait_policy.
+ */
+enum class wait_policy { block, spin, adaptive };
+
+wait_policy
+get_wait_policy();
+
+void
+set_wait_policy(wait_policy policy);
+
+namespace detail {
+
+inline void
+cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+} // detail
+
+/**
+ * Spin per current wait policy until a predicate is satisfied
+ *
+ * The predicate is evaluated without locks and must only read
+ * atomic state.  A false return means the caller must block.
+ *
+ * @param pred
+ *   Nullary predicate
+ * @return
+ *   true if the predicate is satisfied, false otherwise
+ */
+template <typename Predicate>
+bool
+spin_wait(Predicate pred)
+{
+  const unsigned int pause_count = 128;
+
+  auto policy = get_wait_policy();
+  if (policy==wait_policy::block)
+    return pred();
+
+  for (unsigned int i=0; i<pause_count; ++i) {
+    if (pred())
+      return true;
+    detail::cpu_relax();
+  }
+
+  // Yield to other threads, in particular the thread that
+  // completes the wait when there are not enough cores
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(xrt::config::get_wait_spin_us());
+  while (!pred()) {
+    if (policy==wait_policy::adaptive && std::chrono::steady_clock::now()>deadline)
+      return false;
+    std::this_thread::yield();
+  }
+  return true;
+}
+
+} // xocl
+
+#endif
@@ -0,0 +1,220 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "xocl/api/printf/rt_printf_impl.h"
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+using namespace XCL::Printf;
+
+// Formats used by the synthetic kernel
+const BufferPrintf::StringTable&
+stringTable()
+{
+  static BufferPrintf::StringTable table = {
+    {1, "wi %d: x=%u y=%x\n"},
+    {2, "%8.3f %e\n"},
+    {3, "v4 %v4hlf\n"},
+    {4, "v3 %v3d|%v3hlf\n"},
+    {5, "100%% done %ld\n"},
+    {6, "plain text\n"},
+  };
+  return table;
+}
+
+// Builds a printf buffer with 'workItems' work item segments and the
+// expected output of the buffer, formatted one argument at a time
+class SyntheticBuffer
+{
+  BufferPrintf::MemBuffer m_buf;
+  std::ostringstream m_expected;
+  size_t m_offset = 0;
+  std::mt19937 m_rng;
+
+  void
+  put(const void* data, size_t size)
+  {
+    std::memcpy(&m_buf[m_offset],data,size);
+    m_offset += size;
+  }
+
+  void
+  putInt(uint64_t value)
+  {
+    put(&value,sizeof(value));
+  }
+
+  void
+  putDouble(double value)
+  {
+    put(&value,sizeof(value));
+  }
+
+  void
+  putFloat(float value)
+  {
+    put(&value,sizeof(value));
+  }
+
+  void
+  record(std::vector<PrintfArg>& args)
+  {
+    uint32_t id = m_rng()%stringTable().size() + 1;
+    putInt(id);
+    switch (id) {
+    case 1: {
+      uint64_t a = m_rng()%1000, b = m_rng(), c = m_rng();
+      putInt(a); putInt(b); putInt(c);
+      args = { PrintfArg(a), PrintfArg(b), PrintfArg(c) };
+      break;
+    }
+    case 2: {
+      double a = m_rng()/1000.0, b = m_rng()*1.5;
+      putDouble(a); putDouble(b);
+      args = { PrintfArg(a), PrintfArg(b) };
+      break;
+    }
+    case 3: {
+      std::vector<float> v;
+      for (int i=0; i<4; ++i) {
+        v.push_back(m_rng()/7.0f);
+        putFloat(v.back());
+      }
+      args = { PrintfArg(v) };
+      break;
+    }
+    case 4: {
+      // vec3 elements are packed as vec4
+      std::vector<uint64_t> iv;
+      for (int i=0; i<3; ++i) {
+        iv.push_back(m_rng()%100);
+        putInt(iv.back());
+      }
+      putInt(0);
+      std::vector<float> fv;
+      for (int i=0; i<3; ++i) {
+        fv.push_back(m_rng()/3.0f);
+        putFloat(fv.back());
+      }
+      putFloat(0);
+      args = { PrintfArg(iv), PrintfArg(fv) };
+      break;
+    }
+    case 5: {
+      uint64_t a = m_rng();
+      putInt(a);
+      args = { PrintfArg(a) };
+      break;
+    }
+    default:
+      args.clear();
+      break;
+    }
+    m_expected << string_printf(stringTable().at(id),args);
+  }
+
+public:
+  SyntheticBuffer(size_t workItems, unsigned int seed)
+    : m_buf(workItems*getWorkItemPrintfBufferSize(),0xFF), m_rng(seed)
+  {
+    const size_t segment = getWorkItemPrintfBufferSize();
+    std::vector<PrintfArg> args;
+    for (size_t wi=0; wi<workItems; ++wi) {
+      m_offset = wi*segment;
+      // Some work items do not print at all, the largest record is
+      // 8+64 bytes so leave room for it and the end marker
+      auto records = m_rng()%8;
+      for (size_t r=0; r<records && m_offset+8+64+8<=(wi+1)*segment; ++r)
+        record(args);
+    }
+  }
+
+  const BufferPrintf::MemBuffer&
+  buffer() const
+  {
+    return m_buf;
+  }
+
+  std::string
+  expected() const
+  {
+    return m_expected.str();
+  }
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE ( test_printf )
+
+BOOST_AUTO_TEST_CASE( test_printf_decode )
+{
+  SyntheticBuffer sb(64,1);
+  BufferPrintf bp(sb.buffer(),stringTable());
+  std::ostringstream os;
+  bp.print(os);
+  BOOST_CHECK_EQUAL(os.str(),sb.expected());
+
+  // Decoding is repeatable
+  std::ostringstream os2;
+  bp.print(os2);
+  BOOST_CHECK_EQUAL(os2.str(),os.str());
+}
+
+BOOST_AUTO_TEST_CASE( test_printf_empty )
+{
+  BufferPrintf::MemBuffer buf(4*getWorkItemPrintfBufferSize(),0xFF);
+  BufferPrintf bp(buf,stringTable());
+  std::ostringstream os;
+  bp.print(os);
+  BOOST_CHECK(os.str().empty());
+}
+
+BOOST_AUTO_TEST_CASE( test_printf_bad_id )
+{
+  BufferPrintf::MemBuffer buf(getWorkItemPrintfBufferSize(),0xFF);
+  uint64_t id = 42;
+  std::memcpy(buf.data(),&id,sizeof(id));
+  BufferPrintf bp(buf,stringTable());
+  std::ostringstream os;
+  BOOST_CHECK_THROW(bp.print(os),std::runtime_error);
+}
+
+// Synthetic benchmark, decode a buffer of many work items and compare
+// with formatting each record through string_printf
+BOOST_AUTO_TEST_CASE( test_printf_bandwidth )
+{
+  SyntheticBuffer sb(16*1024,2);
+  BufferPrintf bp(sb.buffer(),stringTable());
+  std::ostringstream os;
+  auto start = std::chrono::steady_clock::now();
+  bp.print(os);
+  auto end = std::chrono::steady_clock::now();
+  BOOST_CHECK_EQUAL(os.str(),sb.expected());
+
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(end-start).count();
+  BOOST_TEST_MESSAGE("printf decode of " << sb.buffer().size()/(1024*1024)
+                     << "MB, " << os.str().size() << " characters: " << ms << "ms");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,155 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "xocl/core/object.h"
+#include "xocl/core/event.h"
+#include "xocl/core/context.h"
+#include "xocl/core/command_queue.h"
+#include "xocl/core/command_graph.h"
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+// Events without an enqueue action complete when submitted
+std::vector<xocl::ptr<xocl::event>>
+record(xocl::command_queue* q, size_t count)
+{
+  std::vector<xocl::ptr<xocl::event>> events;
+  for (size_t i=0; i<count; ++i) {
+    cl_event dep = events.empty() ? nullptr : events.back().get();
+    events.push_back(xocl::create_hard_event(q,0,dep?1:0,dep?&dep:nullptr));
+    events.back()->queue();
+  }
+  return events;
+}
+
+void
+replay(xocl::command_graph* graph)
+{
+  auto ev = graph->replay(0,nullptr,[](xocl::command_graph::node&){});
+  ev->wait();
+  BOOST_CHECK_EQUAL(ev->get_status(),CL_COMPLETE);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE ( test_command_graph )
+
+BOOST_AUTO_TEST_CASE( test_command_graph_replay )
+{
+  xocl::context c(nullptr,0,nullptr);
+
+  for (cl_command_queue_properties props : {cl_command_queue_properties(0),cl_command_queue_properties(CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE)}) {
+    xocl::command_queue q(&c,nullptr,props);
+    q.begin_recording();
+    auto events = record(&q,8);
+    std::unique_ptr<xocl::command_graph> graph(q.end_recording());
+
+    // Recorded events are not executed
+    for (auto& ev : events)
+      BOOST_CHECK_EQUAL(ev->get_status(),-1);
+    BOOST_CHECK_THROW(events.back()->wait(),xocl::error);
+
+    for (int i=0; i<3; ++i) {
+      replay(graph.get());
+      for (auto& ev : events)
+        BOOST_CHECK_EQUAL(ev->get_status(),CL_COMPLETE);
+    }
+
+    // Commands enqueued after the graph are executed as usual
+    auto ev = xocl::create_hard_event(&q,0);
+    ev->queue();
+    q.wait();
+    BOOST_CHECK_EQUAL(ev->get_status(),CL_COMPLETE);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( test_command_graph_external_dependency )
+{
+  xocl::context c(nullptr,0,nullptr);
+  xocl::command_queue q(&c,nullptr,0);
+
+  // Incomplete user event is not part of the graph
+  auto user = xocl::create_soft_event(&c,CL_COMMAND_USER);
+  user->queue();
+  cl_event dep = user.get();
+
+  q.begin_recording();
+  auto ev = xocl::create_hard_event(&q,0,1,&dep);
+  BOOST_CHECK_THROW(ev->queue(),xocl::error);
+  BOOST_CHECK_THROW(q.end_recording(),xocl::error);
+  BOOST_CHECK(!q.is_recording());
+
+  user->set_status(CL_COMPLETE);
+}
+
+BOOST_AUTO_TEST_CASE( test_command_graph_recorded_dependency )
+{
+  xocl::context c(nullptr,0,nullptr);
+  xocl::command_queue q(&c,nullptr,0);
+
+  q.begin_recording();
+  auto events = record(&q,2);
+  std::unique_ptr<xocl::command_graph> graph(q.end_recording());
+
+  // Events outside the graph cannot wait on recorded events
+  cl_event dep = events.back().get();
+  BOOST_CHECK_THROW(xocl::create_hard_event(&q,0,1,&dep),xocl::error);
+
+  replay(graph.get());
+}
+
+// Barrier and marker with empty wait list wait on all events in the
+// queue, same as clEnqueueBarrierWithWaitList and clEnqueueMarker
+BOOST_AUTO_TEST_CASE( test_command_graph_barrier_after_replay )
+{
+  xocl::context c(nullptr,0,nullptr);
+
+  for (cl_command_type type : {cl_command_type(CL_COMMAND_BARRIER),cl_command_type(CL_COMMAND_MARKER)}) {
+    xocl::command_queue q(&c,nullptr,0);
+    q.begin_recording();
+    auto events = record(&q,4);
+    std::unique_ptr<xocl::command_graph> graph(q.end_recording());
+
+    // Replay is in flight until the user event completes
+    auto user = xocl::create_soft_event(&c,CL_COMMAND_USER);
+    user->queue();
+    cl_event dep = user.get();
+    auto done = graph->replay(1,&dep,[](xocl::command_graph::node&){});
+
+    xocl::ptr<xocl::event> ev;
+    {
+      auto wait_range = q.get_event_range();
+      std::vector<cl_event> ewl(wait_range.begin(),wait_range.end());
+      ev = xocl::create_hard_event(&q,type,ewl.size(),ewl.data());
+    }
+    ev->queue();
+    BOOST_CHECK(ev->get_status()!=CL_COMPLETE);
+
+    user->set_status(CL_COMPLETE);
+    ev->wait();
+    BOOST_CHECK_EQUAL(done->get_status(),CL_COMPLETE);
+    for (auto& rev : events)
+      BOOST_CHECK_EQUAL(rev->get_status(),CL_COMPLETE);
+    q.wait();
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -21,9 +21,15 @@
 #include "xocl/core/context.h"
 #include "xocl/core/platform.h"
 #include "xocl/core/command_queue.h"
+#include "xocl/core/wait.h"
 
 #include <thread>
+#include <chrono>
 #include <iostream>
+#include <sstream>
+#include <atomic>
+#include <algorithm>
+#include <vector>
 
 namespace {
 
@@ -183,6 +189,142 @@ BOOST_AUTO_TEST_CASE( test_event_submit_wait )
   }
 }
 
+// Microbenchmark of event construction, queuing, completion and
+// destruction.  Events without enqueue action complete when submitted.
+BOOST_AUTO_TEST_CASE( test_event_throughput )
+{
+  xocl::context c(nullptr,0,nullptr);
+
+  for (cl_command_queue_properties props : {cl_command_queue_properties(0),cl_command_queue_properties(CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE)}) {
+    xocl::command_queue q(&c,nullptr,props);
+    const size_t count = 1000000;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i=0; i<count; ++i) {
+      auto ev = xocl::create_hard_event(&q,0);
+      ev->queue();
+    }
+    q.wait();
+    auto end = std::chrono::steady_clock::now();
+
+    auto s = std::chrono::duration<double>(end-start).count();
+    BOOST_TEST_MESSAGE((props ? "out of order" : "in order") << " queue: " << count/s << " events/s");
+  }
+}
+
+// Out of order queue with a barrier every 100 events, where all
+// events are pending on a user event.  Events depend only on the
+// latest barrier, so the cost of queuing an event is independent of
+// the number of pending barriers.  All events complete when the user
+// event completes, or are aborted when the user event is aborted.
+BOOST_AUTO_TEST_CASE( test_event_out_order_barrier_throughput )
+{
+  using clock = std::chrono::steady_clock;
+  const size_t count = 100000;
+  const size_t barrier_interval = 100;
+
+  xocl::context c(nullptr,0,nullptr);
+
+  for (cl_int status : {CL_COMPLETE,CL_OUT_OF_RESOURCES}) {
+    xocl::command_queue q(&c,nullptr,CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE);
+    auto user = xocl::create_soft_event(&c,CL_COMMAND_USER);
+    user->queue(); // per clCreateUserEvent
+    cl_event dep = user.get();
+
+    std::vector<xocl::ptr<xocl::event>> events;
+    events.reserve(count);
+    auto start = clock::now();
+    for (size_t i=0; i<count; ++i) {
+      auto ev = (i%barrier_interval)
+        ? xocl::create_hard_event(&q,0)
+        : xocl::create_hard_event(&q,CL_COMMAND_BARRIER,i?0:1,i?nullptr:&dep);
+      ev->queue();
+      events.push_back(std::move(ev));
+    }
+    auto queued = clock::now();
+
+    if (status==CL_COMPLETE)
+      user->set_status(CL_COMPLETE);
+    else
+      user->abort(status);
+    q.wait();
+    auto end = clock::now();
+
+    BOOST_CHECK(std::all_of(events.begin(),events.end(),[status](const xocl::ptr<xocl::event>& ev) { return ev->get_status()==status; }));
+
+    auto queue_s = std::chrono::duration<double>(queued-start).count();
+    auto drain_s = std::chrono::duration<double>(end-queued).count();
+    BOOST_TEST_MESSAGE((status==CL_COMPLETE ? "complete" : "abort") << ": "
+                       << count/queue_s << " events/s queued, "
+                       << count/drain_s << " events/s " << (status==CL_COMPLETE ? "completed" : "aborted"));
+  }
+}
+
+// Wake up latency of a thread waiting on back-to-back tiny commands
+// that are completed by another thread, per wait policy
+BOOST_AUTO_TEST_CASE( test_event_wait_latency )
+{
+  using clock = std::chrono::steady_clock;
+  const size_t count = 2000;
+  const auto kernel_time = std::chrono::microseconds(5);
+  const std::vector<long> buckets = {1,2,5,10,20,50,100,200,500}; // us
+
+  xocl::context c(nullptr,0,nullptr);
+  xocl::command_queue q(&c,nullptr,0);
+
+  // Completes submitted events after kernel_time
+  std::atomic<xocl::event*> running {nullptr};
+  std::atomic<clock::rep> completed_at {0};
+  std::atomic<bool> stop {false};
+  std::thread device([&] {
+    while (!stop) {
+      auto ev = running.exchange(nullptr);
+      if (!ev) {
+        std::this_thread::yield();
+        continue;
+      }
+      auto end = clock::now() + kernel_time;
+      while (clock::now()<end)
+        ;
+      completed_at = clock::now().time_since_epoch().count();
+      ev->set_status(CL_COMPLETE);
+    }
+  });
+
+  auto saved = xocl::get_wait_policy();
+  for (auto policy : {xocl::wait_policy::block,xocl::wait_policy::adaptive,xocl::wait_policy::spin}) {
+    xocl::set_wait_policy(policy);
+    std::vector<long> latency; // ns
+    for (size_t i=0; i<count; ++i) {
+      auto ev = xocl::create_hard_event(&q,0);
+      ev->set_enqueue_action([&running](xocl::event* ev) { running = ev; });
+      ev->queue();
+      ev->wait();
+      auto now = clock::now().time_since_epoch().count();
+      BOOST_CHECK_EQUAL(ev->get_status(),CL_COMPLETE);
+      latency.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::duration(now-completed_at)).count());
+    }
+    q.wait();
+
+    std::sort(latency.begin(),latency.end());
+    std::stringstream str;
+    str << (policy==xocl::wait_policy::block ? "block" : policy==xocl::wait_policy::spin ? "spin" : "adaptive")
+        << ": p50 " << latency[count/2]/1000.0 << "us p99 " << latency[count*99/100]/1000.0 << "us |";
+    auto itr = latency.begin();
+    for (auto b : buckets) {
+      auto next = std::lower_bound(itr,latency.end(),b*1000);
+      str << " <" << b << "us:" << (next-itr);
+      itr = next;
+    }
+    str << " >=" << buckets.back() << "us:" << (latency.end()-itr);
+    BOOST_TEST_MESSAGE(str.str());
+  }
+  xocl::set_wait_policy(saved);
+
+  stop = true;
+  device.join();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
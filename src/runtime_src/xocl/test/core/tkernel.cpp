@@ -0,0 +1,123 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include <boost/test/unit_test.hpp>
+
+#include "xocl/core/kernel.h"
+
+#include <chrono>
+#include <cstring>
+#include <string>
+
+namespace {
+
+// Kernel symbol with count int arguments
+xocl::xclbin::symbol
+symbol(size_t count)
+{
+  xocl::xclbin::symbol s;
+  s.name = "k";
+  for (size_t idx=0; idx<count; ++idx) {
+    xocl::xclbin::symbol::arg arg;
+    arg.name = "a" + std::to_string(idx);
+    arg.address_qualifier = 0;
+    arg.id = std::to_string(idx);
+    arg.size = arg.hostsize = sizeof(int);
+    arg.offset = arg.hostoffset = 0;
+    arg.atype = xocl::xclbin::symbol::arg::argtype::indexed;
+    s.arguments.push_back(arg);
+  }
+  return s;
+}
+
+int
+value(const xocl::kernel::argument_snapshot_type& snapshot, size_t idx)
+{
+  int v = 0;
+  std::memcpy(&v,snapshot->at(idx)->get_value(),sizeof(v));
+  return v;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE ( test_kernel )
+
+BOOST_AUTO_TEST_CASE( test_kernel_argument_snapshot )
+{
+  auto s = symbol(3);
+  xocl::kernel k(nullptr,"k",s);
+  for (int idx=0; idx<3; ++idx)
+    k.set_argument(idx,sizeof(int),&idx);
+
+  // Launches with unchanged arguments share the snapshot
+  auto s1 = k.get_argument_snapshot();
+  BOOST_CHECK_EQUAL(s1,k.get_argument_snapshot());
+  BOOST_CHECK_EQUAL(s1->size(),3);
+
+  // Changed argument is copied, others are shared
+  int seven = 7;
+  k.set_argument(1,sizeof(int),&seven);
+  auto s2 = k.get_argument_snapshot();
+  BOOST_CHECK(s1!=s2);
+  BOOST_CHECK_EQUAL(value(s1,1),1);
+  BOOST_CHECK_EQUAL(value(s2,1),7);
+  BOOST_CHECK_EQUAL(s1->at(0),s2->at(0));
+  BOOST_CHECK(s1->at(1)!=s2->at(1));
+
+  // Argument not referenced by a snapshot is changed in place
+  s1.reset();
+  s2.reset();
+  auto arg = k.get_indexed_argument_range().begin()->get();
+  k.set_argument(0,sizeof(int),&seven);
+  BOOST_CHECK_EQUAL(k.get_indexed_argument_range().begin()->get(),arg);
+  BOOST_CHECK_EQUAL(value(k.get_argument_snapshot(),0),7);
+
+  // Invalid size is rejected
+  long l = 0;
+  BOOST_CHECK_THROW(k.set_argument(0,sizeof(l),&l),xocl::error);
+}
+
+BOOST_AUTO_TEST_CASE( test_kernel_argument_snapshot_throughput )
+{
+  const size_t args = 32;
+  const size_t count = 1000000;
+  auto s = symbol(args);
+  xocl::kernel k(nullptr,"k",s);
+  for (int idx=0; idx<int(args); ++idx)
+    k.set_argument(idx,sizeof(int),&idx);
+
+  // One argument changed between launches, the previous launch
+  // is still in flight
+  auto start = std::chrono::steady_clock::now();
+  auto inflight = k.get_argument_snapshot();
+  for (int i=0; i<int(count); ++i) {
+    k.set_argument(i%args,sizeof(int),&i);
+    inflight = k.get_argument_snapshot();
+  }
+  auto end = std::chrono::steady_clock::now();
+  auto sec = std::chrono::duration<double>(end-start).count();
+  BOOST_TEST_MESSAGE(args << " args, one changed per launch: " << count/sec << " launches/s");
+
+  start = std::chrono::steady_clock::now();
+  for (size_t i=0; i<count; ++i)
+    inflight = k.get_argument_snapshot();
+  end = std::chrono::steady_clock::now();
+  sec = std::chrono::duration<double>(end-start).count();
+  BOOST_TEST_MESSAGE(args << " args, unchanged: " << count/sec << " launches/s");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
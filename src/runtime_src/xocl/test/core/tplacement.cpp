@@ -0,0 +1,138 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "xocl/core/placement.h"
+#include "xocl/core/error.h"
+
+#include <map>
+#include <vector>
+
+namespace {
+
+using bank_info = xocl::placement_policy::bank_info;
+using memidx_type = xocl::placement_policy::memidx_type;
+
+// Emulated device with banks of equal size, allocations are
+// accounted in the bank chosen by the policy
+struct banks
+{
+  std::vector<bank_info> m_banks;
+
+  explicit
+  banks(size_t count)
+  {
+    for (size_t idx=0; idx<count; ++idx)
+      m_banks.push_back({static_cast<memidx_type>(idx),1024*1024,0});
+  }
+
+  memidx_type
+  alloc(xocl::placement_policy& policy, size_t size)
+  {
+    for (auto memidx : policy.rank(m_banks,size)) {
+      auto& bank = m_banks[memidx];
+      if (bank.used + size > bank.size)
+        continue;
+      bank.used += size;
+      return memidx;
+    }
+    return -1;
+  }
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE ( test_placement )
+
+BOOST_AUTO_TEST_CASE( test_placement_first )
+{
+  banks dev(4);
+  auto policy = xocl::create_placement_policy("first");
+  BOOST_CHECK(!policy->needs_usage());
+  BOOST_CHECK_EQUAL(dev.alloc(*policy,512*1024),0);
+  BOOST_CHECK_EQUAL(dev.alloc(*policy,512*1024),0);
+  // bank 0 is full
+  BOOST_CHECK_EQUAL(dev.alloc(*policy,1),1);
+}
+
+BOOST_AUTO_TEST_CASE( test_placement_balance )
+{
+  banks dev(4);
+  dev.m_banks[0].used = 1000;
+  dev.m_banks[2].used = 10;
+  auto policy = xocl::create_placement_policy("balance");
+  BOOST_CHECK(policy->needs_usage());
+
+  // Least used first, ties by memory index
+  auto order = policy->rank(dev.m_banks,1);
+  BOOST_CHECK((order==std::vector<memidx_type>{1,3,2,0}));
+
+  // Many buffers end up spread evenly
+  for (int i=0; i<400; ++i)
+    dev.alloc(*policy,1024);
+  for (auto& bank : dev.m_banks)
+    BOOST_CHECK(bank.used >= 100*1024 && bank.used <= 101*1024+1000);
+
+  // Relative to bank size
+  std::vector<bank_info> mixed {{0,1000,500},{1,100,60}};
+  BOOST_CHECK((policy->rank(mixed,1)==std::vector<memidx_type>{0,1}));
+}
+
+BOOST_AUTO_TEST_CASE( test_placement_stripe )
+{
+  banks dev(3);
+  auto policy = xocl::create_placement_policy("stripe");
+  BOOST_CHECK(!policy->needs_usage());
+  std::vector<memidx_type> placed;
+  for (int i=0; i<6; ++i)
+    placed.push_back(dev.alloc(*policy,1024));
+  BOOST_CHECK((placed==std::vector<memidx_type>{0,1,2,0,1,2}));
+
+  // Full bank is skipped, next buffer continues the rotation
+  dev.m_banks[1].used = dev.m_banks[1].size;
+  BOOST_CHECK_EQUAL(dev.alloc(*policy,1024),0);
+  BOOST_CHECK_EQUAL(dev.alloc(*policy,1024),2);
+  BOOST_CHECK_EQUAL(dev.alloc(*policy,1024),2);
+
+  std::vector<bank_info> none;
+  BOOST_CHECK(policy->rank(none,1).empty());
+}
+
+BOOST_AUTO_TEST_CASE( test_placement_register )
+{
+  struct reverse_placement : xocl::placement_policy
+  {
+    std::vector<memidx_type>
+    rank(const std::vector<bank_info>& banks, size_t size)
+    {
+      std::vector<memidx_type> order;
+      for (auto itr=banks.rbegin(); itr!=banks.rend(); ++itr)
+        order.push_back((*itr).memidx);
+      return order;
+    }
+  };
+
+  BOOST_CHECK_THROW(xocl::create_placement_policy("reverse"),xocl::error);
+  xocl::register_placement_policy
+    ("reverse",[]() { return std::unique_ptr<xocl::placement_policy>(new reverse_placement()); });
+
+  banks dev(4);
+  auto policy = xocl::create_placement_policy("reverse");
+  BOOST_CHECK_EQUAL(dev.alloc(*policy,1),3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,221 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include <boost/test/unit_test.hpp>
+
+#include "xocl/core/rect.h"
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct rect_args
+{
+  size_t buffer_origin[3];
+  size_t host_origin[3];
+  size_t region[3];
+  size_t buffer_row_pitch;
+  size_t buffer_slice_pitch;
+  size_t host_row_pitch;
+  size_t host_slice_pitch;
+
+  xocl::rect_transfer
+  plan() const
+  {
+    return xocl::rect_transfer(buffer_origin,host_origin,region
+                               ,buffer_row_pitch,buffer_slice_pitch
+                               ,host_row_pitch,host_slice_pitch);
+  }
+
+  size_t
+  buffer_size() const
+  {
+    return (buffer_origin[2]+region[2])*buffer_slice_pitch;
+  }
+
+  size_t
+  host_size() const
+  {
+    return (host_origin[2]+region[2])*host_slice_pitch;
+  }
+};
+
+// Row by row copy per OpenCL specification
+void
+reference_copy_to_host(const rect_args& r, const char* buffer, char* host)
+{
+  for (size_t z=0; z<r.region[2]; ++z) {
+    for (size_t y=0; y<r.region[1]; ++y) {
+      auto boffset = (r.buffer_origin[2]+z)*r.buffer_slice_pitch + (r.buffer_origin[1]+y)*r.buffer_row_pitch + r.buffer_origin[0];
+      auto hoffset = (r.host_origin[2]+z)*r.host_slice_pitch + (r.host_origin[1]+y)*r.host_row_pitch + r.host_origin[0];
+      std::memcpy(host+hoffset,buffer+boffset,r.region[0]);
+    }
+  }
+}
+
+std::vector<char>
+random_bytes(size_t size, unsigned int seed)
+{
+  std::mt19937 rng(seed);
+  std::vector<char> data(size);
+  for (auto& c : data)
+    c = static_cast<char>(rng());
+  return data;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE ( test_rect )
+
+BOOST_AUTO_TEST_CASE( test_rect_coalesce )
+{
+  // Contiguous rows and slices are one span
+  rect_args full {{0,0,0},{0,0,0},{64,8,4},64,64*8,64,64*8};
+  BOOST_CHECK_EQUAL(full.plan().get_spans().size(),1);
+  BOOST_CHECK_EQUAL(full.plan().get_size(),64*8*4);
+
+  // Rows contiguous but slices padded in host memory, one span per slice
+  rect_args slices {{0,0,0},{0,0,0},{64,8,4},64,64*8,64,64*9};
+  BOOST_CHECK_EQUAL(slices.plan().get_spans().size(),4);
+
+  // Sub-rectangle, one span per row
+  rect_args rows {{16,2,1},{0,0,0},{32,4,2},64,64*8,32,32*4};
+  auto plan = rows.plan();
+  BOOST_CHECK_EQUAL(plan.get_spans().size(),8);
+  auto range = plan.get_buffer_range();
+  BOOST_CHECK_EQUAL(range.first,64*8 + 2*64 + 16);
+  BOOST_CHECK_EQUAL(range.second,64*8 + 3*64 + 32);
+}
+
+BOOST_AUTO_TEST_CASE( test_rect_copy )
+{
+  std::mt19937 rng(7);
+  for (int i=0; i<200; ++i) {
+    rect_args r;
+    for (int d : {0,1,2}) {
+      r.region[d] = 1 + rng() % (d ? 16 : 300);
+      r.buffer_origin[d] = rng() % 4;
+      r.host_origin[d] = rng() % 4;
+    }
+    // Pitches either tight or padded
+    r.buffer_row_pitch = r.buffer_origin[0] + r.region[0] + (rng()%2 ? 0 : rng()%64);
+    r.host_row_pitch = r.host_origin[0] + r.region[0] + (rng()%2 ? 0 : rng()%64);
+    r.buffer_slice_pitch = r.buffer_row_pitch*(r.buffer_origin[1]+r.region[1]) + (rng()%2 ? 0 : rng()%64);
+    r.host_slice_pitch = r.host_row_pitch*(r.host_origin[1]+r.region[1]) + (rng()%2 ? 0 : rng()%64);
+
+    auto plan = r.plan();
+    auto buffer = random_bytes(r.buffer_size(),i);
+    for (unsigned int threads : {1,4}) {
+      std::vector<char> expected(r.host_size(),0);
+      std::vector<char> host(r.host_size(),0);
+      reference_copy_to_host(r,buffer.data(),expected.data());
+      plan.copy_to_host(buffer.data(),host.data(),threads);
+      BOOST_CHECK(host==expected);
+
+      // Write back into cleared buffer and read again
+      std::vector<char> copy(buffer.size(),0);
+      plan.copy_to_buffer(copy.data(),host.data(),threads);
+      std::vector<char> again(r.host_size(),0);
+      plan.copy_to_host(copy.data(),again.data(),threads);
+      BOOST_CHECK(again==expected);
+    }
+  }
+}
+
+// Resident buffer, the device copy has data produced by a kernel and
+// the host copy is stale.  A rect write and read sync only the spans
+// between host and device copy, as device::write_buffer_rect and
+// device::read_buffer_rect, so data outside the region is preserved.
+BOOST_AUTO_TEST_CASE( test_rect_resident )
+{
+  rect_args r {{8,1,1},{4,0,0},{24,3,2},64,64*6,32,32*4};
+  auto plan = r.plan();
+  BOOST_CHECK(plan.get_spans().size()>1);
+
+  auto sync = [&plan](const std::vector<char>& from, std::vector<char>& to) {
+    for (auto& span : plan.get_spans())
+      std::memcpy(to.data()+span.buffer_offset,from.data()+span.buffer_offset,span.size);
+  };
+
+  auto device = random_bytes(r.buffer_size(),1);
+  auto hbuf = random_bytes(r.buffer_size(),2);
+  auto host = random_bytes(r.host_size(),3);
+
+  // Write, expected device copy is kernel data with region replaced
+  auto expected = device;
+  plan.copy_to_buffer(expected.data(),host.data());
+  plan.copy_to_buffer(hbuf.data(),host.data());
+  sync(hbuf,device);
+  BOOST_CHECK(device==expected);
+
+  // Read of stale host copy, device data is read
+  hbuf = random_bytes(r.buffer_size(),4);
+  sync(device,hbuf);
+  std::vector<char> read(r.host_size(),0);
+  std::vector<char> reference(r.host_size(),0);
+  plan.copy_to_host(hbuf.data(),read.data());
+  reference_copy_to_host(r,device.data(),reference.data());
+  BOOST_CHECK(read==reference);
+}
+
+// Host side unpack of various pitches and regions, row by row versus
+// planned spans, serial and with 4 threads
+BOOST_AUTO_TEST_CASE( test_rect_benchmark )
+{
+  std::vector<rect_args> cases = {
+    // full 4K 32bpp image, tight pitches
+    {{0,0,0},{0,0,0},{4096*4,2160,1},4096*4,4096*4*2160,4096*4,4096*4*2160},
+    // 1080p window of a 4K image
+    {{64*4,64,0},{0,0,0},{1920*4,1080,1},4096*4,4096*4*2160,1920*4,1920*4*1080},
+    // narrow columns, 64 bytes per row
+    {{128,0,0},{0,0,0},{64,16384,1},4096,4096*16384,64,64*16384},
+    // volume with padded slices
+    {{0,0,0},{0,0,0},{512,256,64},512,512*256+4096,512,512*256},
+  };
+
+  for (auto& r : cases) {
+    auto buffer = random_bytes(r.buffer_size(),1);
+    std::vector<char> host(r.host_size());
+    auto plan = r.plan();
+    auto mb = plan.get_size()/(1024.0*1024.0);
+
+    auto time = [&](std::function<void()> f) {
+      auto start = std::chrono::steady_clock::now();
+      for (int i=0; i<5; ++i)
+        f();
+      auto end = std::chrono::steady_clock::now();
+      return std::chrono::duration<double>(end-start).count()/5;
+    };
+
+    auto rows = time([&] { reference_copy_to_host(r,buffer.data(),host.data()); });
+    auto spans = time([&] { r.plan().copy_to_host(buffer.data(),host.data()); });
+    auto threads = time([&] { r.plan().copy_to_host(buffer.data(),host.data(),4); });
+
+    BOOST_TEST_MESSAGE("region " << r.region[0] << "x" << r.region[1] << "x" << r.region[2]
+                       << " pitch " << r.buffer_row_pitch << "/" << r.host_row_pitch
+                       << ": " << r.region[1]*r.region[2] << " rows, " << plan.get_spans().size() << " spans"
+                       << " | rows " << mb/rows << " MB/s"
+                       << " | spans " << mb/spans << " MB/s"
+                       << " | spans 4 threads " << mb/threads << " MB/s");
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1083,6 +1083,20 @@ public:
     return bitmask;
   }
 
+  unsigned int
+  cu_address_to_control(addr_type cuaddr) const
+  {
+    if (!m_ip)
+      return AP_CTRL_HS;
+
+    for (int32_t i=0; i<m_ip->m_count; ++i) {
+      auto& ip = m_ip->m_ip_data[i];
+      if (ip.m_type==IP_KERNEL && ip.m_base_address==cuaddr)
+        return (ip.properties & IP_CONTROL_MASK) >> IP_CONTROL_SHIFT;
+    }
+    return AP_CTRL_HS;
+  }
+
   xocl::xclbin::memidx_bitmask_type
   mem_address_to_memidx(addr_type addr) const
   {
@@ -1238,6 +1252,10 @@ struct xclbin::impl
   cu_address_to_memidx(addr_type cuaddr) const
   { return m_sections.cu_address_to_memidx(cuaddr); }
 
+  unsigned int
+  cu_address_to_control(addr_type cuaddr) const
+  { return m_sections.cu_address_to_control(cuaddr); }
+
   memidx_bitmask_type
   mem_address_to_memidx(addr_type memaddr) const
   { return m_sections.mem_address_to_memidx(memaddr); }
@@ -1453,6 +1471,13 @@ cu_address_to_memidx(addr_type cuaddr) const
   return m_impl->cu_address_to_memidx(cuaddr);
 }
 
+unsigned int
+xclbin::
+cu_address_to_control(addr_type cuaddr) const
+{
+  return m_impl->cu_address_to_control(cuaddr);
+}
+
 xclbin::memidx_bitmask_type
 xclbin::
 mem_address_to_memidx(addr_type memaddr) const
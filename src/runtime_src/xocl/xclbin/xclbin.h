@@ -331,6 +331,18 @@ public:
   xocl::xclbin::memidx_bitmask_type
   cu_address_to_memidx(addr_type cu_addr) const;
 
+  /**
+   * Get the control protocol of CU at specified address
+   *
+   * @param cuaddr
+   *   The base address of CU
+   * @return
+   *   IP_CONTROL value per ip_layout (AP_CTRL_HS, AP_CTRL_CHAIN, ...),
+   *   AP_CTRL_HS if CU is not in ip_layout
+   */
+  unsigned int
+  cu_address_to_control(addr_type cuaddr) const;
+
   /**
    * Get a bitmask with mem_data indices that maps to specified address
    * @param memaddr
@@ -19,6 +19,7 @@
 #include "xrt/util/task.h"
 #include "xrt/util/event.h"
 
+#include <algorithm>
 #include <future>
 #include <cstring> // for std::memset
 
@@ -31,6 +32,22 @@ printDeviceInfo(std::ostream& ostr) const
   return m_hal->printDeviceInfo(ostr);
 }
 
+bool
+completeOpen(const std::vector<device*>& devices)
+{
+  if (devices.size() < 2)
+    return std::all_of(devices.begin(),devices.end(),[](device* d) { return d->completeOpen(); });
+
+  std::vector<std::future<bool>> opened;
+  for (auto d : devices)
+    opened.emplace_back(std::async(std::launch::async,[d] { return d->completeOpen(); }));
+
+  bool all = true;
+  for (auto& f : opened)
+    all = f.get() && all;
+  return all;
+}
+
 } // xrt
 
 
@@ -49,6 +49,8 @@ public:
   using stream_xfer_flags = hal::StreamXferFlags;
   using stream_buf = hal::StreamBuf;
   using stream_buf_handle = hal::StreamBufHandle;
+  using stream_xfer_buf = hal::StreamXferBuf;
+  using stream_xfer_completion = hal::StreamXferCompletion;
 
   explicit
   device(std::unique_ptr<hal::device>&& hal)
@@ -146,6 +148,18 @@ public:
     return m_hal->open(log,level);
   }
 
+  /**
+   * Complete an open deferred to first use of the device
+   *
+   * @returns
+   *   If the device is open then true, false otherwise
+   */
+  bool
+  completeOpen()
+  {
+    return m_hal->completeOpen();
+  }
+
   void
   close()
   {
@@ -346,6 +360,14 @@ public:
   exec_buf(const ExecBufferObjectHandle& bo)
   { return m_hal->exec_buf(bo); }
 
+  int
+  exec_buf(const ExecBufferObjectHandle& bo, const std::vector<ExecBufferObjectHandle>& waitlist)
+  { return m_hal->exec_buf(bo,waitlist); }
+
+  bool
+  hasExecBufWaitList() const
+  { return m_hal->hasExecBufWaitList(); }
+
   int
   exec_wait(int timeout_ms) const
   { return m_hal->exec_wait(timeout_ms); }
@@ -479,6 +501,24 @@ public:
     return m_hal->readStream(stream, ptr, offset, size, flags);
   };
 
+  ssize_t
+  writeStream(hal::StreamHandle stream, const hal::StreamXferBuf* bufs, size_t count, hal::StreamXferFlags flags, void* priv_data)
+  {
+    return m_hal->writeStream(stream, bufs, count, flags, priv_data);
+  }
+
+  ssize_t
+  readStream(hal::StreamHandle stream, const hal::StreamXferBuf* bufs, size_t count, hal::StreamXferFlags flags, void* priv_data)
+  {
+    return m_hal->readStream(stream, bufs, count, flags, priv_data);
+  }
+
+  int
+  pollStreams(hal::StreamXferCompletion* comps, int min_compl, int max_compl, int* actual_compl, int timeout)
+  {
+    return m_hal->pollStreams(comps, min_compl, max_compl, actual_compl, timeout);
+  }
+
 //End Streaming APIs
 #ifdef PMD_OCL
 public:
@@ -709,6 +749,12 @@ public:
     return m_hal->getDeviceTime();
   }
 
+  hal::operations_result<std::vector<uint64_t>>
+  getBankUsage()
+  {
+    return m_hal->getBankUsage();
+  }
+
   hal::operations_result<double>
   getDeviceMaxRead()
   {
@@ -828,6 +874,19 @@ private:
   bool m_setup_done;
 };
 
+/**
+ * Complete the deferred open of several devices
+ *
+ * The devices are opened in parallel, one thread per device
+ *
+ * @param devices
+ *   Devices to open, devices already open are skipped
+ * @return
+ *   True if all devices are open, false otherwise
+ */
+bool
+completeOpen(const std::vector<device*>& devices);
+
 /**
  * Construct xrt::device objects from matching hal devices
  *
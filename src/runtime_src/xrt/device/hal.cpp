@@ -16,8 +16,11 @@
 
 #include "hal.h"
 #include "xrt/util/memory.h"
+#include "xrt/util/time.h"
+#include "xrt/config.h"
 
 #include <dlfcn.h>
+#include <iostream>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 
@@ -99,6 +102,7 @@ isEmulationMode()
 static void
 createHalDevices(hal::device_list& devices, const std::string& dll, unsigned int count=0)
 {
+  auto start = xrt::time_ns();
   auto delHandle = [](void* handle){dlclose(handle);};
   typedef std::unique_ptr<void,decltype(delHandle)> handle_type;
 
@@ -131,6 +135,11 @@ createHalDevices(hal::device_list& devices, const std::string& dll, unsigned int
     else
       throw std::runtime_error("HAL version " + std::to_string(version) + " not supported");
   }
+
+  // Devices are not opened here, see hal2::device::open
+  if (xrt::config::get_xrt_debug())
+    XRT_PRINT(std::cout,"hal driver (",dll,"): devices: ",count
+              ,", time (ms): ",(xrt::time_ns()-start)*1e-6,"\n");
 }
 
 } // namespace
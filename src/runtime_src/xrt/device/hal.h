@@ -69,6 +69,29 @@ typedef uint32_t StreamAttributes;
 typedef uint32_t StreamXferFlags;
 typedef uint64_t StreamFlags;
 
+// StreamXferFlags bits
+enum stream_xfer_flag : StreamXferFlags
+{
+  STREAM_XFER_DEFAULT     = 0
+ ,STREAM_XFER_NONBLOCKING = (1 << 0) // complete through pollStreams
+ ,STREAM_XFER_EOT         = (1 << 1) // end of packet after the request
+};
+
+// One buffer of a scatter-gather stream request
+struct StreamXferBuf
+{
+  void* ptr;
+  size_t size;
+};
+
+// Completion of a non-blocking stream request
+struct StreamXferCompletion
+{
+  void* priv_data;
+  size_t nbytes;
+  int err_code;
+};
+
 /**
  * Helper class to encapsulate return values from HAL operations.
  *
@@ -153,6 +176,14 @@ public:
   virtual bool
   open(const char* log, verbosity_level l) = 0;
 
+  /**
+   * Open a device now if open() deferred it to first use
+   *
+   * @return true if the device is open
+   */
+  virtual bool
+  completeOpen() { return true; }
+
   virtual void
   close() = 0;
 
@@ -253,6 +284,31 @@ public:
     throw std::runtime_error("exec_buf not supported");
   }
 
+  /**
+   * Submit exec buffer that must not start before the exec buffers
+   * in the wait list have completed
+   *
+   * The exec buffers in the wait list must have been submitted
+   * prior to this call.
+   */
+  virtual int
+  exec_buf(const ExecBufferObjectHandle& bo, const std::vector<ExecBufferObjectHandle>& waitlist)
+  {
+    throw std::runtime_error("exec_buf with wait list not supported");
+  }
+
+  /**
+   * Check if exec buffers can be submitted with a wait list
+   *
+   * @return
+   *   true if exec_buf with wait list is supported, false otherwise
+   */
+  virtual bool
+  hasExecBufWaitList() const
+  {
+    return false;
+  }
+
   virtual int
   exec_wait(int timeout_ms) const
   {
@@ -302,6 +358,25 @@ public:
   virtual ssize_t 
   readStream(hal::StreamHandle stream, void* ptr, size_t offset, size_t size, hal::StreamXferFlags flags) = 0;
 
+  /**
+   * Write the buffers of bufs as one request.  With
+   * STREAM_XFER_NONBLOCKING the call returns 0 once the request is
+   * queued and completion is reported by pollStreams tagged with
+   * priv_data.
+   */
+  virtual ssize_t
+  writeStream(hal::StreamHandle stream, const StreamXferBuf* bufs, size_t count, hal::StreamXferFlags flags, void* priv_data) = 0;
+
+  virtual ssize_t
+  readStream(hal::StreamHandle stream, const StreamXferBuf* bufs, size_t count, hal::StreamXferFlags flags, void* priv_data) = 0;
+
+  /**
+   * Wait for at least min_compl non-blocking requests to complete,
+   * timeout in ms, negative waits forever.
+   */
+  virtual int
+  pollStreams(StreamXferCompletion* comps, int min_compl, int max_compl, int* actual_compl, int timeout) = 0;
+
 public:
   /**
    * @returns
@@ -537,6 +612,16 @@ public:
     return operations_result<size_t>();
   }
 
+  /**
+   * Bytes allocated in each memory bank, indexed by memory index, as
+   * reported by the driver
+   */
+  virtual operations_result<std::vector<uint64_t>>
+  getBankUsage()
+  {
+    return operations_result<std::vector<uint64_t>>();
+  }
+
   virtual operations_result<double>
   getDeviceMaxRead()
   {
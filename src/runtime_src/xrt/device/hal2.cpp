@@ -16,10 +16,14 @@
 
 #include "hal2.h"
 #include "xrt/util/memory.h"
+#include "xrt/util/message.h"
 #include "xrt/util/thread.h"
+#include "xrt/util/time.h"
 
+#include <cstddef>
 #include <cstring> // for std::memcpy
 #include <iostream>
+#include <mutex>
 #include <sys/mman.h> // for POSIX munmap
 
 namespace xrt { namespace hal2 {
@@ -27,6 +31,7 @@ namespace xrt { namespace hal2 {
 device::
 device(std::shared_ptr<operations> ops, unsigned int idx)
   : m_ops(std::move(ops)), m_idx(idx), m_handle(nullptr), m_devinfo{}
+  , m_open_pending(false), m_open_level(hal::verbosity_level::quiet)
 {
 }
 
@@ -44,47 +49,81 @@ std::ostream&
 device::
 printDeviceInfo(std::ostream& ostr) const
 {
-  if (!m_handle)
+  if (!handle())
     throw std::runtime_error("Can't print device info, device is not open");
-  ostr << "Name: " << m_devinfo.mName << "\n";
-  ostr << "HAL v" << m_devinfo.mHALMajorVersion << "." << m_devinfo.mHALMinorVersion << "\n";
-  ostr << "HAL vendor id: " << std::hex << m_devinfo.mVendorId << std::dec << "\n";
-  ostr << "HAL device id: " << std::hex << m_devinfo.mDeviceId << std::dec << "\n";
-  ostr << "HAL device v" << m_devinfo.mDeviceVersion << "\n";
-  ostr << "HAL subsystem id: " << std::hex << m_devinfo.mSubsystemId << std::dec << "\n";
-  ostr << "HAL subsystem vendor id: " << std::hex << m_devinfo.mSubsystemVendorId << std::dec << "\n";
-  ostr << "HAL DDR size: " << std::hex << m_devinfo.mDDRSize << std::dec << "\n";
-  ostr << "HAL Data alignment: " << m_devinfo.mDataAlignment << "\n";
-  ostr << "HAL DDR free size: " << std::hex << m_devinfo.mDDRFreeSize << std::dec << "\n";
-  ostr << "HAL Min transfer size: " << m_devinfo.mMinTransferSize << "\n";
-  ostr << "HAL OnChip Temp: " << m_devinfo.mOnChipTemp << "\n";
-  ostr << "HAL Fan Temp: " << m_devinfo.mFanTemp << "\n";
-  ostr << "HAL Voltage: " << m_devinfo.mVInt << "\n";
-  ostr << "HAL Current: " << m_devinfo.mCurrent << "\n";
-  ostr << "HAL DDR count: " << m_devinfo.mDDRBankCount << "\n";
-  ostr << "HAL OCL freq: " << m_devinfo.mOCLFrequency[0] << "\n";
-  ostr << "HAL PCIe width: " << m_devinfo.mPCIeLinkWidth << "\n";
-  ostr << "HAL PCIe speed: " << m_devinfo.mPCIeLinkSpeed << "\n";
-  ostr << "HAL DMA threads: " << m_devinfo.mDMAThreads << "\n";
+  ostr << "Name: " << devinfo().mName << "\n";
+  ostr << "HAL v" << devinfo().mHALMajorVersion << "." << devinfo().mHALMinorVersion << "\n";
+  ostr << "HAL vendor id: " << std::hex << devinfo().mVendorId << std::dec << "\n";
+  ostr << "HAL device id: " << std::hex << devinfo().mDeviceId << std::dec << "\n";
+  ostr << "HAL device v" << devinfo().mDeviceVersion << "\n";
+  ostr << "HAL subsystem id: " << std::hex << devinfo().mSubsystemId << std::dec << "\n";
+  ostr << "HAL subsystem vendor id: " << std::hex << devinfo().mSubsystemVendorId << std::dec << "\n";
+  ostr << "HAL DDR size: " << std::hex << devinfo().mDDRSize << std::dec << "\n";
+  ostr << "HAL Data alignment: " << devinfo().mDataAlignment << "\n";
+  ostr << "HAL DDR free size: " << std::hex << devinfo().mDDRFreeSize << std::dec << "\n";
+  ostr << "HAL Min transfer size: " << devinfo().mMinTransferSize << "\n";
+  ostr << "HAL OnChip Temp: " << devinfo().mOnChipTemp << "\n";
+  ostr << "HAL Fan Temp: " << devinfo().mFanTemp << "\n";
+  ostr << "HAL Voltage: " << devinfo().mVInt << "\n";
+  ostr << "HAL Current: " << devinfo().mCurrent << "\n";
+  ostr << "HAL DDR count: " << devinfo().mDDRBankCount << "\n";
+  ostr << "HAL OCL freq: " << devinfo().mOCLFrequency[0] << "\n";
+  ostr << "HAL PCIe width: " << devinfo().mPCIeLinkWidth << "\n";
+  ostr << "HAL PCIe speed: " << devinfo().mPCIeLinkSpeed << "\n";
+  ostr << "HAL DMA threads: " << devinfo().mDMAThreads << "\n";
   return ostr;
 }
 
 void
 device::
-setup()
+openDeferred() const
 {
 #ifndef PMD_OCL
-  if (!m_workers.empty())
+  std::lock_guard<std::mutex> lk(m_open_mutex);
+  if (!m_open_pending)
+    return;
+
+  auto start = time_ns();
+  auto log = m_open_log.empty() ? nullptr : m_open_log.c_str();
+  m_handle = m_ops->mOpen(m_idx,log,static_cast<hal2::verbosity_level>(m_open_level));
+  m_open_pending = false;
+  if (!m_handle) {
+    message::send(message::severity_level::ERROR,
+                  "Failed to open device (" + std::to_string(m_idx) + ") of '" + m_ops->getFileName() + "'");
     return;
+  }
+  getDeviceInfo(&m_devinfo);
+
+  if (config::get_xrt_debug())
+    XRT_PRINT(std::cout,"device open (",m_idx,"): ",m_devinfo.mName
+              ,(m_handle ? "" : " failed"),", time (ms): ",(time_ns()-start)*1e-6,"\n");
+#endif
+}
+
+void
+device::
+setup()
+{
+#ifndef PMD_OCL
+  std::call_once(m_setup_flag,&device::startWorkers,this);
+#endif
+}
 
+void
+device::
+startWorkers()
+{
+#ifndef PMD_OCL
   openOrError();
 
+  auto start = time_ns();
+
   auto threads = config::get_dma_threads(); // number of bidirectional channels
   if (!threads)
-    threads = m_devinfo.mDMAThreads;
+    threads = devinfo().mDMAThreads;
   else
-    threads = std::min(static_cast<unsigned short>(threads),m_devinfo.mDMAThreads);
-  if (!threads) // Guard against drivers who do not set m_devinfo.mDMAThreads
+    threads = std::min(static_cast<unsigned short>(threads),devinfo().mDMAThreads);
+  if (!threads) // Guard against drivers who do not set devinfo().mDMAThreads
     threads = 2;
 
   XRT_DEBUG(std::cout,"Creating ",2*threads," DMA worker threads\n");
@@ -95,6 +134,10 @@ setup()
   }
   // single misc queue worker
   m_workers.emplace_back(xrt::thread(task::worker2,std::ref(m_queue[static_cast<qtype>(hal::queue_type::misc)]),"misc"));
+
+  if (config::get_xrt_debug())
+    XRT_PRINT(std::cout,"device workers (",m_idx,"): ",m_workers.size()
+              ,", time (ms): ",(time_ns()-start)*1e-6,"\n");
 #endif
 }
 
@@ -103,7 +146,7 @@ device::
 getBufferObject(const BufferObjectHandle& boh) const
 {
   BufferObject* bo = static_cast<BufferObject*>(boh.get());
-  if (bo->owner != m_handle)
+  if (bo->owner != handle())
     throw std::runtime_error("bad buffer object");
   return bo;
 }
@@ -113,7 +156,7 @@ device::
 getExecBufferObject(const ExecBufferObjectHandle& boh) const
 {
   ExecBufferObject* bo = static_cast<ExecBufferObject*>(boh.get());
-  if (bo->owner != m_handle)
+  if (bo->owner != handle())
     throw std::runtime_error("bad exec buffer object");
   return bo;
 }
@@ -126,19 +169,19 @@ allocExecBuffer(size_t sz)
     ExecBufferObject* bo = static_cast<ExecBufferObject*>(ebo);
     XRT_DEBUG(std::cout,"deleted exec buffer object\n");
     munmap(bo->data, bo->size);
-    m_ops->mFreeBO(m_handle, bo->handle);
+    m_ops->mFreeBO(handle(), bo->handle);
     delete bo;
   };
 
   auto ubo = xrt::make_unique<ExecBufferObject>();
-  //ubo->handle = m_ops->mAllocBO(m_handle,sz,xclBOKind(0),(1<<31));  // 1<<31 xocl_ioctl.h
-  ubo->handle = m_ops->mAllocBO(m_handle,sz,xclBOKind(0),(((uint64_t)1)<<31));  // 1<<31 xocl_ioctl.h
+  //ubo->handle = m_ops->mAllocBO(handle(),sz,xclBOKind(0),(1<<31));  // 1<<31 xocl_ioctl.h
+  ubo->handle = m_ops->mAllocBO(handle(),sz,xclBOKind(0),(((uint64_t)1)<<31));  // 1<<31 xocl_ioctl.h
   if (ubo->handle == 0xffffffff)
     throw std::bad_alloc();
 
   ubo->size = sz;
-  ubo->owner = m_handle;
-  ubo->data = m_ops->mMapBO(m_handle,ubo->handle, true /* write */);
+  ubo->owner = handle();
+  ubo->data = m_ops->mMapBO(handle(),ubo->handle, true /* write */);
   if (ubo->data == (void*)(-1))
     throw std::runtime_error(std::string("map failed: ") + std::strerror(errno));
   return ExecBufferObjectHandle(ubo.release(),delBufferObject);
@@ -152,22 +195,22 @@ alloc(size_t sz)
     BufferObject* bo = static_cast<BufferObject*>(vbo);
     XRT_DEBUG(std::cout,"deleted buffer object device address(",bo->deviceAddr,",",bo->size,")\n");
     munmap(bo->hostAddr, bo->size);
-    m_ops->mFreeBO(m_handle, bo->handle);
+    m_ops->mFreeBO(handle(), bo->handle);
     delete bo;
   };
 
   xclBOKind kind = XCL_BO_DEVICE_RAM; //TODO: check default
   uint64_t flags = 0xFFFFFF; //TODO: check default, any bank.
   auto ubo = xrt::make_unique<BufferObject>();
-  ubo->handle = m_ops->mAllocBO(m_handle, sz, kind, flags);
+  ubo->handle = m_ops->mAllocBO(handle(), sz, kind, flags);
   if (ubo->handle == 0xffffffff)
     throw std::bad_alloc();
 
   ubo->kind = kind;
   ubo->size = sz;
-  ubo->owner = m_handle;
-  ubo->deviceAddr = m_ops->mGetDeviceAddr(m_handle, ubo->handle);
-  ubo->hostAddr = m_ops->mMapBO(m_handle, ubo->handle, true /*write*/);
+  ubo->owner = handle();
+  ubo->deviceAddr = m_ops->mGetDeviceAddr(handle(), ubo->handle);
+  ubo->hostAddr = m_ops->mMapBO(handle(), ubo->handle, true /*write*/);
 
   XRT_DEBUG(std::cout,"allocated buffer object device address(",ubo->deviceAddr,",",ubo->size,")\n");
   return BufferObjectHandle(ubo.release(), delBufferObject);
@@ -180,21 +223,21 @@ alloc(size_t sz,void* userptr)
   auto delBufferObject = [this](BufferObjectHandle::element_type* vbo) {
     BufferObject* bo = static_cast<BufferObject*>(vbo);
     XRT_DEBUG(std::cout,"deleted buffer object device address(",bo->deviceAddr,",",bo->size,")\n");
-    m_ops->mFreeBO(m_handle, bo->handle);
+    m_ops->mFreeBO(handle(), bo->handle);
     delete bo;
   };
 
   uint64_t flags = 0xFFFFFF; //TODO:check default
   auto ubo = xrt::make_unique<BufferObject>();
-  ubo->handle = m_ops->mAllocUserPtrBO(m_handle, userptr, sz, flags);
+  ubo->handle = m_ops->mAllocUserPtrBO(handle(), userptr, sz, flags);
   if (ubo->handle == 0xffffffff)
     throw std::bad_alloc();
 
   ubo->kind = XCL_BO_DEVICE_RAM;
   ubo->hostAddr = userptr;
-  ubo->deviceAddr = m_ops->mGetDeviceAddr(m_handle, ubo->handle);
+  ubo->deviceAddr = m_ops->mGetDeviceAddr(handle(), ubo->handle);
   ubo->size = sz;
-  ubo->owner = m_handle;
+  ubo->owner = handle();
 
   XRT_DEBUG(std::cout,"allocated buffer object device address(",ubo->deviceAddr,",",ubo->size,")\n");
   return BufferObjectHandle(ubo.release(), delBufferObject);
@@ -211,7 +254,7 @@ alloc(size_t sz, Domain domain, uint64_t memory_index, void* userptr)
     if (bo->kind != XCL_BO_DEVICE_PREALLOCATED_BRAM) {
       if (mmapRequired)
         munmap(bo->hostAddr, bo->size);
-      m_ops->mFreeBO(m_handle, bo->handle);
+      m_ops->mFreeBO(handle(), bo->handle);
     }
     delete bo;
   };
@@ -231,9 +274,9 @@ alloc(size_t sz, Domain domain, uint64_t memory_index, void* userptr)
       flags |= (1<<30);
     }
     if (userptr)
-      ubo->handle = m_ops->mAllocUserPtrBO(m_handle, userptr, sz, flags);
+      ubo->handle = m_ops->mAllocUserPtrBO(handle(), userptr, sz, flags);
     else
-      ubo->handle = m_ops->mAllocBO(m_handle, sz, kind, flags);
+      ubo->handle = m_ops->mAllocBO(handle(), sz, kind, flags);
 
     if (ubo->handle == 0xffffffff)
       throw std::bad_alloc();
@@ -242,12 +285,12 @@ alloc(size_t sz, Domain domain, uint64_t memory_index, void* userptr)
     if (userptr)
       ubo->hostAddr = userptr;
     else
-      ubo->hostAddr = m_ops->mMapBO(m_handle, ubo->handle, true /*write*/);
+      ubo->hostAddr = m_ops->mMapBO(handle(), ubo->handle, true /*write*/);
 
-    ubo->deviceAddr = m_ops->mGetDeviceAddr(m_handle, ubo->handle);
+    ubo->deviceAddr = m_ops->mGetDeviceAddr(handle(), ubo->handle);
   }
   ubo->size = sz;
-  ubo->owner = m_handle;
+  ubo->owner = handle();
 
   XRT_DEBUG(std::cout,"allocated buffer object device address(",ubo->deviceAddr,",",ubo->size,")\n");
   return BufferObjectHandle(ubo.release(), delBufferObject);
@@ -300,7 +343,7 @@ device::
 free(const BufferObjectHandle& boh)
 {
   BufferObject* bo = getBufferObject(boh);
-  m_ops->mFreeBO(m_handle, bo->handle);
+  m_ops->mFreeBO(handle(), bo->handle);
 }
 
 void
@@ -310,7 +353,7 @@ free_svm(void* svm_ptr)
   auto boh = svm_bo_lookup(svm_ptr);
   auto bo = getBufferObject(boh);
   eraseSVMBufferObjectMap(bo->hostAddr);
-  m_ops->mFreeBO(m_handle, bo->handle);
+  m_ops->mFreeBO(handle(), bo->handle);
 }
 
 event
@@ -347,9 +390,9 @@ device::sync(const BufferObjectHandle& boh, size_t sz, size_t offset, direction
 
   if (async) {
     auto qt = (dir==XCL_BO_SYNC_BO_FROM_DEVICE) ? hal::queue_type::read : hal::queue_type::write;
-    return event(addTaskF(m_ops->mSyncBO,qt,m_handle,bo->handle,dir,sz,offset));
+    return event(addTaskF(m_ops->mSyncBO,qt,handle(),bo->handle,dir,sz,offset));
   }
-  return event(typed_event<int>(m_ops->mSyncBO(m_handle, bo->handle, dir, sz, offset+bo->offset)));
+  return event(typed_event<int>(m_ops->mSyncBO(handle(), bo->handle, dir, sz, offset+bo->offset)));
 }
 
 event
@@ -357,21 +400,21 @@ device::copy(const BufferObjectHandle& dst_boh, const BufferObjectHandle& src_bo
 {
   BufferObject* dst_bo = getBufferObject(dst_boh);
   BufferObject* src_bo = getBufferObject(src_boh);
-  return event(typed_event<int>(m_ops->mCopyBO(m_handle, dst_bo->handle, src_bo->handle, sz, dst_offset, src_offset)));
+  return event(typed_event<int>(m_ops->mCopyBO(handle(), dst_bo->handle, src_bo->handle, sz, dst_offset, src_offset)));
 }
 
 size_t
 device::
 read_register(size_t offset, void* buffer, size_t size)
 {
-  return m_ops->mRead(m_handle, XCL_ADDR_KERNEL_CTRL, offset, buffer, size);
+  return m_ops->mRead(handle(), XCL_ADDR_KERNEL_CTRL, offset, buffer, size);
 }
 
 size_t
 device::
 write_register(size_t offset, const void* buffer, size_t size)
 {
-  return m_ops->mWrite(m_handle, XCL_ADDR_KERNEL_CTRL, offset, buffer, size);
+  return m_ops->mWrite(handle(), XCL_ADDR_KERNEL_CTRL, offset, buffer, size);
 }
 
 void*
@@ -407,14 +450,26 @@ device::
 exec_buf(const ExecBufferObjectHandle& boh)
 {
   auto bo = getExecBufferObject(boh);
-  return m_ops->mExecBuf(m_handle,bo->handle);
+  return m_ops->mExecBuf(handle(),bo->handle);
+}
+
+int
+device::
+exec_buf(const ExecBufferObjectHandle& boh, const std::vector<ExecBufferObjectHandle>& waitlist)
+{
+  auto bo = getExecBufferObject(boh);
+  std::vector<unsigned int> handles;
+  handles.reserve(waitlist.size());
+  for (auto& wboh : waitlist)
+    handles.push_back(getExecBufferObject(wboh)->handle);
+  return m_ops->mExecBufWithWaitList(handle(),bo->handle,handles.size(),handles.data());
 }
 
 int
 device::
 exec_wait(int timeout_ms) const
 {
-  return m_ops->mExecWait(m_handle,timeout_ms);
+  return m_ops->mExecWait(handle(),timeout_ms);
 }
 
 BufferObjectHandle
@@ -431,7 +486,7 @@ import(const BufferObjectHandle& boh)
   auto ubo = xrt::make_unique<BufferObject>();
   ubo->hostAddr = bo->hostAddr;
   ubo->size = bo->size;
-  ubo->owner = m_handle;
+  ubo->owner = handle();
   // Point to the parent exported bo; if the parent is itself an imported
   // bo point to its parent
   // Note that the max hierarchy depth is not more than 1
@@ -454,7 +509,7 @@ getMemObjectFd(const BufferObjectHandle& boh)
 {
   if (!m_ops->mExportBO)
     throw std::runtime_error("ExportBO function not found in FPGA driver. Please install latest driver");
-  return m_ops->mExportBO(m_handle, getBufferObject(boh)->handle);
+  return m_ops->mExportBO(handle(), getBufferObject(boh)->handle);
 }
 
 BufferObjectHandle
@@ -465,7 +520,7 @@ getBufferFromFd(const int fd, size_t& size, unsigned flags)
     BufferObject* bo = static_cast<BufferObject*>(vbo);
     XRT_DEBUG(std::cout,"deleted buffer object device address(",bo->deviceAddr,",",bo->size,")\n");
     munmap(bo->hostAddr, bo->size);
-    m_ops->mFreeBO(m_handle, bo->handle);
+    m_ops->mFreeBO(handle(), bo->handle);
     delete bo;
   };
 
@@ -474,17 +529,17 @@ getBufferFromFd(const int fd, size_t& size, unsigned flags)
   if (!m_ops->mImportBO)
     throw std::runtime_error("ImportBO function not found in FPGA driver. Please install latest driver");
 
-  ubo->handle = m_ops->mImportBO(m_handle, fd, flags);
+  ubo->handle = m_ops->mImportBO(handle(), fd, flags);
   if (ubo->handle == 0xffffffff)
     throw std::runtime_error("getBufferFromFd-Create XRT-BO: BOH handle is invalid");
 
 
   ubo->kind = XCL_BO_DEVICE_RAM;
-  ubo->size = m_ops->mGetBOSize(m_handle, ubo->handle);
+  ubo->size = m_ops->mGetBOSize(handle(), ubo->handle);
   size = ubo->size;
-  ubo->owner = m_handle;
-  ubo->deviceAddr = m_ops->mGetDeviceAddr(m_handle, ubo->handle);
-  ubo->hostAddr = m_ops->mMapBO(m_handle, ubo->handle, true /*write*/);
+  ubo->owner = handle();
+  ubo->deviceAddr = m_ops->mGetDeviceAddr(handle(), ubo->handle);
+  ubo->hostAddr = m_ops->mMapBO(handle(), ubo->handle, true /*write*/);
 
   return BufferObjectHandle(ubo.release(), delBufferObject);
 }
@@ -528,7 +583,7 @@ createWriteStream(hal::StreamFlags flags, hal::StreamAttributes attr, uint64_t r
   ctx.type = attr;
   ctx.route = route;
   ctx.flow = flow;
-  return m_ops->mCreateWriteQueue(m_handle,&ctx,stream);
+  return m_ops->mCreateWriteQueue(handle(),&ctx,stream);
 }
 
 int 
@@ -540,73 +595,116 @@ createReadStream(hal::StreamFlags flags, hal::StreamAttributes attr, uint64_t ro
   ctx.type = attr;
   ctx.route = route;
   ctx.flow = flow;
-  return m_ops->mCreateReadQueue(m_handle,&ctx,stream);
+  return m_ops->mCreateReadQueue(handle(),&ctx,stream);
 }
 
 int 
 device::
 closeStream(hal::StreamHandle stream) 
 {
-  return m_ops->mDestroyQueue(m_handle,stream);
+  return m_ops->mDestroyQueue(handle(),stream);
 }
 
 hal::StreamBuf
 device::
 allocStreamBuf(size_t size, hal::StreamBufHandle *buf)
 {
-  return m_ops->mAllocQDMABuf(m_handle,size,buf);
+  return m_ops->mAllocQDMABuf(handle(),size,buf);
 }
 
 int 
 device::
 freeStreamBuf(hal::StreamBufHandle buf)
 {
-  return m_ops->mFreeQDMABuf(m_handle,buf);
+  return m_ops->mFreeQDMABuf(handle(),buf);
 }
 
-ssize_t 
-device::
-writeStream(hal::StreamHandle stream, const void* ptr, size_t offset, size_t size, hal::StreamXferFlags flags) 
+namespace {
+
+// Scatter-gather list of a queue request, on the stack for the common
+// case of a few buffers
+class queue_request
 {
-  //TODO:
-  (void)offset;
-  (void)flags;
+  static const size_t inline_bufs = 16;
+  xclWRBuffer m_inline[inline_bufs];
+  std::vector<xclWRBuffer> m_heap;
+
+public:
   xclQueueRequest req;
-  xclWRBuffer buffer;
 
-  buffer.va = (uint64_t)ptr;
-  buffer.len = size;
-  buffer.buf_hdl = 0;
+  queue_request(xclQueueRequestKind kind, const hal::StreamXferBuf* bufs, size_t count,
+                hal::StreamXferFlags flags, void* priv_data)
+  {
+    xclWRBuffer* wrbufs = m_inline;
+    if (count > inline_bufs) {
+      m_heap.resize(count);
+      wrbufs = m_heap.data();
+    }
+    for (size_t i = 0; i < count; ++i) {
+      wrbufs[i].va = reinterpret_cast<uint64_t>(bufs[i].ptr);
+      wrbufs[i].len = bufs[i].size;
+      wrbufs[i].buf_hdl = 0;
+    }
+
+    std::memset(&req, 0, sizeof(req));
+    req.op_code = kind;
+    req.bufs = wrbufs;
+    req.buf_num = static_cast<uint32_t>(count);
+    req.flag = (flags & hal::STREAM_XFER_NONBLOCKING) ? XCL_QUEUE_NONBLOCKING : XCL_QUEUE_BLOCKING;
+    if (flags & hal::STREAM_XFER_EOT)
+      req.flag |= XCL_QUEUE_EOT;
+    req.priv_data = priv_data;
+  }
+};
+
+}
 
-  req.bufs = &buffer;
-  req.buf_num = 1;
-//  req,op_code = XCL_QUEUE_WRITE;
-//  req.bufs.buf = const_cast<char*>(ptr);
-//  req.bufs.len = size;
-//  req.flag = XCL_QUEUE_DEFAULT;
-  return m_ops->mWriteQueue(m_handle,stream,&req);
+ssize_t 
+device::
+writeStream(hal::StreamHandle stream, const void* ptr, size_t offset, size_t size, hal::StreamXferFlags flags) 
+{
+  hal::StreamXferBuf buf { const_cast<char*>(static_cast<const char*>(ptr)) + offset, size };
+  // A non-blocking single buffer request is tagged with its buffer
+  return writeStream(stream, &buf, 1, flags, buf.ptr);
 }
 
 ssize_t 
 device::
 readStream(hal::StreamHandle stream, void* ptr, size_t offset, size_t size, hal::StreamXferFlags flags) 
 { 
-  (void)offset;
-  (void)flags;
-  xclQueueRequest req;
-  xclWRBuffer buffer;
-
-  buffer.va = (uint64_t)ptr;
-  buffer.len = size;
-  buffer.buf_hdl = 0;
-
-  req.bufs = &buffer;
-  req.buf_num = 1;
-//  req,op_code = XCL_QUEUE_READ;
-//  req.bufs.buf = ptr;
-//  req.bufs.len = size;
-//  req.flag = XCL_QUEUE_DEFAULT;
-  return m_ops->mReadQueue(m_handle,stream,&req);
+  hal::StreamXferBuf buf { static_cast<char*>(ptr) + offset, size };
+  return readStream(stream, &buf, 1, flags, buf.ptr);
+}
+
+ssize_t
+device::
+writeStream(hal::StreamHandle stream, const hal::StreamXferBuf* bufs, size_t count, hal::StreamXferFlags flags, void* priv_data)
+{
+  queue_request qr(XCL_QUEUE_WRITE, bufs, count, flags, priv_data);
+  return m_ops->mWriteQueue(handle(),stream,&qr.req);
+}
+
+ssize_t
+device::
+readStream(hal::StreamHandle stream, const hal::StreamXferBuf* bufs, size_t count, hal::StreamXferFlags flags, void* priv_data)
+{
+  queue_request qr(XCL_QUEUE_READ, bufs, count, flags, priv_data);
+  return m_ops->mReadQueue(handle(),stream,&qr.req);
+}
+
+int
+device::
+pollStreams(hal::StreamXferCompletion* comps, int min_compl, int max_compl, int* actual_compl, int timeout)
+{
+  static_assert(sizeof(hal::StreamXferCompletion) == sizeof(xclReqCompletion)
+                && offsetof(hal::StreamXferCompletion,priv_data) == offsetof(xclReqCompletion,priv_data)
+                && offsetof(hal::StreamXferCompletion,nbytes) == offsetof(xclReqCompletion,nbytes)
+                && offsetof(hal::StreamXferCompletion,err_code) == offsetof(xclReqCompletion,err_code),
+                "StreamXferCompletion must match xclReqCompletion");
+  if (!m_ops->mPollCompletion)
+    throw std::runtime_error("pollStreams: xclPollCompletion is not supported by the driver");
+  return m_ops->mPollCompletion(handle(),min_compl,max_compl,
+                                reinterpret_cast<xclReqCompletion*>(comps),actual_compl,timeout);
 }
 
 #ifdef PMD_OCL
@@ -23,11 +23,14 @@
 
 #include <cassert>
 
+#include <atomic>
 #include <functional>
 #include <type_traits>
 #include <cstring>
 #include <memory>
 #include <map>
+#include <mutex>
+#include <string>
 
 
 namespace xrt { namespace hal2 {
@@ -50,6 +53,9 @@ using svmbomap_iterator_type = svmbomap_type::iterator;
  *
  * The number of workers supported is defined by the HAL implementation
  * and aquired through the HAL API.
+ *
+ * Opening the device and starting the workers are deferred to first use,
+ * so a process pays only for the devices it actually touches.
  */
 
 class device : public xrt::hal::device
@@ -65,8 +71,14 @@ class device : public xrt::hal::device
   std::shared_ptr<hal2::operations> m_ops;
   unsigned int m_idx;
 
-  hal2::device_handle m_handle;
-  hal2::device_info m_devinfo;
+  // Set by the deferred open on first use, see handle()
+  mutable hal2::device_handle m_handle;
+  mutable hal2::device_info m_devinfo;
+  mutable std::atomic<bool> m_open_pending;
+  mutable std::mutex m_open_mutex;
+  std::string m_open_log;
+  hal::verbosity_level m_open_level;
+  std::once_flag m_setup_flag;
 
   struct BufferObject : hal::buffer_object
   {
@@ -95,10 +107,34 @@ class device : public xrt::hal::device
   ExecBufferObject*
   getExecBufferObject(const ExecBufferObjectHandle& boh) const;
 
+  void
+  openDeferred() const;
+
+  void
+  startWorkers();
+
+  /**
+   * The device handle, opening the device if open() was deferred
+   */
+  hal2::device_handle
+  handle() const
+  {
+    if (m_open_pending)
+      openDeferred();
+    return m_handle;
+  }
+
+  const hal2::device_info&
+  devinfo() const
+  {
+    handle();
+    return m_devinfo;
+  }
+
   void
   openOrError() const
   {
-    if (!m_handle)
+    if (!handle())
       throw std::runtime_error("hal::device is not open");
   }
 
@@ -117,6 +153,7 @@ class device : public xrt::hal::device
   task::queue&
   get_queue(hal::queue_type qt)
   {
+    setup();
     return m_queue[static_cast<qtype>(qt)];
   }
 
@@ -176,33 +213,45 @@ public:
    * Prepare the hal2 device for actual use
    *
    * If the device supports DMA threads then they are started by
-   * this function.
+   * this function.  The threads are started once, on first call,
+   * which is also done by the first task added to a queue.
    */
   void
   setup();
 
+  /**
+   * Open the device
+   *
+   * The device is opened on first use, open() records the arguments
+   * only and always succeeds.  Use completeOpen() to open it now and
+   * to know if the device could be opened.  A failed open is logged,
+   * the info of a device that is not open is zeroed.
+   */
   virtual bool
   open(const char* log, hal::verbosity_level level)
   {
-    bool retval = false;
-    if (m_handle)
+    std::lock_guard<std::mutex> lk(m_open_mutex);
+    if (m_handle || m_open_pending)
       throw std::runtime_error("device is already open");
-#ifdef PMD_OCL
-    assert(0);
-#else
-    m_handle=m_ops->mOpen(m_idx,log,static_cast<hal2::verbosity_level>(level));
-    if (m_handle)
-      retval = true;
-#endif
-    getDeviceInfo(&m_devinfo);
-    return retval;
+    m_open_log = log ? log : "";
+    m_open_level = level;
+    m_open_pending = true;
+    return true;
+  }
+
+  virtual bool
+  completeOpen()
+  {
+    return handle() != nullptr;
   }
 
   virtual void
   close()
   {
+    std::lock_guard<std::mutex> lk(m_open_mutex);
+    m_open_pending = false;
     if (m_handle) {
-      m_ops->mClose(m_handle);
+      m_ops->mClose(handle());
       m_handle=nullptr;
     }
   }
@@ -210,7 +259,7 @@ public:
   virtual task::queue*
   getQueue(hal::queue_type qt)
   {
-    return &m_queue[static_cast<qtype>(qt)];
+    return &get_queue(qt);
   }
 
   virtual std::string
@@ -222,32 +271,32 @@ public:
   virtual std::string
   getName() const
   {
-    return m_devinfo.mName;
+    return devinfo().mName;
   }
 
   virtual unsigned int
   getBankCount() const
   {
-    return m_devinfo.mDDRBankCount;
+    return devinfo().mDDRBankCount;
   }
 
   virtual size_t
   getDdrSize() const override
   {
-    return m_devinfo.mDDRSize;
+    return devinfo().mDDRSize;
   }
 
   virtual size_t
   getAlignment() const
   {
     openOrError();
-    return m_devinfo.mDataAlignment;
+    return devinfo().mDataAlignment;
   }
 
   virtual range<const unsigned short*>
   getClockFrequencies() const
   {
-    return {m_devinfo.mOCLFrequency,m_devinfo.mOCLFrequency+4};
+    return {devinfo().mOCLFrequency,devinfo().mOCLFrequency+4};
   }
 
   virtual std::ostream&
@@ -313,6 +362,15 @@ public:
   virtual int
   exec_buf(const ExecBufferObjectHandle& bo);
 
+  virtual int
+  exec_buf(const ExecBufferObjectHandle& bo, const std::vector<ExecBufferObjectHandle>& waitlist);
+
+  virtual bool
+  hasExecBufWaitList() const
+  {
+    return m_ops->mExecBufWithWaitList!=nullptr;
+  }
+
   virtual int
   exec_wait(int timeout_ms) const;
 
@@ -339,6 +397,15 @@ public:
   virtual ssize_t 
   readStream(hal::StreamHandle stream, void* ptr, size_t offset, size_t size, hal::StreamXferFlags flags);
 
+  virtual ssize_t
+  writeStream(hal::StreamHandle stream, const hal::StreamXferBuf* bufs, size_t count, hal::StreamXferFlags flags, void* priv_data);
+
+  virtual ssize_t
+  readStream(hal::StreamHandle stream, const hal::StreamXferBuf* bufs, size_t count, hal::StreamXferFlags flags, void* priv_data);
+
+  virtual int
+  pollStreams(hal::StreamXferCompletion* comps, int min_compl, int max_compl, int* actual_compl, int timeout);
+
 public:
   virtual uint64_t
   getDeviceAddr(const BufferObjectHandle& boh);
@@ -355,7 +422,7 @@ public:
   {
     if (!m_ops->mLockDevice)
       return hal::operations_result<int>();
-    return m_ops->mLockDevice(m_handle);
+    return m_ops->mLockDevice(handle());
   }
 
   virtual hal::operations_result<int>
@@ -363,7 +430,7 @@ public:
   {
     if (!m_ops->mUnlockDevice)
       return hal::operations_result<int>();
-    return m_ops->mUnlockDevice(m_handle);
+    return m_ops->mUnlockDevice(handle());
   }
 
   virtual hal::operations_result<int>
@@ -372,7 +439,7 @@ public:
     if (!m_ops->mLoadXclBin)
       return hal::operations_result<int>();
 
-    hal::operations_result<int> ret = m_ops->mLoadXclBin(m_handle,xclbin);
+    hal::operations_result<int> ret = m_ops->mLoadXclBin(handle(),xclbin);
     // refresh device info on successful load
     if (!ret.get())
       getDeviceInfo(&m_devinfo);
@@ -385,7 +452,7 @@ public:
   {
     // PCIe DSAs have device DDRs which allow bank allocation/selection
     // Zynq PL based devices set device id to 0xffff.
-    return (m_devinfo.mDeviceId != 0xffff);
+    return (devinfo().mDeviceId != 0xffff);
   }
 
   virtual hal::operations_result<ssize_t>
@@ -393,7 +460,7 @@ public:
   {
     if (!m_ops->mRead)
       return hal::operations_result<ssize_t>();
-    return m_ops->mRead(m_handle,XCL_ADDR_KERNEL_CTRL,offset,hbuf,size);
+    return m_ops->mRead(handle(),XCL_ADDR_KERNEL_CTRL,offset,hbuf,size);
   }
 
   virtual hal::operations_result<ssize_t>
@@ -401,7 +468,7 @@ public:
   {
     if (!m_ops->mWrite)
       return hal::operations_result<ssize_t>();
-    return m_ops->mWrite(m_handle,XCL_ADDR_KERNEL_CTRL,offset,hbuf,size);
+    return m_ops->mWrite(handle(),XCL_ADDR_KERNEL_CTRL,offset,hbuf,size);
   }
 
   virtual hal::operations_result<int>
@@ -409,7 +476,7 @@ public:
   {
     if (!m_ops->mReClock2)
       return hal::operations_result<int>();
-    return m_ops->mReClock2(m_handle, region, freqMHz);
+    return m_ops->mReClock2(handle(), region, freqMHz);
   }
 
   // Following functions are profiling functions
@@ -418,7 +485,7 @@ public:
   {
     if (!m_ops->mClockTraining)
       return hal::operations_result<size_t>();
-    return m_ops->mClockTraining(m_handle,type);
+    return m_ops->mClockTraining(handle(),type);
   }
 
   virtual hal::operations_result<uint32_t>
@@ -426,7 +493,7 @@ public:
   {
     if (!m_ops->mCountTrace)
       return hal::operations_result<uint32_t>();
-    return m_ops->mCountTrace(m_handle,type);
+    return m_ops->mCountTrace(handle(),type);
   }
 
   virtual hal::operations_result<double>
@@ -434,7 +501,7 @@ public:
   {
     if (!m_ops->mGetDeviceClock)
       return hal::operations_result<double>();
-    return m_ops->mGetDeviceClock(m_handle);
+    return m_ops->mGetDeviceClock(handle());
   }
 
   virtual hal::operations_result<size_t>
@@ -442,7 +509,17 @@ public:
   {
     if (!m_ops->mGetDeviceTime)
       return hal::operations_result<size_t>();
-    return m_ops->mGetDeviceTime(m_handle);
+    return m_ops->mGetDeviceTime(handle());
+  }
+
+  virtual hal::operations_result<std::vector<uint64_t>>
+  getBankUsage()
+  {
+    xclDeviceUsage info;
+    if (!m_ops->mGetUsageInfo || m_ops->mGetUsageInfo(handle(),&info))
+      return hal::operations_result<std::vector<uint64_t>>();
+    auto count = sizeof(info.ddrMemUsed)/sizeof(info.ddrMemUsed[0]);
+    return std::vector<uint64_t>(info.ddrMemUsed,info.ddrMemUsed+count);
   }
 
   virtual hal::operations_result<double>
@@ -450,7 +527,7 @@ public:
   {
     if (!m_ops->mGetDeviceMaxRead)
       return hal::operations_result<double>();
-    return m_ops->mGetDeviceMaxRead(m_handle);
+    return m_ops->mGetDeviceMaxRead(handle());
   }
 
   virtual hal::operations_result<double>
@@ -458,7 +535,7 @@ public:
   {
     if (!m_ops->mGetDeviceMaxWrite)
       return hal::operations_result<double>();
-    return m_ops->mGetDeviceMaxWrite(m_handle);
+    return m_ops->mGetDeviceMaxWrite(handle());
   }
 
   virtual hal::operations_result<size_t>
@@ -466,7 +543,7 @@ public:
   {
     if (!m_ops->mReadCounters)
       return hal::operations_result<size_t>();
-    return m_ops->mReadCounters(m_handle,type,results);
+    return m_ops->mReadCounters(handle(),type,results);
   }
 
   virtual hal::operations_result<size_t>
@@ -474,7 +551,7 @@ public:
   {
     if (!m_ops->mDebugReadIPStatus)
       return hal::operations_result<size_t>();
-    return m_ops->mDebugReadIPStatus(m_handle, type, (void*)results);
+    return m_ops->mDebugReadIPStatus(handle(), type, (void*)results);
   }
 
   virtual hal::operations_result<size_t>
@@ -482,7 +559,7 @@ public:
   {
     if (!m_ops->mReadTrace)
       return hal::operations_result<size_t>();
-    return m_ops->mReadTrace(m_handle,type, vec);
+    return m_ops->mReadTrace(handle(),type, vec);
   }
 
   virtual hal::operations_result<void>
@@ -490,7 +567,7 @@ public:
   {
     if (!m_ops->mSetProfilingSlots)
       return hal::operations_result<void>();
-    m_ops->mSetProfilingSlots(m_handle,type,slots);
+    m_ops->mSetProfilingSlots(handle(),type,slots);
     return hal::operations_result<void>(0);
   }
 
@@ -499,7 +576,7 @@ public:
   {
     if (!m_ops->mGetProfilingSlots)
       return hal::operations_result<uint32_t>();
-    return m_ops->mGetProfilingSlots(m_handle,type);
+    return m_ops->mGetProfilingSlots(handle(),type);
   }
 
   virtual hal::operations_result<void>
@@ -508,7 +585,7 @@ public:
   {
     if (!m_ops->mGetProfilingSlotName)
       return hal::operations_result<void>();
-    m_ops->mGetProfilingSlotName(m_handle,type,slotnum,slotName,length);
+    m_ops->mGetProfilingSlotName(handle(),type,slotnum,slotName,length);
     return hal::operations_result<void>(0);
   }
 
@@ -517,7 +594,7 @@ public:
   {
     if (!m_ops->mWriteHostEvent)
       return hal::operations_result<void>();
-    m_ops->mWriteHostEvent(m_handle,type,id);
+    m_ops->mWriteHostEvent(handle(),type,id);
     return hal::operations_result<void>(0);
   }
 
@@ -526,7 +603,7 @@ public:
   {
     if (!m_ops->mStartCounters)
       return hal::operations_result<size_t>();
-    return m_ops->mStartCounters(m_handle,type);
+    return m_ops->mStartCounters(handle(),type);
   }
 
   virtual hal::operations_result<size_t>
@@ -534,7 +611,7 @@ public:
   {
     if (!m_ops->mStartTrace)
       return hal::operations_result<size_t>();
-    return m_ops->mStartTrace(m_handle,type,options);
+    return m_ops->mStartTrace(handle(),type,options);
   }
 
   virtual hal::operations_result<size_t>
@@ -542,7 +619,7 @@ public:
   {
     if (!m_ops->mStopCounters)
       return hal::operations_result<size_t>();
-    return m_ops->mStopCounters(m_handle,type);
+    return m_ops->mStopCounters(handle(),type);
   }
 
   virtual hal::operations_result<size_t>
@@ -550,7 +627,7 @@ public:
   {
     if (!m_ops->mStopTrace)
       return hal::operations_result<size_t>();
-    return m_ops->mStopTrace(m_handle,type);
+    return m_ops->mStopTrace(handle(),type);
   }
 };
 
@@ -34,6 +34,7 @@ operations(const std::string &fileName, void *fileHandle, unsigned int count)
   ,mExportBO(0)
   ,mGetBOProperties(0)
   ,mExecBuf(0)
+  ,mExecBufWithWaitList(0)
   ,mExecWait(0)
   ,mFreeBO(0)
   ,mWriteBO(0)
@@ -47,6 +48,7 @@ operations(const std::string &fileName, void *fileHandle, unsigned int count)
   ,mLockDevice(0)
   ,mUnlockDevice(0)
   ,mGetDeviceInfo(0)
+  ,mGetUsageInfo(0)
   ,mGetDeviceTime(0)
   ,mGetDeviceClock(0)
   ,mGetDeviceMaxRead(0)
@@ -70,6 +72,7 @@ operations(const std::string &fileName, void *fileHandle, unsigned int count)
   ,mFreeQDMABuf(0)
   ,mWriteQueue(0)
   ,mReadQueue(0)
+  ,mPollCompletion(0)
 {
   mProbe = (probeFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclProbe");
   if (!mProbe)
@@ -95,6 +98,7 @@ operations(const std::string &fileName, void *fileHandle, unsigned int count)
 
   mGetBOProperties = (getBOPropertiesFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclGetBOProperties");
   mExecBuf = (execBOFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclExecBuf");
+  mExecBufWithWaitList = (execBOWithWaitListFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclExecBufWithWaitList");
   mExecWait = (execWaitFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclExecWait");
 
   mFreeBO   = (freeBOFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclFreeBO");
@@ -122,6 +126,7 @@ operations(const std::string &fileName, void *fileHandle, unsigned int count)
   mLockDevice = (lockDeviceFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclLockDevice");
   mUnlockDevice = (unlockDeviceFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclUnlockDevice");
   mGetDeviceInfo = (getDeviceInfoFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclGetDeviceInfo2");
+  mGetUsageInfo = (getUsageInfoFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclGetUsageInfo");
 
   mCreateWriteQueue = (createWriteQueueFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclCreateWriteQueue");
   mCreateReadQueue = (createReadQueueFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclCreateReadQueue");
@@ -130,6 +135,7 @@ operations(const std::string &fileName, void *fileHandle, unsigned int count)
   mFreeQDMABuf = (freeQDMABufFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclFreeQDMABuf");
   mWriteQueue = (writeQueueFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclWriteQueue");
   mReadQueue = (readQueueFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclReadQueue");
+  mPollCompletion = (pollCompletionFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclPollCompletion");
 
   mGetDeviceTime = (getDeviceTimeFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclGetDeviceTimestamp");
   if (!mGetDeviceTime)
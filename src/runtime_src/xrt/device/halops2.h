@@ -62,6 +62,7 @@ private:
   typedef unsigned int (*exportBOFuncType)(xclDeviceHandle handle, unsigned int boHandle);
   typedef int (*getBOPropertiesFuncType)(xclDeviceHandle handle, unsigned int boHandle, xclBOProperties*);
   typedef unsigned int (*execBOFuncType)(xclDeviceHandle handle, unsigned int cmdBO);
+  typedef int (*execBOWithWaitListFuncType)(xclDeviceHandle handle, unsigned int cmdBO, size_t num_bo_in_wait_list, unsigned int *bo_wait_list);
   typedef int (*execWaitFuncType)(xclDeviceHandle handle, int timeoutMS);
 
   typedef void (* freeBOFuncType)(xclDeviceHandle handle, unsigned int boHandle);
@@ -86,6 +87,7 @@ private:
   typedef int (* unlockDeviceFuncType)(xclDeviceHandle handle);
 
   typedef int (* getDeviceInfoFuncType)(xclDeviceHandle handle, xclDeviceInfo2 *info);
+  typedef int (* getUsageInfoFuncType)(xclDeviceHandle handle, xclDeviceUsage *info);
 
   typedef size_t (* getDeviceTimeFuncType)(xclDeviceHandle handle);
   typedef double (* getDeviceClockFuncType)(xclDeviceHandle handle);
@@ -119,6 +121,7 @@ private:
   typedef int     (*freeQDMABufFuncType)(xclDeviceHandle handle,uint64_t buf_hdl);
   typedef ssize_t (*writeQueueFuncType)(xclDeviceHandle handle,uint64_t q_hdl, xclQueueRequest *wr);
   typedef ssize_t (*readQueueFuncType)(xclDeviceHandle handle,uint64_t q_hdl, xclQueueRequest *wr);
+  typedef int     (*pollCompletionFuncType)(xclDeviceHandle handle, int min_compl, int max_compl, xclReqCompletion *comps, int* actual_compl, int timeout);
 //End Streaming
 //
 #if 0
@@ -156,6 +159,7 @@ public:
   getBOPropertiesFuncType mGetBOProperties;
 
   execBOFuncType mExecBuf;
+  execBOWithWaitListFuncType mExecBufWithWaitList;
   execWaitFuncType mExecWait;
 
   freeBOFuncType mFreeBO;
@@ -170,6 +174,7 @@ public:
   lockDeviceFuncType mLockDevice;
   unlockDeviceFuncType mUnlockDevice;
   getDeviceInfoFuncType mGetDeviceInfo;
+  getUsageInfoFuncType mGetUsageInfo;
 
   getDeviceTimeFuncType mGetDeviceTime;
   getDeviceClockFuncType mGetDeviceClock;
@@ -196,6 +201,7 @@ public:
   freeQDMABufFuncType mFreeQDMABuf;
   writeQueueFuncType mWriteQueue;
   readQueueFuncType mReadQueue;
+  pollCompletionFuncType mPollCompletion;
 //End Streaming
 
 #if 0
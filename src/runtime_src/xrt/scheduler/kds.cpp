@@ -43,7 +43,21 @@
 namespace {
 
 using command_type = std::shared_ptr<xrt::command>;
-using command_queue_type = std::list<command_type>;
+using command_list_type = std::vector<command_type>;
+
+// A command along with the commands it waits on.  The wait list is
+// kept until the command is done, so that the exec buffers of the
+// commands waited on are not recycled while the command is pending
+struct command_entry
+{
+  command_type cmd;
+  command_list_type waitlist;
+};
+
+using command_queue_type = std::list<command_entry>;
+
+// Max number of exec buffers in wait list per kernel driver
+static const size_t max_waitlist = ERT_MAX_WAIT_LIST;
 
 ////////////////////////////////////////////////////////////////
 // Command notification is threaded through task queue
@@ -63,6 +77,7 @@ static bool s_running = false;
 static bool s_stop = false;
 static std::exception_ptr s_exception;
 static std::map<const xrt::device*, command_queue_type> s_device_cmds;
+static std::map<const xrt::device*, command_queue_type> s_device_waiting_cmds;
 static std::map<const xrt::device*, std::thread> s_device_monitor_threads;
 
 inline bool
@@ -99,22 +114,85 @@ check(const command_type& cmd)
   return true;
 }
 
+// Remove completed commands from wait list
+static void
+prune(command_list_type& waitlist)
+{
+  waitlist.erase(std::remove_if(waitlist.begin(),waitlist.end(),is_command_done),waitlist.end());
+}
+
+// Check if a command in the wait list is itself waiting to be
+// submitted, the kernel driver can wait only on submitted commands
+static bool
+waits_on_waiting(const command_list_type& waitlist, const command_queue_type& waiting_cmds)
+{
+  for (auto& entry : waiting_cmds)
+    if (std::find(waitlist.begin(),waitlist.end(),entry.cmd)!=waitlist.end())
+      return true;
+  return false;
+}
+
+static void
+exec_buf(const command_entry& entry)
+{
+  auto device = entry.cmd->get_device();
+  auto exec_bo = entry.cmd->get_exec_bo();
+  if (entry.waitlist.empty()) {
+    device->exec_buf(exec_bo);
+    return;
+  }
+
+  std::vector<xrt::device::ExecBufferObjectHandle> waitlist;
+  for (auto& wcmd : entry.waitlist)
+    waitlist.push_back(wcmd->get_exec_bo());
+  device->exec_buf(exec_bo,waitlist);
+}
+
 static void
-launch(command_type cmd)
+launch(command_type cmd, command_list_type waitlist)
 {
   XRT_DEBUG(std::cout,"xrt::kds::command(",cmd->get_uid(),") [new->submitted->running]\n");
 
-  // Submit the command
   auto device = cmd->get_device();
-  auto exec_bo = cmd->get_exec_bo();
-  device->exec_buf(exec_bo);
 
   // thread safe access, since guaranteed to be inserted in init
   auto& submitted_cmds = s_device_cmds[device];
+  auto& waiting_cmds = s_device_waiting_cmds[device];
+
+  command_entry entry {std::move(cmd),std::move(waitlist)};
+  prune(entry.waitlist);
+
+  if (entry.waitlist.empty()) {
+    // Submit the command
+    exec_buf(entry);
+
+    // Store command so completion can be tracked
+    std::lock_guard<std::mutex> lk(s_mutex);
+    submitted_cmds.push_back(std::move(entry));
+    s_work.notify_all();
+    return;
+  }
 
-  // Store command so completion can be tracked
+  // The wait list is checked again under lock, a command that waits
+  // in the monitor is submitted when the monitor sees the commands
+  // it waits on complete
   std::lock_guard<std::mutex> lk(s_mutex);
-  submitted_cmds.push_back(cmd);
+  prune(entry.waitlist);
+
+  // The kernel driver starts the command when the commands in its
+  // wait list complete.  If the driver does not support a wait list,
+  // then the command waits in the monitor.
+  if (entry.waitlist.empty()
+      || (device->hasExecBufWaitList()
+          && entry.waitlist.size()<=max_waitlist
+          && !waits_on_waiting(entry.waitlist,waiting_cmds))) {
+    exec_buf(entry);
+    submitted_cmds.push_back(std::move(entry));
+  }
+  else {
+    XRT_DEBUG(std::cout,"xrt::kds::command(",entry.cmd->get_uid(),") waits on ",entry.waitlist.size()," commands\n");
+    waiting_cmds.push_back(std::move(entry));
+  }
   s_work.notify_all();
 }
 
@@ -126,6 +204,7 @@ monitor_loop(const xrt::device* device)
 
   // thread safe access, since guaranteed to be inserted in init
   auto& submitted_cmds = s_device_cmds[device];
+  auto& waiting_cmds = s_device_waiting_cmds[device];
 
   while (1) {
     ++loops;
@@ -150,7 +229,7 @@ monitor_loop(const xrt::device* device)
       std::lock_guard<std::mutex> lk(s_mutex);
       auto end = submitted_cmds.end();
       for (auto itr=submitted_cmds.begin(); itr!=end; ) {
-        auto& cmd = (*itr);
+        auto& cmd = (*itr).cmd;
         if (check(cmd)) {
           itr = submitted_cmds.erase(itr);
           end = submitted_cmds.end();
@@ -159,6 +238,19 @@ monitor_loop(const xrt::device* device)
           ++itr;
         }
       }
+
+      // Submit waiting commands whose wait list is done
+      for (auto itr=waiting_cmds.begin(); itr!=waiting_cmds.end(); ) {
+        prune((*itr).waitlist);
+        if ((*itr).waitlist.empty()) {
+          XRT_DEBUG(std::cout,"xrt::kds::command(",(*itr).cmd->get_uid(),") [waiting->submitted]\n");
+          exec_buf(*itr);
+          submitted_cmds.splice(submitted_cmds.end(),waiting_cmds,itr++);
+        }
+        else {
+          ++itr;
+        }
+      }
     }
   }
 }
@@ -191,7 +283,13 @@ namespace xrt { namespace kds {
 void
 schedule(const command_type& cmd)
 {
-  launch(cmd);
+  launch(cmd,command_list_type());
+}
+
+void
+schedule(const command_type& cmd, const command_list_type& waitlist)
+{
+  launch(cmd,waitlist);
 }
 
 void
@@ -280,6 +378,7 @@ init(xrt::device* device, size_t regmap_size, bool cu_isr, size_t num_cus, size_
   if (itr==s_device_monitor_threads.end()) {
     XRT_DEBUG(std::cout,"creating monitor thread and queue for device '",device->getName(),"'\n");
     s_device_cmds.emplace(device,command_queue_type());
+    s_device_waiting_cmds.emplace(device,command_queue_type());
     s_device_monitor_threads.emplace(device,xrt::thread(::monitor,device));
   }
 
@@ -138,6 +138,15 @@ schedule(const command_type& cmd)
     sws::schedule(cmd);
 }
 
+void
+schedule(const command_type& cmd, const command_list_type& waitlist)
+{
+  if (kds_enabled())
+    kds::schedule(cmd,waitlist);
+  else
+    sws::schedule(cmd,waitlist);
+}
+
 void
 init(xrt::device* device, size_t regmap_size, bool cu_isr, size_t num_cus, size_t cu_offset, size_t cu_base_addr, const std::vector<uint32_t>& cu_addr_map)
 {
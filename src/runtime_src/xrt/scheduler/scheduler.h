@@ -23,6 +23,7 @@
 namespace xrt { 
 
 using command_type = std::shared_ptr<command>;
+using command_list_type = std::vector<command_type>;
 
 /**
  * Software command scheduling
@@ -52,6 +53,13 @@ init(xrt::device* device, size_t slot_size, size_t num_cus, size_t cu_offset, si
 void 
 schedule(const command_type& cmd);
 
+/**
+ * Schedule a command for execution when the commands in the
+ * wait list have completed
+ */
+void
+schedule(const command_type& cmd, const command_list_type& waitlist);
+
 } // sws
 
 /**
@@ -81,6 +89,9 @@ namespace kds {
 void 
 schedule(const command_type& cmd);
 
+void
+schedule(const command_type& cmd, const command_list_type& waitlist);
+
 void
 start();
 
@@ -99,6 +110,17 @@ namespace scheduler {
 void 
 schedule(const command_type& cmd);
 
+/**
+ * Schedule a command for execution on either sws or mbs
+ *
+ * The command is started by the scheduler when the commands in the
+ * wait list have completed, the host is not involved in resolving
+ * the dependencies.  The commands in the wait list must have been
+ * scheduled prior to this call.
+ */
+void
+schedule(const command_type& cmd, const command_list_type& waitlist);
+
 void
 start();
 
@@ -27,9 +27,11 @@
 #include "xrt/util/task.h"
 #include "command.h"
 #include <limits>
+#include <algorithm>
 #include <bitset>
 #include <vector>
 #include <list>
+#include <deque>
 #include <mutex>
 #include <condition_variable>
 
@@ -42,6 +44,7 @@ using size_type = uint32_t;
 using addr_type = uint32_t;
 using value_type = uint32_t;
 using command_type = std::shared_ptr<xrt::command>;
+using command_list_type = std::vector<command_type>;
 
 ////////////////////////////////////////////////////////////////
 // Constants
@@ -53,6 +56,11 @@ using bitmask_type = std::bitset<max_cus>;
 const size_type CONTROL_AP_START=1;
 const size_type CONTROL_AP_DONE=2;
 const size_type CONTROL_AP_IDLE=4;
+const size_type CONTROL_AP_READY=8;
+const size_type CONTROL_AP_CONTINUE=0x10;
+
+// Max outstanding invocations of a chained CU
+const size_type max_cu_chain = 4;
 
 ////////////////////////////////////////////////////////////////
 // Command opcodes
@@ -78,6 +86,9 @@ static value_type cu_trace_enabled = 0;
 // Mapping from cu_idx to its base address
 static std::vector<uint32_t> cu_addr_map;
 
+// Chained CUs (ap_ctrl_chain) per ERT_CU_CTRL_CHAIN in CU address
+static bitmask_type cu_chain;
+
 ////////////////////////////////////////////////////////////////
 // Helper functions for extracting command header information
 ////////////////////////////////////////////////////////////////
@@ -140,10 +151,18 @@ struct slot_info
   // free    [0x4]: the command slot is free
   value_type header_value = 0;
 
+  // Commands that must complete before this command can start
+  command_list_type waitlist;
+
   slot_info(command_type xcmd)
     : cmd(std::move(xcmd)), device(cmd->get_device()), header_value(cmd->get_header())
   {}
 
+  slot_info(command_type xcmd, command_list_type xwaitlist)
+    : cmd(std::move(xcmd)), device(cmd->get_device()), header_value(cmd->get_header())
+    , waitlist(std::move(xwaitlist))
+  {}
+
   unsigned int
   get_uid() const
   {
@@ -193,6 +212,12 @@ static const slot_info* cu_slot_usage[max_cus];
 // Only 'num_cus' lower bits are used
 static bitmask_type cu_status;
 
+// Outstanding invocations of chained CUs in order of start, a
+// chained CU can be started again when AP_READY is seen after
+// previous start, its invocations complete in order
+static std::deque<slot_info*> cu_chain_slots[max_cus];
+static bitmask_type cu_ready;
+
 // Track runtime of each cu
 static uint64_t cu_total_runtime[max_cus] = {0};
 static uint64_t cu_start_time[max_cus] = {0};
@@ -213,7 +238,9 @@ setup()
     cu_total_runtime[i] = 0;
     cu_start_time[i] = 0;
     cu_stop_time[i] = 0;
+    cu_chain_slots[i].clear();
   }
+  cu_ready.reset();
 }
 
 /**
@@ -298,12 +325,94 @@ start_cu(slot_info* slot)
       configure_cu(slot,cu);
       cu_status.flip(cu);        // toggle cu status bit, it is now busy
       cu_slot_usage[cu] = slot;
+      if (cu_chain.test(cu)) {
+        cu_chain_slots[cu].push_back(slot);
+        cu_ready.reset(cu);      // busy until AP_READY
+      }
       return true;
     }
   }
   return false;
 }
 
+/**
+ * Mark command packet completed, same as kernel driver scheduler.
+ * The packet state is how commands waiting on this command see that
+ * it is done.
+ */
+inline void
+set_completed(slot_info* slot)
+{
+  auto epacket = xrt::command_cast<ert_packet*>(slot->cmd);
+  epacket->state = ERT_CMD_STATE_COMPLETED;
+}
+
+/**
+ * Check if commands in wait list of slot have completed
+ *
+ * Completed commands are removed from the wait list
+ */
+static bool
+check_waitlist(slot_info* slot)
+{
+  auto& waitlist = slot->waitlist;
+  waitlist.erase(std::remove_if(waitlist.begin(),waitlist.end(),
+                                [](const command_type& cmd) {
+                                  return xrt::command_cast<ert_packet*>(cmd)->state >= ERT_CMD_STATE_COMPLETED;
+                                })
+                 ,waitlist.end());
+  return waitlist.empty();
+}
+
+/**
+ * Complete command in slot
+ */
+static void
+slot_done(slot_info* slot)
+{
+  set_completed(slot);
+  notify_host(slot);
+  slot->header_value = (slot->header_value & ~0xF) | 0x4; // free
+  XRT_DEBUGF("slot(%d) [running->free]\n",slot->get_uid());
+}
+
+/**
+ * Check status of chained CU
+ *
+ * AP_READY means the CU accepted its most recent start and can be
+ * started again.  AP_DONE means the oldest outstanding invocation is
+ * done, it is acknowledged with AP_CONTINUE.  The CU remains busy
+ * in cu_status until AP_READY is seen or while max_cu_chain
+ * invocations are outstanding.
+ *
+ * @return
+ *   Slot of oldest invocation if done, nullptr otherwise
+ */
+static slot_info*
+check_chain_cu(xrt::device* device, size_type cu_idx)
+{
+  auto& slots = cu_chain_slots[cu_idx];
+  auto cu_addr = cu_idx_to_addr(cu_idx);
+  value_type ctrlreg = 0;
+  device->read_register(cu_addr,&ctrlreg,4);
+
+  if (ctrlreg & CONTROL_AP_READY)
+    cu_ready.set(cu_idx);
+
+  slot_info* done = nullptr;
+  if ((ctrlreg & CONTROL_AP_DONE) && !slots.empty()) {
+    done = slots.front();
+    slots.pop_front();
+    value_type cont = CONTROL_AP_CONTINUE;
+    device->write_register(cu_addr,&cont,4);
+  }
+
+  bool busy = slots.size()>=max_cu_chain || (!slots.empty() && !cu_ready.test(cu_idx));
+  cu_status.set(cu_idx,busy);
+  cu_slot_usage[cu_idx] = slots.empty() ? nullptr : slots.back();
+  return done;
+}
+
 /**
  * Check CU status
  *
@@ -313,6 +422,9 @@ start_cu(slot_info* slot)
  * and internal cu_status register that tracks running CUs is toggled
  * at corresponding position.
  *
+ * A chained CU completes its invocations in order, an invocation
+ * that completes before the one of argument slot is completed here.
+ *
  * @param cu_mask
  *   A bitmask with 1 bit set. Position of bit indicates the CU to check
  * @return
@@ -328,10 +440,21 @@ check_cu(slot_info* slot,bool wait=false)
   size_type cu_idx = 0;
   for (; !cu_mask.test(cu_idx); ++cu_idx);
   XRT_ASSERT(cu_idx < num_cus,"bad cu idx");
-  XRT_ASSERT(cu_status.test(cu_idx),"cu wasn't started");
   auto cu_addr = cu_idx_to_addr(cu_idx);
   value_type ctrlreg = 0;
 
+  if (cu_chain.test(cu_idx)) {
+    do {
+      auto done = check_chain_cu(device,cu_idx);
+      if (done==slot)
+        return true;
+      if (done)
+        slot_done(done);
+    } while (wait);
+    return false;
+  }
+
+  XRT_ASSERT(cu_status.test(cu_idx),"cu wasn't started");
   do {
     device->read_register(cu_addr,&ctrlreg,4);
     if (ctrlreg & (CONTROL_AP_IDLE | CONTROL_AP_DONE)) {
@@ -411,6 +534,7 @@ configure(slot_info* slot)
   setup();
 
   // notify host
+  set_completed(slot);
   notify_host(slot);
 
   slot->header_value = (slot->header_value & ~0xF) | 0x4; // free
@@ -438,7 +562,7 @@ process_special_command(slot_info* slot, size_type opcode)
 static std::mutex s_mutex;
 static std::condition_variable s_work;
 static bool s_stop=false;
-static std::vector<command_type> s_cmds;
+static std::vector<slot_info> s_cmds;
 
 /**
  * Main routine executed by embedded scheduler loop
@@ -447,7 +571,8 @@ static std::vector<command_type> s_cmds;
  *  1. If status is free (0x4), then read new command header
  *     Status remains free (0x4), or transitions to new (0x1)
  *  2. If status is new (0x1), then read CUs in command
- *     Status transitions to queued (0x2)
+ *     Status remains new (0x1) while commands in its wait list are
+ *     running, or transitions to queued (0x2)
  *  3. If status is queued (0x2), then start command on available CU
  *     Status remains queued if no CUs available, or transitions to running (0x3)
  *  4. If status is running (0x4), then check CU status
@@ -492,6 +617,12 @@ scheduler_loop()
           continue;
         }
 
+        // Command remains new until the commands it waits on are done
+        if (!slot->waitlist.empty() && !check_waitlist(slot)) {
+          nitr = ++itr;
+          continue;
+        }
+
         // Extract and cache cumask from cmd
         size_type cumasks = cu_masks(slot->header_value);
         for (size_type i=0; i<cumasks; ++i) {
@@ -514,11 +645,8 @@ scheduler_loop()
 
       if ((slot->header_value & 0xF) == 0x3) { // running
         // running command, check its cu status
-        if (check_cu(slot,false)) {
-          notify_host(slot);
-          slot->header_value = (slot->header_value & ~0xF) | 0x4; // free
-          XRT_DEBUGF("slot(%d) [running->free]\n",slot->get_uid());
-        }
+        if (check_cu(slot,false))
+          slot_done(slot);
       }
 
       if ((slot->header_value & 0xF) == 0x4) { // free
@@ -545,7 +673,15 @@ void
 schedule(const command_type& cmd)
 {
   std::lock_guard<std::mutex> lk(s_mutex);
-  s_cmds.push_back(cmd);
+  s_cmds.emplace_back(cmd);
+  s_work.notify_one();
+}
+
+void
+schedule(const command_type& cmd, const command_list_type& waitlist)
+{
+  std::lock_guard<std::mutex> lk(s_mutex);
+  s_cmds.emplace_back(cmd,waitlist);
   s_work.notify_one();
 }
 
@@ -596,7 +732,15 @@ init(xrt::device*, size_t, size_t cus, size_t cuoffset, size_t cubase, const std
   cu_base_address = cubase;
   cu_offset = cuoffset;
   cu_trace_enabled = xrt::config::get_profile();
-  cu_addr_map = cu_amap;
+
+  // CU control protocol is encoded in low bits of CU address
+  cu_addr_map.clear();
+  cu_chain.reset();
+  for (size_type cu=0; cu<cu_amap.size(); ++cu) {
+    cu_addr_map.push_back(cu_amap[cu] & ~ERT_CU_CTRL_MASK);
+    if ((cu_amap[cu] & ERT_CU_CTRL_MASK)==ERT_CU_CTRL_CHAIN)
+      cu_chain.set(cu);
+  }
 }
 
 }} // sws,xrt
@@ -130,6 +130,19 @@ get_stall_trace()
   return value;
 }
 
+/**
+ * Sample API calls and event state transitions instead of tracing
+ * every one of them.  Either "off", "<N>" to trace 1 in N, or
+ * "<on>/<period>" to trace only during the first <on> msec of every
+ * <period> msec.  API call summary counts and times remain exact.
+ */
+inline std::string
+get_profile_sampling()
+{
+  static std::string value = (!get_profile()) ? "off" : detail::get_string_value("Debug.profile_sampling","off");
+  return value;
+}
+
 inline bool
 get_timeline_trace()
 {
@@ -278,6 +291,65 @@ get_ert_slotsize()
   return value;
 }
 
+/**
+ * Submit NDRange kernels ahead of the kernels they depend on, the
+ * scheduler starts the kernel when the dependencies are done.
+ * Opt-in, default is to submit a kernel when its dependencies are done.
+ * An early submitted kernel reports CL_RUNNING when its commands are
+ * issued, which can be before its dependencies complete.
+ */
+inline bool
+get_kernel_wait_list()
+{
+  static bool value = detail::get_bool_value("Runtime.kernel_wait_list",false);
+  return value;
+}
+
+/**
+ * Placement of buffers that are not assigned a memory bank, one of
+ * first, balance, or stripe.  Overridden per context by
+ * CL_CONTEXT_MEM_PLACEMENT_XILINX.
+ */
+inline std::string
+get_mem_placement()
+{
+  static std::string value = detail::get_string_value("Runtime.mem_placement","first");
+  return value;
+}
+
+/**
+ * How a host thread waits for events and command queues, one of
+ * block (default), spin, or adaptive.  Adaptive spins for at most
+ * Runtime.wait_spin_us before blocking.
+ */
+inline std::string
+get_wait_policy()
+{
+  static std::string value = detail::get_string_value("Runtime.wait_policy","block");
+  return value;
+}
+
+/**
+ * Time in microseconds an adaptive wait spins before blocking
+ */
+inline unsigned int
+get_wait_spin_us()
+{
+  static unsigned int value = detail::get_uint_value("Runtime.wait_spin_us",20);
+  return value;
+}
+
+/**
+ * Max number of host threads copying a rectangular buffer region
+ * to or from host memory
+ */
+inline unsigned int
+get_rect_copy_threads()
+{
+  static unsigned int value = detail::get_uint_value("Runtime.rect_copy_threads",1);
+  return value;
+}
+
 inline std::string
 get_hw_em_driver()
 {